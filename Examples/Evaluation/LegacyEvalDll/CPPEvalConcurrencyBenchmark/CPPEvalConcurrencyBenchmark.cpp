@@ -0,0 +1,172 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPPEvalConcurrencyBenchmark.cpp : Measures the evaluation throughput of the extended evaluation interface
+// when several threads evaluate the same model concurrently, each with its own execution context.
+//
+
+#include <sys/stat.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Eval.h"
+#ifdef _WIN32
+#include "Windows.h"
+#endif
+
+using namespace std;
+using namespace Microsoft::MSR::CNTK;
+
+// Fills every input with a sequence of one-hot vectors, i.e. a sentence of random words.
+void feedRandomSequence(Values<float>& inputBuffers, const VariableSchema& inputLayouts, size_t sequenceLength, std::mt19937& rng)
+{
+    for (size_t i = 0; i < inputLayouts.size(); i++)
+    {
+        size_t inputDim = inputLayouts[i].m_numElements;
+        std::uniform_int_distribution<size_t> word(0, inputDim - 1);
+        inputBuffers[i].m_buffer.assign(inputDim * sequenceLength, 0);
+        for (size_t t = 0; t < sequenceLength; t++)
+            inputBuffers[i].m_buffer[t * inputDim + word(rng)] = 1;
+    }
+}
+
+// Runs numRequests forward passes on the given evaluator, and returns the number of output values produced.
+size_t runRequests(IEvaluateModelExtended<float>* eval, VariableSchema inputLayouts, VariableSchema outputLayouts,
+                   size_t numRequests, size_t sequenceLength, unsigned int seed)
+{
+    vector<size_t> inputBufferSize, outputBufferSize;
+    for (const auto& layout : inputLayouts)
+        inputBufferSize.push_back(layout.m_numElements * sequenceLength);
+    for (const auto& layout : outputLayouts)
+        outputBufferSize.push_back(layout.m_numElements * sequenceLength);
+
+    Values<float> inputBuffers = inputLayouts.CreateBuffers<float>(inputBufferSize);
+    Values<float> outputBuffers = outputLayouts.CreateBuffers<float>(outputBufferSize);
+
+    std::mt19937 rng(seed);
+    size_t numOutputValues = 0;
+    for (size_t r = 0; r < numRequests; r++)
+    {
+        feedRandomSequence(inputBuffers, inputLayouts, sequenceLength, rng);
+        eval->ForwardPass(inputBuffers, outputBuffers);
+        numOutputValues += outputBuffers[0].m_buffer.size();
+    }
+    return numOutputValues;
+}
+
+/// <summary>
+/// Program for measuring how model evaluation with the native extended evaluation interface scales with the number of threads.
+/// </summary>
+/// <description>
+/// The model is loaded once. Every worker thread gets its own execution context (IEvaluateModelExtended::CreateExecutionContext()),
+/// which shares the model parameters with the loaded model, but has its own activation buffers. The program then reports
+/// the throughput for 1, 2, 4, ... up to the given number of threads.
+/// Every worker does its own computation on a single core (numCPUThreads=1), throughput comes from running several requests at once.
+/// The model is the one of CPPEvalExtendedClient; first run the example in <CNTK>/Examples/LanguageUnderstanding/ATIS/BrainScript
+/// to create ATIS.slot.lstm.
+/// Usage: CPPEvalConcurrencyBenchmark [maxThreads [requestsPerThread [sequenceLength]]]
+/// </description>
+int main(int argc, char* argv[])
+{
+    std::string app = argv[0];
+    std::string path;
+    size_t pos;
+    int ret;
+
+    size_t maxThreads = argc > 1 ? std::stoul(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    size_t requestsPerThread = argc > 2 ? std::stoul(argv[2]) : 200;
+    size_t sequenceLength = argc > 3 ? std::stoul(argv[3]) : 20;
+
+#ifdef _WIN32
+    pos = app.rfind("\\");
+    path = (pos == std::string::npos) ? "." : app.substr(0, pos);
+
+    // This relative path assumes launching from CNTK's binary folder, e.g. x64\Release
+    const std::string modelBaseDir = path + "/../../Examples/LanguageUnderstanding/ATIS/BrainScript/";
+
+#else // on Linux
+    pos = app.rfind("/");
+    path = (pos == std::string::npos) ? "." : app.substr(0, pos);
+
+    // This relative path assumes launching from CNTK's binary folder, e.g. build/cpu/release/bin/
+    const std::string modelBaseDir = path + "/../../../../Examples/LanguageUnderstanding/ATIS/BrainScript/";
+#endif
+    const std::string modelFilePath = modelBaseDir + "work/ATIS.slot.lstm";
+
+    try
+    {
+        struct stat statBuf;
+        if (stat(modelFilePath.c_str(), &statBuf) != 0)
+        {
+            fprintf(stderr, "Error: The model %s does not exist. Please follow instructions in README.md in <CNTK>/Examples/LanguageUnderstanding/ATIS/BrainScript to create the model.\n", modelFilePath.c_str());
+            return(1);
+        }
+
+        IEvaluateModelExtended<float>* eval;
+        GetEvalExtendedF(&eval);
+        eval->Init("numCPUThreads=1");
+        eval->CreateNetwork("modelPath=\"" + modelFilePath + "\"");
+
+        VariableSchema outputLayouts = eval->GetOutputSchema();
+        eval->StartForwardEvaluation({ outputLayouts[0].m_name });
+        VariableSchema inputLayouts = eval->GetInputSchema();
+        outputLayouts = eval->GetOutputSchema();
+
+        // Warm up, so that the first measurement does not include one-time allocations.
+        runRequests(eval, inputLayouts, outputLayouts, 10, sequenceLength, 0);
+
+        double singleThreadThroughput = 0;
+        for (size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+        {
+            // The execution contexts are created before the measurement; they are cheap, but not free.
+            vector<IEvaluateModelExtended<float>*> contexts(numThreads);
+            contexts[0] = eval;
+            for (size_t i = 1; i < numThreads; i++)
+                contexts[i] = eval->CreateExecutionContext();
+
+            auto start = std::chrono::steady_clock::now();
+            vector<std::thread> workers;
+            for (size_t i = 0; i < numThreads; i++)
+                workers.emplace_back([&, i]() { runRequests(contexts[i], inputLayouts, outputLayouts, requestsPerThread, sequenceLength, (unsigned int)i + 1); });
+            for (auto& worker : workers)
+                worker.join();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            for (size_t i = 1; i < numThreads; i++)
+                contexts[i]->Destroy();
+
+            double throughput = numThreads * requestsPerThread / seconds;
+            if (numThreads == 1)
+                singleThreadThroughput = throughput;
+            fprintf(stdout, "%3" PRIu64 " threads: %10.1f requests/s (speedup %.2f)\n", (uint64_t)numThreads, throughput, throughput / singleThreadThroughput);
+        }
+
+        eval->Destroy();
+
+        // This pattern is used by End2EndTests to check whether the program runs to complete.
+        printf("Evaluation complete.\n");
+        ret = 0;
+    }
+    catch (const std::exception& err)
+    {
+        fprintf(stderr, "Evaluation failed. EXCEPTION occurred: %s\n", err.what());
+        ret = 1;
+    }
+    catch (...)
+    {
+        fprintf(stderr, "Evaluation failed. Unknown ERROR occurred.\n");
+        ret = 1;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    return ret;
+}
@@ -0,0 +1,203 @@
+#!/usr/bin/env python
+
+# This script repacks the HTK feature files referenced by an HTK script (SCP) file
+# into one HTK archive per reader chunk, and writes a new SCP file that points into
+# these archives.
+#
+# Each input line has the form
+#   <utterance key>=<feature file>[<first frame>,<last frame>]
+# or
+#   <utterance key>=<feature file>
+# for utterances that span the whole file, as expected by the HTK deserializer. The utterances are grouped into chunks with
+# the same rule the HTK deserializer uses (a new chunk is started once the current
+# one exceeds 15 minutes of 10ms frames), and the frames of all utterances of a
+# chunk are written back to back into a single archive. The HTK deserializer then
+# reads each chunk with one open and one large read, instead of one open/seek and
+# one read per utterance.
+#
+# The archives are regular uncompressed HTK feature files, so no reader
+# configuration changes are needed besides pointing 'scpFile' to the new SCP file.
+# Compressed input files are decompressed while packing.
+#
+# Example:
+#   python htk2pack.py --input train.scp --output_dir packed --output_scp train.packed.scp
+#
+
+import sys
+import argparse
+import os
+import struct
+import re
+
+HEADER_SIZE = 12
+HASCOMPX = 0o2000
+HASCRCC = 0o10000
+FESTREAM = 12
+
+FRAMES_PER_SEC = 100
+CHUNK_FRAMES = 15 * 60 * FRAMES_PER_SEC
+
+LINE_PATTERN = re.compile(r'^([^=]+)=(.*?)(?:\[(\d+),(\d+)\])?\s*$')
+
+class HtkFile(object):
+    '''An opened HTK feature file, gives access to frames as float32 big-endian bytes.'''
+
+    def __init__(self, path):
+        self.path = path
+        self.file = open(path, 'rb')
+        header = self.file.read(HEADER_SIZE)
+        if len(header) != HEADER_SIZE:
+            raise ValueError("'%s': truncated HTK header" % path)
+        # the HTK deserializer guesses the byte order from the sample period
+        nsamples, period, sampsize, kind = struct.unpack('>iiHh', header)
+        little_period = struct.unpack('<i', header[4:8])[0]
+        self.endian = '>'
+        if (little_period & 0xffffffff) < (period & 0xffffffff):
+            nsamples, period, sampsize, kind = struct.unpack('<iiHh', header)
+            self.endian = '<'
+        if kind == FESTREAM:
+            raise ValueError("'%s': FESTREAM features are not supported" % path)
+        self.period = period
+        self.compressed = (kind & HASCOMPX) != 0
+        # the packed archive is uncompressed and carries no CRC
+        self.kind = kind & ~(HASCOMPX | HASCRCC)
+        value_size = 2 if self.compressed else 4
+        if sampsize % value_size != 0:
+            raise ValueError("'%s': sample size not multiple of dimension" % path)
+        self.dim = sampsize // value_size
+        self.frame_bytes = sampsize
+        if self.compressed:
+            fmt = '%s%df' % (self.endian, self.dim)
+            self.a = struct.unpack(fmt, self.file.read(4 * self.dim))
+            self.b = struct.unpack(fmt, self.file.read(4 * self.dim))
+            nsamples -= 4
+        self.data_start = self.file.tell()
+        self.nsamples = nsamples
+
+    def read_frames(self, first, last):
+        '''Returns frames [first, last] as big-endian float32 bytes.'''
+        if first > last or last >= self.nsamples:
+            raise ValueError("'%s': frame range [%d,%d] outside of %d frames" % (self.path, first, last, self.nsamples))
+        count = last - first + 1
+        self.file.seek(self.data_start + first * self.frame_bytes)
+        raw = self.file.read(count * self.frame_bytes)
+        if len(raw) != count * self.frame_bytes:
+            raise ValueError("'%s': unexpected end of file" % self.path)
+        if not self.compressed:
+            if self.endian == '>':
+                return raw
+            values = struct.unpack('<%df' % (count * self.dim), raw)
+            return struct.pack('>%df' % len(values), *values)
+        values = struct.unpack('%s%dh' % (self.endian, count * self.dim), raw)
+        dim, a, b = self.dim, self.a, self.b
+        # round like the single-precision (v + b) / a of the HTK reader, so packed values are bit-identical
+        sums = struct.unpack('%df' % len(values), struct.pack('%df' % len(values), *[v + b[i % dim] for i, v in enumerate(values)]))
+        decoded = [v / a[i % dim] for i, v in enumerate(sums)]
+        return struct.pack('>%df' % len(decoded), *decoded)
+
+    def close(self):
+        self.file.close()
+
+class ArchiveWriter(object):
+    '''Writes one uncompressed HTK archive, fixing up the frame count on close.'''
+
+    def __init__(self, path, kind, dim, period):
+        self.path = path
+        self.file = open(path, 'wb')
+        self.kind = kind
+        self.dim = dim
+        self.period = period
+        self.frames = 0
+        self.write_header()
+
+    def write_header(self):
+        self.file.seek(0)
+        self.file.write(struct.pack('>iiHh', self.frames, self.period, 4 * self.dim, self.kind))
+
+    def append(self, data, count):
+        first = self.frames
+        self.file.write(data)
+        self.frames += count
+        return first, self.frames - 1
+
+    def close(self):
+        self.write_header()
+        self.file.close()
+
+def read_scp(path):
+    entries = []
+    counts = {}
+    with open(path, 'r') as scp:
+        for line in scp:
+            line = line.rstrip('\r\n')
+            if not line:
+                continue
+            match = LINE_PATTERN.match(line)
+            if not match or not match.group(2):
+                raise ValueError("malformed SCP line '%s', expected key=path[s,e] or key=path" % line)
+            key, file_path = match.group(1), match.group(2)
+            if match.group(3) is None:
+                # the whole file, the range is determined once the file is opened
+                first, last = 0, None
+            else:
+                first, last = int(match.group(3)), int(match.group(4))
+            entries.append((key, file_path, first, last))
+            counts[key] = counts.get(key, 0) + 1
+    # the HTK deserializer drops all utterances whose key is not unique; do the same
+    # so that archive boundaries line up with its chunks
+    return [e for e in entries if counts[e[0]] == 1], len(entries)
+
+def pack(input_scp, output_dir, output_scp, chunk_frames):
+    entries, num_lines = read_scp(input_scp)
+    if not os.path.isdir(output_dir):
+        os.makedirs(output_dir)
+
+    files = {}
+    writer = None
+    kind = dim = period = None
+    num_chunks = 0
+    chunk_size = 0
+    with open(output_scp, 'w') as out:
+        for key, file_path, first, last in entries:
+            htk = files.get(file_path)
+            if htk is None:
+                # keep a single input open; archives are typically referenced in order
+                for f in files.values():
+                    f.close()
+                htk = HtkFile(file_path)
+                files = {file_path: htk}
+            if last is None:
+                last = htk.nsamples - 1
+            if kind is None:
+                kind, dim, period = htk.kind, htk.dim, htk.period
+            elif (kind, dim, period) != (htk.kind, htk.dim, htk.period):
+                raise ValueError("'%s': inconsistent feature kind" % file_path)
+
+            if writer is None or chunk_size > chunk_frames:
+                if writer is not None:
+                    writer.close()
+                archive = os.path.join(output_dir, 'chunk%06d.htk' % num_chunks)
+                writer = ArchiveWriter(archive, kind, dim, period)
+                num_chunks += 1
+                chunk_size = 0
+
+            count = last - first + 1
+            s, e = writer.append(htk.read_frames(first, last), count)
+            chunk_size += count
+            out.write('%s=%s[%d,%d]\n' % (key, writer.path, s, e))
+
+    if writer is not None:
+        writer.close()
+    for f in files.values():
+        f.close()
+    sys.stderr.write('Packed %d of %d utterances into %d archives.\n' % (len(entries), num_lines, num_chunks))
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description="Repacks HTK features into one archive per HTK deserializer chunk.")
+    parser.add_argument('--input', help="SCP file with key=path[s,e] or key=path entries.", required=True)
+    parser.add_argument('--output_dir', help="Directory for the packed archives.", required=True)
+    parser.add_argument('--output_scp', help="Name of the SCP file to write for the packed archives.", required=True)
+    parser.add_argument('--chunk_frames', type=int, default=CHUNK_FRAMES,
+        help="Frames after which a new archive is started (default matches the HTK deserializer: %d)." % CHUNK_FRAMES, required=False)
+    args = parser.parse_args()
+    pack(args.input, args.output_dir, args.output_scp, args.chunk_frames)
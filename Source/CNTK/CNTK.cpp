@@ -81,7 +81,8 @@ void SetupProfiling(ProfilerContext& profilerContext, const ConfigParamType& con
         profilerContext.Init(workDir + L"/profiler",
                              config(L"profilerBufferSize", static_cast<uint64_t>(32 * 1024 * 1024)),
                              std::to_wstring(nodeRank),
-                             config(L"profilerSyncGpu", true));
+                             config(L"profilerSyncGpu", true),
+                             config(L"profilerNodes", false));
     }
 }
 
@@ -512,6 +513,10 @@ int wmainWithBS(int argc, wchar_t* argv[]) // called from wmain which is a wrapp
 
     Globals::SetShareNodeValueMatrices(config(L"shareNodeValueMatrices", true));
     Globals::SetGradientAccumulationOptimization(config(L"optimizeGradientAccumulation", true));
+    Globals::SetElementwiseFusion(config(L"fuseElementwiseOperations", false));
+    Globals::SetDirectConvolution(config(L"directConvolution", false));
+    // interOpThreads > 1 runs independent CPU nodes concurrently, each with a share of the numCPUThreads
+    Globals::SetInterOpParallelism(config(L"interOpThreads", (size_t)1), (unsigned long)config(L"scheduleSeed", (size_t)0));
 
     TracingGPUMemoryAllocator::SetTraceLevel(config(L"traceGPUMemoryAllocations", 0));
 
@@ -660,6 +665,10 @@ int wmainOldCNTKConfig(int argc, wchar_t* argv[])
 
     Globals::SetShareNodeValueMatrices(config(L"shareNodeValueMatrices", true));
     Globals::SetGradientAccumulationOptimization(config(L"optimizeGradientAccumulation", true));
+    Globals::SetElementwiseFusion(config(L"fuseElementwiseOperations", false));
+    Globals::SetDirectConvolution(config(L"directConvolution", false));
+    // interOpThreads > 1 runs independent CPU nodes concurrently, each with a share of the numCPUThreads
+    Globals::SetInterOpParallelism(config(L"interOpThreads", (size_t)1), (unsigned long)config(L"scheduleSeed", (size_t)0));
 
     TracingGPUMemoryAllocator::SetTraceLevel(config(L"traceGPUMemoryAllocations", 0));
 
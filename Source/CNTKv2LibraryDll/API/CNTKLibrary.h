@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <mutex>
 #include <future>
+#include <chrono>
 #include <cstddef>
 #include <cmath>
 
@@ -595,6 +596,7 @@ namespace CNTK
         friend class BlockMomentumDistributedLearner;
         friend class Internal::VariableResolver;
         friend class Trainer;
+        friend class Serializer;
 
         template <typename T, typename ...CtorArgTypes>
         friend inline std::shared_ptr<T> MakeSharedObject(CtorArgTypes&& ...ctorArgs);
@@ -876,6 +878,14 @@ namespace CNTK
     private:
         CNTK_API NDArrayView(::CNTK::DataType dataType, const DeviceDescriptor& device, ::CNTK::StorageFormat storageType, const NDShape& viewShape, bool readOnly, void* tensorView);
 
+        // Construct a dense CPU view over 'dataBuffer', which is kept alive by 'bufferOwner' (e.g. a mapped model file)
+        // for as long as this view or any of its aliases exists.
+        NDArrayView(::CNTK::DataType dataType, const NDShape& viewShape, void* dataBuffer, size_t bufferSizeInBytes, const std::shared_ptr<void>& bufferOwner);
+
+        // Returns true if the data of this view lives in memory owned by somebody else and kept alive by the view,
+        // in which case aliasing the view is as safe as copying it.
+        bool HasBufferOwner() const { return m_bufferOwner != nullptr; }
+
         template <typename ElementType>
         static std::shared_ptr<Microsoft::MSR::CNTK::Matrix<ElementType>> GetMatrixImpl(const Microsoft::MSR::CNTK::TensorView<ElementType>* tensorView, size_t rowColSplitPoint);
 
@@ -899,6 +909,7 @@ namespace CNTK
         bool m_isReadOnly;
 
         std::shared_ptr<void> m_tensorView; // Microsoft::MSR::CNTK::TensorView<ElemType>*
+        std::shared_ptr<void> m_bufferOwner; // owner of the data buffer if it was not allocated by the view, see HasBufferOwner()
     };
 
     enum class MaskKind : char
@@ -2533,6 +2544,30 @@ namespace CNTK
             return Create(sampleShape, batchOfSequences, {}, device, readOnly);
         }
 
+        ///
+        /// Creates a new Value object containing a batch of variable length sequences, without padding them to the length of the longest one.
+        /// The sequences are laid out in the packed form the Function graph computes on, so the created Value object is fed to a Function
+        /// without padded data being created or reshuffled. The padded data and the mask are only created if Data() or Mask() is accessed.
+        /// Parameters:
+        ///     sampleShape: the tensor shape of the Value. It must not have free dimensions.
+        ///     batchOfSequences: the data to be stored in the Value. The outer vector represents a collection of sequences with variable length, and the inner vector represents each individual, non-empty sequence.
+        ///     sequenceStartFlags: A collection of boolean value. Each element represent whether the correspoinding sequence in batchOfSequences is a new sequence (in case of true) or a continuation of a previous sequence (in case of false).
+        ///     device: on which device the Value should be created.
+        ///     readOnly: the Value is read-only if this flag is true.
+        ///
+        template <typename ElementType>
+        CNTK_API static ValuePtr CreatePackedBatchOfSequences(const NDShape& sampleShape, const std::vector<std::vector<ElementType>>& batchOfSequences, const std::vector<bool>& sequenceStartFlags, const DeviceDescriptor& device, bool readOnly = false);
+
+        ///
+        /// Creates a new Value object containing a batch of variable length sequences, without padding them to the length of the longest one.
+        /// Each sequence in batchOfSequences is a new sequence.
+        ///
+        template <typename ElementType>
+        static ValuePtr CreatePackedBatchOfSequences(const NDShape& sampleShape, const std::vector<std::vector<ElementType>>& batchOfSequences, const DeviceDescriptor& device, bool readOnly = false)
+        {
+            return CreatePackedBatchOfSequences(sampleShape, batchOfSequences, {}, device, readOnly);
+        }
+
         ///
         /// Creates a new Value object containing a batch of samples.
         /// Each sample is represented by an index value that points to the non-zero value in the one-hot vector of dimension elements.
@@ -2931,7 +2966,7 @@ namespace CNTK
             // Check whether each sequence has enough space allocated and resize if necessary.
             std::vector<ptrdiff_t> sequenceBeginIndices(numOfSequences, 0);
             std::vector<size_t> sequenceLengths(numOfSequences, maxSequenceLen);
-            GetSequenceStartsAndLengths(Mask(), sequenceBeginIndices, sequenceLengths, outputVariable.DynamicAxes().size());
+            GetSequenceStartsAndLengths(sequenceBeginIndices, sequenceLengths, outputVariable.DynamicAxes().size());
             for (auto seqIndex = 0; seqIndex < numOfSequences; seqIndex++)
             {
                 if (sequenceBeginIndices[seqIndex] != 0)
@@ -2945,6 +2980,11 @@ namespace CNTK
         Value(const Value&) = delete; Value& operator=(const Value&) = delete; Value(Value&&) = delete; Value& operator=(Value&&) = delete;
 
     protected:
+        ///
+        /// Get the begin index and length of each sequence stored in 'this' Value object.
+        ///
+        CNTK_API virtual void GetSequenceStartsAndLengths(std::vector<ptrdiff_t>& sequenceBeginIndices, std::vector<size_t>& sequenceLengths, size_t numDynamicAxes) const;
+
         mutable NDArrayViewPtr m_data;
         mutable NDMaskPtr m_mask;
     };
@@ -2995,6 +3035,24 @@ namespace CNTK
     };
     typedef std::shared_ptr<BackPropState> BackPropStatePtr;
 
+    ///
+    /// On-disk layout of a saved Function
+    ///
+    enum class ModelFormat
+    {
+        ///
+        /// The graph and the parameter values are stored together in a protobuf message
+        ///
+        CNTKv2,
+
+        ///
+        /// The graph is stored apart from the raw, 64-byte aligned parameter values, which are
+        /// memory mapped when the model is loaded instead of being decoded and copied.
+        /// The file must not be modified while a Function loaded from it on the CPU is alive.
+        ///
+        CNTKv2Mapped,
+    };
+
     ///
     /// How are Parameters handled when cloning a Function
     ///
@@ -3408,6 +3466,12 @@ namespace CNTK
         ///
         CNTK_API void Save(const std::wstring& filepath);
 
+        ///
+        /// Save this Function graph into a model file of the specified format.
+        /// Function::Load detects the format of a model file by itself.
+        ///
+        CNTK_API void Save(const std::wstring& filepath, ModelFormat format);
+
         ///
         /// Restore the models parameters (in-place) from a model file
         ///
@@ -5066,6 +5130,211 @@ namespace CNTK
     ///
     CNTK_API EvaluatorPtr CreateEvaluator(const FunctionPtr& evaluationFunction, const std::vector<ProgressWriterPtr>& progressWriters = {});
 
+    ///
+    /// Statistics of the batches formed by a BatchingEvaluator.
+    ///
+    struct BatchingEvaluatorStatistics
+    {
+        size_t m_numRequests = 0;
+        size_t m_numBatches = 0;
+
+        ///
+        /// Element i is the number of forward passes that were done over a batch of i requests.
+        ///
+        std::vector<size_t> m_batchSizeHistogram;
+
+        ///
+        /// Element i is the number of requests that found i requests (including themselves) waiting when they were
+        /// submitted. The last element also counts all requests that found more requests waiting.
+        ///
+        std::vector<size_t> m_queueDepthHistogram;
+    };
+
+    ///
+    /// BatchingEvaluator evaluates a Function for single requests, which may be submitted concurrently from many threads.
+    /// The requests are queued, and coalesced into a batch that is evaluated by a single forward pass. A batch is
+    /// evaluated as soon as it has reached the maximum batch size, or when the oldest request in it has waited for the
+    /// maximum latency, whichever comes first. This allows online services to benefit from the efficiency of batched
+    /// evaluation without having to batch their requests themselves.
+    ///
+    class BatchingEvaluator : public std::enable_shared_from_this<BatchingEvaluator>
+    {
+    public:
+        ///
+        /// Submits a request. 'arguments' must have data for each argument of the Function, as a CPU NDArrayView holding
+        /// either a single sample, or a sequence of samples (with the sequence axis as the last axis).
+        /// Data that does not match the arguments is rejected by an exception from this call, and never joins a batch.
+        /// The returned future delivers the value of each output of the Function for this request, in the same layout,
+        /// or the exception that occurred when evaluating the batch that contained the request.
+        ///
+        virtual std::future<std::unordered_map<Variable, NDArrayViewPtr>> Evaluate(const std::unordered_map<Variable, NDArrayViewPtr>& arguments) = 0;
+
+        ///
+        /// Returns the statistics collected since creation or the last call to ResetStatistics().
+        ///
+        virtual BatchingEvaluatorStatistics Statistics() const = 0;
+
+        ///
+        /// Resets the statistics.
+        ///
+        virtual void ResetStatistics() = 0;
+
+        ///
+        /// Destruction evaluates all requests that have already been submitted.
+        ///
+        virtual ~BatchingEvaluator() {}
+    };
+
+    ///
+    /// Construct a BatchingEvaluator for the specified Function, that evaluates batches of at most maxBatchSize requests,
+    /// and waits no longer than maxLatency for a batch to fill up.
+    ///
+    CNTK_API BatchingEvaluatorPtr CreateBatchingEvaluator(const FunctionPtr& function, size_t maxBatchSize, const std::chrono::microseconds& maxLatency, const DeviceDescriptor& computeDevice = DeviceDescriptor::UseDefaultDevice());
+
+    ///
+    /// A hypothesis produced by beam search decoding.
+    ///
+    struct DecodingHypothesis
+    {
+        ///
+        /// The decoded tokens. The start token is not included; the end token is included if the hypothesis is finished.
+        ///
+        std::vector<size_t> m_tokens;
+
+        ///
+        /// The sum of the log-probabilities of the decoded tokens.
+        ///
+        double m_logProbability = 0;
+
+        ///
+        /// False if decoding reached the maximum length before the end token was emitted.
+        ///
+        bool m_finished = false;
+    };
+
+    ///
+    /// Statistics of the search done by a BeamSearchDecoder.
+    ///
+    struct BeamSearchDecoderStatistics
+    {
+        size_t m_numSequences = 0;
+
+        ///
+        /// Number of forward passes of the step Function; each one advances all live hypotheses of all sequences by one token.
+        ///
+        size_t m_numSteps = 0;
+
+        ///
+        /// Total number of hypotheses over all forward passes.
+        ///
+        size_t m_numHypothesisSteps = 0;
+
+        double m_evaluationSeconds = 0;
+        double m_searchSeconds = 0;
+    };
+
+    ///
+    /// BeamSearchDecoder decodes the output sequences of a recurrent (e.g. sequence-to-sequence) model by beam search.
+    /// The model is specified as a step Function that maps the previous token (one-hot), the recurrent state and any
+    /// constant context (e.g. the encoder output) to the log-probabilities of the next token and the next recurrent state.
+    /// All inputs and outputs of the step Function have a batch axis only. Each decoding step evaluates the step Function
+    /// once for all live hypotheses of all sequences; the recurrent state is reordered on the compute device, and only the
+    /// scores are copied to the CPU for pruning.
+    /// A BeamSearchDecoder must not be used from multiple threads concurrently.
+    ///
+    class BeamSearchDecoder : public std::enable_shared_from_this<BeamSearchDecoder>
+    {
+    public:
+        ///
+        /// Decodes a batch of sequences, and returns up to nBest hypotheses for each, best first.
+        /// 'arguments' contains the initial value of every state input and the value of every other input of the step
+        /// Function except the token input, with one sample per sequence to decode.
+        ///
+        virtual std::vector<std::vector<DecodingHypothesis>> Decode(const std::unordered_map<Variable, ValuePtr>& arguments, size_t nBest = 1) = 0;
+
+        ///
+        /// Returns the statistics collected since creation or the last call to ResetStatistics().
+        ///
+        virtual BeamSearchDecoderStatistics Statistics() const = 0;
+
+        ///
+        /// Resets the statistics.
+        ///
+        virtual void ResetStatistics() = 0;
+
+        virtual ~BeamSearchDecoder() {}
+    };
+
+    ///
+    /// Construct a BeamSearchDecoder for the specified step Function. 'stateInputToOutput' maps every recurrent state input
+    /// of the step Function to the output that produces its next value. Decoding starts with 'startToken', and a hypothesis
+    /// is finished when it emits 'endToken' or reaches 'maxLength' tokens.
+    ///
+    CNTK_API BeamSearchDecoderPtr CreateBeamSearchDecoder(const FunctionPtr& stepFunction,
+                                                          const Variable& tokenInput,
+                                                          const Variable& scoresOutput,
+                                                          const std::unordered_map<Variable, Variable>& stateInputToOutput,
+                                                          size_t startToken,
+                                                          size_t endToken,
+                                                          size_t beamWidth,
+                                                          size_t maxLength,
+                                                          const DeviceDescriptor& computeDevice = DeviceDescriptor::UseDefaultDevice());
+
+    ///
+    /// Decodes the output of a CTC model by prefix beam search. 'logProbabilities' holds the per-frame log-probabilities
+    /// of a batch of sequences; returns up to nBest label sequences for each, best first. The probability of a label sequence
+    /// is summed over all of its alignments, so even with a beam width of 1 the result can differ from best path decoding.
+    ///
+    CNTK_API std::vector<std::vector<DecodingHypothesis>> CTCBeamSearchDecode(const ValuePtr& logProbabilities, size_t blankToken, size_t beamWidth, size_t nBest = 1);
+
+    ///
+    /// Statistics of the transformations done by OptimizeForInference.
+    /// Functions are counted as primitive Functions, including those inside blocks. FLOPs are estimated per sample
+    /// from the static shapes; Functions with free or inferred dimensions do not contribute.
+    ///
+    struct InferenceOptimizationStatistics
+    {
+        size_t m_numFunctionsBefore = 0;
+        size_t m_numFunctionsAfter = 0;
+        size_t m_flopsBefore = 0;
+        size_t m_flopsAfter = 0;
+
+        ///
+        /// Number of BatchNormalization Functions folded into the weights of the preceding Times or Convolution.
+        /// The others are replaced by a per-channel scale and shift.
+        ///
+        size_t m_numBatchNormalizationsFoldedIntoWeights = 0;
+        size_t m_numBatchNormalizationsFoldedIntoScaleAndShift = 0;
+
+        ///
+        /// Number of Functions that depend on Constants only and were replaced by their value.
+        ///
+        size_t m_numConstantFunctionsFolded = 0;
+
+        ///
+        /// Number of Dropout, StopGradient and Pass Functions removed.
+        ///
+        size_t m_numIdentityFunctionsRemoved = 0;
+    };
+
+    ///
+    /// Returns a Function for evaluation only, that computes the same values as 'outputs' of the specified Function
+    /// (all of its outputs if 'outputs' is empty), in the same order. The returned Function has no Parameters: their
+    /// current values are copied into Constants. Blocks are inlined; Dropout, StopGradient and Pass are removed;
+    /// BatchNormalization uses its running statistics and is folded into the preceding Times or Convolution weights,
+    /// or else into a scale and shift; Functions that depend on Constants only are replaced by their value; and
+    /// Functions that do not contribute to 'outputs' are dropped. The arguments are those of the specified Function
+    /// that 'outputs' depend on; arguments that only feed dropped Functions (e.g. the labels of a training criterion)
+    /// are not arguments of the returned Function.
+    ///
+    CNTK_API FunctionPtr OptimizeForInference(const FunctionPtr& function, const std::vector<Variable>& outputs, InferenceOptimizationStatistics& statistics);
+
+    inline FunctionPtr OptimizeForInference(const FunctionPtr& function)
+    {
+        InferenceOptimizationStatistics statistics;
+        return OptimizeForInference(function, {}, statistics);
+    }
+
     ///
     /// Trainer is the top-level abstraction responsible for the orchestration of the training of a model
     /// using the specified learners and training data either explicitly supplied as Value objects or from
@@ -5425,6 +5694,31 @@ namespace CNTK
         ///
         Internal::Optional<bool> isMultithreaded;
 
+        ///
+        /// Number of chunks that are loaded asynchronously ahead of the randomization window (only applicable
+        /// to the randomized input).
+        ///
+        size_t prefetchDepthInChunks{ 1 };
+
+        ///
+        /// Maximum number of chunks loaded concurrently by the prefetch. Values greater than 1 require
+        /// deserializers that support concurrent chunk loading (e.g. ImageDeserializer, HTKFeatureDeserializer).
+        ///
+        size_t prefetchThreads{ 1 };
+
+        ///
+        /// Memory budget in bytes for the prefetched chunks (0 - no limit, the default). At least one chunk
+        /// is always prefetched.
+        ///
+        size_t prefetchBudgetInBytes{ 0 };
+
+        ///
+        /// Number of minibatches that are prepared by the reader thread ahead of the network. Larger values
+        /// absorb occasional slow minibatches (e.g. long sequences or chunk loads) at the cost of one set of
+        /// input buffers per minibatch.
+        ///
+        size_t prefetchDepthInMinibatches{ 1 };
+
         ///
         /// Deserializers to be used in the composite reader.
         ///
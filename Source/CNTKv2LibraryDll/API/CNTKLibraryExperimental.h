@@ -111,7 +111,7 @@ namespace CNTK {
             : SequenceDataBase(numberOfSamples, isValid)
         {}
 
-        SparseIndexType* m_indices {0};            /// an index for every value in the m_data array
+        const SparseIndexType* m_indices {0};      /// an index for every value in the m_data array
         std::vector<SparseIndexType> m_nnzCounts;  /// nnz count for each sample in the sequence
         SparseIndexType m_totalNnzCount {0};       /// sum of all nzzCounts of all samples
                                                    /// Using IndexType for both properties above since the nnzCount should fit inside
@@ -212,6 +212,12 @@ namespace CNTK
     class Evaluator;
     typedef std::shared_ptr<Evaluator> EvaluatorPtr;
 
+    class BatchingEvaluator;
+    typedef std::shared_ptr<BatchingEvaluator> BatchingEvaluatorPtr;
+
+    class BeamSearchDecoder;
+    typedef std::shared_ptr<BeamSearchDecoder> BeamSearchDecoderPtr;
+
     class Trainer;
     typedef std::shared_ptr<Trainer> TrainerPtr;
 
@@ -308,8 +314,17 @@ namespace CNTK
         CNTK_API void EnableGradientAccumulationOptimization();
         CNTK_API void DisableGradientAccumulationOptimization();
 
+        // Lets CPU convolutions use the direct/Winograd engine, which picks the fastest implementation per layer by timing it.
+        CNTK_API void EnableDirectConvolution();
+        CNTK_API void DisableDirectConvolution();
+
+        // Executes up to numThreads independent nodes of a CPU network concurrently (1 = one at a time).
+        // Each node then uses fewer intra-op threads, so results of reductions can differ from sequential
+        // execution within floating-point rounding.
+        CNTK_API void SetInterOpParallelism(size_t numThreads, unsigned long scheduleSeed = 0);
+
         static const uint64_t DefaultProfilerBufferSize = 32 * 1024 * 1024;
-        CNTK_API void StartProfiler(const std::wstring& profilerDir = L"profiler", bool profilerSyncGpu = false, size_t profilerBufferSize = DefaultProfilerBufferSize);
+        CNTK_API void StartProfiler(const std::wstring& profilerDir = L"profiler", bool profilerSyncGpu = false, size_t profilerBufferSize = DefaultProfilerBufferSize, bool profileNodes = false);
         CNTK_API void EnableProfiler();
         CNTK_API void DisableProfiler();
         CNTK_API void StopProfiler();
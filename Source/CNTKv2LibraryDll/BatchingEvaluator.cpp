@@ -0,0 +1,264 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include "BatchingEvaluator.h"
+
+namespace CNTK
+{
+    namespace
+    {
+        // Copies each sequence of an output value into its own NDArrayView on the CPU.
+        // CopyVariableValueTo reads a PackedValue without unpacking it, so this also works when automatic unpacking is disabled.
+        template <typename ElementType>
+        std::vector<NDArrayViewPtr> CopySequences(const ValuePtr& value, const Variable& output)
+        {
+            std::vector<std::vector<ElementType>> sequences;
+            value->CopyVariableValueTo(output, sequences);
+
+            auto sampleShape = value->Shape().SubShape(0, output.Shape().Rank());
+            auto sampleSize = sampleShape.TotalSize();
+            std::vector<NDArrayViewPtr> results;
+            results.reserve(sequences.size());
+            for (const auto& sequence : sequences)
+            {
+                NDArrayView sequenceView(sampleShape.AppendShape({ sequence.size() / sampleSize }), sequence.data(), sequence.size(), DeviceDescriptor::CPUDevice());
+                results.push_back(sequenceView.DeepClone(DeviceDescriptor::CPUDevice(), /*readOnly =*/ false));
+            }
+            return results;
+        }
+    }
+
+    BatchingEvaluatorPtr CreateBatchingEvaluator(const FunctionPtr& function, size_t maxBatchSize, const std::chrono::microseconds& maxLatency, const DeviceDescriptor& computeDevice)
+    {
+        return MakeSharedObject<BatchingEvaluatorImpl>(function, maxBatchSize, maxLatency, computeDevice);
+    }
+
+    BatchingEvaluatorImpl::BatchingEvaluatorImpl(const FunctionPtr& function, size_t maxBatchSize, const std::chrono::microseconds& maxLatency, const DeviceDescriptor& computeDevice)
+        : m_function(function),
+          m_maxBatchSize(maxBatchSize),
+          m_maxLatency(maxLatency),
+          m_computeDevice(computeDevice),
+          m_stopping(false)
+    {
+        if (!m_function)
+            InvalidArgument("BatchingEvaluator: The Function to evaluate is not allowed to be null.");
+
+        if (m_maxBatchSize == 0)
+            InvalidArgument("BatchingEvaluator: The maximum batch size must be > 0.");
+
+        if (m_maxLatency.count() < 0)
+            InvalidArgument("BatchingEvaluator: The maximum latency must not be negative.");
+
+        m_arguments = m_function->Arguments();
+        for (const auto& argument : m_arguments)
+        {
+            if (argument.DynamicAxes().empty())
+                InvalidArgument("BatchingEvaluator: Argument '%S' has no batch axis, so requests cannot be batched.", argument.AsString().c_str());
+        }
+        m_outputs = m_function->Outputs();
+
+        ResetStatistics();
+
+        m_worker = std::thread([this]() { Run(); });
+    }
+
+    BatchingEvaluatorImpl::~BatchingEvaluatorImpl()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_requestsAvailable.notify_all();
+        m_worker.join();
+    }
+
+    std::future<std::unordered_map<Variable, NDArrayViewPtr>> BatchingEvaluatorImpl::Evaluate(const std::unordered_map<Variable, NDArrayViewPtr>& arguments)
+    {
+        if (arguments.size() != m_arguments.size())
+            InvalidArgument("BatchingEvaluator: %d arguments were specified, but the Function has %d.", (int)arguments.size(), (int)m_arguments.size());
+
+        for (const auto& argument : m_arguments)
+        {
+            auto data = arguments.find(argument);
+            if (data == arguments.end() || !data->second)
+                InvalidArgument("BatchingEvaluator: No data was specified for argument '%S'.", argument.AsString().c_str());
+
+            if (data->second->Device() != DeviceDescriptor::CPUDevice())
+                InvalidArgument("BatchingEvaluator: The data for argument '%S' must be located on the CPU.", argument.AsString().c_str());
+
+            ValidateArgument(argument, data->second);
+        }
+
+        Request request;
+        request.m_arguments = arguments;
+        request.m_submitted = std::chrono::steady_clock::now();
+        auto result = request.m_result.get_future();
+
+        bool wakeWorker;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_stopping)
+                LogicError("BatchingEvaluator: Evaluate() called while the evaluator is being destroyed.");
+
+            m_queue.push_back(std::move(request));
+
+            auto& queueDepthHistogram = m_statistics.m_queueDepthHistogram;
+            queueDepthHistogram[std::min(m_queue.size(), queueDepthHistogram.size() - 1)]++;
+            m_statistics.m_numRequests++;
+
+            // The worker only needs to know when there is something to wait for, and when there is no reason to wait any longer.
+            wakeWorker = (m_queue.size() == 1) || (m_queue.size() == m_maxBatchSize);
+        }
+        if (wakeWorker)
+            m_requestsAvailable.notify_one();
+
+        return result;
+    }
+
+    BatchingEvaluatorStatistics BatchingEvaluatorImpl::Statistics() const
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    void BatchingEvaluatorImpl::ResetStatistics()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_statistics = BatchingEvaluatorStatistics();
+        m_statistics.m_batchSizeHistogram.resize(m_maxBatchSize + 1, 0);
+        // deeper queues are all counted in the last element
+        m_statistics.m_queueDepthHistogram.resize(4 * m_maxBatchSize + 1, 0);
+    }
+
+    /*static*/ void BatchingEvaluatorImpl::ValidateArgument(const Variable& argument, const NDArrayViewPtr& data)
+    {
+        if (data->GetDataType() != argument.GetDataType())
+            InvalidArgument("BatchingEvaluator: The data for argument '%S' has data type '%s', but the argument has '%s'.",
+                            argument.AsString().c_str(), DataTypeName(data->GetDataType()), DataTypeName(argument.GetDataType()));
+
+        // Same rules as Value::Create(), which forms the batch: the data is a sample, or a sequence of samples along the last axis.
+        const auto& sampleShape = argument.Shape();
+        auto dataShape = data->Shape();
+        if ((sampleShape.Rank() == 1) && !sampleShape.HasUnboundDimension() && (sampleShape.TotalSize() == 1) && (dataShape.Rank() > 0) && (dataShape[0] != 1))
+            dataShape = NDShape(1, 1).AppendShape(dataShape);
+
+        bool isCompatible = (dataShape.Rank() >= sampleShape.Rank()) && (dataShape.Rank() <= sampleShape.Rank() + 1);
+        for (size_t k = 0; isCompatible && (k < sampleShape.Rank()); k++)
+            isCompatible = (sampleShape[k] == NDShape::FreeDimension) || (sampleShape[k] == dataShape[k]);
+        if (!isCompatible)
+            InvalidArgument("BatchingEvaluator: The shape '%S' of the data for argument '%S' is not compatible with the argument's shape '%S'.",
+                            data->Shape().AsString().c_str(), argument.AsString().c_str(), sampleShape.AsString().c_str());
+
+        auto sequenceLength = dataShape.SubShape(sampleShape.Rank()).TotalSize();
+        if (sequenceLength == 0)
+            InvalidArgument("BatchingEvaluator: The data for argument '%S' is empty.", argument.AsString().c_str());
+
+        if ((argument.DynamicAxes().size() == 1) && (sequenceLength != 1))
+            InvalidArgument("BatchingEvaluator: Argument '%S' has no sequence axis, but its data '%S' has %d samples.",
+                            argument.AsString().c_str(), data->Shape().AsString().c_str(), (int)sequenceLength);
+    }
+
+    bool BatchingEvaluatorImpl::CanBatch(const Request& first, const Request& other) const
+    {
+        // All sequences of a Value share the storage format and the sample shape, which differs between requests for free dimensions.
+        for (const auto& argument : m_arguments)
+        {
+            const auto& firstData = first.m_arguments.at(argument);
+            const auto& otherData = other.m_arguments.at(argument);
+            if (firstData->GetStorageFormat() != otherData->GetStorageFormat())
+                return false;
+
+            const auto& sampleShape = argument.Shape();
+            if (sampleShape.HasFreeDimension() && (firstData->Shape().SubShape(0, sampleShape.Rank()) != otherData->Shape().SubShape(0, sampleShape.Rank())))
+                return false;
+        }
+        return true;
+    }
+
+    void BatchingEvaluatorImpl::Run()
+    {
+        for (;;)
+        {
+            std::vector<Request> batch;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_requestsAvailable.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+                if (m_queue.empty())
+                    return; // stopping, and all requests are done
+
+                // Wait for the batch to fill up, but not longer than the oldest request may wait.
+                auto deadline = m_queue.front().m_submitted + m_maxLatency;
+                m_requestsAvailable.wait_until(lock, deadline, [this]() { return m_stopping || m_queue.size() >= m_maxBatchSize; });
+
+                // A request that cannot join the batch starts the next one.
+                batch.reserve(std::min(m_queue.size(), m_maxBatchSize));
+                do
+                {
+                    batch.push_back(std::move(m_queue.front()));
+                    m_queue.pop_front();
+                } while ((batch.size() < m_maxBatchSize) && !m_queue.empty() && CanBatch(batch.front(), m_queue.front()));
+
+                m_statistics.m_batchSizeHistogram[batch.size()]++;
+                m_statistics.m_numBatches++;
+            }
+
+            EvaluateBatch(batch);
+        }
+    }
+
+    void BatchingEvaluatorImpl::EvaluateBatch(std::vector<Request>& batch)
+    {
+        std::vector<std::unordered_map<Variable, NDArrayViewPtr>> results(batch.size());
+        try
+        {
+            // Each request becomes one sequence of the batch.
+            std::unordered_map<Variable, ValuePtr> arguments;
+            std::vector<bool> sequenceStartFlags(batch.size(), true);
+            for (const auto& argument : m_arguments)
+            {
+                std::vector<NDArrayViewPtr> sequences;
+                sequences.reserve(batch.size());
+                for (const auto& request : batch)
+                    sequences.push_back(request.m_arguments.at(argument));
+
+                arguments[argument] = Value::Create(argument.Shape(), sequences, sequenceStartFlags, m_computeDevice, /*readOnly =*/ true, /*createNewCopy =*/ false);
+            }
+
+            std::unordered_map<Variable, ValuePtr> outputs;
+            for (const auto& output : m_outputs)
+                outputs[output] = nullptr;
+
+            m_function->Evaluate(arguments, outputs, m_computeDevice);
+
+            // The output values refer to memory of the network, which is overwritten by the next batch, so each request gets a copy.
+            for (const auto& output : outputs)
+            {
+                std::vector<NDArrayViewPtr> sequences;
+                if (output.first.GetDataType() == DataType::Float)
+                    sequences = CopySequences<float>(output.second, output.first);
+                else if (output.first.GetDataType() == DataType::Double)
+                    sequences = CopySequences<double>(output.second, output.first);
+                else
+                    LogicError("BatchingEvaluator: Unsupported DataType %s of the output '%S'.", DataTypeName(output.first.GetDataType()), output.first.AsString().c_str());
+
+                if (sequences.size() != batch.size())
+                    LogicError("BatchingEvaluator: The output '%S' has %d sequences for a batch of %d requests.", output.first.AsString().c_str(), (int)sequences.size(), (int)batch.size());
+
+                for (size_t i = 0; i < batch.size(); i++)
+                    results[i][output.first] = sequences[i];
+            }
+        }
+        catch (...)
+        {
+            for (auto& request : batch)
+                request.m_result.set_exception(std::current_exception());
+            return;
+        }
+
+        for (size_t i = 0; i < batch.size(); i++)
+            batch[i].m_result.set_value(std::move(results[i]));
+    }
+}
@@ -0,0 +1,66 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma once
+
+#include "stdafx.h"
+#include "CNTKLibrary.h"
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace CNTK
+{
+    // Queues the requests, and evaluates them on a dedicated worker thread, which forms the batches.
+    class BatchingEvaluatorImpl final : public BatchingEvaluator
+    {
+    public:
+        BatchingEvaluatorImpl(const FunctionPtr& function, size_t maxBatchSize, const std::chrono::microseconds& maxLatency, const DeviceDescriptor& computeDevice);
+
+        ~BatchingEvaluatorImpl();
+
+        std::future<std::unordered_map<Variable, NDArrayViewPtr>> Evaluate(const std::unordered_map<Variable, NDArrayViewPtr>& arguments) override;
+
+        BatchingEvaluatorStatistics Statistics() const override;
+
+        void ResetStatistics() override;
+
+    private:
+        struct Request
+        {
+            std::unordered_map<Variable, NDArrayViewPtr> m_arguments;
+            std::promise<std::unordered_map<Variable, NDArrayViewPtr>> m_result;
+            std::chrono::steady_clock::time_point m_submitted;
+        };
+
+        // Checks the data of a request for an argument, so that a bad request is rejected on its own when it is submitted.
+        static void ValidateArgument(const Variable& argument, const NDArrayViewPtr& data);
+
+        // Whether two requests can be evaluated in the same batch.
+        bool CanBatch(const Request& first, const Request& other) const;
+
+        // Main loop of the worker thread.
+        void Run();
+
+        // Evaluates the requests by a single forward pass, and delivers the results.
+        void EvaluateBatch(std::vector<Request>& batch);
+
+        FunctionPtr m_function;
+        std::vector<Variable> m_arguments;
+        std::vector<Variable> m_outputs;
+        const size_t m_maxBatchSize;
+        const std::chrono::microseconds m_maxLatency;
+        const DeviceDescriptor m_computeDevice;
+
+        // Everything below is protected by m_mutex.
+        mutable std::mutex m_mutex;
+        std::condition_variable m_requestsAvailable;
+        std::deque<Request> m_queue;
+        bool m_stopping;
+        BatchingEvaluatorStatistics m_statistics;
+
+        std::thread m_worker;
+    };
+}
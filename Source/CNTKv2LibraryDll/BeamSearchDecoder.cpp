@@ -0,0 +1,616 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include "BeamSearchDecoder.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace CNTK
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        double SecondsSince(const Clock::time_point& start)
+        {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        double LogAdd(double a, double b)
+        {
+            if (a < b)
+                std::swap(a, b);
+            if (b == -std::numeric_limits<double>::infinity())
+                return a;
+            return a + log1p(exp(b - a));
+        }
+
+        // Finds the k best scores, and returns them best first together with their indices.
+        // The scores are log-probabilities, so after the first few blocks hardly any block contains a score that beats the
+        // k-th best score found so far. Each block is therefore first reduced to its maximum by a branch-free loop, which
+        // the compiler vectorizes, and only the blocks that beat the threshold are inspected element by element.
+        template <typename ElementType>
+        void TopK(const ElementType* scores, size_t dimension, size_t k, std::vector<std::pair<ElementType, size_t>>& result)
+        {
+            const size_t blockSize = 16;
+            auto better = [](const std::pair<ElementType, size_t>& a, const std::pair<ElementType, size_t>& b) { return a.first > b.first; };
+
+            // 'result' is a heap with the worst of the best k scores on top.
+            result.clear();
+            k = std::min(k, dimension);
+            for (size_t begin = 0; begin < dimension; begin += blockSize)
+            {
+                size_t end = std::min(begin + blockSize, dimension);
+                if (result.size() == k)
+                {
+                    ElementType blockMax = scores[begin];
+                    for (size_t i = begin + 1; i < end; i++)
+                        blockMax = (scores[i] > blockMax) ? scores[i] : blockMax;
+
+                    if (!(blockMax > result.front().first))
+                        continue;
+                }
+
+                for (size_t i = begin; i < end; i++)
+                {
+                    if (result.size() < k)
+                    {
+                        result.emplace_back(scores[i], i);
+                        std::push_heap(result.begin(), result.end(), better);
+                    }
+                    else if (scores[i] > result.front().first)
+                    {
+                        std::pop_heap(result.begin(), result.end(), better);
+                        result.back() = std::make_pair(scores[i], i);
+                        std::push_heap(result.begin(), result.end(), better);
+                    }
+                }
+            }
+            std::sort_heap(result.begin(), result.end(), better);
+        }
+
+        bool IsBatchOnly(const Variable& variable)
+        {
+            return (variable.DynamicAxes().size() == 1) && (variable.DynamicAxes()[0] == Axis::DefaultBatchAxis());
+        }
+
+        size_t NumSamples(const NDArrayViewPtr& data)
+        {
+            return data->Shape()[data->Shape().Rank() - 1];
+        }
+
+        NDArrayViewPtr ToCPU(const NDArrayViewPtr& data)
+        {
+            if (data->Device() == DeviceDescriptor::CPUDevice())
+                return data;
+            return data->DeepClone(DeviceDescriptor::CPUDevice(), /*readOnly =*/ true);
+        }
+    }
+
+    BeamSearchDecoderPtr CreateBeamSearchDecoder(const FunctionPtr& stepFunction,
+                                                 const Variable& tokenInput,
+                                                 const Variable& scoresOutput,
+                                                 const std::unordered_map<Variable, Variable>& stateInputToOutput,
+                                                 size_t startToken,
+                                                 size_t endToken,
+                                                 size_t beamWidth,
+                                                 size_t maxLength,
+                                                 const DeviceDescriptor& computeDevice)
+    {
+        return MakeSharedObject<BeamSearchDecoderImpl>(stepFunction, tokenInput, scoresOutput, stateInputToOutput, startToken, endToken, beamWidth, maxLength, computeDevice);
+    }
+
+    BeamSearchDecoderImpl::BeamSearchDecoderImpl(const FunctionPtr& stepFunction,
+                                                 const Variable& tokenInput,
+                                                 const Variable& scoresOutput,
+                                                 const std::unordered_map<Variable, Variable>& stateInputToOutput,
+                                                 size_t startToken,
+                                                 size_t endToken,
+                                                 size_t beamWidth,
+                                                 size_t maxLength,
+                                                 const DeviceDescriptor& computeDevice)
+        : m_stepFunction(stepFunction),
+          m_tokenInput(tokenInput),
+          m_scoresOutput(scoresOutput),
+          m_stateInputToOutput(stateInputToOutput),
+          m_vocabularySize(tokenInput.Shape().TotalSize()),
+          m_startToken(startToken),
+          m_endToken(endToken),
+          m_beamWidth(beamWidth),
+          m_maxLength(maxLength),
+          m_computeDevice(computeDevice)
+    {
+        if (!m_stepFunction)
+            InvalidArgument("BeamSearchDecoder: The step Function is not allowed to be null.");
+
+        if (m_beamWidth == 0)
+            InvalidArgument("BeamSearchDecoder: The beam width must be > 0.");
+
+        if (m_maxLength == 0)
+            InvalidArgument("BeamSearchDecoder: The maximum length must be > 0.");
+
+        if (m_startToken >= m_vocabularySize || m_endToken >= m_vocabularySize)
+            InvalidArgument("BeamSearchDecoder: The start and end tokens must be smaller than the dimension %d of the token input.", (int)m_vocabularySize);
+
+        if (m_scoresOutput.Shape().TotalSize() != m_vocabularySize)
+            InvalidArgument("BeamSearchDecoder: The scores output '%S' must have the same dimension as the token input '%S'.", m_scoresOutput.AsString().c_str(), m_tokenInput.AsString().c_str());
+
+        auto dataType = m_scoresOutput.GetDataType();
+        if (dataType != DataType::Float && dataType != DataType::Double)
+            InvalidArgument("BeamSearchDecoder: The scores output '%S' must be of type float or double.", m_scoresOutput.AsString().c_str());
+
+        if (m_tokenInput.GetDataType() != dataType)
+            InvalidArgument("BeamSearchDecoder: The token input '%S' must have the data type of the scores output.", m_tokenInput.AsString().c_str());
+
+        auto arguments = m_stepFunction->Arguments();
+        auto outputs = m_stepFunction->Outputs();
+        auto isArgument = [&arguments](const Variable& v) { return std::find(arguments.begin(), arguments.end(), v) != arguments.end(); };
+        auto isOutput = [&outputs](const Variable& v) { return std::find(outputs.begin(), outputs.end(), v) != outputs.end(); };
+
+        if (!isArgument(m_tokenInput))
+            InvalidArgument("BeamSearchDecoder: The token input '%S' is not an argument of the step Function.", m_tokenInput.AsString().c_str());
+
+        if (!isOutput(m_scoresOutput))
+            InvalidArgument("BeamSearchDecoder: The scores output '%S' is not an output of the step Function.", m_scoresOutput.AsString().c_str());
+
+        for (const auto& state : m_stateInputToOutput)
+        {
+            if (!isArgument(state.first))
+                InvalidArgument("BeamSearchDecoder: The state input '%S' is not an argument of the step Function.", state.first.AsString().c_str());
+
+            if (!isOutput(state.second))
+                InvalidArgument("BeamSearchDecoder: The state output '%S' is not an output of the step Function.", state.second.AsString().c_str());
+
+            if (state.first.Shape() != state.second.Shape())
+                InvalidArgument("BeamSearchDecoder: The state input '%S' and output '%S' must have the same shape.", state.first.AsString().c_str(), state.second.AsString().c_str());
+        }
+
+        for (const auto& argument : arguments)
+        {
+            if (!IsBatchOnly(argument))
+                InvalidArgument("BeamSearchDecoder: Argument '%S' of the step Function must have the batch axis as its only dynamic axis.", argument.AsString().c_str());
+        }
+
+        ResetStatistics();
+    }
+
+    BeamSearchDecoderStatistics BeamSearchDecoderImpl::Statistics() const
+    {
+        return m_statistics;
+    }
+
+    void BeamSearchDecoderImpl::ResetStatistics()
+    {
+        m_statistics = BeamSearchDecoderStatistics();
+    }
+
+    std::vector<std::vector<DecodingHypothesis>> BeamSearchDecoderImpl::Decode(const std::unordered_map<Variable, ValuePtr>& arguments, size_t nBest)
+    {
+        if (nBest == 0)
+            InvalidArgument("BeamSearchDecoder: The number of hypotheses to return must be > 0.");
+
+        if (m_scoresOutput.GetDataType() == DataType::Float)
+            return Search<float>(arguments, nBest);
+        else
+            return Search<double>(arguments, nBest);
+    }
+
+    template <typename ElementType>
+    std::vector<std::vector<DecodingHypothesis>> BeamSearchDecoderImpl::Search(const std::unordered_map<Variable, ValuePtr>& arguments, size_t nBest)
+    {
+        // The state and context of the hypotheses, on the compute device.
+        std::unordered_map<Variable, NDArrayViewPtr> inputs;
+        std::unordered_map<Variable, NDArrayViewPtr> contextPerSequence;
+        size_t numSequences = SIZE_MAX;
+        for (const auto& argument : m_stepFunction->Arguments())
+        {
+            if (argument == m_tokenInput)
+                continue;
+
+            auto value = arguments.find(argument);
+            if (value == arguments.end() || !value->second)
+                InvalidArgument("BeamSearchDecoder: No value was specified for argument '%S'.", argument.AsString().c_str());
+
+            auto data = value->second->Data();
+            if (data->IsSparse())
+                InvalidArgument("BeamSearchDecoder: The value of argument '%S' must be dense.", argument.AsString().c_str());
+
+            if (data->Device() != m_computeDevice)
+                data = data->DeepClone(m_computeDevice, /*readOnly =*/ true);
+
+            if (numSequences == SIZE_MAX)
+                numSequences = NumSamples(data);
+            else if (NumSamples(data) != numSequences)
+                InvalidArgument("BeamSearchDecoder: The value of argument '%S' has %d samples, but other arguments have %d.", argument.AsString().c_str(), (int)NumSamples(data), (int)numSequences);
+
+            inputs[argument] = data;
+            if (m_stateInputToOutput.find(argument) == m_stateInputToOutput.end())
+                contextPerSequence[argument] = data;
+        }
+        if (numSequences == SIZE_MAX)
+            InvalidArgument("BeamSearchDecoder: The step Function has no argument other than the token input, so the number of sequences to decode is unknown.");
+
+        std::vector<std::vector<DecodingHypothesis>> results(numSequences);
+        std::vector<Hypothesis> live;
+        live.reserve(numSequences * m_beamWidth);
+        for (size_t i = 0; i < numSequences; i++)
+            live.push_back(Hypothesis{ i, {}, 0.0 });
+
+        struct Candidate
+        {
+            size_t m_parent;
+            size_t m_token;
+            double m_logProbability;
+        };
+        std::vector<std::vector<std::pair<ElementType, size_t>>> topTokens;
+        std::vector<Candidate> candidates;
+        std::vector<Hypothesis> nextLive;
+        std::vector<size_t> parents;
+        std::vector<size_t> sequences;
+        bool contextIsCurrent = true;
+
+        auto finishedIsBetter = [](const DecodingHypothesis& a, const DecodingHypothesis& b) { return a.m_logProbability > b.m_logProbability; };
+
+        for (size_t step = 0; step < m_maxLength && !live.empty(); step++)
+        {
+            auto evaluationStart = Clock::now();
+
+            if (!contextIsCurrent)
+            {
+                sequences.clear();
+                for (const auto& hypothesis : live)
+                    sequences.push_back(hypothesis.m_sequence);
+
+                for (const auto& context : contextPerSequence)
+                    inputs[context.first] = Gather(context.second, sequences);
+            }
+
+            std::unordered_map<Variable, ValuePtr> stepArguments;
+            stepArguments[m_tokenInput] = CreateTokenValue<ElementType>(live);
+            for (const auto& input : inputs)
+                stepArguments[input.first] = MakeSharedObject<Value>(input.second);
+
+            std::unordered_map<Variable, ValuePtr> stepOutputs;
+            stepOutputs[m_scoresOutput] = nullptr;
+            for (const auto& state : m_stateInputToOutput)
+                stepOutputs[state.second] = nullptr;
+
+            m_stepFunction->Evaluate(stepArguments, stepOutputs, m_computeDevice);
+
+            m_statistics.m_numSteps++;
+            m_statistics.m_numHypothesisSteps += live.size();
+            m_statistics.m_evaluationSeconds += SecondsSince(evaluationStart);
+            auto searchStart = Clock::now();
+
+            // Only the scores go to the CPU.
+            auto scores = ToCPU(stepOutputs[m_scoresOutput]->Data());
+            if (scores->Shape().TotalSize() != live.size() * m_vocabularySize)
+                LogicError("BeamSearchDecoder: The scores output has %d elements for %d hypotheses.", (int)scores->Shape().TotalSize(), (int)live.size());
+
+            const ElementType* scoreBuffer = scores->DataBuffer<ElementType>();
+
+            // A hypothesis can contribute at most one finished candidate, so k + 1 tokens per hypothesis are enough to
+            // find the k best live extensions of the sequence.
+            topTokens.resize(live.size());
+            for (size_t h = 0; h < live.size(); h++)
+                TopK(scoreBuffer + h * m_vocabularySize, m_vocabularySize, m_beamWidth + 1, topTokens[h]);
+
+            nextLive.clear();
+            parents.clear();
+            for (size_t begin = 0, end; begin < live.size(); begin = end)
+            {
+                size_t sequence = live[begin].m_sequence;
+                for (end = begin; end < live.size() && live[end].m_sequence == sequence; end++);
+
+                candidates.clear();
+                for (size_t h = begin; h < end; h++)
+                {
+                    for (const auto& token : topTokens[h])
+                        candidates.push_back(Candidate{ h, token.second, live[h].m_logProbability + token.first });
+                }
+                std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.m_logProbability > b.m_logProbability; });
+
+                auto& finished = results[sequence];
+                size_t numSelected = 0;
+                for (const auto& candidate : candidates)
+                {
+                    if (numSelected == m_beamWidth)
+                        break;
+
+                    if (candidate.m_token == m_endToken)
+                    {
+                        DecodingHypothesis hypothesis;
+                        hypothesis.m_tokens = live[candidate.m_parent].m_tokens;
+                        hypothesis.m_tokens.push_back(m_endToken);
+                        hypothesis.m_logProbability = candidate.m_logProbability;
+                        hypothesis.m_finished = true;
+                        finished.push_back(std::move(hypothesis));
+                    }
+                    else
+                    {
+                        candidates[numSelected++] = candidate;
+                    }
+                }
+
+                std::sort(finished.begin(), finished.end(), finishedIsBetter);
+                if (finished.size() > nBest)
+                    finished.resize(nBest);
+
+                // Scores only decrease as hypotheses grow, so the sequence is done once no live hypothesis can beat the n-th best finished one.
+                if (finished.size() == nBest && (numSelected == 0 || candidates[0].m_logProbability <= finished.back().m_logProbability))
+                    continue;
+
+                // Ordering the survivors by parent lets Gather() copy runs of consecutive samples.
+                std::sort(candidates.begin(), candidates.begin() + numSelected, [](const Candidate& a, const Candidate& b) { return a.m_parent < b.m_parent; });
+                for (size_t i = 0; i < numSelected; i++)
+                {
+                    const auto& parent = live[candidates[i].m_parent];
+                    Hypothesis hypothesis{ sequence, parent.m_tokens, candidates[i].m_logProbability };
+                    hypothesis.m_tokens.push_back(candidates[i].m_token);
+                    nextLive.push_back(std::move(hypothesis));
+                    parents.push_back(candidates[i].m_parent);
+                }
+            }
+
+            // The context only has to be gathered again when the number of hypotheses of some sequence has changed.
+            contextIsCurrent = (nextLive.size() == live.size());
+            for (size_t i = 0; contextIsCurrent && i < live.size(); i++)
+                contextIsCurrent = (nextLive[i].m_sequence == live[i].m_sequence);
+
+            if (!nextLive.empty())
+            {
+                for (const auto& state : m_stateInputToOutput)
+                    inputs[state.first] = Gather(stepOutputs[state.second]->Data(), parents);
+            }
+
+            live.swap(nextLive);
+            m_statistics.m_searchSeconds += SecondsSince(searchStart);
+        }
+
+        // Sequences that reached the maximum length are filled up with their best unfinished hypotheses.
+        for (auto& hypothesis : live)
+        {
+            auto& finished = results[hypothesis.m_sequence];
+            if (std::count_if(finished.begin(), finished.end(), [](const DecodingHypothesis& h) { return h.m_finished; }) == (ptrdiff_t)nBest)
+                continue;
+
+            DecodingHypothesis unfinished;
+            unfinished.m_tokens = std::move(hypothesis.m_tokens);
+            unfinished.m_logProbability = hypothesis.m_logProbability;
+            unfinished.m_finished = false;
+            finished.push_back(std::move(unfinished));
+        }
+
+        for (auto& finished : results)
+        {
+            std::stable_sort(finished.begin(), finished.end(), finishedIsBetter);
+            if (finished.size() > nBest)
+                finished.resize(nBest);
+        }
+
+        m_statistics.m_numSequences += numSequences;
+        return results;
+    }
+
+    template <typename ElementType>
+    ValuePtr BeamSearchDecoderImpl::CreateTokenValue(const std::vector<Hypothesis>& hypotheses) const
+    {
+        size_t numSamples = hypotheses.size();
+        auto shape = m_tokenInput.Shape().AppendShape({ numSamples });
+        auto lastToken = [this](const Hypothesis& hypothesis) { return hypothesis.m_tokens.empty() ? m_startToken : hypothesis.m_tokens.back(); };
+
+        NDArrayViewPtr data;
+        if (m_tokenInput.IsSparse())
+        {
+            std::vector<SparseIndexType> colStarts(numSamples + 1);
+            std::vector<SparseIndexType> rowIndices(numSamples);
+            std::vector<ElementType> nonZeroValues(numSamples, 1);
+            for (size_t i = 0; i < numSamples; i++)
+            {
+                colStarts[i] = (SparseIndexType)i;
+                rowIndices[i] = (SparseIndexType)lastToken(hypotheses[i]);
+            }
+            colStarts[numSamples] = (SparseIndexType)numSamples;
+
+            data = MakeSharedObject<NDArrayView>(shape, colStarts.data(), rowIndices.data(), nonZeroValues.data(), numSamples, m_computeDevice, /*readOnly =*/ true);
+        }
+        else
+        {
+            std::vector<ElementType> buffer(numSamples * m_vocabularySize, 0);
+            for (size_t i = 0; i < numSamples; i++)
+                buffer[i * m_vocabularySize + lastToken(hypotheses[i])] = 1;
+
+            NDArrayView cpuData(shape, buffer.data(), buffer.size(), DeviceDescriptor::CPUDevice(), /*readOnly =*/ true);
+            data = cpuData.DeepClone(m_computeDevice, /*readOnly =*/ true);
+        }
+
+        return MakeSharedObject<Value>(data);
+    }
+
+    NDArrayViewPtr BeamSearchDecoderImpl::Gather(const NDArrayViewPtr& data, const std::vector<size_t>& sources) const
+    {
+        const auto& shape = data->Shape();
+        size_t lastAxis = shape.Rank() - 1;
+        auto result = MakeSharedObject<NDArrayView>(data->GetDataType(), shape.SubShape(0, lastAxis).AppendShape({ sources.size() }), m_computeDevice);
+
+        std::vector<size_t> sourceOffset(shape.Rank(), 0);
+        std::vector<size_t> resultOffset(shape.Rank(), 0);
+        std::vector<size_t> extent = shape.Dimensions();
+        for (size_t begin = 0, end; begin < sources.size(); begin = end)
+        {
+            for (end = begin + 1; end < sources.size() && sources[end] == sources[end - 1] + 1; end++);
+
+            sourceOffset[lastAxis] = sources[begin];
+            resultOffset[lastAxis] = begin;
+            extent[lastAxis] = end - begin;
+            result->SliceView(resultOffset, extent)->CopyFrom(*data->SliceView(sourceOffset, extent, /*readOnly =*/ true));
+        }
+
+        return result;
+    }
+
+    namespace
+    {
+        // A label sequence of CTC prefix beam search, with the log-probabilities of all paths that collapse to it and end
+        // with a blank, and of those that end with its last label.
+        struct Prefix
+        {
+            std::vector<size_t> m_tokens;
+            double m_blank;
+            double m_nonBlank;
+
+            double LogProbability() const { return LogAdd(m_blank, m_nonBlank); }
+        };
+
+        struct TokensHash
+        {
+            size_t operator()(const std::vector<size_t>& tokens) const
+            {
+                size_t hash = tokens.size();
+                for (auto token : tokens)
+                    hash = hash * 31 + token;
+                return hash;
+            }
+        };
+
+        template <typename ElementType>
+        std::vector<DecodingHypothesis> CTCPrefixBeamSearch(const ElementType* logProbabilities, size_t numFrames, size_t dimension, size_t blankToken, size_t beamWidth, size_t nBest)
+        {
+            const double minusInfinity = -std::numeric_limits<double>::infinity();
+
+            std::vector<Prefix> beam(1, Prefix{ {}, 0.0, minusInfinity });
+            std::vector<Prefix> next;
+            std::unordered_map<std::vector<size_t>, size_t, TokensHash> nextIndex;
+            std::vector<std::pair<ElementType, size_t>> topTokens;
+
+            auto extend = [&](std::vector<size_t>&& tokens) -> Prefix&
+            {
+                auto index = nextIndex.find(tokens);
+                if (index != nextIndex.end())
+                    return next[index->second];
+
+                nextIndex.emplace(tokens, next.size());
+                next.push_back(Prefix{ std::move(tokens), minusInfinity, minusInfinity });
+                return next.back();
+            };
+
+            for (size_t t = 0; t < numFrames; t++)
+            {
+                const ElementType* frame = logProbabilities + t * dimension;
+
+                // Only the best beamWidth labels of the frame extend the prefixes.
+                TopK(frame, dimension, beamWidth, topTokens);
+
+                next.clear();
+                nextIndex.clear();
+                for (const auto& prefix : beam)
+                {
+                    double total = prefix.LogProbability();
+
+                    auto& same = extend(std::vector<size_t>(prefix.m_tokens));
+                    same.m_blank = LogAdd(same.m_blank, total + frame[blankToken]);
+
+                    // A repeated label without a blank in between collapses into the same prefix.
+                    if (!prefix.m_tokens.empty())
+                        same.m_nonBlank = LogAdd(same.m_nonBlank, prefix.m_nonBlank + frame[prefix.m_tokens.back()]);
+
+                    for (const auto& token : topTokens)
+                    {
+                        if (token.second == blankToken)
+                            continue;
+
+                        std::vector<size_t> tokens(prefix.m_tokens);
+                        tokens.push_back(token.second);
+                        double extension = (!prefix.m_tokens.empty() && prefix.m_tokens.back() == token.second) ? prefix.m_blank : total;
+
+                        auto& extended = extend(std::move(tokens));
+                        extended.m_nonBlank = LogAdd(extended.m_nonBlank, extension + token.first);
+                    }
+                }
+
+                auto isBetter = [](const Prefix& a, const Prefix& b) { return a.LogProbability() > b.LogProbability(); };
+                if (next.size() > beamWidth)
+                {
+                    std::partial_sort(next.begin(), next.begin() + beamWidth, next.end(), isBetter);
+                    next.resize(beamWidth);
+                }
+                beam.swap(next);
+            }
+
+            std::sort(beam.begin(), beam.end(), [](const Prefix& a, const Prefix& b) { return a.LogProbability() > b.LogProbability(); });
+            std::vector<DecodingHypothesis> result;
+            for (size_t i = 0; i < beam.size() && i < nBest; i++)
+            {
+                DecodingHypothesis hypothesis;
+                hypothesis.m_tokens = std::move(beam[i].m_tokens);
+                hypothesis.m_logProbability = beam[i].LogProbability();
+                hypothesis.m_finished = true;
+                result.push_back(std::move(hypothesis));
+            }
+            return result;
+        }
+
+        template <typename ElementType>
+        std::vector<std::vector<DecodingHypothesis>> CTCBeamSearchDecode(const NDArrayViewPtr& data, const NDMaskPtr& mask, size_t blankToken, size_t beamWidth, size_t nBest)
+        {
+            const auto& shape = data->Shape();
+            size_t numSequences = shape[shape.Rank() - 1];
+            size_t maxNumFrames = shape[shape.Rank() - 2];
+            size_t dimension = shape.SubShape(0, shape.Rank() - 2).TotalSize();
+            if (blankToken >= dimension)
+                InvalidArgument("CTCBeamSearchDecode: The blank token %d is out of range for dimension %d.", (int)blankToken, (int)dimension);
+
+            const ElementType* buffer = data->DataBuffer<ElementType>();
+            const MaskKind* maskBuffer = mask ? mask->DataBuffer() : nullptr;
+
+            std::vector<std::vector<DecodingHypothesis>> results(numSequences);
+            for (size_t s = 0; s < numSequences; s++)
+            {
+                // Sequences are padded at the end.
+                size_t numFrames = maxNumFrames;
+                if (maskBuffer)
+                {
+                    for (numFrames = 0; numFrames < maxNumFrames && maskBuffer[s * maxNumFrames + numFrames] != MaskKind::Invalid; numFrames++);
+                }
+
+                results[s] = CTCPrefixBeamSearch(buffer + s * maxNumFrames * dimension, numFrames, dimension, blankToken, beamWidth, nBest);
+            }
+            return results;
+        }
+    }
+
+    std::vector<std::vector<DecodingHypothesis>> CTCBeamSearchDecode(const ValuePtr& logProbabilities, size_t blankToken, size_t beamWidth, size_t nBest)
+    {
+        if (!logProbabilities)
+            InvalidArgument("CTCBeamSearchDecode: The log-probabilities are not allowed to be null.");
+
+        if (beamWidth == 0 || nBest == 0)
+            InvalidArgument("CTCBeamSearchDecode: The beam width and the number of hypotheses to return must be > 0.");
+
+        auto data = logProbabilities->Data();
+        if (data->IsSparse())
+            InvalidArgument("CTCBeamSearchDecode: The log-probabilities must be dense.");
+
+        if (data->Shape().Rank() < 3)
+            InvalidArgument("CTCBeamSearchDecode: The log-probabilities must have a sequence and a batch axis, but their shape is '%S'.", data->Shape().AsString().c_str());
+
+        data = ToCPU(data);
+        auto mask = logProbabilities->Mask();
+        if (mask && mask->Device() != DeviceDescriptor::CPUDevice())
+            mask = mask->DeepClone(DeviceDescriptor::CPUDevice());
+
+        switch (data->GetDataType())
+        {
+        case DataType::Float:
+            return CTCBeamSearchDecode<float>(data, mask, blankToken, beamWidth, nBest);
+        case DataType::Double:
+            return CTCBeamSearchDecode<double>(data, mask, blankToken, beamWidth, nBest);
+        default:
+            InvalidArgument("CTCBeamSearchDecode: The log-probabilities must be of type float or double.");
+        }
+    }
+}
@@ -0,0 +1,65 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma once
+
+#include "stdafx.h"
+#include "CNTKLibrary.h"
+
+namespace CNTK
+{
+    // Keeps the live hypotheses of all sequences in the batch of a single step Function evaluation, grouped by sequence.
+    // After each step, the state of the surviving hypotheses is gathered from the state outputs on the compute device.
+    class BeamSearchDecoderImpl final : public BeamSearchDecoder
+    {
+    public:
+        BeamSearchDecoderImpl(const FunctionPtr& stepFunction,
+                              const Variable& tokenInput,
+                              const Variable& scoresOutput,
+                              const std::unordered_map<Variable, Variable>& stateInputToOutput,
+                              size_t startToken,
+                              size_t endToken,
+                              size_t beamWidth,
+                              size_t maxLength,
+                              const DeviceDescriptor& computeDevice);
+
+        std::vector<std::vector<DecodingHypothesis>> Decode(const std::unordered_map<Variable, ValuePtr>& arguments, size_t nBest) override;
+
+        BeamSearchDecoderStatistics Statistics() const override;
+
+        void ResetStatistics() override;
+
+    private:
+        struct Hypothesis
+        {
+            size_t m_sequence;
+            std::vector<size_t> m_tokens;
+            double m_logProbability;
+        };
+
+        template <typename ElementType>
+        std::vector<std::vector<DecodingHypothesis>> Search(const std::unordered_map<Variable, ValuePtr>& arguments, size_t nBest);
+
+        // Creates the value of the token input, with the last token of every hypothesis as a one-hot sample.
+        template <typename ElementType>
+        ValuePtr CreateTokenValue(const std::vector<Hypothesis>& hypotheses) const;
+
+        // Returns a new array on the compute device, whose i-th sample (along the last axis) is the sample sources[i] of 'data'.
+        NDArrayViewPtr Gather(const NDArrayViewPtr& data, const std::vector<size_t>& sources) const;
+
+        FunctionPtr m_stepFunction;
+        Variable m_tokenInput;
+        Variable m_scoresOutput;
+        std::unordered_map<Variable, Variable> m_stateInputToOutput;
+        const size_t m_vocabularySize;
+        const size_t m_startToken;
+        const size_t m_endToken;
+        const size_t m_beamWidth;
+        const size_t m_maxLength;
+        const DeviceDescriptor m_computeDevice;
+
+        BeamSearchDecoderStatistics m_statistics;
+    };
+}
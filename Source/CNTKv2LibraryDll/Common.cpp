@@ -171,7 +171,24 @@ namespace CNTK
             Microsoft::MSR::CNTK::Globals::SetGradientAccumulationOptimization(/* enable = */ false);
         }
 
-        void StartProfiler(const wstring& profilerDir, bool profilerSyncGpu, size_t profilerBufferSize)
+        void EnableDirectConvolution()
+        {
+            Microsoft::MSR::CNTK::Globals::SetDirectConvolution(/* enable = */ true);
+        }
+
+        void DisableDirectConvolution()
+        {
+            Microsoft::MSR::CNTK::Globals::SetDirectConvolution(/* enable = */ false);
+        }
+
+        void SetInterOpParallelism(size_t numThreads, unsigned long scheduleSeed)
+        {
+            if (numThreads == 0)
+                InvalidArgument("SetInterOpParallelism: The number of threads must be positive.");
+            Microsoft::MSR::CNTK::Globals::SetInterOpParallelism(numThreads, scheduleSeed);
+        }
+
+        void StartProfiler(const wstring& profilerDir, bool profilerSyncGpu, size_t profilerBufferSize, bool profileNodes)
         {
 #ifndef CNTK_UWP
             std::wstring logSuffix = L"";
@@ -185,7 +202,8 @@ namespace CNTK
                 profilerDir,
                 profilerBufferSize,
                 logSuffix,
-                profilerSyncGpu);
+                profilerSyncGpu,
+                profileNodes);
 #endif
         }
 
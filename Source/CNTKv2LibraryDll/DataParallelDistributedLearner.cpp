@@ -115,14 +115,189 @@ namespace CNTK
     }
 
     DataParallelDistributedLearner::DataParallelDistributedLearner(DistributedCommunicatorPtr communicator, LearnerPtr learner, size_t distributedAfterSamples, bool useAsyncBufferedParameterUpdate)
-        : DistributedLearnerBase(communicator, learner, distributedAfterSamples, !Internal::ShouldUseSparseGradientAggregationInDataParallelSGD())
+        : DistributedLearnerBase(communicator, learner, distributedAfterSamples, !Internal::ShouldUseSparseGradientAggregationInDataParallelSGD()),
+          m_useAsyncBufferedParameterUpdate(useAsyncBufferedParameterUpdate),
+          m_bufferedAtEndOfSweep(false),
+          m_hasPendingAggregation(false),
+          m_totalAggregationSeconds(0),
+          m_totalWaitSeconds(0)
     {
-        if (useAsyncBufferedParameterUpdate)
-            LogicError("Asynchronous parameter update is not yet supported for the DataParallelDistributedLearner.");
+        if (m_useAsyncBufferedParameterUpdate)
+        {
+            m_asyncCommunicator = std::dynamic_pointer_cast<MPICommunicatorImpl>(communicator);
+            if (!m_asyncCommunicator)
+                InvalidArgument("Asynchronous parameter update of the DataParallelDistributedLearner requires an MPI communicator.");
+        }
+    }
+
+    DataParallelDistributedLearner::~DataParallelDistributedLearner()
+    {
+        try
+        {
+            // Training may stop without an empty minibatch or a checkpoint, e.g. after a fixed number of minibatches.
+            // The parameters are shared with the model, so it still gets the last minibatch.
+            ApplyPendingGradients();
+        }
+        catch (...)
+        {
+            // Destructors must not throw.
+        }
+    }
+
+    Dictionary DataParallelDistributedLearner::CreateCheckpoint()
+    {
+        // Apply the gradients that are still in flight, so that the checkpointed parameters and learner state
+        // include every minibatch seen so far.
+        ApplyPendingGradients();
+
+        return DistributedLearnerBase::CreateCheckpoint();
+    }
+
+    void DataParallelDistributedLearner::RestoreFromCheckpoint(const Dictionary& checkpoint)
+    {
+        // Gradients in flight were computed for the parameters being replaced, drop them.
+        WaitForBufferedAggregation();
+        DistributedLearnerBase::RestoreFromCheckpoint(checkpoint);
+    }
+
+    void DataParallelDistributedLearner::WaitForBufferedAggregation()
+    {
+        if (!m_hasPendingAggregation)
+            return;
+
+        m_hasPendingAggregation = false;
+        m_asyncCommunicator->WaitForPendingAggregation();
+    }
+
+    void DataParallelDistributedLearner::ApplyPendingGradients()
+    {
+        if (!m_hasPendingAggregation)
+            return;
+
+        WaitForBufferedAggregation();
+        ApplyBufferedGradients();
+    }
+
+    bool DataParallelDistributedLearner::ApplyBufferedGradients()
+    {
+#ifndef  CNTK_UWP
+        auto profWeights = Microsoft::MSR::CNTK::ScopeProfile(Microsoft::MSR::CNTK::profilerEvtMainWeights);
+#endif
+
+        auto numberOfSamples = static_cast<size_t>(*m_bufferedNumberOfSamples->DataBuffer<double>());
+        m_sampleCount += numberOfSamples;
+
+        if (numberOfSamples == 0)
+            return false;
+
+        std::unordered_map<Parameter, NDArrayViewPtr> gradients(m_bufferedGradients.begin(), m_bufferedGradients.end());
+        return m_learner->Update(gradients, numberOfSamples, m_bufferedAtEndOfSweep);
+    }
+
+    // Copies a scalar value of the minibatch into a CPU buffer that can be aggregated in the background.
+    static void CopyToScalarBuffer(NDArrayViewPtr& buffer, const NDArrayViewPtr& value)
+    {
+        if (!buffer || buffer->GetDataType() != value->GetDataType())
+            buffer = MakeSharedObject<NDArrayView>(value->GetDataType(), NDShape{}, DeviceDescriptor::CPUDevice());
+
+        buffer->CopyFrom(*value->AsShape(NDShape{}));
+    }
+
+    bool DataParallelDistributedLearner::UpdateAsync(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, MinibatchInfo& info)
+    {
+        if (info.IsEmpty())
+            PrepaireZeroGradients(gradientValues, info);
+
+        // Wait for the gradients of the previous minibatch and apply them, the current ones will be applied
+        // on the next call. The parameters hence lag one minibatch behind the gradients computed from them.
+        bool hasAggregatedValues = m_hasPendingAggregation;
+        bool updated = true;
+        size_t aggregatedNumberOfSamples = 0;
+        NDArrayViewPtr aggregatedEvalCriterion, aggregatedTrainingLoss;
+        if (hasAggregatedValues)
+        {
+            {
+#ifndef  CNTK_UWP
+                auto profGradientAgg = Microsoft::MSR::CNTK::ScopeProfile(Microsoft::MSR::CNTK::profilerEvtMainGradient);
+#endif
+                auto waitBegin = std::chrono::high_resolution_clock::now();
+                WaitForBufferedAggregation();
+                auto waitEnd = std::chrono::high_resolution_clock::now();
+
+                double waitSeconds = std::chrono::duration<double>(waitEnd - waitBegin).count();
+                double aggregationSeconds = std::chrono::duration<double>(waitEnd - m_aggregationBegin).count();
+                m_totalWaitSeconds += waitSeconds;
+                m_totalAggregationSeconds += aggregationSeconds;
+
+                if (GetTraceLevel() >= TraceLevel::Info)
+                    fprintf(stderr, "Info: Asynchronous gradient aggregation waited %.3f ms, overlap %.1f%% (total overlap %.1f%%).\n",
+                            waitSeconds * 1000,
+                            aggregationSeconds > 0 ? 100 * (1 - waitSeconds / aggregationSeconds) : 100.0,
+                            m_totalAggregationSeconds > 0 ? 100 * (1 - m_totalWaitSeconds / m_totalAggregationSeconds) : 100.0);
+            }
+
+            aggregatedNumberOfSamples = static_cast<size_t>(*m_bufferedNumberOfSamples->DataBuffer<double>());
+            aggregatedEvalCriterion = m_bufferedEvalCriterion->DeepClone();
+            aggregatedTrainingLoss = m_bufferedTrainingLoss->DeepClone();
+            updated = ApplyBufferedGradients();
+        }
+
+        // Start aggregating the current minibatch unless training is over, i.e. the previous minibatch
+        // was empty on all workers or the learner refused to update.
+        if (updated)
+        {
+            if (m_bufferedGradients.empty())
+            {
+                for (const auto& g : gradientValues)
+                {
+                    auto weights = g.first.Value();
+                    m_bufferedGradients.push_back(std::make_pair(g.first, MakeSharedObject<NDArrayView>(weights->GetDataType(), weights->Shape(), weights->Device())));
+                }
+
+                std::sort(m_bufferedGradients.begin(), m_bufferedGradients.end(),
+                    [](const std::pair<Parameter, NDArrayViewPtr>& a, const std::pair<Parameter, NDArrayViewPtr>& b) { return a.first.Uid() < b.first.Uid(); });
+
+                m_bufferedNumberOfSamples = MakeSharedObject<NDArrayView>(0.0, NDShape{}, DeviceDescriptor::CPUDevice());
+            }
+
+            // The gradient buffers of the trainer are overwritten by the next minibatch, so aggregate a copy.
+            std::vector<NDArrayViewPtr> valuesToAggregate;
+            for (const auto& b : m_bufferedGradients)
+            {
+                b.second->CopyFrom(*gradientValues.at(b.first));
+                valuesToAggregate.push_back(b.second);
+            }
+
+            CopyToScalarBuffer(m_bufferedEvalCriterion, info.evalCriterionValue);
+            CopyToScalarBuffer(m_bufferedTrainingLoss, info.trainingLossValue);
+            *m_bufferedNumberOfSamples->WritableDataBuffer<double>() = static_cast<double>(info.numberOfSamples);
+            m_bufferedAtEndOfSweep = info.atEndOfSweep;
+
+            valuesToAggregate.push_back(m_bufferedEvalCriterion);
+            valuesToAggregate.push_back(m_bufferedTrainingLoss);
+            valuesToAggregate.push_back(m_bufferedNumberOfSamples);
+
+            m_aggregationBegin = std::chrono::high_resolution_clock::now();
+            m_asyncCommunicator->AggregateInPlaceAsync(valuesToAggregate, m_communicator->Workers());
+            m_hasPendingAggregation = true;
+        }
+
+        // Report the aggregated values of the minibatch that has just been applied.
+        info.numberOfSamples = aggregatedNumberOfSamples;
+        if (hasAggregatedValues)
+        {
+            info.evalCriterionValue->CopyFrom(*aggregatedEvalCriterion->AsShape(info.evalCriterionValue->Shape()));
+            info.trainingLossValue->CopyFrom(*aggregatedTrainingLoss->AsShape(info.trainingLossValue->Shape()));
+        }
+
+        return updated;
     }
 
     bool DataParallelDistributedLearner::Update(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, MinibatchInfo& info)
     {
+        if (m_useAsyncBufferedParameterUpdate && m_sampleCount >= m_distributeAfterSamples && m_communicator->Workers().size() > 1)
+            return UpdateAsync(gradientValues, info);
+
         // sparse gradient may be converted to dense for aggregation
         std::unordered_map<Parameter, NDArrayViewPtr> convertedGradientValues = gradientValues;
 
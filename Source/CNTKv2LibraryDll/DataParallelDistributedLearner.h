@@ -7,9 +7,12 @@
 
 #include "CNTKLibrary.h"
 #include "DistributedLearnerBase.h"
+#include <chrono>
 
 namespace CNTK
 {
+    class MPICommunicatorImpl;
+
     ///
     /// Distributed Trainer.
     ///
@@ -20,5 +23,40 @@ namespace CNTK
 
         // Optional override that gets called per minibatch after finishing gradient computation but before updating model parameters
         bool Update(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, MinibatchInfo& trainingSampleCount) override;
+
+        Dictionary CreateCheckpoint() override;
+
+        void RestoreFromCheckpoint(const Dictionary& checkpoint) override;
+
+        ~DataParallelDistributedLearner();
+
+    private:
+        // Applies the gradients aggregated during the previous minibatch and starts aggregating the current ones,
+        // so that the aggregation overlaps with the computation of the next minibatch.
+        bool UpdateAsync(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, MinibatchInfo& info);
+
+        // Waits for the aggregation started by the previous call to UpdateAsync(), if any.
+        void WaitForBufferedAggregation();
+
+        // Applies the aggregated gradients to the parameters. Returns false if the aggregated minibatch was empty on all workers.
+        bool ApplyBufferedGradients();
+
+        // Waits for the aggregation started by the previous call to UpdateAsync(), if any, and applies it.
+        void ApplyPendingGradients();
+
+        bool m_useAsyncBufferedParameterUpdate;
+        std::shared_ptr<MPICommunicatorImpl> m_asyncCommunicator;
+
+        // Buffers that hold the values of the previous minibatch while they are being aggregated.
+        std::vector<std::pair<Parameter, NDArrayViewPtr>> m_bufferedGradients;
+        NDArrayViewPtr m_bufferedEvalCriterion;
+        NDArrayViewPtr m_bufferedTrainingLoss;
+        NDArrayViewPtr m_bufferedNumberOfSamples;
+        bool m_bufferedAtEndOfSweep;
+        bool m_hasPendingAggregation;
+
+        std::chrono::time_point<std::chrono::high_resolution_clock> m_aggregationBegin;
+        double m_totalAggregationSeconds;
+        double m_totalWaitSeconds;
     };
 }
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include "GPUDataTransferer.h"
 #include <numeric>
 #include "Utils.h"
+#include "PerformanceProfiler.h"
 
 using namespace Microsoft::MSR::CNTK;
 
@@ -150,6 +151,8 @@ namespace CNTK
         std::vector<NDArrayViewPtr>& outputValues,
         const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers)
     {
+        WaitForPendingAggregation();
+
         if (outputValues.empty())
         {
             Recreate(values, outputValues);
@@ -193,6 +196,7 @@ namespace CNTK
         const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers)
     {
         CheckWorkers(sendToWorkers);
+        WaitForPendingAggregation();
 
         std::stringstream dict;
         dict << input;
@@ -241,6 +245,7 @@ namespace CNTK
     {
         // TODO: Currently we only support concatenation of inputs of the same size.
         CheckWorkers(workers);
+        WaitForPendingAggregation();
 
         // Check inputs, currently we support only CPU
         auto nonCpu = std::find_if(input.begin(), input.end(), [](const NDArrayViewPtr& v) { return v->Device() != DeviceDescriptor::CPUDevice(); });
@@ -284,13 +289,62 @@ namespace CNTK
         const std::vector<NDArrayViewPtr>& values,
         const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers)
     {
+        WaitForPendingAggregation();
         AggregateImpl(values, values, sendToWorkers);
     }
 
+    void MPICommunicatorImpl::AggregateInPlaceAsync(
+        const std::vector<NDArrayViewPtr>& values,
+        const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers)
+    {
+        CheckWorkers(sendToWorkers);
+        WaitForPendingAggregation();
+
+        // The values have been computed by work queued on the main thread, so the event must be recorded here.
+        // Recording it on the background thread would also wait for the computation of the next minibatch.
+        SynchronizeWithComputeStream(values);
+
+        auto self = shared_from_this();
+        int deviceId = AsCNTKImplDeviceId(GetNonCPUDevice(values));
+        m_mpi->RunAsync([self, values, sendToWorkers, deviceId]
+        {
+#ifndef CNTK_UWP
+            Microsoft::MSR::CNTK::ScopeProfile profAggregation("Async Aggregation");
+#endif
+            // We are starting on a new thread. Make sure the new thread is
+            // setup to use the right device
+            if (deviceId != CPUDEVICE)
+                Matrix<float>::SetDevice(deviceId);
+
+            self->AggregateImpl(values, values, sendToWorkers, /*synchronizeComputeStream=*/false);
+        });
+    }
+
+    void MPICommunicatorImpl::WaitForPendingAggregation()
+    {
+        m_mpi->WaitForAsync();
+    }
+
+    void MPICommunicatorImpl::SynchronizeWithComputeStream(const std::vector<NDArrayViewPtr>& values)
+    {
+        auto device = GetNonCPUDevice(values);
+        if (device.Type() != DeviceKind::CPU)
+        {
+            // Since we will be copying the gradients asynchronously, let us
+            // ensure that the gradient matrices have been computed before starting to aggregate
+            // them asynchronously on another thread. This essentially means that when we are using
+            // a GPU device, we will synchronize on the main GPU compute stream before starting
+            // the gradient aggregation asynchronously on a separate stream
+            std::unique_ptr<MatrixComputeStreamEvent> mainStreamSyncEvent(MatrixComputeStreamEvent::Create(device.Id()));
+            mainStreamSyncEvent->SynchronizeDataTransferFetchStreamWithEvent<float>();
+        }
+    }
+
     void MPICommunicatorImpl::AggregateImpl(
         const std::vector<NDArrayViewPtr>& inputValues,
         const std::vector<NDArrayViewPtr>& outputValues,
-        const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers)
+        const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers,
+        bool synchronizeComputeStream)
     {
         CheckWorkers(sendToWorkers);
 
@@ -344,17 +398,9 @@ namespace CNTK
         Initialize(valuesToAggregate);
 
         // We need to make sure no compuatation happens on the main CUDA stream.
-        auto device = GetNonCPUDevice(valuesToAggregate);
-        if (device.Type() != DeviceKind::CPU)
-        {
-            // Since we will be copying the gradients asynchronously, let us
-            // ensure that the gradient matrices have been computed before starting to aggregate
-            // them asynchronously on another thread. This essentially means that when we are using
-            // a GPU device, we will synchronize on the main GPU compute stream before starting
-            // the gradient aggregation asynchronously on a separate stream
-            std::unique_ptr<MatrixComputeStreamEvent> mainStreamSyncEvent(MatrixComputeStreamEvent::Create(device.Id()));
-            mainStreamSyncEvent->SynchronizeDataTransferFetchStreamWithEvent<float>();
-        }
+        // The caller may have synchronized already, but the packing above has queued more copies.
+        if (synchronizeComputeStream || !packedFloatGradientsIndex.empty() || !packedDoubleGradientsIndex.empty())
+            SynchronizeWithComputeStream(valuesToAggregate);
 
         // BUGBUG: assuming the all values on the same device
         if (m_nccl == nullptr)
@@ -451,6 +497,8 @@ namespace CNTK
     {
         if (m_mpi->NumNodesInUse() == 1) // No need to aggregate anything.
             return;
+
+        WaitForPendingAggregation();
 #ifdef CPUONLY
         LogicError("Sparse block column aggregation on CPUDevice not implemented");
 #else
@@ -595,6 +643,7 @@ namespace CNTK
 
     void MPICommunicatorImpl::Barrier()
     {
+        WaitForPendingAggregation();
         m_mpi->WaitAll();
     }
 
@@ -63,6 +63,16 @@ namespace CNTK
 
         virtual void Barrier() override;
 
+        // Starts to aggregate the values in place on a background thread, see MPIWrapper::RunAsync(). Only one aggregation
+        // can be pending; all other calls into MPI wait for it first, so that the workers issue the collective operations
+        // in the same order.
+        void AggregateInPlaceAsync(
+            const std::vector<NDArrayViewPtr>& values,
+            const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers);
+
+        // Waits for the aggregation started by AggregateInPlaceAsync(), if any, and rethrows its error.
+        void WaitForPendingAggregation();
+
         virtual ~MPICommunicatorImpl() {}
 
     private:
@@ -71,7 +81,11 @@ namespace CNTK
         void AggregateImpl(
             const std::vector<NDArrayViewPtr>& inputValues,
             const std::vector<NDArrayViewPtr>& outputValues,
-            const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers);
+            const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers,
+            bool synchronizeComputeStream = true);
+
+        // Makes the transfers of the values to the CPU wait for the work that is queued on the GPU compute stream.
+        void SynchronizeWithComputeStream(const std::vector<NDArrayViewPtr>& values);
 
         struct Buffer
         {
@@ -9,6 +9,7 @@
 #include "CompositeFunction.h"
 #include "BlockFunction.h"
 #include "Utils.h"
+#include "Serialization.h"
 #include "UserFunctionFactory.h"
 #include "TrainingNodes.h"
 
@@ -475,10 +476,29 @@ namespace CNTK
         stream->flush();
     }
 
+    void Function::Save(const std::wstring& filepath, ModelFormat format)
+    {
+        switch (format)
+        {
+        case ModelFormat::CNTKv2:
+            Save(filepath);
+            break;
+        case ModelFormat::CNTKv2Mapped:
+            SaveMappedModel(Serialize(), filepath);
+            break;
+        default:
+            InvalidArgument("Function::Save: Unsupported model format %d.", (int)format);
+        }
+    }
+
     /*static*/ FunctionPtr Function::Load(const std::wstring& filepath, const DeviceDescriptor& computeDevice)
     {
         auto stream = GetFstream(filepath, true);
-        if (!Internal::IsLegacyModel(*stream))
+        if (IsMappedModel(*stream))
+        {
+            return Function::Deserialize(LoadMappedModel(filepath), computeDevice);
+        }
+        else if (!Internal::IsLegacyModel(*stream))
         {
             Dictionary model;
             *stream >> model;
@@ -506,6 +526,8 @@ namespace CNTK
 
         if (Internal::IsLegacyModel(buffer, length))
             InvalidArgument("Loading a legacy model from byte array is not supported.");
+        else if (IsMappedModel(buffer, length))
+            InvalidArgument("Loading a mapped model from byte array is not supported.");
         else
         {
             modelStreamBuffer buf(buffer, length);
@@ -525,6 +547,12 @@ namespace CNTK
     void Function::Restore(const std::wstring& filepath)
     {
         auto stream = GetFstream(filepath, true);
+        if (IsMappedModel(*stream))
+        {
+            RestoreFromCheckpoint(LoadMappedModel(filepath));
+            return;
+        }
+
         if (!Internal::IsLegacyModel(*stream))
         {
             Dictionary model;
@@ -0,0 +1,541 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// InferenceOptimizer.cpp -- rewrites a Function into a smaller equivalent Function for evaluation only
+//
+
+#include "stdafx.h"
+#include "CNTKLibrary.h"
+#include "PrimitiveFunction.h"
+#include "BlockFunction.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CNTK
+{
+    namespace
+    {
+        size_t StaticSize(const Variable& var)
+        {
+            const auto& shape = var.Shape();
+            return (shape.IsUnknown() || shape.HasUnboundDimension()) ? 0 : shape.TotalSize();
+        }
+
+        // Calls 'visitor' for every primitive Function in the graph underneath 'function', including those inside blocks.
+        template <typename VisitorType>
+        void TraversePrimitiveFunctions(const FunctionPtr& function, std::unordered_set<const Function*>& visitedFunctions, const VisitorType& visitor)
+        {
+            if (!visitedFunctions.insert(function.get()).second)
+                return;
+
+            if (function->IsBlock())
+                TraversePrimitiveFunctions(function->BlockRoot(), visitedFunctions, visitor);
+            else
+                visitor(function);
+
+            auto inputs = function->Inputs();
+            for (const auto& input : inputs)
+            {
+                if (input.IsOutput())
+                    TraversePrimitiveFunctions(input.Owner(), visitedFunctions, visitor);
+            }
+        }
+
+        // A rough estimate of the floating point operations of one sample, from the static shapes.
+        size_t EstimateFlops(const FunctionPtr& function)
+        {
+            auto primitive = dynamic_cast<const PrimitiveFunction*>(function.get());
+            if (!primitive)
+                return 0;
+
+            auto inputs = function->Inputs();
+            size_t outputSize = 0;
+            for (const auto& output : function->Outputs())
+                outputSize += StaticSize(output);
+
+            switch (primitive->OpType())
+            {
+            case PrimitiveOpType::Combine:
+            case PrimitiveOpType::NoOp:
+            case PrimitiveOpType::Pass:
+            case PrimitiveOpType::StopGradient:
+            case PrimitiveOpType::Dropout:
+            case PrimitiveOpType::Reshape:
+                return 0;
+            case PrimitiveOpType::Times:
+            {
+                // [M x K] times [K x N] --> 2 M K N
+                auto outputRank = primitive->Attributes()[PrimitiveFunction::AttributeNameOutputRank].Value<size_t>();
+                const auto& leftShape = inputs[0].Shape();
+                if ((StaticSize(inputs[0]) == 0) || (leftShape.Rank() < outputRank))
+                    return 0;
+                return 2 * outputSize * (leftShape.TotalSize() / leftShape.SubShape(0, outputRank).TotalSize());
+            }
+            case PrimitiveOpType::TransposeTimes:
+            {
+                const auto& leftShape = inputs[0].Shape();
+                if ((StaticSize(inputs[0]) == 0) || (leftShape.Rank() == 0))
+                    return 0;
+                return 2 * outputSize * leftShape[0];
+            }
+            case PrimitiveOpType::Convolution:
+            {
+                // every output element sums kernel-size products; a transposed convolution scatters every input element instead
+                const auto& mapShape = inputs[0].Shape();
+                const auto& operandShape = inputs[1].Shape();
+                if ((StaticSize(inputs[0]) == 0) || (StaticSize(inputs[1]) == 0) || (mapShape.Rank() < operandShape.Rank()) || (operandShape.Rank() == 0))
+                    return 0;
+                bool transpose = primitive->Attributes()[PrimitiveFunction::AttributeNameTranspose].Value<bool>();
+                if (transpose)
+                    return 2 * operandShape.TotalSize() * (mapShape.TotalSize() / operandShape[operandShape.Rank() - 1]);
+                return 2 * outputSize * mapShape.SubShape(0, operandShape.Rank()).TotalSize();
+            }
+            case PrimitiveOpType::BatchNormalization:
+                return 4 * outputSize;
+            default:
+            {
+                // elementwise operations and reductions touch every element of their largest input or output once
+                size_t flops = outputSize;
+                for (const auto& input : inputs)
+                    flops = std::max(flops, StaticSize(input));
+                return flops;
+            }
+            }
+        }
+
+        void CountFunctionsAndFlops(const std::vector<FunctionPtr>& roots, size_t& numFunctions, size_t& flops)
+        {
+            numFunctions = 0;
+            flops = 0;
+            std::unordered_set<const Function*> visitedFunctions;
+            for (const auto& root : roots)
+            {
+                TraversePrimitiveFunctions(root, visitedFunctions, [&numFunctions, &flops](const FunctionPtr& function) {
+                    auto primitive = dynamic_cast<const PrimitiveFunction*>(function.get());
+                    if (primitive && (primitive->OpType() == PrimitiveOpType::Combine))
+                        return;
+
+                    numFunctions++;
+                    flops += EstimateFlops(function);
+                });
+            }
+        }
+
+        template <typename ElementType>
+        std::vector<ElementType> CopyToVector(const NDArrayViewPtr& view)
+        {
+            auto cpuView = view->DeepClone(DeviceDescriptor::CPUDevice(), /*readOnly =*/ true);
+            const ElementType* buffer = cpuView->DataBuffer<ElementType>();
+            return std::vector<ElementType>(buffer, buffer + cpuView->Shape().TotalSize());
+        }
+
+        template <typename ElementType>
+        Constant CreateConstant(const NDShape& shape, const std::vector<ElementType>& data, const DeviceDescriptor& device, const std::wstring& name)
+        {
+            auto cpuView = MakeSharedObject<NDArrayView>(shape, data.data(), data.size(), DeviceDescriptor::CPUDevice());
+            return Constant(cpuView->DeepClone(device, /*readOnly =*/ false), name);
+        }
+
+        bool IsDenseConstant(const Variable& var, DataType dataType)
+        {
+            return var.IsConstant() && (var.GetDataType() == dataType) && (Constant(var).Value()->GetStorageFormat() == StorageFormat::Dense);
+        }
+
+        // Rebuilds the graph underneath a set of outputs bottom-up, in one of two passes:
+        // * Flatten inlines blocks, turns Parameters into Constants and removes Functions that are identities during evaluation.
+        // * Fold folds BatchNormalization into the Function before it or into a scale and shift, and replaces Functions
+        //   of Constants by their value. It expects a flattened graph.
+        // Functions that do not contribute to the outputs are not visited and hence dropped.
+        class InferenceGraphRewriter
+        {
+        public:
+            enum class Pass
+            {
+                Flatten,
+                Fold,
+            };
+
+            InferenceGraphRewriter(Pass pass, InferenceOptimizationStatistics& statistics)
+                : m_pass(pass), m_statistics(statistics)
+            {}
+
+            FunctionPtr Rewrite(const std::vector<Variable>& outputs, const std::wstring& name)
+            {
+                if (m_pass == Pass::Fold)
+                    CountConsumers(outputs);
+
+                m_scopes.push_back(Scope());
+                std::vector<Variable> rewrittenOutputs;
+                for (const auto& output : outputs)
+                    rewrittenOutputs.push_back(RewriteVariable(output));
+                PopScope();
+
+                FunctionPtr result;
+                if ((rewrittenOutputs.size() == 1) && rewrittenOutputs[0].IsOutput() && (rewrittenOutputs[0].Owner()->Outputs().size() == 1))
+                    result = AsComposite(rewrittenOutputs[0].Owner(), name);
+                else
+                    result = Combine(rewrittenOutputs, name);
+
+                // close the loops that were cut while rebuilding them
+                std::unordered_map<Variable, Variable> placeholderReplacements;
+                for (const auto& placeholder : result->Placeholders())
+                {
+                    auto iter = m_placeholderReplacements.find(placeholder);
+                    if (iter == m_placeholderReplacements.end())
+                        continue;
+
+                    auto replacement = iter->second;
+                    for (auto next = m_placeholderReplacements.find(replacement); next != m_placeholderReplacements.end(); next = m_placeholderReplacements.find(replacement))
+                        replacement = next->second;
+                    placeholderReplacements[placeholder] = replacement;
+                }
+
+                if (!placeholderReplacements.empty())
+                    result->ReplacePlaceholders(placeholderReplacements);
+
+                return result;
+            }
+
+        private:
+            // The rewritten Variables of one graph; the composite of each inlined block is rewritten in a scope of its own,
+            // since one composite may underlie several blocks.
+            struct Scope
+            {
+                std::unordered_map<Variable, Variable> m_rewrittenVariables;
+                std::unordered_set<const Function*> m_functionsInProgress;
+                std::vector<std::pair<Variable, Variable>> m_loopPlaceholders; // placeholder, and the Variable whose rewrite replaces it
+            };
+
+            void PopScope()
+            {
+                auto& scope = m_scopes.back();
+                for (const auto& loopPlaceholder : scope.m_loopPlaceholders)
+                    m_placeholderReplacements[loopPlaceholder.first] = scope.m_rewrittenVariables.at(loopPlaceholder.second);
+                m_scopes.pop_back();
+            }
+
+            void CountConsumers(const std::vector<Variable>& outputs)
+            {
+                std::unordered_set<const Function*> visitedFunctions;
+                for (const auto& output : outputs)
+                {
+                    m_numConsumers[output]++;
+                    if (output.IsOutput())
+                    {
+                        TraversePrimitiveFunctions(output.Owner(), visitedFunctions, [this](const FunctionPtr& function) {
+                            auto inputs = function->Inputs();
+                            for (const auto& input : inputs)
+                                m_numConsumers[input]++;
+                        });
+                    }
+                }
+            }
+
+            Variable RewriteVariable(const Variable& var)
+            {
+                auto& scope = m_scopes.back();
+                auto iter = scope.m_rewrittenVariables.find(var);
+                if (iter != scope.m_rewrittenVariables.end())
+                    return iter->second;
+
+                if (var.IsParameter())
+                {
+                    // the same Parameter may be used inside several blocks, so the frozen copies are shared by all scopes
+                    auto frozenIter = m_frozenParameters.find(var);
+                    if (frozenIter != m_frozenParameters.end())
+                        return frozenIter->second;
+
+                    const auto& value = Parameter(var).Value();
+                    Variable frozen = Constant(value->DeepClone(value->Device(), /*readOnly =*/ false), var.Name());
+                    m_frozenParameters[var] = frozen;
+                    return frozen;
+                }
+
+                if (!var.IsOutput())
+                    return var;
+
+                // a loop (through PastValue or FutureValue) leads back to a Function that is being rewritten
+                auto owner = var.Owner();
+                if (scope.m_functionsInProgress.find(owner.get()) != scope.m_functionsInProgress.end())
+                {
+                    auto placeholder = PlaceholderLike(var);
+                    scope.m_loopPlaceholders.push_back({ placeholder, var });
+                    return placeholder;
+                }
+
+                scope.m_functionsInProgress.insert(owner.get());
+                RewriteFunction(owner);
+                m_scopes.back().m_functionsInProgress.erase(owner.get());
+
+                return m_scopes.back().m_rewrittenVariables.at(var);
+            }
+
+            void RewriteFunction(const FunctionPtr& function)
+            {
+                auto inputs = function->Inputs();
+                std::vector<Variable> rewrittenInputs;
+                for (const auto& input : inputs)
+                    rewrittenInputs.push_back(RewriteVariable(input));
+
+                auto outputs = function->Outputs();
+                auto& rewrittenVariables = m_scopes.back().m_rewrittenVariables;
+                if (function->IsBlock())
+                {
+                    auto blockFunction = dynamic_cast<const BlockFunction*>(function.get());
+                    auto argumentsMap = blockFunction->CompositeArgumentsMap();
+
+                    Scope blockScope;
+                    for (const auto& argumentMapping : argumentsMap)
+                    {
+                        auto inputIndex = std::find(inputs.begin(), inputs.end(), argumentMapping.second) - inputs.begin();
+                        blockScope.m_rewrittenVariables[argumentMapping.first] = rewrittenInputs[inputIndex];
+                    }
+
+                    auto outputsMap = blockFunction->CompositeOutputsMap();
+                    m_scopes.push_back(std::move(blockScope));
+                    std::vector<Variable> rewrittenOutputs;
+                    for (const auto& output : outputs)
+                        rewrittenOutputs.push_back(RewriteVariable(outputsMap.at(output)));
+                    PopScope();
+
+                    for (size_t i = 0; i < outputs.size(); i++)
+                        m_scopes.back().m_rewrittenVariables[outputs[i]] = rewrittenOutputs[i];
+                    return;
+                }
+
+                auto primitive = dynamic_cast<const PrimitiveFunction*>(function.get());
+                if (primitive && (m_pass == Pass::Flatten))
+                {
+                    auto op = primitive->OpType();
+                    if ((op == PrimitiveOpType::Dropout) || (op == PrimitiveOpType::StopGradient) || (op == PrimitiveOpType::Pass))
+                    {
+                        rewrittenVariables[outputs[0]] = rewrittenInputs[0];
+                        m_statistics.m_numIdentityFunctionsRemoved++;
+                        return;
+                    }
+                }
+
+                if (primitive && (m_pass == Pass::Fold) && (primitive->OpType() == PrimitiveOpType::BatchNormalization))
+                {
+                    Variable folded = FoldBatchNormalization(primitive, inputs[0], rewrittenInputs);
+                    if (folded != Variable())
+                    {
+                        rewrittenVariables[outputs[0]] = folded;
+                        return;
+                    }
+                }
+
+                auto rewrittenFunction = function->Clone(rewrittenInputs);
+                auto rewrittenOutputs = rewrittenFunction->Outputs();
+                if (primitive && (m_pass == Pass::Fold) && CanFoldConstant(primitive, rewrittenInputs))
+                {
+                    rewrittenOutputs = EvaluateConstant(rewrittenFunction, rewrittenInputs);
+                    m_statistics.m_numConstantFunctionsFolded++;
+                }
+
+                for (size_t i = 0; i < outputs.size(); i++)
+                    rewrittenVariables[outputs[i]] = rewrittenOutputs[i];
+            }
+
+            bool CanFoldConstant(const PrimitiveFunction* primitive, const std::vector<Variable>& inputs) const
+            {
+                if (inputs.empty() || primitive->IsStateful())
+                    return false;
+
+                switch (primitive->OpType())
+                {
+                case PrimitiveOpType::Combine:
+                case PrimitiveOpType::Assign:
+                    return false;
+                default:
+                    break;
+                }
+
+                size_t inputSize = 0;
+                for (const auto& input : inputs)
+                {
+                    if (!input.IsConstant())
+                        return false;
+                    inputSize += StaticSize(input);
+                }
+
+                // Functions that broadcast their inputs are cheaper to evaluate than to store
+                size_t outputSize = 0;
+                for (const auto& output : primitive->Outputs())
+                {
+                    if (!output.DynamicAxes().empty() || (StaticSize(output) == 0))
+                        return false;
+                    outputSize += StaticSize(output);
+                }
+                return outputSize <= inputSize;
+            }
+
+            std::vector<Variable> EvaluateConstant(const FunctionPtr& function, const std::vector<Variable>& inputs)
+            {
+                auto device = Constant(inputs[0]).Value()->Device();
+                auto outputs = function->Outputs();
+                std::unordered_map<Variable, ValuePtr> outputValues;
+                for (const auto& output : outputs)
+                    outputValues[output] = nullptr;
+
+                AsComposite(function)->Evaluate({}, outputValues, device);
+
+                std::vector<Variable> constants;
+                for (const auto& output : outputs)
+                {
+                    auto data = outputValues.at(output)->Data();
+                    if (data->Shape() != output.Shape())
+                        data = data->AsShape(output.Shape());
+                    constants.push_back(Constant(data, output.Name()));
+                }
+                return constants;
+            }
+
+            // Returns the rewrite of a BatchNormalization in evaluation mode, or an empty Variable if its statistics are not Constants.
+            //     output = scale * (operand - runningMean) / sqrt(runningVariance + epsilon) + bias
+            //            = operand * s + (bias - runningMean * s),  where s = scale / sqrt(runningVariance + epsilon)
+            Variable FoldBatchNormalization(const PrimitiveFunction* batchNormalization, const Variable& operand, const std::vector<Variable>& inputs)
+            {
+                const auto& rewrittenOperand = inputs[0];
+                auto dataType = rewrittenOperand.GetDataType();
+                if (dataType == DataType::Float)
+                    return FoldBatchNormalization<float>(batchNormalization, operand, inputs);
+                if (dataType == DataType::Double)
+                    return FoldBatchNormalization<double>(batchNormalization, operand, inputs);
+                return Variable();
+            }
+
+            template <typename ElementType>
+            Variable FoldBatchNormalization(const PrimitiveFunction* batchNormalization, const Variable& operand, const std::vector<Variable>& inputs)
+            {
+                const auto& rewrittenOperand = inputs[0];
+                auto dataType = rewrittenOperand.GetDataType();
+                for (size_t i = 1; i <= 4; i++)
+                {
+                    if (!IsDenseConstant(inputs[i], dataType))
+                        return Variable();
+                }
+
+                const auto& operandShape = rewrittenOperand.Shape();
+                size_t operandSize = StaticSize(rewrittenOperand);
+                if ((operandSize == 0) || (operandShape.Rank() == 0))
+                    return Variable();
+
+                auto scale = CopyToVector<ElementType>(Constant(inputs[1]).Value());
+                auto bias = CopyToVector<ElementType>(Constant(inputs[2]).Value());
+                auto runningMean = CopyToVector<ElementType>(Constant(inputs[3]).Value());
+                auto runningVariance = CopyToVector<ElementType>(Constant(inputs[4]).Value());
+                size_t numChannels = scale.size();
+                if ((bias.size() != numChannels) || (runningMean.size() != numChannels) || (runningVariance.size() != numChannels))
+                    return Variable();
+
+                // spatial mode shares the statistics along all but the last axis of the operand
+                const auto& attributes = batchNormalization->Attributes();
+                bool spatial = attributes[PrimitiveFunction::AttributeNameSpatial].Value<bool>();
+                double epsilon = attributes[PrimitiveFunction::AttributeNameEpsilon].Value<double>();
+                if (spatial ? (operandShape[operandShape.Rank() - 1] != numChannels) : (operandSize != numChannels))
+                    return Variable();
+
+                std::vector<ElementType> channelScale(numChannels), channelShift(numChannels);
+                for (size_t c = 0; c < numChannels; c++)
+                {
+                    channelScale[c] = (ElementType)(scale[c] / std::sqrt((double)runningVariance[c] + epsilon));
+                    channelShift[c] = bias[c] - runningMean[c] * channelScale[c];
+                }
+
+                size_t channelStride = operandSize / numChannels; // the channel of element k of the operand is k / channelStride
+                auto device = Constant(inputs[1]).Value()->Device();
+                const auto& name = batchNormalization->Name();
+
+                // Fold into the weights of a Times or Convolution that feeds nothing else.
+                auto producer = rewrittenOperand.IsOutput() ? dynamic_cast<const PrimitiveFunction*>(rewrittenOperand.Owner().get()) : nullptr;
+                if (producer && (m_numConsumers[operand] == 1))
+                {
+                    auto producerInputs = producer->Inputs();
+                    const auto& weights = producerInputs.empty() ? Variable() : producerInputs[0];
+                    if (IsDenseConstant(weights, dataType) && (StaticSize(weights) != 0))
+                    {
+                        auto weightValues = CopyToVector<ElementType>(Constant(weights).Value());
+                        bool canFold = false;
+                        if (producer->OpType() == PrimitiveOpType::Times)
+                        {
+                            // output element k of [M x K] times [K x N] is scaled by scaling row k of the weights; only possible if N is 1
+                            auto outputRank = producer->Attributes()[PrimitiveFunction::AttributeNameOutputRank].Value<size_t>();
+                            if ((weights.Shape().Rank() >= outputRank) && (weights.Shape().SubShape(0, outputRank).TotalSize() == operandSize))
+                            {
+                                for (size_t j = 0; j < weightValues.size(); j++)
+                                    weightValues[j] *= channelScale[(j % operandSize) / channelStride];
+                                canFold = true;
+                            }
+                        }
+                        else if (producer->OpType() == PrimitiveOpType::Convolution)
+                        {
+                            // the last axes of the convolution map enumerate the output maps, each of which is a kernel
+                            const auto& producerAttributes = producer->Attributes();
+                            bool transpose = producerAttributes[PrimitiveFunction::AttributeNameTranspose].Value<bool>();
+                            auto sharing = AsVector<bool>(producerAttributes[PrimitiveFunction::AttributeNameSharing].Value<std::vector<DictionaryValue>>());
+                            bool allShared = std::all_of(sharing.begin(), sharing.end(), [](bool shared) { return shared; });
+                            size_t operandRank = producerInputs[1].Shape().Rank();
+                            if (spatial && !transpose && allShared && (weights.Shape().Rank() >= operandRank) && (weights.Shape().SubShape(operandRank).TotalSize() == numChannels))
+                            {
+                                size_t kernelSize = weights.Shape().SubShape(0, operandRank).TotalSize();
+                                for (size_t j = 0; j < weightValues.size(); j++)
+                                    weightValues[j] *= channelScale[j / kernelSize];
+                                canFold = true;
+                            }
+                        }
+
+                        if (canFold)
+                        {
+                            producerInputs[0] = CreateConstant(weights.Shape(), weightValues, device, weights.Name());
+                            auto scaledProducer = rewrittenOperand.Owner()->Clone(producerInputs);
+                            m_statistics.m_numBatchNormalizationsFoldedIntoWeights++;
+                            return Plus(scaledProducer->Output(), CreateShift(operandShape, spatial, channelShift, device), name);
+                        }
+                    }
+                }
+
+                NDShape scaleShape = spatial ? NDShape(operandShape.Rank() - 1, 1).AppendShape({ numChannels }) : operandShape;
+                auto scaled = ElementTimes(rewrittenOperand, CreateConstant(scaleShape, channelScale, device, L""));
+                m_statistics.m_numBatchNormalizationsFoldedIntoScaleAndShift++;
+                return Plus(scaled, CreateShift(operandShape, spatial, channelShift, device), name);
+            }
+
+            template <typename ElementType>
+            Constant CreateShift(const NDShape& operandShape, bool spatial, const std::vector<ElementType>& channelShift, const DeviceDescriptor& device)
+            {
+                NDShape shape = spatial ? NDShape(operandShape.Rank() - 1, 1).AppendShape({ channelShift.size() }) : operandShape;
+                return CreateConstant(shape, channelShift, device, L"");
+            }
+
+            const Pass m_pass;
+            InferenceOptimizationStatistics& m_statistics;
+
+            std::vector<Scope> m_scopes;
+            std::unordered_map<Variable, Variable> m_frozenParameters;
+            std::unordered_map<Variable, Variable> m_placeholderReplacements;
+            std::unordered_map<Variable, size_t> m_numConsumers; // of each Variable of the graph to be folded, counting the outputs as consumers
+        };
+    }
+
+    FunctionPtr OptimizeForInference(const FunctionPtr& function, const std::vector<Variable>& outputs, InferenceOptimizationStatistics& statistics)
+    {
+        statistics = InferenceOptimizationStatistics();
+        CountFunctionsAndFlops({ function->RootFunction() }, statistics.m_numFunctionsBefore, statistics.m_flopsBefore);
+
+        auto functionOutputs = function->Outputs();
+        for (const auto& output : outputs)
+        {
+            if (std::find(functionOutputs.begin(), functionOutputs.end(), output) == functionOutputs.end())
+                InvalidArgument("OptimizeForInference: '%S' is not an output of the Function '%S'.", output.AsString().c_str(), function->AsString().c_str());
+        }
+
+        auto flattened = InferenceGraphRewriter(InferenceGraphRewriter::Pass::Flatten, statistics).Rewrite(outputs.empty() ? functionOutputs : outputs, function->Name());
+        auto optimized = InferenceGraphRewriter(InferenceGraphRewriter::Pass::Fold, statistics).Rewrite(flattened->Outputs(), function->Name());
+
+        CountFunctionsAndFlops({ optimized->RootFunction() }, statistics.m_numFunctionsAfter, statistics.m_flopsAfter);
+        return optimized;
+    }
+}
@@ -393,12 +393,37 @@ namespace CNTK
     {
         Deserializer img;
         std::vector<DictionaryValue> actualTransforms;
-        std::transform(transforms.begin(), transforms.end(), std::back_inserter(actualTransforms), [](ImageTransform t) { return static_cast<DictionaryValue>(t); });
 
-        // Add the transpose transform by default.
-        Dictionary transposeTransform;
-        transposeTransform[L"type"] = L"Transpose";
-        actualTransforms.push_back(DictionaryValue(transposeTransform));
+        // Crop, scale and mean in this order, followed by the default transpose, are done by a single
+        // fused transform with the union of their options.
+        static const std::vector<std::wstring> fusableTypes = { L"Crop", L"Scale", L"Mean" };
+        bool fuse = std::any_of(transforms.begin(), transforms.end(), [](const ImageTransform& t) { return t[L"type"].Value<std::wstring>() == L"Scale"; });
+        size_t nextType = 0;
+        for (const auto& t : transforms)
+        {
+            auto position = std::find(fusableTypes.begin() + nextType, fusableTypes.end(), t[L"type"].Value<std::wstring>());
+            fuse = fuse && position != fusableTypes.end();
+            nextType = fuse ? position - fusableTypes.begin() + 1 : 0;
+        }
+
+        if (fuse)
+        {
+            Dictionary fusedTransform;
+            for (const auto& t : transforms)
+                for (const auto& option : t)
+                    fusedTransform[option.first] = option.second;
+            fusedTransform[L"type"] = L"CropScaleMeanTranspose";
+            actualTransforms.push_back(DictionaryValue(fusedTransform));
+        }
+        else
+        {
+            std::transform(transforms.begin(), transforms.end(), std::back_inserter(actualTransforms), [](ImageTransform t) { return static_cast<DictionaryValue>(t); });
+
+            // Add the transpose transform by default.
+            Dictionary transposeTransform;
+            transposeTransform[L"type"] = L"Transpose";
+            actualTransforms.push_back(DictionaryValue(transposeTransform));
+        }
 
         Dictionary labeldim;
         labeldim[L"labelDim"] = numLabels;
@@ -558,6 +583,10 @@ namespace CNTK
             }
 
             augmentedConfiguration[L"frameMode"] = configuration.isFrameModeEnabled;
+            augmentedConfiguration[L"prefetchDepth"] = configuration.prefetchDepthInChunks;
+            augmentedConfiguration[L"prefetchThreads"] = configuration.prefetchThreads;
+            augmentedConfiguration[L"prefetchBudgetInBytes"] = configuration.prefetchBudgetInBytes;
+            augmentedConfiguration[L"prefetchMinibatches"] = configuration.prefetchDepthInMinibatches;
             augmentedConfiguration[L"traceLevel"] = static_cast<size_t>(configuration.traceLevel);
 
             bool defaultMultithreaded = false;
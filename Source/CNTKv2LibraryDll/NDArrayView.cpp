@@ -129,6 +129,12 @@ namespace CNTK
         : NDArrayView(dataType, device, storageType, viewShape, false, AllocateTensorView(dataType, storageType, viewShape, device))
     {}
 
+    NDArrayView::NDArrayView(CNTK::DataType dataType, const NDShape& viewShape, void* dataBuffer, size_t bufferSizeInBytes, const std::shared_ptr<void>& bufferOwner)
+        : NDArrayView(dataType, viewShape, dataBuffer, bufferSizeInBytes, DeviceDescriptor::CPUDevice())
+    {
+        m_bufferOwner = bufferOwner;
+    }
+
     NDArrayView::~NDArrayView()
     {}
 
@@ -300,7 +306,9 @@ namespace CNTK
             break;
         }
 
-        return MakeSharedObject<NDArrayView>(GetDataType(), Device(), GetStorageFormat(), Shape(), IsReadOnly() || readOnly, tensorView);
+        auto aliasView = MakeSharedObject<NDArrayView>(GetDataType(), Device(), GetStorageFormat(), Shape(), IsReadOnly() || readOnly, tensorView);
+        aliasView->m_bufferOwner = m_bufferOwner;
+        return aliasView;
     }
 
     NDArrayViewPtr NDArrayView::SliceView(const std::vector<size_t>& startOffset, const std::vector<size_t>& extent, bool readOnly) const
@@ -372,7 +380,9 @@ namespace CNTK
             break;
         }
 
-        return MakeSharedObject<NDArrayView>(GetDataType(), Device(), GetStorageFormat(), sliceViewShape, IsReadOnly() || readOnly, tensorView);
+        auto sliceView = MakeSharedObject<NDArrayView>(GetDataType(), Device(), GetStorageFormat(), sliceViewShape, IsReadOnly() || readOnly, tensorView);
+        sliceView->m_bufferOwner = m_bufferOwner;
+        return sliceView;
     }
 
     NDArrayViewPtr NDArrayView::AsShape(const NDShape& newShape) const
@@ -399,7 +409,9 @@ namespace CNTK
             break;
         }
 
-        return MakeSharedObject<NDArrayView>(GetDataType(), Device(), GetStorageFormat(), newShape, IsReadOnly(), tensorView);
+        auto reshapedView = MakeSharedObject<NDArrayView>(GetDataType(), Device(), GetStorageFormat(), newShape, IsReadOnly(), tensorView);
+        reshapedView->m_bufferOwner = m_bufferOwner;
+        return reshapedView;
     }
 
     // TODO: This could actually be strided?
@@ -6,6 +6,8 @@
 #include "stdafx.h"
 #include "CNTKLibrary.h"
 #include "Utils.h"
+#include "Serialization.h"
+#include "MemoryMappedFile.h"
 #include <istream>
 #include <ostream>
 #include <string>
@@ -31,6 +33,19 @@ namespace CNTK
     static const uint32 MAGIC_NUMBER = 0x636e746bU;
     static const uint32 BLOCK_SIZE = 8 << 10; // 8Kb;
 
+    // Header of a mapped model file: magic number, format version, graph size, data section offset and size.
+    // It is followed by the graph protobuf and, at the next aligned offset, by the data section, which contains
+    // the raw (little-endian) NDArrayView values, each starting at an aligned offset.
+    static const uint32 MAPPED_MAGIC_NUMBER = 0x6d6e746bU;
+    static const uint32 MAPPED_FORMAT_VERSION = 1;
+    static const uint64 MAPPED_HEADER_SIZE = 2 * sizeof(uint32) + 3 * sizeof(uint64);
+    static const uint64 MAPPED_DATA_ALIGNMENT = 64; // a cache line, enough for any vectorized access
+
+    static inline uint64 AlignMappedOffset(uint64 offset)
+    {
+        return (offset + MAPPED_DATA_ALIGNMENT - 1) & ~(MAPPED_DATA_ALIGNMENT - 1);
+    }
+
     static void SetUTF8Locale()
     {
 #ifndef _MSC_VER
@@ -124,6 +139,9 @@ namespace CNTK
         friend class Dictionary;
         friend class DictionaryValue;
 
+        friend void SaveMappedModel(const Dictionary& model, const std::wstring& filename);
+        friend Dictionary LoadMappedModel(const std::wstring& filename);
+
         Serializer(const Dictionary& dict);
         Serializer(const DictionaryValue& dict);
 
@@ -146,6 +164,8 @@ namespace CNTK
         void Write(const std::wstring& filename);
         void Write(io::ZeroCopyOutputStream& stream);
 
+        void WriteMapped(const std::wstring& filename);
+        void WriteMappedData(io::CodedOutputStream& output, uint64 position);
 
         bool Read(std::istream& stream, Dictionary& dict);
         bool Read(std::istream& stream, DictionaryValue& value);
@@ -158,6 +178,8 @@ namespace CNTK
 
         bool ReadNDArrayViewData(io::ZeroCopyInputStream& input);
 
+        bool ReadMapped(const std::wstring& filename, Dictionary& dict);
+
         size_t GetTotalByteSize() 
         {
             return m_byteSize + m_proto->ByteSizeLong();
@@ -285,6 +307,11 @@ namespace CNTK
         Message* m_proto;
         std::vector<std::pair<NDArrayView*, proto::NDArrayView*>> m_arrayViews;
         size_t m_byteSize {0};
+
+        // Mapping of the file being read with ReadMapped() and the start and size of its data section.
+        MemoryMappedViewPtr m_mappedFile;
+        char* m_mappedData {nullptr};
+        size_t m_mappedDataSize {0};
     };
 
 
@@ -430,6 +457,24 @@ namespace CNTK
         std::unique_ptr<NDShape> shape(CreateFromProto(src.shape()));
         auto dataType = FromProtoType(src.data_type());
         auto storageFormat = FromProtoType(src.storage_format());
+
+        if (src.has_external_values())
+        {
+            if (m_mappedData == nullptr)
+                RuntimeError("NDArrayView values are stored in the data section of a mapped model file, which can only be read by loading the model from that file.");
+
+            if (storageFormat != StorageFormat::Dense)
+                RuntimeError("Only dense NDArrayView values can be stored in the data section of a mapped model file.");
+
+            auto offset = src.external_values().offset();
+            auto byteSize = shape->TotalSize() * DataTypeSize(dataType);
+            if ((offset % MAPPED_DATA_ALIGNMENT != 0) || (offset > m_mappedDataSize) || (byteSize > m_mappedDataSize - offset))
+                RuntimeError("NDArrayView values (%zu bytes at offset %zu) are not within the data section (%zu bytes) of the mapped model file.",
+                             (size_t)byteSize, (size_t)offset, m_mappedDataSize);
+
+            return new NDArrayView(dataType, *shape, m_mappedData + offset, byteSize, m_mappedFile);
+        }
+
         NDArrayView* dst = new NDArrayView(dataType, storageFormat, *shape, DeviceDescriptor::CPUDevice());
 
         if (dataType == DataType::Float)
@@ -651,6 +696,116 @@ namespace CNTK
 #endif
     }
 
+    void Serializer::WriteMapped(const std::wstring& filename)
+    {
+        // Lay out the values in the data section and point the protos at them.
+        uint64 dataSize = 0;
+        for (auto& pair : m_arrayViews)
+        {
+            const auto& src = *(pair.first);
+            if (src.GetStorageFormat() != StorageFormat::Dense)
+                InvalidArgument("Sparse NDArrayView values cannot be saved in a mapped model file.");
+
+            dataSize = AlignMappedOffset(dataSize);
+            pair.second->mutable_external_values()->set_offset(dataSize);
+            dataSize += src.Shape().TotalSize() * DataTypeSize(src.GetDataType());
+        }
+
+        uint64 graphSize = m_proto->ByteSizeLong();
+        if (graphSize >= static_cast<uint64>(INT_MAX))
+            RuntimeError("The serialized graph (%zu bytes) exceeds the protobuf limit of %d bytes.", (size_t)graphSize, INT_MAX);
+        uint64 dataOffset = AlignMappedOffset(MAPPED_HEADER_SIZE + graphSize);
+
+        auto fd = GetFileDescriptor(filename, false);
+        {
+            io::FileOutputStream stream(fd);
+            io::CodedOutputStream output(&stream);
+            output.WriteLittleEndian32(MAPPED_MAGIC_NUMBER);
+            output.WriteLittleEndian32(MAPPED_FORMAT_VERSION);
+            output.WriteLittleEndian64(graphSize);
+            output.WriteLittleEndian64(dataOffset);
+            output.WriteLittleEndian64(dataSize);
+            m_proto->SerializeToCodedStream(&output);
+            WriteMappedData(output, MAPPED_HEADER_SIZE + graphSize);
+        }
+#ifdef _MSC_VER
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+
+    void Serializer::WriteMappedData(io::CodedOutputStream& output, uint64 position)
+    {
+        static const char padding[MAPPED_DATA_ALIGNMENT] = {};
+        static const size_t maxChunkSize = 1 << 30;
+
+        // The data section starts at the first aligned offset after the graph,
+        // and all offsets within it are aligned, so aligning the file position aligns both.
+        auto pad = [&output, &position]()
+        {
+            auto aligned = AlignMappedOffset(position);
+            output.WriteRaw(padding, (int)(aligned - position));
+            position = aligned;
+        };
+
+        pad();
+        for (auto& pair : m_arrayViews)
+        {
+            const auto& src = *(pair.first);
+            pad();
+
+            const char* buffer = (src.GetDataType() == DataType::Float) ?
+                reinterpret_cast<const char*>(src.DataBuffer<float>()) :
+                reinterpret_cast<const char*>(src.DataBuffer<double>());
+            size_t size = src.Shape().TotalSize() * DataTypeSize(src.GetDataType());
+            for (size_t written = 0; written < size; written += maxChunkSize)
+                output.WriteRaw(buffer + written, (int)std::min(maxChunkSize, size - written));
+            position += size;
+        }
+    }
+
+    bool Serializer::ReadMapped(const std::wstring& filename, Dictionary& dict)
+    {
+        MemoryMappedFile file(filename);
+        auto fileSize = file.Size();
+        if (fileSize < MAPPED_HEADER_SIZE)
+            return false;
+
+        // Map the whole file; the pages of the values are only read from the file (or found in the page cache)
+        // when the values are first accessed. The values are used in place, and a Parameter that is updated
+        // gets private copies of its pages.
+        m_mappedFile = file.Map(0, fileSize, MemoryAccessHint::Normal, MemoryMappingMode::CopyOnWrite);
+        auto header = reinterpret_cast<const uint8*>(m_mappedFile->Data());
+
+        uint32 magic = 0, version = 0;
+        uint64 graphSize = 0, dataOffset = 0, dataSize = 0;
+        header = io::CodedInputStream::ReadLittleEndian32FromArray(header, &magic);
+        header = io::CodedInputStream::ReadLittleEndian32FromArray(header, &version);
+        header = io::CodedInputStream::ReadLittleEndian64FromArray(header, &graphSize);
+        header = io::CodedInputStream::ReadLittleEndian64FromArray(header, &dataOffset);
+        header = io::CodedInputStream::ReadLittleEndian64FromArray(header, &dataSize);
+
+        if (magic != MAPPED_MAGIC_NUMBER || version != MAPPED_FORMAT_VERSION)
+            return false;
+
+        if (graphSize >= static_cast<uint64>(INT_MAX) || MAPPED_HEADER_SIZE + graphSize > dataOffset ||
+            dataOffset > fileSize || dataSize > fileSize - dataOffset || dataOffset % MAPPED_DATA_ALIGNMENT != 0)
+            return false;
+
+        m_mappedData = m_mappedFile->WritableData() + dataOffset;
+        m_mappedDataSize = dataSize;
+
+        m_proto = Arena::CreateMessage<proto::Dictionary>(&m_arena);
+        io::CodedInputStream codedInput(header, (int)graphSize);
+        codedInput.SetTotalBytesLimit(INT_MAX, INT_MAX);
+        if (!m_proto->ParseFromCodedStream(&codedInput) || !codedInput.ConsumedEntireMessage())
+            return false;
+
+        Copy(*dynamic_cast<proto::Dictionary*>(m_proto), dict);
+        return true;
+    }
+
     bool ParseMessage(io::ZeroCopyInputStream& input, Message& msg)
     {
         uint32 prefix = 0, limit = INT_MAX;;
@@ -799,4 +954,47 @@ namespace CNTK
             RuntimeError("Failed to parse DictionaryValue from file (%ls).", filename.c_str());
         return dictionaryValue;
     }
+
+    bool IsMappedModel(std::istream& stream)
+    {
+        char buffer[sizeof(MAPPED_MAGIC_NUMBER)];
+        const auto position = stream.tellg();
+        stream.read(buffer, sizeof(buffer));
+        auto bytesRead = stream.gcount();
+        stream.clear();
+        stream.seekg(position);
+        return IsMappedModel(buffer, (size_t)bytesRead);
+    }
+
+    bool IsMappedModel(const char* buffer, size_t bufferSize)
+    {
+        if (bufferSize < sizeof(MAPPED_MAGIC_NUMBER))
+            return false;
+        uint32 magic = 0;
+        io::CodedInputStream::ReadLittleEndian32FromArray(reinterpret_cast<const uint8*>(buffer), &magic);
+        return magic == MAPPED_MAGIC_NUMBER;
+    }
+
+    void SaveMappedModel(const Dictionary& model, const std::wstring& filename)
+    {
+        // The values being saved may still be mapped from the file being replaced (e.g. a loaded model saved
+        // over itself), so the file must not be rewritten in place: write a new file and rename it over the old one,
+        // which keeps the old file alive until it is unmapped.
+        std::wstring tempFilename = filename + L".tmp";
+
+        // The return values are ignored here.
+        _wunlink(tempFilename.c_str());
+        Serializer(model).WriteMapped(tempFilename);
+        _wunlink(filename.c_str());
+
+        renameOrDie(tempFilename, filename);
+    }
+
+    Dictionary LoadMappedModel(const std::wstring& filename)
+    {
+        Dictionary model;
+        if (!Serializer().ReadMapped(filename, model))
+            RuntimeError("Failed to parse a mapped model from file (%ls).", filename.c_str());
+        return model;
+    }
 }
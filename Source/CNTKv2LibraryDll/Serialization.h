@@ -107,4 +107,14 @@ namespace CNTK
 
         return version;
     }
+
+    // Model files of ModelFormat::CNTKv2Mapped keep the serialized graph apart from the raw NDArrayView values,
+    // which are loaded as views into a (copy-on-write) mapping of the file.
+    bool IsMappedModel(std::istream& stream);
+
+    bool IsMappedModel(const char* buffer, size_t bufferSize);
+
+    void SaveMappedModel(const Dictionary& model, const std::wstring& filename);
+
+    Dictionary LoadMappedModel(const std::wstring& filename);
 }
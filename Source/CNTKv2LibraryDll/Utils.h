@@ -672,6 +672,12 @@ namespace CNTK
         }
         static void VerifyVariableValueCompatibility(const Variable& var, const ValuePtr& value, NDShape* inferredVarShape = nullptr);
 
+        // Creates a layout packing the sequences of the specified lengths into as few parallel streams as possible,
+        // and returns the parallel stream and the first time step of each sequence in 'placement'.
+        // Sequences that began before this minibatch cannot be packed, all sequences then get a parallel stream of their own.
+        static Microsoft::MSR::CNTK::MBLayoutPtr CreatePackedLayout(const std::vector<ptrdiff_t>& sequenceBeginIndices, const std::vector<size_t>& sequenceLengths,
+                                                                    std::vector<std::pair<size_t, size_t>>& placement);
+
         template <typename ElementType>
         static std::pair<std::shared_ptr<const Microsoft::MSR::CNTK::Matrix<ElementType>>, Microsoft::MSR::CNTK::MBLayoutPtr>
         GetCNTKImplMatrixAndMBLayoutFromValueObject(const Variable& var, const ValuePtr& value, NDShape* inferredVarShape,
@@ -312,6 +312,69 @@ namespace CNTK
         return Create(sampleShape, sequencesData, sequenceStartFlags, device, readOnly, /*createNewCopy =*/ true);
     }
 
+    template <typename ElementType>
+    /*static*/ ValuePtr Value::CreatePackedBatchOfSequences(const NDShape& sampleShape, const std::vector<std::vector<ElementType>>& batchOfSequences, const std::vector<bool>& sequenceStartFlags, const DeviceDescriptor& device, bool readOnly)
+    {
+        size_t numSequences = batchOfSequences.size();
+        if (numSequences == 0)
+            InvalidArgument("Value::CreatePackedBatchOfSequences: The number of sequences must be > 0");
+
+        if (sampleShape.HasUnboundDimension())
+            InvalidArgument("Value::CreatePackedBatchOfSequences: The sample shape '%S' must not have free or inferred dimensions.", sampleShape.AsString().c_str());
+
+        if (!sequenceStartFlags.empty() && (sequenceStartFlags.size() != numSequences))
+            InvalidArgument("Value::CreatePackedBatchOfSequences: The number (%zu) of sequence start flags does not match the number (%zu) of sequences.",
+                            sequenceStartFlags.size(), numSequences);
+
+        size_t numElementsPerSample = sampleShape.TotalSize();
+        std::vector<ptrdiff_t> sequenceBeginIndices(numSequences, 0);
+        std::vector<size_t> sequenceLengths(numSequences);
+        for (size_t i = 0; i < numSequences; ++i)
+        {
+            auto& currentSequence = batchOfSequences[i];
+            if (currentSequence.empty() || ((currentSequence.size() % numElementsPerSample) != 0))
+                InvalidArgument("Value::CreatePackedBatchOfSequences: The number of elements (%zu) in the vector containing sequence #%zu must be a non-zero multiple of the size (%zu) of specified sample shape '%S'",
+                                currentSequence.size(), i, numElementsPerSample, sampleShape.AsString().c_str());
+
+            sequenceLengths[i] = currentSequence.size() / numElementsPerSample;
+            if (!sequenceStartFlags.empty() && !sequenceStartFlags[i])
+                sequenceBeginIndices[i] = Microsoft::MSR::CNTK::SentinelValueIndicatingUnspecifedSequenceBeginIdx;
+        }
+
+        std::vector<std::pair<size_t, size_t>> placement;
+        auto layout = Utils::CreatePackedLayout(sequenceBeginIndices, sequenceLengths, placement);
+        size_t numParallelSequences = layout->GetNumParallelSequences();
+
+        // Write the samples of each sequence to the columns of its parallel stream, and zero the few columns of the gaps.
+        auto matrix = std::make_shared<Microsoft::MSR::CNTK::Matrix<ElementType>>(numElementsPerSample, layout->GetNumCols(), CPUDEVICE);
+        ElementType* packedData = matrix->Data();
+        for (size_t i = 0; i < numSequences; ++i)
+        {
+            size_t parallelStreamIdx = placement[i].first;
+            size_t startIdxInParallelStream = placement[i].second;
+            for (size_t j = 0; j < sequenceLengths[i]; ++j)
+            {
+                auto sample = batchOfSequences[i].data() + (j * numElementsPerSample);
+                std::copy(sample, sample + numElementsPerSample, packedData + ((((startIdxInParallelStream + j) * numParallelSequences) + parallelStreamIdx) * numElementsPerSample));
+            }
+        }
+
+        for (const auto& sequenceInfo : layout->GetAllSequences())
+        {
+            if (sequenceInfo.seqId != GAP_SEQUENCE_ID)
+                continue;
+
+            for (size_t t = (size_t)sequenceInfo.tBegin; t < sequenceInfo.tEnd; ++t)
+            {
+                auto gap = packedData + (((t * numParallelSequences) + sequenceInfo.s) * numElementsPerSample);
+                std::fill(gap, gap + numElementsPerSample, (ElementType)0);
+            }
+        }
+
+        matrix->TransferToDeviceIfNotThere(AsCNTKImplDeviceId(device), /*isBeingMoved =*/ true);
+        return MakeSharedObject<PackedValue>(sampleShape, Axis::DefaultInputVariableDynamicAxes(), matrix, layout, readOnly);
+    }
+
     template <typename ElementType>
     /*static*/ ValuePtr Value::CreateBatch(const NDShape& sampleShape, const std::vector<ElementType>& batchData, const DeviceDescriptor& device, bool readOnly /*= false */)
     {
@@ -482,11 +545,16 @@ namespace CNTK
         }
     }
 
+    /*virtual*/ void Value::GetSequenceStartsAndLengths(std::vector<ptrdiff_t>& sequenceBeginIndices, std::vector<size_t>& sequenceLengths, size_t numDynamicAxes) const
+    {
+        GetSequenceStartsAndLengths(Mask(), sequenceBeginIndices, sequenceLengths, numDynamicAxes);
+    }
+
     template <typename ElementType, typename DestType>
-    void DirectCopy(const ElementType *source, size_t elementCount, std::vector<DestType>& dest);
+    void DirectCopy(const ElementType *source, size_t elementCount, std::vector<DestType>& dest, size_t destOffset = 0);
 
     template <typename ElementType, typename DestType>
-    void CopyDenseToOneHot(const ElementType *source, const size_t sampleCount, const size_t sampleSize, std::vector<DestType>& dest);
+    void CopyDenseToOneHot(const ElementType *source, const size_t sampleCount, const size_t sampleSize, std::vector<DestType>& dest, size_t destOffset = 0);
 
     template <typename ElementType>
     void Value::CopyVariableValueToVector(const Variable& outputVariable, std::vector<std::vector<ElementType>>& sequences)
@@ -521,6 +589,11 @@ namespace CNTK
         if (sequences.size() < numOfSequences)
             RuntimeError("The size of output buffer (%zu) is smaller than the number (%zu) of sequences.", sequences.size(), numOfSequences);
 
+        // A PackedValue is copied from its packed data, without creating the padded data first.
+        auto packedValue = dynamic_cast<const PackedValue*>(this);
+        if (packedValue && packedValue->CopyPackedDataTo<ValueType, DestType>(inferredVarShape.TotalSize(), sequences))
+            return;
+
         // Copy data to the CPU device if required.
         const ValueType *valueData;
         NDArrayViewPtr cpuArrayView;
@@ -700,28 +773,87 @@ namespace CNTK
         }
     }
 
+    /*virtual*/ void PackedValue::GetSequenceStartsAndLengths(std::vector<ptrdiff_t>& sequenceBeginIndices, std::vector<size_t>& sequenceLengths, size_t numDynamicAxes) const
+    {
+        if (!m_isPacked || !m_packedDataLayout)
+            return Value::GetSequenceStartsAndLengths(sequenceBeginIndices, sequenceLengths, numDynamicAxes);
+
+        // The layout describes the sequences, there is no need to unpack the data to get a mask.
+        // Sequences are numbered in the order of the layout, like in the unpacked data.
+        size_t maxNumTimeSteps = m_packedDataLayout->GetNumTimeSteps();
+        size_t sequenceIdx = 0;
+        for (const auto& sequenceInfo : m_packedDataLayout->GetAllSequences())
+        {
+            if (sequenceInfo.seqId == GAP_SEQUENCE_ID)
+                continue;
+
+            assert(sequenceIdx < sequenceLengths.size());
+            auto currentSequenceBeginIdx = std::max<ptrdiff_t>(0, sequenceInfo.tBegin);
+            auto currentSequenceEndIdx = std::min(maxNumTimeSteps, sequenceInfo.tEnd);
+            sequenceBeginIndices[sequenceIdx] = (sequenceInfo.tBegin >= 0) ? 0 : Microsoft::MSR::CNTK::SentinelValueIndicatingUnspecifedSequenceBeginIdx;
+            sequenceLengths[sequenceIdx] = currentSequenceEndIdx - currentSequenceBeginIdx;
+            sequenceIdx++;
+        }
+    }
+
+    template <typename ValueType, typename DestType>
+    bool PackedValue::CopyPackedDataTo(size_t sampleSize, std::vector<std::vector<DestType>>& sequences) const
+    {
+        if (!m_isPacked || !m_packedDataLayout || m_packedData->IsSparse() || (m_packedData->Shape()[0] != sampleSize))
+            return false;
+
+        NDArrayViewPtr cpuPackedData = m_packedData;
+        if (m_packedData->Device() != DeviceDescriptor::CPUDevice())
+            cpuPackedData = m_packedData->DeepClone(DeviceDescriptor::CPUDevice());
+
+        const ValueType* packedData = cpuPackedData->DataBuffer<ValueType>();
+        size_t numParallelSequences = m_packedDataLayout->GetNumParallelSequences();
+        size_t maxNumTimeSteps = m_packedDataLayout->GetNumTimeSteps();
+        size_t sequenceIdx = 0;
+        for (const auto& sequenceInfo : m_packedDataLayout->GetAllSequences())
+        {
+            if (sequenceInfo.seqId == GAP_SEQUENCE_ID)
+                continue;
+
+            // The samples of a sequence are strided by the number of parallel sequences in the packed data.
+            auto& dest = sequences[sequenceIdx++];
+            size_t currentSequenceBeginIdx = std::max<ptrdiff_t>(0, sequenceInfo.tBegin);
+            size_t currentSequenceEndIdx = std::min(maxNumTimeSteps, sequenceInfo.tEnd);
+            for (size_t t = currentSequenceBeginIdx; t < currentSequenceEndIdx; ++t)
+            {
+                const ValueType* sample = packedData + (((t * numParallelSequences) + sequenceInfo.s) * sampleSize);
+                if (std::is_same<DestType, size_t>::value)
+                    CopyDenseToOneHot<ValueType, DestType>(sample, 1, sampleSize, dest, t - currentSequenceBeginIdx);
+                else
+                    DirectCopy<ValueType, DestType>(sample, sampleSize, dest, (t - currentSequenceBeginIdx) * sampleSize);
+            }
+        }
+
+        return true;
+    }
+
     template <typename ElementType, typename DestType>
-    void DirectCopy(const ElementType *source, const size_t elementCount, std::vector<DestType>& dest)
+    void DirectCopy(const ElementType *source, const size_t elementCount, std::vector<DestType>& dest, size_t destOffset)
     {
         if (!std::is_same<ElementType, DestType>::value)
             RuntimeError("Copy: Source and destination must be the same data type.");
 
-        DestType *destData = dest.data();
-        if (elementCount > dest.size())
-            RuntimeError("Copy: The output buffer size (%zu) is smaller than the number (%zu) of source elements to copy.", dest.size(), elementCount);
+        DestType *destData = dest.data() + destOffset;
+        if (destOffset + elementCount > dest.size())
+            RuntimeError("Copy: The output buffer size (%zu) is smaller than the number (%zu) of source elements to copy.", dest.size(), destOffset + elementCount);
 
         std::copy(source, source + elementCount, reinterpret_cast<ElementType *>(destData));
     }
 
     template <typename ElementType, typename DestType>
-    void CopyDenseToOneHot(const ElementType *source, const size_t sampleCount, const size_t sampleSize, std::vector<DestType>& dest)
+    void CopyDenseToOneHot(const ElementType *source, const size_t sampleCount, const size_t sampleSize, std::vector<DestType>& dest, size_t destOffset)
     {
         if (!std::is_same<DestType, size_t>::value)
             RuntimeError("Copy: The destination data type must be size_t.");
 
         const ElementType *currentp = source;
         const ElementType *lastp = source + sampleCount * sampleSize;
-        size_t destIndex = 0;
+        size_t destIndex = destOffset;
         while (currentp < lastp)
         {
             size_t index = sampleSize;
@@ -755,6 +887,8 @@ namespace CNTK
     template /*static*/ CNTK_API ValuePtr Value::Create<double>(const NDShape& sampleShape, const std::vector<std::vector<double>>& sequences, const std::vector<bool>& sequenceStartFlags, const DeviceDescriptor& device, bool readOnly/* = false*/);
     template /*static*/ CNTK_API ValuePtr Value::Create<float>(const NDShape& sampleShape, const std::vector<std::vector<size_t>>& oneHotSequences, const std::vector<bool>& sequenceStartFlags, const DeviceDescriptor& device, bool readOnly/* = false*/);
     template /*static*/ CNTK_API ValuePtr Value::Create<double>(const NDShape& sampleShape, const std::vector<std::vector<size_t>>& oneHotSequences, const std::vector<bool>& sequenceStartFlags, const DeviceDescriptor& device, bool readOnly/* = false*/);
+    template /*static*/ CNTK_API ValuePtr Value::CreatePackedBatchOfSequences<float>(const NDShape& sampleShape, const std::vector<std::vector<float>>& batchOfSequences, const std::vector<bool>& sequenceStartFlags, const DeviceDescriptor& device, bool readOnly/* = false*/);
+    template /*static*/ CNTK_API ValuePtr Value::CreatePackedBatchOfSequences<double>(const NDShape& sampleShape, const std::vector<std::vector<double>>& batchOfSequences, const std::vector<bool>& sequenceStartFlags, const DeviceDescriptor& device, bool readOnly/* = false*/);
     template /*static*/ CNTK_API ValuePtr Value::CreateBatch<float>(const NDShape& sampleShape, const std::vector<float>& batchData, const DeviceDescriptor& device, bool readOnly /*= false */);
     template /*static*/ CNTK_API ValuePtr Value::CreateBatch<double>(const NDShape& sampleShape, const std::vector<double>& batchData, const DeviceDescriptor& device, bool readOnly /*= false */);
     template /*static*/ CNTK_API ValuePtr Value::CreateSequence<float>(const NDShape& sampleShape, const std::vector<float>& sequenceData, bool sequenceStartFlag, const DeviceDescriptor& device, bool readOnly /*= false */);
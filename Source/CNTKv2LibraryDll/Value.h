@@ -113,6 +113,11 @@ namespace CNTK
             LogicError("Value::CopyFrom is currently unsupported for PackedValue objects");
         }
 
+        // Copies each sequence straight from the packed data into the corresponding (already resized) buffer in 'sequences'.
+        // Returns false if the data has to be unpacked first, i.e. if it is sparse or has no layout.
+        template <typename ValueType, typename DestType>
+        bool CopyPackedDataTo(size_t sampleSize, std::vector<std::vector<DestType>>& sequences) const;
+
         template <typename ElementType>
         std::pair<std::shared_ptr<const Microsoft::MSR::CNTK::Matrix<ElementType>>, std::shared_ptr<Microsoft::MSR::CNTK::MBLayout>> PackedData()
         {
@@ -146,6 +151,9 @@ namespace CNTK
             return unpackedShape;
         }
 
+    protected:
+        void GetSequenceStartsAndLengths(std::vector<ptrdiff_t>& sequenceBeginIndices, std::vector<size_t>& sequenceLengths, size_t numDynamicAxes) const override;
+
     private:
         PackedValue(const NDShape& sampleShape, const std::vector<Axis>& sampleDynamicAxes, const NDArrayViewPtr& packedData, const std::shared_ptr<Microsoft::MSR::CNTK::MBLayout>& packedDataLayout, bool isReadOnly)
             : Value(nullptr), m_isPacked(true), m_sampleShape(sampleShape), m_sampleDynamicAxes(sampleDynamicAxes), m_packedData(packedData), m_packedDataLayout(packedDataLayout), m_isReadOnly(isReadOnly)
@@ -525,7 +525,11 @@ namespace CNTK
 
             // TODO: this copying here is redundant, value should be moved from the dictionary to the variable.
             // Also, the correct device should be used upfront when deserializing NDArrayView.
-            Variable var(shape, kind, dataType, value.DeepClone(device, value.IsReadOnly()), needsGradient, dynamicAxis, isSparse, name, uid);
+            // Values of a mapped model file are used in place on the CPU, so that the processes mapping the same
+            // model share its pages (the mapping is copy-on-write, a Parameter that is updated gets private pages).
+            auto varValue = (value.HasBufferOwner() && device.Type() == DeviceKind::CPU) ?
+                value.Alias(value.IsReadOnly()) : value.DeepClone(device, value.IsReadOnly());
+            Variable var(shape, kind, dataType, varValue, needsGradient, dynamicAxis, isSparse, name, uid);
             if (var.IsParameter())
                 return Parameter(var);
             else
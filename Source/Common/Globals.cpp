@@ -15,4 +15,9 @@ namespace Microsoft { namespace MSR { namespace CNTK {
 
     std::atomic<bool> Globals::m_enableShareNodeValueMatrices(true);
     std::atomic<bool> Globals::m_optimizeGradientAccumulation(true);
+    std::atomic<bool> Globals::m_fuseElementwiseOperations(false);
+    std::atomic<bool> Globals::m_useDirectConvolution(false);
+
+    std::atomic<size_t> Globals::m_interOpThreads(1);
+    std::atomic<unsigned long> Globals::m_scheduleSeed(0);
 }}}
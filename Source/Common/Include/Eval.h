@@ -26,6 +26,7 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <stdexcept>
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -332,7 +333,8 @@ public:
     // The layout and shape of the data in inputs vector must match the schema returned by GetInputLayouts.
     // Output must be preallocated and sized to avoid memory allocation / deallocation across DLL
     // boundaries.
-    // This method is not reentrant, as the forward pass keeps internal state.
+    // This method is not reentrant, as the forward pass keeps internal state. To evaluate concurrently,
+    // use one execution context (see CreateExecutionContext()) per thread.
     // inputs - vector of input buffers, one for every input as given by GetInputLayouts()
     // outputs - vector of output buffers. Must be sized to fit output schema.
     //
@@ -355,6 +357,19 @@ public:
     // resetRNN - flags whether to reset memory cells of RNN. 
     //
     virtual void ForwardPass(const ValueRefs<ElemType>& inputs, ValueRefs<ElemType>& output, bool resetRNN) = 0;
+
+    //
+    // CreateExecutionContext - create an evaluator that shares the model parameters of this one, but has its own
+    // buffers for the activations. Must be called after StartForwardEvaluation(); the new evaluator is ready
+    // for ForwardPass() with the same outputs. Different execution contexts (and this evaluator) can evaluate
+    // concurrently from different threads. The parameters stay owned by this evaluator, so all execution contexts
+    // must be destroyed (by calling their Destroy()) before this one is.
+    // Evaluators that do not support execution contexts keep this default, which throws.
+    //
+    virtual IEvaluateModelExtended<ElemType>* CreateExecutionContext()
+    {
+        throw std::runtime_error("CreateExecutionContext: Not supported by this evaluator.");
+    }
 };
 
 template <typename ElemType>
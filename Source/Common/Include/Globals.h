@@ -6,6 +6,7 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -28,11 +29,31 @@ namespace Microsoft { namespace MSR { namespace CNTK {
         static void SetShareNodeValueMatrices(bool enable) { m_enableShareNodeValueMatrices = enable; }
         static bool ShouldEnableShareNodeValueMatrices() { return m_enableShareNodeValueMatrices; }
 
+        // Let CPU convolutions use the direct/Winograd engine, which picks the fastest implementation per layer by timing it.
+        static void SetDirectConvolution(bool enable) { m_useDirectConvolution = enable; }
+        static bool ShouldUseDirectConvolution() { return m_useDirectConvolution; }
+
+        // Replace an activation (Sigmoid, Tanh, RectifiedLinear) of a Plus node by a fused node when compiling a network.
+        // The fusion is not saved with the model.
+        static void SetElementwiseFusion(bool enable) { m_fuseElementwiseOperations = enable; }
+        static bool ShouldFuseElementwiseOperations() { return m_fuseElementwiseOperations; }
+
+        // Number of threads that execute independent nodes of a network concurrently (1 = one node at a time).
+        // The seed randomizes the order in which idle threads steal work. Each of the threads uses a share of the
+        // intra-op (OpenMP/BLAS) threads, so reductions can round differently than with one node at a time.
+        static void SetInterOpParallelism(size_t numThreads, unsigned long scheduleSeed) { m_interOpThreads = numThreads; m_scheduleSeed = scheduleSeed; }
+        static size_t GetInterOpThreads() { return m_interOpThreads; }
+        static unsigned long GetScheduleSeed() { return m_scheduleSeed; }
+
     private:
         static std::atomic<bool> m_forceDeterministicAlgorithms;
         // The global flag to enable matrices values in forward and backward prop
         static std::atomic<bool> m_enableShareNodeValueMatrices;
         static std::atomic<bool> m_forceConstantRandomSeed;
         static std::atomic<bool> m_optimizeGradientAccumulation;
+        static std::atomic<bool> m_fuseElementwiseOperations;
+        static std::atomic<bool> m_useDirectConvolution;
+        static std::atomic<size_t> m_interOpThreads;
+        static std::atomic<unsigned long> m_scheduleSeed;
     };
 }}}
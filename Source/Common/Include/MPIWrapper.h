@@ -43,6 +43,7 @@ typedef void *MPI_Status;
 #include <array>
 #include <vector>
 #include <memory>
+#include <functional>
 
 #include "CommonMatrix.h"
 
@@ -93,6 +94,14 @@ public:
     // Use GPUDirect RDMA support
     virtual bool UseGpuGdr() = 0;
 
+    // Runs an operation that calls into this MPIWrapper on a background thread. Only one such operation can be
+    // pending; all other data-exchange functions wait for it first, so that MPI is only called by one thread at a time
+    // and all ranks issue their collective operations in the same order.
+    virtual void RunAsync(const std::function<void()>& operation) = 0;
+
+    // Waits for the operation started by RunAsync(), if any, and rethrows its error.
+    virtual void WaitForAsync() const = 0;
+
     // -----------------------------------------------------------------------
     // data-exchange functions (wrappers around MPI functions)
     // -----------------------------------------------------------------------
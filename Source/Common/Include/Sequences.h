@@ -608,6 +608,7 @@ private:
     // A value of 1 indicates that the column has valid content
     // and 0 indicates invalid (aka MinibatchPackingFlags::NoInput)
     mutable Matrix<char> m_columnsValidityMask;
+    mutable std::mutex m_columnsValidityMaskMutex; // nodes that share this layout may run concurrently
 
     // A boolean flag indicating whether the MBLayout can be further modified
     // When it's value is false, no set operations are allowed on the MBLayout.
@@ -910,6 +911,7 @@ inline const Matrix<char>& MBLayout::GetColumnsValidityMask(DEVICEID_TYPE device
 {
     CheckIsValid();
     // lazily compute the validity mask
+    std::lock_guard<std::mutex> lock(m_columnsValidityMaskMutex);
     if (m_columnsValidityMask.IsEmpty())
     {
         assert(HasGaps()); // must only be called if there are gaps
@@ -5,6 +5,7 @@
 #include "Include/Basics.h"
 #include "Include/MPIWrapper.h"
 #include "Include/EnvironmentUtil.h"
+#include <future>
 
 #if HAS_MPI
 #pragma comment(lib, "msmpi.lib")
@@ -34,6 +35,9 @@ class MPIWrapperMpi : public MPIWrapper
     // MPI communicator that reflects the current subset selection
     MPI_Comm m_currentComm;
 
+    // operation started by RunAsync(); mutable, since the const data-exchange functions wait for it as well
+    mutable std::future<void> m_asyncOperation;
+
     // MPI_Init() is loading the msmpi.dll. Failing to load the dll will terminate the
     // application.
     int MPI_Init_DL();
@@ -75,6 +79,9 @@ public:
     // Use GPUDirect RDMA support
     virtual bool UseGpuGdr() override;
 
+    virtual void RunAsync(const std::function<void()>& operation) override;
+    virtual void WaitForAsync() const override;
+
     // -----------------------------------------------------------------------
     // data-exchange functions (wrappers around MPI functions)
     // -----------------------------------------------------------------------
@@ -172,6 +179,9 @@ public:
     // Use GPUDirect RDMA
     virtual bool UseGpuGdr() override;
 
+    virtual void RunAsync(const std::function<void()>& operation) override;
+    virtual void WaitForAsync() const override;
+
     // -----------------------------------------------------------------------
     // data-exchange functions (wrappers around MPI functions)
     // -----------------------------------------------------------------------
@@ -461,6 +471,7 @@ int MPIWrapperMpi::MPI_Init_DL()
     int argc = 0;
     char **argv = NULL;
     // TODO(qiwye) Multiverso(parameter server) will benefit from MPI_THREAD_MULTIPLE .
+    // Operations of RunAsync() call MPI from a background thread, but all other calls wait for them, see WaitForAsync().
     int requiredThreadLevelSupport = MPI_THREAD_SERIALIZED;
     int provided;
     int ret = MPI_Init_thread(&argc, &argv, requiredThreadLevelSupport, &provided);
@@ -597,52 +608,62 @@ MPI_Comm MPIWrapperMpi::Communicator() const
 
 int MPIWrapperMpi::Finalize(void)
 {
+    WaitForAsync();
     return MPI_Finalize();
 }
 
 // wait for all ranks to reach here
 int MPIWrapperMpi::WaitAll()
 {
+    WaitForAsync();
     return MPI_Barrier(m_currentComm) || MpiFail("waitall: MPI_Barrier");
 }
 
 int MPIWrapperMpi::Wait(MPI_Request* request, MPI_Status* status)
 {
+    WaitForAsync();
     return MPI_Wait(request, status);
 }
 
 int MPIWrapperMpi::WaitAll(std::vector<MPI_Request>& requests)
 {
+    WaitForAsync();
     return MPI_Waitall((int)requests.size(), &requests[0], MPI_STATUSES_IGNORE) || MpiFail("waitall: MPI_Waitall");
 }
 
 int MPIWrapperMpi::Waitany(int count, MPI_Request array_of_requests[], int* index, MPI_Status* status)
 {
+    WaitForAsync();
     return MPI_Waitany(count, array_of_requests, index, status);
 }
 
 int MPIWrapperMpi::Waitall(int count, MPI_Request array_of_requests[], MPI_Status array_of_statuses[])
 {
+    WaitForAsync();
     return MPI_Waitall(count, array_of_requests, array_of_statuses);
 }
 
 int MPIWrapperMpi::Isend(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Request* request)
 {
+    WaitForAsync();
     return MPI_Isend(buf, count, datatype, dest, tag, m_currentComm, request);
 }
 
 int MPIWrapperMpi::Recv(void* buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Status* status)
 {
+    WaitForAsync();
     return MPI_Recv(buf, count, datatype, source, tag, m_currentComm, status);
 }
 
 int MPIWrapperMpi::Irecv(void* buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Request* request)
 {
+    WaitForAsync();
     return MPI_Irecv(buf, count, datatype, source, tag, m_currentComm, request);
 }
 
 int MPIWrapperMpi::Iallreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Request* request)
 {
+    WaitForAsync();
     return MPI_Iallreduce(sendbuf, recvbuf, count, datatype, op, m_currentComm, request);
 }
 
@@ -667,6 +688,28 @@ bool MPIWrapperMpi::UseGpuGdr()
 #endif
 }
 
+// set on the thread that runs the operation of RunAsync(), which calls into MPI itself and must not wait for itself
+static thread_local bool t_isAsyncOperation = false;
+
+void MPIWrapperMpi::RunAsync(const std::function<void()>& operation)
+{
+    if (t_isAsyncOperation)
+        LogicError("RunAsync: cannot be called from an asynchronous operation");
+
+    WaitForAsync();
+    m_asyncOperation = std::async(std::launch::async, [operation]
+    {
+        t_isAsyncOperation = true;
+        operation();
+    });
+}
+
+void MPIWrapperMpi::WaitForAsync() const
+{
+    if (!t_isAsyncOperation && m_asyncOperation.valid())
+        m_asyncOperation.get();
+}
+
 size_t MPIWrapperMpi::NumNodesInUse() const
 {
     return m_numNodesInUse;
@@ -762,26 +805,31 @@ void MPIWrapperMpi::AllReduce(float* sendData, size_t numElements, MPI_Op op) co
 
 void MPIWrapperMpi::AllReduce(size_t* sendData, size_t* receiveData, size_t numElements, MPI_Op op) const
 {
+    WaitForAsync();
     MPI_Allreduce(sendData, receiveData, (int)numElements, GetDataType(sendData), op, Communicator()) || MpiFail("Allreduce: MPI_Allreduce");
 }
 
 void MPIWrapperMpi::AllReduce(int* sendData, int* receiveData, size_t numElements, MPI_Op op) const
 {
+    WaitForAsync();
     MPI_Allreduce(sendData, receiveData, (int)numElements, GetDataType(sendData), op, Communicator()) || MpiFail("Allreduce: MPI_Allreduce");
 }
 
 void MPIWrapperMpi::AllReduce(double* sendData, double* receiveData, size_t numElements, MPI_Op op) const
 {
+    WaitForAsync();
     MPI_Allreduce(sendData, receiveData, (int)numElements, GetDataType(sendData), op, Communicator()) || MpiFail("Allreduce: MPI_Allreduce");
 }
 
 void MPIWrapperMpi::AllReduce(float* sendData, float* receiveData, size_t numElements, MPI_Op op) const
 {
+    WaitForAsync();
     MPI_Allreduce(sendData, receiveData, (int)numElements, GetDataType(sendData), op, Communicator()) || MpiFail("Allreduce: MPI_Allreduce");
 }
 
 void MPIWrapperMpi::Bcast(size_t* sendData, size_t numElements, size_t srcRank)
 {
+    WaitForAsync();
     MPI_Bcast(sendData, (int)numElements, GetDataType(sendData), (int)srcRank, Communicator()) || MpiFail("Bcast: MPI_Bcast");
 }
 
@@ -807,136 +855,163 @@ void MPIWrapperMpi::AllReduceAsync(float* sendData, size_t numElements, MPI_Requ
 
 void MPIWrapperMpi::AllReduceAsync(size_t *sendData, size_t *receiveData, size_t numElements, MPI_Request* request, MPI_Op op) const
 {
+    WaitForAsync();
     MPI_Iallreduce(sendData, receiveData, (int)numElements, GetDataType(sendData), op, Communicator(), request) || MpiFail("AllReduceAsync: MPI_Iallreduce");
 }
 
 void MPIWrapperMpi::AllReduceAsync(int *sendData, int *receiveData, size_t numElements, MPI_Request* request, MPI_Op op) const
 {
+    WaitForAsync();
     MPI_Iallreduce(sendData, receiveData, (int)numElements, GetDataType(sendData), op, Communicator(), request) || MpiFail("AllReduceAsync: MPI_Iallreduce");
 }
 void MPIWrapperMpi::AllReduceAsync(double *sendData, double *receiveData, size_t numElements, MPI_Request* request, MPI_Op op) const
 {
+    WaitForAsync();
     MPI_Iallreduce(sendData, receiveData, (int)numElements, GetDataType(sendData), op, Communicator(), request) || MpiFail("AllReduceAsync: MPI_Iallreduce");
 }
 void MPIWrapperMpi::AllReduceAsync(float *sendData, float *receiveData, size_t numElements, MPI_Request* request, MPI_Op op) const
 {
+    WaitForAsync();
     MPI_Iallreduce(sendData, receiveData, (int)numElements, GetDataType(sendData), op, Communicator(), request) || MpiFail("AllReduceAsync: MPI_Iallreduce");
 }
 
 
 void MPIWrapperMpi::Bcast(double* sendData, size_t numElements, size_t srcRank)
 {
+    WaitForAsync();
     MPI_Bcast(sendData, (int)numElements, GetDataType(sendData), (int)srcRank, Communicator()) || MpiFail("Bcast: MPI_Bcast");
 }
 
 void MPIWrapperMpi::Bcast(float* sendData, size_t numElements, size_t srcRank)
 {
+    WaitForAsync();
     MPI_Bcast(sendData, (int)numElements, GetDataType(sendData), (int)srcRank, Communicator()) || MpiFail("Bcast: MPI_Bcast");
 }
 
 void MPIWrapperMpi::Bcast(void* buffer, int count, MPI_Datatype datatype, int root)
 {
+    WaitForAsync();
     MPI_Bcast(buffer, count, datatype, root, Communicator()) || MpiFail("Bcast: MPI_Bcast");
 }
 
 void MPIWrapperMpi::AllGatherAsync(const size_t *sendData, size_t numSendElements, size_t *receiveData, size_t numRecvElements, MPI_Request* request) const
 {
+    WaitForAsync();
     MPI_Iallgather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), Communicator(), request) || MpiFail("AllReduceAsync: MPI_Iallgather");
 }
 
 void MPIWrapperMpi::AllGatherAsync(const int *sendData, size_t numSendElements, int *receiveData, size_t numRecvElements, MPI_Request* request) const
 {
+    WaitForAsync();
     MPI_Iallgather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), Communicator(), request) || MpiFail("AllReduceAsync: MPI_Iallgather");
 }
 
 void MPIWrapperMpi::AllGatherAsync(const float *sendData, size_t numSendElements, float *receiveData, size_t numRecvElements, MPI_Request* request) const
 {
+    WaitForAsync();
     MPI_Iallgather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), Communicator(), request) || MpiFail("AllReduceAsync: MPI_Iallgather");
 }
 
 void MPIWrapperMpi::AllGatherAsync(const double *sendData, size_t numSendElements, double *receiveData, size_t numRecvElements, MPI_Request* request) const
 {
+    WaitForAsync();
     MPI_Iallgather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), Communicator(), request) || MpiFail("AllReduceAsync: MPI_Iallgather");
 }
 
 void MPIWrapperMpi::AllGather(const size_t *sendData, size_t numSendElements, size_t *receiveData, size_t numRecvElements) const
 {
+    WaitForAsync();
     MPI_Allgather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), Communicator()) || MpiFail("AllReduceAsync: MPI_Allgather");
 }
 
 void MPIWrapperMpi::AllGather(const int *sendData, size_t numSendElements, int *receiveData, size_t numRecvElements) const
 {
+    WaitForAsync();
     MPI_Allgather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), Communicator()) || MpiFail("AllReduceAsync: MPI_Allgather");
 }
 
 void MPIWrapperMpi::AllGather(const float *sendData, size_t numSendElements, float *receiveData, size_t numRecvElements) const
 {
+    WaitForAsync();
     MPI_Allgather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), Communicator()) || MpiFail("AllReduceAsync: MPI_Allgather");
 }
 
 void MPIWrapperMpi::AllGather(const double *sendData, size_t numSendElements, double*receiveData, size_t numRecvElements) const
 {
+    WaitForAsync();
     MPI_Allgather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), Communicator()) || MpiFail("AllReduceAsync: MPI_Allgather");
 }
 
 void MPIWrapperMpi::Allgather(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount, MPI_Datatype recvtype) const
 {
+    WaitForAsync();
     MPI_Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, Communicator()) || MpiFail("AllReduceAsync: MPI_Allgather");
 }
 
 void MPIWrapperMpi::Gather(const size_t *sendData, size_t numSendElements, size_t *receiveData, size_t numRecvElements, size_t rootRank) const
 {
+    WaitForAsync();
     MPI_Gather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), (int)rootRank, Communicator()) || MpiFail("AllReduceAsync: MPI_Gather");
 }
 
 void MPIWrapperMpi::Gather(const int *sendData, size_t numSendElements, int *receiveData, size_t numRecvElements, size_t rootRank) const
 {
+    WaitForAsync();
     MPI_Gather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), (int)rootRank, Communicator()) || MpiFail("AllReduceAsync: MPI_Gather");
 }
 
 void MPIWrapperMpi::Gather(const float *sendData, size_t numSendElements, float *receiveData, size_t numRecvElements, size_t rootRank) const
 {
+    WaitForAsync();
     MPI_Gather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), (int)rootRank, Communicator()) || MpiFail("AllReduceAsync: MPI_Gather");
 }
 
 void MPIWrapperMpi::Gather(const double *sendData, size_t numSendElements, double *receiveData, size_t numRecvElements, size_t rootRank) const
 {
+    WaitForAsync();
     MPI_Gather(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, (int)numRecvElements, GetDataType(receiveData), (int)rootRank, Communicator()) || MpiFail("AllReduceAsync: MPI_Gather");
 }
 
 void MPIWrapperMpi::Gatherv(const size_t *sendData, size_t numSendElements, size_t *receiveData, int recvCounts[], int offsets[], size_t rootRank) const
 {
+    WaitForAsync();
     MPI_Gatherv(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, recvCounts, offsets, GetDataType(receiveData), (int)rootRank, Communicator()) || MpiFail("AllReduceAsync: MPI_Gatherv");
 }
 
 void MPIWrapperMpi::Gatherv(const char *sendData, size_t numSendElements, char *receiveData, int recvCounts[], int offsets[], size_t rootRank) const
 {
+    WaitForAsync();
     MPI_Gatherv(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, recvCounts, offsets, GetDataType(receiveData), (int)rootRank, Communicator()) || MpiFail("AllReduceAsync: MPI_Gatherv");
 }
 
 void MPIWrapperMpi::Gatherv(const int *sendData, size_t numSendElements, int *receiveData, int recvCounts[], int offsets[], size_t rootRank) const
 {
+    WaitForAsync();
     MPI_Gatherv(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, recvCounts, offsets, GetDataType(receiveData), (int)rootRank, Communicator()) || MpiFail("AllReduceAsync: MPI_Gatherv");
 }
 
 void MPIWrapperMpi::Gatherv(const float *sendData, size_t numSendElements, float *receiveData, int recvCounts[], int offsets[], size_t rootRank) const
 {
+    WaitForAsync();
     MPI_Gatherv(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, recvCounts, offsets, GetDataType(receiveData), (int)rootRank, Communicator()) || MpiFail("AllReduceAsync: MPI_Gatherv");
 }
 
 void MPIWrapperMpi::Gatherv(const double *sendData, size_t numSendElements, double *receiveData, int recvCounts[], int offsets[], size_t rootRank) const
 {
+    WaitForAsync();
     MPI_Gatherv(sendData, (int)numSendElements, GetDataType(receiveData), receiveData, recvCounts, offsets, GetDataType(receiveData), (int)rootRank, Communicator()) || MpiFail("AllReduceAsync: MPI_Gatherv");
 }
 
 // wait for an async request to finish
 void MPIWrapperMpi::Wait(MPI_Request* request)
 {
+    WaitForAsync();
     MPI_Wait(request, MPI_STATUSES_IGNORE) || MpiFail("Wait: MPI_Wait");
 }
 
 void MPIWrapperMpi::WaitAny(MPI_Request* requests, int numRequests, int* index)
 {
+    WaitForAsync();
     MPI_Waitany(numRequests, requests, index, MPI_STATUSES_IGNORE) || MpiFail("WaitAny: MPI_Waitany");
 }
 
@@ -978,6 +1053,16 @@ bool MPIWrapperEmpty::UseGpuGdr()
     return false;
 }
 
+// without MPI there is nothing to overlap with
+void MPIWrapperEmpty::RunAsync(const std::function<void()>& operation)
+{
+    operation();
+}
+
+void MPIWrapperEmpty::WaitForAsync() const
+{
+}
+
 int MPIWrapperEmpty::Finalize(void)
 {
     return MPI_UNDEFINED;
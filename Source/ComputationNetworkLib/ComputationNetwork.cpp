@@ -26,6 +26,7 @@
 #include <stack>
 #include <list>
 #include <set>
+#include <algorithm>
 
 using namespace std;
 
@@ -115,7 +116,13 @@ void ComputationNetwork::SaveToFileImpl(const wstring& fileName, const FileOptio
     fstream << (size_t) CURRENT_CNTK_MODEL_VERSION;
     fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EVersion");
 
-    fstream << (size_t) m_nameToNodeMap.size();
+    // Nodes fused by FuseElementwiseOperations() are saved as the Plus node and the activation they replace,
+    // so that models do not depend on whether fusion was enabled.
+    size_t numFusedNodes = count_if(m_nameToNodeMap.begin(), m_nameToNodeMap.end(), [](const pair<const wstring, ComputationNodeBasePtr>& iter)
+    {
+        return dynamic_pointer_cast<IActivationOfPlusNode>(iter.second) != nullptr;
+    });
+    fstream << (size_t) (m_nameToNodeMap.size() + numFusedNodes);
 
     // put all node info first
     fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BNodeList");
@@ -132,7 +139,19 @@ void ComputationNetwork::SaveToFileImpl(const wstring& fileName, const FileOptio
         else LogicError("Unexpected node type.");
         fstream << precision;
 #endif
-        fstream << nodePtr->OperationName();
+        auto fusedNode = dynamic_pointer_cast<IActivationOfPlusNode>(nodePtr);
+        if (fusedNode)
+        {
+            // the Plus node has nothing to save but its type and name
+            fstream << OperationNameOf(PlusNode);
+            fstream << fusedNode->PlusNodeName();
+#if CURRENT_CNTK_MODEL_VERSION >= CNTK_MODEL_VERSION_7
+            fstream << precision;
+#endif
+            fstream << fusedNode->ActivationOperationName();
+        }
+        else
+            fstream << nodePtr->OperationName();
         // name
         fstream << nodePtr->NodeName();
         // content
@@ -146,6 +165,16 @@ void ComputationNetwork::SaveToFileImpl(const wstring& fileName, const FileOptio
     for (auto nodeIter = m_nameToNodeMap.begin(); nodeIter != m_nameToNodeMap.end(); nodeIter++)
     {
         ComputationNodeBasePtr nodePtr = nodeIter->second;
+        auto fusedNode = dynamic_pointer_cast<IActivationOfPlusNode>(nodePtr);
+        if (fusedNode)
+        {
+            // the Plus node reads the inputs of the fused node, the activation reads the Plus node
+            fstream << fusedNode->PlusNodeName() << nodePtr->GetNumInputs();
+            for (size_t i = 0; i < nodePtr->GetNumInputs(); i++)
+                fstream << nodePtr->Input(i)->NodeName();
+            fstream << nodePtr->NodeName() << (size_t) 1 << fusedNode->PlusNodeName();
+            continue;
+        }
         fstream << nodePtr->NodeName() << nodePtr->GetNumInputs();
         for (size_t i = 0; i < nodePtr->GetNumInputs(); i++)
         {
@@ -174,8 +174,9 @@ public:
     template <class NODESET> // version that takes multiple nodes
     void ForwardProp(const NODESET& nodes)
     {
-        TravserseInSortedGlobalEvalOrder(nodes, [](const ComputationNodeBasePtr& node) {
-            PARTraversalFlowControlNode::ForwardProp(node, FrameRange(nullptr));
+        bool profile = PARTraversalFlowControlNode::ProfileNodes();
+        TravserseInSortedGlobalEvalOrder(nodes, [profile](const ComputationNodeBasePtr& node) {
+            PARTraversalFlowControlNode::ForwardProp(node, FrameRange(nullptr), profile);
         });
     }
 
@@ -204,9 +205,10 @@ public:
         });
 
         // Perform forward on resulting nodes in global evaluation order.
+        bool profile = PARTraversalFlowControlNode::ProfileNodes();
         for (const auto& node : SortByGlobalEvalOrder(nodesToForward))
         {
-            ComputationNetwork::PARTraversalFlowControlNode::ForwardProp(node, FrameRange(nullptr));
+            ComputationNetwork::PARTraversalFlowControlNode::ForwardProp(node, FrameRange(nullptr), profile);
         }
     }
 
@@ -473,6 +475,19 @@ public:
     //ComputationNodeBasePtr RemoveFeatureNode(ComputationNodeBasePtr featureNode);
     void SetLearnableNodesBelowLearningRateMultiplier(const float learningRateMultiplier, const ComputationNodeBasePtr& rootNode = nullptr);
 
+    // Replaces each activation (Sigmoid, Tanh, RectifiedLinear) whose input is a Plus node that feeds nothing else
+    // by a single fused node (see ActivationOfPlusNodeBase) under the activation's name. Tagged Plus nodes are kept.
+    // Called by CompileNetwork() if Globals::ShouldFuseElementwiseOperations(). Returns the number of fused nodes.
+    // The fusion only lives in memory; Save() writes the original Plus and activation nodes.
+    size_t FuseElementwiseOperations();
+
+    // Creates a copy of this network that references the values of the parameters (LearnableParameter and
+    // precompute nodes) of this one instead of copying them. All other nodes get their own, empty value matrices,
+    // so that copies can be evaluated concurrently with each other and with this network, as long as nobody
+    // modifies the parameters. The copy is compiled, but its matrices are not allocated yet.
+    template <class ElemType>
+    ComputationNetworkPtr CloneWithSharedParameters() const;
+
     // -----------------------------------------------------------------------
     // node access
     // -----------------------------------------------------------------------
@@ -1182,7 +1197,8 @@ protected:
             return L"PARTraversalFlowControlNode";
         }
 
-        static void ForwardProp(const ComputationNodeBasePtr& node, const FrameRange& fr);
+        static void ForwardProp(const ComputationNodeBasePtr& node, const FrameRange& fr, bool profile = false);
+        static bool ProfileNodes(); // whether passes over single nodes are reported to the profiler; test once per pass over the network
         static void PostForwardAndBackProp(const ComputationNodeBasePtr& node);
 
         virtual void BeginForwardProp() override {}
@@ -9,10 +9,15 @@
 #include "ComputationNode.h"
 #include "ComputationNetwork.h"
 #include "InputAndParamNodes.h"
+#include "LinearAlgebraNodes.h"
+#include "NonlinearityNodes.h"
 #include "TrainingNodes.h"
 #include <string>
 #include <vector>
 #include <list>
+#include <map>
+#include <set>
+#include <algorithm>
 
 using namespace std;
 
@@ -97,6 +102,61 @@ void ComputationNetwork::CopySubTree(const ComputationNetwork& fromNet,
     }
 }
 
+template <class ElemType>
+ComputationNetworkPtr ComputationNetwork::CloneWithSharedParameters() const
+{
+    auto clone = make_shared<ComputationNetwork>(GetDeviceId());
+    clone->SetTraceLevel(TraceLevel());
+    clone->SetRandomSeedOffset(GetRandomSeedOffset());
+
+    // copy the nodes, sharing all value matrices for now
+    map<ComputationNodeBasePtr, ComputationNodeBasePtr> clonedNodes;
+    for (const auto& nameAndNode : m_nameToNodeMap)
+    {
+        const auto& node = nameAndNode.second;
+        auto clonedNode = node->Duplicate(node->NodeName(), (CopyNodeFlags)(CopyNodeFlags::copyNodeValue | CopyNodeFlags::copyNodeShareValue));
+
+        // everything that is not a parameter is computed, and gets its own matrix of the same kind
+        bool isParameter = node->OperationName() == OperationNameOf(LearnableParameter) || node->Is<IPreComputeNode>();
+        if (!isParameter)
+        {
+            auto typedNode = dynamic_pointer_cast<ComputationNode<ElemType>>(clonedNode);
+            if (!typedNode)
+                LogicError("CloneWithSharedParameters: %ls %ls operation has an unexpected element type.", node->NodeName().c_str(), node->OperationName().c_str());
+            auto& value = typedNode->ValuePtrRef();
+            if (value)
+                value = make_shared<Matrix<ElemType>>(0, 0, value->GetDeviceId(), value->GetMatrixType(), value->GetFormat());
+        }
+
+        clonedNodes[node] = clonedNode;
+        clone->AddNodeToNet(clonedNode);
+    }
+
+    // link the copies like the originals
+    for (const auto& originalAndClone : clonedNodes)
+    {
+        vector<ComputationNodeBasePtr> inputs;
+        for (const auto& input : originalAndClone.first->GetInputs())
+            inputs.push_back(clonedNodes.at(input));
+        originalAndClone.second->AttachInputs(inputs);
+    }
+
+    // same node groups, in the same order
+    auto nodeGroups = const_cast<ComputationNetwork&>(*this).GetAllNodeGroups();
+    auto clonedNodeGroups = clone->GetAllNodeGroups();
+    for (size_t i = 0; i < nodeGroups.size(); i++)
+    {
+        for (const auto& node : *nodeGroups[i])
+            clonedNodeGroups[i]->push_back(clonedNodes.at(node));
+    }
+
+    clone->CompileNetwork();
+    return clone;
+}
+
+template ComputationNetworkPtr ComputationNetwork::CloneWithSharedParameters<float>() const;
+template ComputationNetworkPtr ComputationNetwork::CloneWithSharedParameters<double>() const;
+
 // you can only copy inputs from nodes in the same network
 void ComputationNetwork::CopyInputs(const std::wstring fromName, std::wstring toName)
 {
@@ -339,6 +399,80 @@ ComputationNodeBasePtr ComputationNetwork::RemoveFeatureNode(ComputationNodeBase
 }
 #endif
 
+// creates the node that fuses the given activation with the Plus node that is its input, or returns nullptr if there is none
+template <class ElemType>
+static ComputationNodeBasePtr NewActivationOfPlusNode(const ComputationNodeBasePtr& activation)
+{
+    auto deviceId = activation->GetDeviceId();
+    const auto& name = activation->NodeName();
+    if (activation->OperationName() == OperationNameOf(SigmoidNode))
+        return New<SigmoidOfPlusNode<ElemType>>(deviceId, name);
+    else if (activation->OperationName() == OperationNameOf(TanhNode))
+        return New<TanhOfPlusNode<ElemType>>(deviceId, name);
+    else if (activation->OperationName() == OperationNameOf(RectifiedLinearNode))
+        return New<RectifiedLinearOfPlusNode<ElemType>>(deviceId, name);
+    else
+        return nullptr;
+}
+
+size_t ComputationNetwork::FuseElementwiseOperations()
+{
+    // a Plus node can only be fused if the activation is the only node that reads its value
+    map<ComputationNodeBasePtr, size_t> numConsumers;
+    for (const auto& iter : m_nameToNodeMap)
+    {
+        for (const auto& input : iter.second->GetInputs())
+            numConsumers[input]++;
+    }
+    set<ComputationNodeBasePtr> taggedNodes;
+    for (auto group : GetAllNodeGroups())
+        taggedNodes.insert(group->begin(), group->end());
+
+    // determine all pairs first, since fusing modifies m_nameToNodeMap
+    vector<pair<ComputationNodeBasePtr, ComputationNodeBasePtr>> fusions; // (activation, fused node)
+    for (const auto& iter : m_nameToNodeMap)
+    {
+        const auto& activation = iter.second;
+        if (activation->GetNumInputs() != 1)
+            continue;
+        const auto& plus = activation->GetInputs()[0];
+        if (!plus || plus->OperationName() != OperationNameOf(PlusNode) || numConsumers[plus] != 1 || taggedNodes.find(plus) != taggedNodes.end())
+            continue;
+
+        bool isFloat = dynamic_pointer_cast<ComputationNode<float>>(activation) != nullptr;
+        if (isFloat != (dynamic_pointer_cast<ComputationNode<float>>(plus) != nullptr))
+            continue;
+        auto fused = isFloat ? NewActivationOfPlusNode<float>(activation) : NewActivationOfPlusNode<double>(activation);
+        if (fused)
+            fusions.push_back(make_pair(activation, fused));
+    }
+
+    if (!fusions.empty())
+        InvalidateCompiledNetwork();
+
+    for (const auto& fusion : fusions)
+    {
+        auto activation = fusion.first;
+        auto plus = activation->GetInputs()[0];
+        auto fused = fusion.second;
+
+        // the fused node reads the summands and takes over the activation's name, consumers and node groups
+        // it remembers the name of the Plus node, so that the model can be saved without fused nodes
+        dynamic_pointer_cast<IActivationOfPlusNode>(fused)->SetPlusNodeName(plus->NodeName());
+        fused->AttachInputs(plus->GetInputs());
+        ChangeNodeInputs(activation, fused);
+        for (auto group : GetAllNodeGroups())
+            replace(group->begin(), group->end(), activation, fused);
+
+        activation->DetachInputs();
+        plus->DetachInputs();
+        RemoveNodeFromNet(activation);
+        RemoveNodeFromNet(plus);
+        AddNodeToNet(fused);
+    }
+    return fusions.size();
+}
+
 // sets m_learningRateMultiplier in all LearnableParameters feeding into the passed rootNode
 // Called from MEL
 void ComputationNetwork::SetLearnableNodesBelowLearningRateMultiplier(const float learningRateMultiplier, const ComputationNodeBasePtr& rootNode)
@@ -11,6 +11,9 @@
 #include "RecurrentNodes.h"
 #include "InputAndParamNodes.h"
 #include "LinearAlgebraNodes.h"
+#include "ConvolutionalNodes.h"
+#include "InterOpScheduler.h"
+#include "PerformanceProfiler.h"
 #include <string>
 #include <vector>
 #include <list>
@@ -112,6 +115,7 @@ ComputationNodeBasePtr ComputationNetwork::GetNestedNetwork(const ComputationNod
 // -----------------------------------------------------------------------
 
 template<class ElemType> static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient);
+static void ProfileNode(const ComputationNodeBasePtr& node, const FrameRange& fr, bool backprop, long long beginClock);
 
 ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(const std::vector<shared_ptr<SEQTraversalFlowControlNode>>& recurrentInfo, const std::list<ComputationNodeBasePtr>& allNodes /*must be in eval order*/)
 {
@@ -140,14 +144,21 @@ ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(con
         }
     }
 }
-/*static*/ void ComputationNetwork::PARTraversalFlowControlNode::ForwardProp(const ComputationNodeBasePtr& node, const FrameRange& fr)
+/*static*/ void ComputationNetwork::PARTraversalFlowControlNode::ForwardProp(const ComputationNodeBasePtr& node, const FrameRange& fr, bool profile)
 {
     if (node->IsOutOfDateWrtInputs())
     {
+        // a nested SEQ loop profiles its own nodes
+        profile = profile && !dynamic_pointer_cast<FlowControlNode>(node);
+        auto beginClock = profile ? ProfilerTimeBegin() : 0;
+
         node->BeginForwardProp();
         node->ForwardProp(fr.WithLayout(node->GetMBLayout()));
         node->EndForwardProp();
 
+        if (profile)
+            ProfileNode(node, fr.WithLayout(node->GetMBLayout()), /*backprop=*/false, beginClock);
+
         node->BumpEvalTimeStamp();
 
         // Extreme Tracing, part 1/4
@@ -157,10 +168,126 @@ ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(con
 }
 
 
+// Returns the InterOpScheduler if the nodes may be executed concurrently, or nullptr if they must run one at a time.
+// Nodes on a GPU are already executed asynchronously, and user-defined functions may call back into
+// a script interpreter, which must not be entered from a worker thread that the interpreter does not know.
+static shared_ptr<InterOpScheduler> GetInterOpScheduler(const std::vector<ComputationNodeBasePtr>& nodes)
+{
+    if (nodes.size() < 2)
+        return nullptr;
+    auto scheduler = InterOpScheduler::Get();
+    if (!scheduler)
+        return nullptr;
+
+    for (auto& node : nodes)
+    {
+        auto flowControlNode = dynamic_pointer_cast<FlowControlNode>(node);
+        const auto& members = flowControlNode ? flowControlNode->m_nestedNodes : std::vector<ComputationNodeBasePtr>{ node };
+        for (auto& member : members)
+        {
+            if (member->GetDeviceId() != CPUDEVICE || member->OperationName() == L"UserDefinedV2Function")
+                return nullptr;
+        }
+    }
+    return scheduler;
+}
+
+// Returns for each node the indices of the earlier nodes it must wait for, where 'nodes' is in sequential execution order.
+// Besides its inputs (or, in backprop, the nodes it is an input of), a node waits for the last earlier node that wrote
+// a matrix it accesses, and, if it writes the matrix, for all earlier nodes that read it since. Thus two nodes that touch
+// the same matrix (directly, through memory sharing, or by accumulating into the same gradient) execute in the sequential
+// order, so no node sees an input that the schedule changed.
+static std::vector<std::vector<size_t>> GetExecutionDependencies(const std::vector<ComputationNodeBasePtr>& nodes, bool backprop)
+{
+    // the nodes of a loop are represented by the loop's flow-control node
+    std::unordered_map<const ComputationNodeBase*, size_t> taskOf;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        taskOf[nodes[i].get()] = i;
+        if (auto flowControlNode = dynamic_pointer_cast<FlowControlNode>(nodes[i]))
+            for (auto& member : flowControlNode->m_nestedNodes)
+                taskOf[member.get()] = i;
+    }
+
+    std::vector<std::vector<size_t>> predecessors(nodes.size());
+    std::vector<std::vector<size_t>> successorsInGraph(nodes.size()); // in backprop, the nodes that consume a node
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        auto flowControlNode = dynamic_pointer_cast<FlowControlNode>(nodes[i]);
+        const auto& members = flowControlNode ? flowControlNode->m_nestedNodes : std::vector<ComputationNodeBasePtr>{ nodes[i] };
+        for (auto& member : members)
+        {
+            for (auto& input : member->GetInputs())
+            {
+                auto iter = taskOf.find(input.get());
+                if (iter == taskOf.end() || iter->second == i)
+                    continue;
+                if (backprop) // in backprop, 'nodes' is reversed, so the input comes later
+                    successorsInGraph[iter->second].push_back(i);
+                else
+                    predecessors[i].push_back(iter->second);
+            }
+        }
+    }
+    if (backprop)
+        predecessors.swap(successorsInGraph);
+
+    std::unordered_map<const MatrixBase*, size_t> lastWriter;
+    std::unordered_map<const MatrixBase*, std::vector<size_t>> readersSinceWrite;
+    std::vector<const MatrixBase*> reads, writes;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        reads.clear();
+        writes.clear();
+        nodes[i]->GetMatrixAccesses(backprop, reads, writes);
+        sort(writes.begin(), writes.end());
+        writes.erase(unique(writes.begin(), writes.end()), writes.end());
+        sort(reads.begin(), reads.end());
+        reads.erase(unique(reads.begin(), reads.end()), reads.end());
+
+        auto& pred = predecessors[i];
+        for (auto matrix : reads)
+        {
+            auto writer = lastWriter.find(matrix);
+            if (writer != lastWriter.end())
+                pred.push_back(writer->second);
+            if (!binary_search(writes.begin(), writes.end(), matrix))
+                readersSinceWrite[matrix].push_back(i);
+        }
+        for (auto matrix : writes)
+        {
+            auto writer = lastWriter.find(matrix);
+            if (writer != lastWriter.end())
+                pred.push_back(writer->second);
+            auto& readers = readersSinceWrite[matrix];
+            pred.insert(pred.end(), readers.begin(), readers.end());
+            readers.clear();
+            lastWriter[matrix] = i;
+        }
+        sort(pred.begin(), pred.end());
+        pred.erase(unique(pred.begin(), pred.end()), pred.end());
+    }
+    return predecessors;
+}
+
 /*virtual*/ void ComputationNetwork::PARTraversalFlowControlNode::ForwardProp(const FrameRange& fr) /*override*/
 {
+    // independent nodes may run concurrently on CPU if inter-op parallelism is enabled
+    bool profile = ProfilerNodesEnabled();
+    auto scheduler = GetInterOpScheduler(m_nestedNodes);
+    if (scheduler)
+    {
+        scheduler->Run(GetExecutionDependencies(m_nestedNodes, /*backprop=*/false), [&](size_t i) { ForwardProp(m_nestedNodes[i], fr, profile); });
+        return;
+    }
+
     for (auto& node : m_nestedNodes)
-        ForwardProp(node, fr);
+        ForwardProp(node, fr, profile);
+}
+
+/*static*/ bool ComputationNetwork::PARTraversalFlowControlNode::ProfileNodes()
+{
+    return ProfilerNodesEnabled();
 }
 
 /*static*/ void ComputationNetwork::PARTraversalFlowControlNode::PostForwardAndBackProp(const ComputationNodeBasePtr& node)
@@ -177,19 +304,36 @@ ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(con
 /*virtual*/ void ComputationNetwork::PARTraversalFlowControlNode::Backprop(const FrameRange& fr, bool childrenInThisLoop, bool childrenInOuterLoop) /*override*/
 {
     childrenInThisLoop, childrenInOuterLoop; // TODO: think through what these mean when coming from PAR mode
-    // process nodes in pre-determined order
-    for (auto pnode = m_nestedNodes.rbegin(); pnode != m_nestedNodes.rend(); pnode++) // iterate backwards over evaluation order
+    bool profileNodes = ProfilerNodesEnabled();
+    auto backprop = [&fr, profileNodes](const ComputationNodeBasePtr& node)
     {
-        auto& node = *pnode;
+        // a nested SEQ loop profiles its own nodes
+        bool profile = profileNodes && !dynamic_pointer_cast<FlowControlNode>(node);
+        auto beginClock = profile ? ProfilerTimeBegin() : 0;
 
         node->BeginBackprop();
         node->Backprop(fr.WithLayout(node->GetMBLayout()), true /*childrenInThisLoop*/, true /*childrenInOuterLoop*/);
         node->EndBackprop();
 
+        if (profile)
+            ProfileNode(node, fr.WithLayout(node->GetMBLayout()), /*backprop=*/true, beginClock);
+
         // Extreme Tracing, part 2/4
         if (node->HasEnvironmentPtr() && node->Environment().ShouldDumpNode() && node->NeedsGradient())
             DumpNode<float>(node, /*dumpGradient=*/true) || DumpNode<double>(node, true);
+    };
+
+    // process nodes in pre-determined order, iterating backwards over evaluation order
+    std::vector<ComputationNodeBasePtr> nodes(m_nestedNodes.rbegin(), m_nestedNodes.rend());
+    auto scheduler = GetInterOpScheduler(nodes);
+    if (scheduler)
+    {
+        scheduler->Run(GetExecutionDependencies(nodes, /*backprop=*/true), [&](size_t i) { backprop(nodes[i]); });
+        return;
     }
+
+    for (auto& node : nodes)
+        backprop(node);
 }
 /*virtual*/ void ComputationNetwork::PARTraversalFlowControlNode::RequestMatricesBeforeForwardProp(MatrixPool& matrixPool) /*override*/
 {
@@ -227,6 +371,84 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
     return true;
 }
 
+// number of elements of the value of a node that are processed for 'fr'; a step of a SEQ loop processes one time step
+static size_t GetNumElementsInFrameRange(const ComputationNodeBasePtr& node, const FrameRange& fr)
+{
+    size_t numCols = 1;
+    if (node->HasMBLayout())
+        numCols = fr.IsAllFrames() ? node->GetMBLayout()->GetNumCols() : node->GetMBLayout()->GetNumParallelSequences();
+    return node->GetSampleLayout().GetNumElements() * numCols;
+}
+
+// estimated floating-point operations of the forward pass of a node
+// Products and convolutions count a multiply-add as 2 operations; all other nodes are counted as one operation per output element.
+static size_t EstimateForwardFlops(const ComputationNodeBasePtr& node, size_t outputElements)
+{
+    const auto& operationName = node->OperationName();
+    const auto& outputShape = node->GetSampleLayout();
+    if (outputShape.GetNumElements() == 0)
+        return 0;
+
+    if (operationName == OperationNameOf(TimesNode) || operationName == OperationNameOf(TransposeTimesNode))
+    {
+        // [M x K] * [K x N] -> [M x N]: the product of the input sample sizes over the output sample size is K^2
+        double innerDim = sqrt((double)node->GetInputs()[0]->GetSampleLayout().GetNumElements() * node->GetInputs()[1]->GetSampleLayout().GetNumElements() / outputShape.GetNumElements());
+        return (size_t)(2 * outputElements * innerDim);
+    }
+    else if (operationName == OperationNameOf(ConvolutionNode) && outputShape.GetRank() > 0)
+    {
+        // each output element is the dot product with the kernel of its output channel (the last output dimension)
+        size_t kernelElements = node->GetInputs()[0]->GetSampleLayout().GetNumElements();
+        return 2 * outputElements * (kernelElements / outputShape[outputShape.GetRank() - 1]);
+    }
+    return outputElements;
+}
+
+// helper for node profiling. Returns false if it was not able to dynamic-cast nodep to ComputationNode<ElemType>
+// Bytes touched count the output value and all input values, and in backprop the output gradient and the updated input gradients.
+template<class ElemType>
+static bool ProfileNode(const ComputationNodeBasePtr& nodep, const FrameRange& fr, bool backprop, long long beginClock)
+{
+    let node = dynamic_pointer_cast<ComputationNode<ElemType>>(nodep);
+    if (!node)
+        return false;
+
+    size_t outputElements = GetNumElementsInFrameRange(nodep, fr);
+    size_t elements = backprop ? 2 * outputElements : outputElements;
+    size_t numInputsWithGradient = 0;
+    for (const auto& input : nodep->GetInputs())
+    {
+        size_t inputElements = GetNumElementsInFrameRange(input, fr);
+        elements += inputElements;
+        if (backprop && input->NeedsGradient())
+        {
+            elements += 2 * inputElements; // gradients are accumulated: read and written
+            numInputsWithGradient++;
+        }
+    }
+
+    // backprop repeats about the work of the forward pass for each input that receives a gradient
+    size_t flops = EstimateForwardFlops(nodep, outputElements);
+    if (backprop)
+        flops *= max(numInputsWithGradient, (size_t)1);
+
+    size_t allocatedBytes = 0;
+    if (node->ValuePtr())
+        allocatedBytes += node->Value().BufferSize();
+    if (node->GradientPtr())
+        allocatedBytes += node->Gradient().BufferSize();
+
+    ProfilerNodeTimeEnd(beginClock, msra::strfun::utf8(node->NodeName()).c_str(), msra::strfun::utf8(node->OperationName()).c_str(), backprop,
+                        (long long)(elements * sizeof(ElemType)), (long long)flops, (long long)allocatedBytes);
+    return true;
+}
+
+// reports the forward or backward pass of a node that began at 'beginClock' to the profiler
+static void ProfileNode(const ComputationNodeBasePtr& node, const FrameRange& fr, bool backprop, long long beginClock)
+{
+    ProfileNode<float>(node, fr, backprop, beginClock) || ProfileNode<double>(node, fr, backprop, beginClock);
+}
+
 // -----------------------------------------------------------------------
 // SEQTraversalFlowControlNode methods -- implements SEQ traversal (loop unrolling)
 //
@@ -265,12 +487,16 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
     // for every time step run through all nodes in this particular loop (treat the loop like a little ComputationNetwork)
     // Note: Currently, this is limited to linear-time loops. But nothing stops the iteration below to, e.g., be a 2D iteration over an image
     // if we implement an according FrameRangeIteration.
+    bool profile = ProfilerNodesEnabled();
     FrameRangeIteration range(GetMBLayout(), m_steppingDirection);
     for (auto t = range.begin(); t != range.end(); t++)
     {
         for (auto& node : m_nestedNodes)
         {
+            auto beginClock = profile ? ProfilerTimeBegin() : 0;
             node->ForwardProp(t);
+            if (profile)
+                ProfileNode(node, t, /*backprop=*/false, beginClock);
             node->BumpEvalTimeStamp();
         }
     }
@@ -304,15 +530,19 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
     childrenInThisLoop, childrenInOuterLoop;    // TODO: think through what these mean when coming from PAR mode
     const auto& recurrentNodes = m_nestedNodes; // BUGBUG: -ForForward?? Does this mean we can remove non-ForForward?
     auto pMBLayout = recurrentNodes[0]->GetMBLayout();
+    bool profile = ProfilerNodesEnabled();
     FrameRangeIteration range(pMBLayout, m_steppingDirection);
     for (auto t = range.rbegin(); t != range.rend(); t++) // note: reverse iteration
     {
         for (auto nodeIter2 = recurrentNodes.rbegin(); nodeIter2 != recurrentNodes.rend(); ++nodeIter2)
         {
             auto& node2 = *nodeIter2;
+            auto beginClock = profile ? ProfilerTimeBegin() : 0;
             node2->Backprop(t, true /*childrenInThisLoop*/, false /*childrenInOuterLoop*/);
             // The above flags tell Backprop() to skip back-propagation from inside a node into
             // a node that is outside the loop, which is done later in EndBackprop() in PAR mode.
+            if (profile)
+                ProfileNode(node2, t, /*backprop=*/true, beginClock);
         }
     }
 
@@ -331,10 +561,14 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
 {
     // The following loop handles the case that a node inside the loop back-propagates a gradient into a node outside of the loop.
     // For efficiency, we perform this outside the loop in PAR mode. E.g., in one LSTM speech setup, we measured 12..14% overall speed-up.
+    bool profile = ProfilerNodesEnabled();
     for (auto nodeIter2 = m_nestedNodes.rbegin(); nodeIter2 != m_nestedNodes.rend(); ++nodeIter2)
     {
         auto& node2 = *nodeIter2;
+        auto beginClock = profile ? ProfilerTimeBegin() : 0;
         node2->Backprop(FrameRange(m_nestedNodes[0]->GetMBLayout()), false /*childrenInThisLoop*/, true /*childrenInOuterLoop*/);
+        if (profile)
+            ProfileNode(node2, FrameRange(m_nestedNodes[0]->GetMBLayout()), /*backprop=*/true, beginClock);
     }
 
     // tell all nodes we are done for this iteraTion
@@ -532,7 +766,17 @@ void ComputationNetwork::CompileNetwork()
     ValidateNetwork();
 
     // STEP: Optimize the network.
-    // :)
+    // Fusing nodes changes the graph, so the steps above are repeated for the fused network.
+    if (Globals::ShouldFuseElementwiseOperations())
+    {
+        size_t numFused = FuseElementwiseOperations();
+        if (numFused > 0)
+        {
+            if (TraceLevel() > 0)
+                fprintf(stderr, "\nFused %d elementwise operations; post-processing the fused network.\n", (int)numFused);
+            return CompileNetwork();
+        }
+    }
 
     // STEP: Some final details.
     ResetEvalTimeStamps(); // invalidate all m_value fields. Really belongs into StartEvaluateMinibatchLoop()
@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <assert.h>
 #include <atomic>
+#include <mutex>
 
 #define DEFAULT_HIDDEN_ACTIVATION 0.1
 
@@ -73,7 +74,8 @@ enum CopyNodeFlags // flags to be passed to the CopyTo() function
     copyNodeValue          = 1, // copy everything except for the input links
     copyNodeInputLinks     = 2, // copy over input links
     copyNodeAll            = 3, // copy everything
-    copyNodeAcrossNetworks = 4  // allow a cross network child copy
+    copyNodeAcrossNetworks = 4, // allow a cross network child copy
+    copyNodeShareValue     = 8  // with copyNodeValue: reference the same value matrix instead of copying it, and do not copy the gradient
 };
 
 #pragma region base computation class
@@ -725,6 +727,10 @@ public:
 
     virtual std::set<std::pair<const MatrixBase*, std::wstring>> GetMatrixInfo() const = 0; // to be defined by <ElemType> version
 
+    // Collects the matrices that ForwardProp() (or Backprop()) of this node reads and writes.
+    // Used to order the concurrent execution of nodes; see PARTraversalFlowControlNode.
+    virtual void GetMatrixAccesses(bool backprop, std::vector<const MatrixBase*>& reads, std::vector<const MatrixBase*>& writes) const = 0;
+
     // -----------------------------------------------------------------------
     // validation
     // -----------------------------------------------------------------------
@@ -1300,14 +1306,16 @@ public:
         if (flags & CopyNodeFlags::copyNodeValue)
         {
             auto node = DownCast(nodeP);
-            if (m_value)
+            if (flags & CopyNodeFlags::copyNodeShareValue)
+                node->m_value = m_value;
+            else if (m_value)
             {
                 node->CreateValueMatrixIfNull();
                 node->m_value->SetValue(*m_value);
             }
             else
                 node->m_value = nullptr;
-            if (m_gradient)
+            if (m_gradient && !(flags & CopyNodeFlags::copyNodeShareValue))
             {
                 node->CreateGradientMatrixIfNull();
                 node->m_gradient->SetValue(*m_gradient);
@@ -1828,6 +1836,33 @@ public:
         return matrixInfo;
     }
 
+    // All matrices this node got from the pool, including its temporaries, count as written, since the pool may share
+    // them with other nodes. Backprop() writes the gradients of the inputs.
+    virtual void GetMatrixAccesses(bool backprop, std::vector<const MatrixBase*>& reads, std::vector<const MatrixBase*>& writes) const override
+    {
+        if (m_value)
+            writes.push_back(m_value.get());
+        for (auto matrixPtr : m_poolMatrices)
+        {
+            if (*matrixPtr && (backprop || *matrixPtr != m_gradient))
+                writes.push_back(matrixPtr->get());
+        }
+
+        for (const auto& input : GetInputs())
+        {
+            auto inputValue = input->ValuePtr();
+            if (inputValue)
+                reads.push_back(inputValue.get());
+
+            auto typedInput = dynamic_pointer_cast<ComputationNode<ElemType>>(input);
+            if (backprop && typedInput && typedInput->GradientPtr())
+                writes.push_back(typedInput->GradientPtr().get());
+        }
+
+        if (backprop && m_gradient)
+            reads.push_back(m_gradient.get());
+    }
+
     // request matrices needed to do node function value evaluation
     // for memory pool utilization optimization, the requested pointer is not immediately useable until the entire network has gone through all requests 
     virtual void RequestMatricesBeforeForwardProp(MatrixPool& matrixPool) override
@@ -1949,6 +1984,9 @@ protected:
                 matrixPool.RequestAliasedAllocate<ElemType>(m_deviceId, this, &matrixPtr, matrixSize, mbScale);
             else
                 matrixPool.RequestAllocate<ElemType>(m_deviceId, &matrixPtr, matrixSize, mbScale, isWorkSpace);
+
+            if (std::find(m_poolMatrices.begin(), m_poolMatrices.end(), &matrixPtr) == m_poolMatrices.end())
+                m_poolMatrices.push_back(&matrixPtr);
         }
     }
 
@@ -2122,6 +2160,7 @@ public:
     // When using the TensorView interface, one could instead just use a 1x1 matrix with a view that broadcasts its columns (stride 0).
     static const Matrix<ElemType>& ConstOnes(const size_t rows, const size_t cols, const DEVICEID_TYPE deviceId)
     {
+        std::lock_guard<std::mutex> lock(s_constOnesMutex);
         if (s_constOnes.find(rows) == s_constOnes.end() ||
             s_constOnes[rows].find(cols) == s_constOnes[rows].end()) // not found
         {
@@ -2144,7 +2183,11 @@ protected:
 
     shared_ptr<Matrix<ElemType>> m_value, m_gradient;
 
+    // members that were requested from the matrix pool, for GetMatrixAccesses()
+    std::vector<shared_ptr<Matrix<ElemType>>*> m_poolMatrices;
+
     static std::map<size_t, std::map<size_t, shared_ptr<Matrix<ElemType>>>> s_constOnes;
+    static std::mutex s_constOnesMutex;
 
     MatrixType m_preferredGradientMatrixType = UNDETERMINED;
 };
@@ -2273,6 +2316,11 @@ public:
     virtual std::string FormatOperationPrototype(const std::string& extraArgs) const override { return ""; }
     virtual void DumpNodeInfo(const bool /*printValues*/, const bool /*printMetadata*/, File& fstream) const override {}
     virtual std::set<std::pair<const MatrixBase*, std::wstring>> GetMatrixInfo() const override { NOT_IMPLEMENTED; }
+    virtual void GetMatrixAccesses(bool backprop, std::vector<const MatrixBase*>& reads, std::vector<const MatrixBase*>& writes) const override
+    {
+        for (const auto& node : m_nestedNodes)
+            node->GetMatrixAccesses(backprop, reads, writes);
+    }
 
 protected: public:                                     // needed in ComputationNetwork::FindInRecurrentLoops(), which really should be part of SEQTraversalFlowControlNode
     std::vector<ComputationNodeBasePtr> m_nestedNodes; // nodes tucked away in this node, in evaluation order
@@ -2301,6 +2349,19 @@ struct IRecurrentNode { virtual int GetRecurrenceSteppingDirection() const = 0;
 
 struct IFreezable { virtual void FreezeParameters() { } };
 
+// =======================================================================
+// IActivationOfPlusNode -- interface implemented by the nodes that ComputationNetwork::FuseElementwiseOperations()
+// creates in place of an activation and the Plus node that feeds it
+// Models are saved with these two nodes instead, see ComputationNetwork::SaveToFileImpl().
+// =======================================================================
+
+struct IActivationOfPlusNode
+{
+    virtual std::wstring ActivationOperationName() const = 0; // the fused node has the name of the activation
+    virtual std::wstring PlusNodeName() const = 0;
+    virtual void SetPlusNodeName(const std::wstring& name) = 0;
+};
+
 // =======================================================================
 // PreComputedNodeBase -- interface implemented by ComputationNodes that precompute
 // TODO: We can use this interface in more places.
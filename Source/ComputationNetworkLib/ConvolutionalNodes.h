@@ -582,9 +582,12 @@ public:
                 auto geometry = std::make_shared<ConvolveGeometry>(!m_transpose ? inputShape : outputShape,
                                                                    m_kernelShape, m_mapCount, m_stride,
                                                                    m_sharing, m_autoPad, m_lowerPad, m_upperPad, m_dilation);
+                // The direct CPU engine is only used when enabled explicitly.
+                auto engines = Globals::ShouldUseDirectConvolution() ?
+                    (ConvolutionEngineKind)((int)ConvolutionEngineKind::All | (int)ConvolutionEngineKind::Direct) : ConvolutionEngineKind::All;
                 m_convEng = ConvolutionEngine<ElemType>::Create(geometry, m_deviceId, m_imageLayout,
                                                                 m_maxTempMemSizeInSamples, m_poolKind,
-                                                                ConvolutionEngineKind::All, NodeName(), Globals::ShouldForceDeterministicAlgorithms(),
+                                                                engines, NodeName(), Globals::ShouldForceDeterministicAlgorithms(),
                                                                 false, recomputeConvGeometry);
             }
 
@@ -0,0 +1,266 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#define _CRT_SECURE_NO_WARNINGS // "secure" CRT not available on all platforms  --add this at the top of all CPP files that give "function or variable may be unsafe" warnings
+
+#include "Basics.h"
+#include "InterOpScheduler.h"
+#include "Globals.h"
+#include "CPUMatrix.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// set on the worker threads, so that a task that evaluates another network does not wait for the pool it is running on
+static thread_local bool t_isInterOpWorker = false;
+
+struct InterOpScheduler::Job
+{
+    Job(const function<void(size_t)>& task, const vector<vector<size_t>>& predecessors)
+        : m_task(task), m_numTasks(predecessors.size()), m_successors(predecessors.size()),
+          m_numPendingPredecessors(new atomic<size_t>[predecessors.size()]), m_numFinished(0), m_numQueued(0), m_failed(false)
+    {
+        for (size_t i = 0; i < m_numTasks; i++)
+        {
+            for (size_t p : predecessors[i])
+            {
+                if (p >= i)
+                    LogicError("InterOpScheduler: Task %d depends on task %d, which does not precede it.", (int)i, (int)p);
+                m_successors[p].push_back(i);
+            }
+            m_numPendingPredecessors[i] = predecessors[i].size();
+        }
+    }
+
+    const function<void(size_t)>& m_task;
+    const size_t m_numTasks;
+    vector<vector<size_t>> m_successors;
+    unique_ptr<atomic<size_t>[]> m_numPendingPredecessors;
+    atomic<size_t> m_numFinished;
+    atomic<size_t> m_numQueued; // upper bound of the tasks in all queues; incremented before a task is pushed
+    atomic<bool> m_failed;
+
+    mutex m_exceptionMutex;
+    exception_ptr m_exception;
+};
+
+InterOpScheduler::InterOpScheduler(size_t numWorkers, int numIntraOpThreads, unsigned long scheduleSeed)
+    : m_numIntraOpThreads(numIntraOpThreads), m_scheduleSeed(scheduleSeed),
+      m_job(nullptr), m_jobGeneration(0), m_numActiveWorkers(0), m_stopping(false)
+{
+    if (numWorkers == 0)
+        InvalidArgument("InterOpScheduler: The number of worker threads must be positive.");
+
+    for (size_t i = 0; i < numWorkers; i++)
+        m_queues.push_back(unique_ptr<WorkerQueue>(new WorkerQueue()));
+    for (size_t i = 0; i < numWorkers; i++)
+        m_workers.emplace_back([this, i]() { WorkerLoop(i); });
+}
+
+InterOpScheduler::~InterOpScheduler()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_jobAvailable.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void InterOpScheduler::Run(const vector<vector<size_t>>& predecessors, const function<void(size_t)>& task)
+{
+    auto runSequentially = [&]()
+    {
+        for (size_t i = 0; i < predecessors.size(); i++)
+            task(i);
+    };
+
+    if (predecessors.empty())
+        return;
+    if (t_isInterOpWorker)
+        return runSequentially();
+
+    Job job(task, predecessors);
+    unique_lock<mutex> lock(m_mutex);
+    if (m_job) // the workers are busy with another network
+    {
+        lock.unlock();
+        return runSequentially();
+    }
+
+    // hand the tasks without predecessors to the workers round-robin
+    for (size_t i = 0, worker = 0; i < job.m_numTasks; i++)
+    {
+        if (job.m_numPendingPredecessors[i] == 0)
+            Enqueue(job, worker++ % m_queues.size(), i);
+    }
+
+    m_job = &job;
+    m_jobGeneration++;
+    m_jobAvailable.notify_all();
+    m_jobDone.wait(lock, [&]() { return job.m_numFinished == job.m_numTasks && m_numActiveWorkers == 0; });
+    m_job = nullptr;
+    lock.unlock();
+
+    if (job.m_exception)
+        rethrow_exception(job.m_exception);
+}
+
+void InterOpScheduler::WorkerLoop(size_t worker)
+{
+    t_isInterOpWorker = true;
+    CPUMatrix<float /*any will do*/>::SetNumThreadsForCurrentThread(m_numIntraOpThreads);
+
+    size_t joinedGeneration = 0;
+    for (;;)
+    {
+        Job* job;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_jobAvailable.wait(lock, [&]() { return m_stopping || (m_job && m_jobGeneration != joinedGeneration); });
+            if (m_stopping)
+                return;
+            job = m_job;
+            joinedGeneration = m_jobGeneration;
+            m_numActiveWorkers++;
+        }
+
+        RunJob(*job, worker);
+
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (--m_numActiveWorkers == 0)
+                m_jobDone.notify_all();
+        }
+    }
+}
+
+void InterOpScheduler::RunJob(Job& job, size_t worker)
+{
+    // victims are drawn from a sequence that depends on the seed and the worker only, so that a run can be replayed
+    seed_seq seed{ (unsigned long)m_scheduleSeed, (unsigned long)worker };
+    mt19937 rng(seed);
+
+    for (;;)
+    {
+        size_t task;
+        if (TryGetTask(job, worker, rng, task))
+        {
+            Execute(job, worker, task);
+            continue;
+        }
+
+        unique_lock<mutex> lock(m_idleMutex);
+        m_taskAvailable.wait(lock, [&]() { return job.m_numQueued > 0 || job.m_numFinished == job.m_numTasks; });
+        if (job.m_numFinished == job.m_numTasks)
+            return;
+    }
+}
+
+bool InterOpScheduler::TryGetTask(Job& job, size_t worker, mt19937& rng, size_t& task)
+{
+    // the most recently readied task of our own queue
+    {
+        auto& own = *m_queues[worker];
+        lock_guard<mutex> lock(own.m_mutex);
+        if (!own.m_tasks.empty())
+        {
+            task = own.m_tasks.back();
+            own.m_tasks.pop_back();
+            job.m_numQueued--;
+            return true;
+        }
+    }
+
+    // else the oldest task of another worker, starting at a random one
+    size_t numQueues = m_queues.size();
+    size_t first = rng() % numQueues;
+    for (size_t k = 0; k < numQueues; k++)
+    {
+        size_t victim = (first + k) % numQueues;
+        if (victim == worker)
+            continue;
+
+        auto& queue = *m_queues[victim];
+        lock_guard<mutex> lock(queue.m_mutex);
+        if (!queue.m_tasks.empty())
+        {
+            task = queue.m_tasks.front();
+            queue.m_tasks.pop_front();
+            job.m_numQueued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void InterOpScheduler::Execute(Job& job, size_t worker, size_t task)
+{
+    if (!job.m_failed)
+    {
+        try
+        {
+            job.m_task(task);
+        }
+        catch (...)
+        {
+            lock_guard<mutex> lock(job.m_exceptionMutex);
+            if (!job.m_exception)
+                job.m_exception = current_exception();
+            job.m_failed = true;
+        }
+    }
+
+    for (size_t successor : job.m_successors[task])
+    {
+        if (--job.m_numPendingPredecessors[successor] == 0)
+            Enqueue(job, worker, successor);
+    }
+
+    if (++job.m_numFinished == job.m_numTasks)
+    {
+        lock_guard<mutex> lock(m_idleMutex); // so that no worker misses the wake-up between testing and waiting
+        m_taskAvailable.notify_all();
+    }
+}
+
+void InterOpScheduler::Enqueue(Job& job, size_t worker, size_t task)
+{
+    job.m_numQueued++;
+    {
+        auto& queue = *m_queues[worker];
+        lock_guard<mutex> lock(queue.m_mutex);
+        queue.m_tasks.push_back(task);
+    }
+    {
+        lock_guard<mutex> lock(m_idleMutex);
+    }
+    m_taskAvailable.notify_one();
+}
+
+/*static*/ shared_ptr<InterOpScheduler> InterOpScheduler::Get()
+{
+    static mutex s_mutex;
+    static shared_ptr<InterOpScheduler> s_scheduler;
+
+    size_t numWorkers = Globals::GetInterOpThreads();
+    if (numWorkers <= 1)
+        return nullptr;
+    unsigned long scheduleSeed = Globals::GetScheduleSeed();
+
+    lock_guard<mutex> lock(s_mutex);
+    if (!s_scheduler || s_scheduler->GetNumWorkers() != numWorkers || s_scheduler->GetScheduleSeed() != scheduleSeed)
+    {
+        // split the CPU threads between the workers, each of which runs its operations with the rest
+        int numIntraOpThreads = max(1, CPUMatrix<float /*any will do*/>::GetMaxNumThreads() / (int)numWorkers);
+        s_scheduler = make_shared<InterOpScheduler>(numWorkers, numIntraOpThreads, scheduleSeed);
+    }
+    return s_scheduler;
+}
+
+}}}
@@ -0,0 +1,96 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// InterOpScheduler.h -- runs mutually independent nodes of a network concurrently on a work-stealing thread pool
+//
+
+#pragma once
+
+#include "Basics.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// -----------------------------------------------------------------------
+// InterOpScheduler -- executes a graph of tasks on a pool of worker threads
+//
+// A task starts once all of its predecessors have finished. Each worker keeps the tasks that became ready when
+// it finished one of their predecessors, and runs the most recent one first (its inputs are still in the cache).
+// A worker without tasks steals the oldest ready task of another worker, chosen by a random generator seeded
+// from the schedule seed. The CPU threads are split between the workers (inter-op threads) and the OpenMP/MKL
+// threads that each worker uses inside an operation (intra-op threads), so that together they do not
+// oversubscribe the cores.
+//
+// The schedule only decides which of the ready tasks runs where and when. Tasks that touch the same data
+// must be ordered by the caller through the predecessors; then which worker runs a task does not change its
+// result, since all workers use the same number of intra-op threads. So for a given number of workers, repeated
+// runs give bitwise identical results with any schedule seed, as long as the operations themselves are
+// deterministic for a given number of threads. Fewer intra-op threads than in sequential execution can change
+// the rounding of reductions, though, so results match sequential execution only up to rounding.
+// -----------------------------------------------------------------------
+
+class InterOpScheduler
+{
+public:
+    InterOpScheduler(size_t numWorkers, int numIntraOpThreads, unsigned long scheduleSeed);
+    ~InterOpScheduler();
+
+    // Runs task(0) .. task(N-1), where N = predecessors.size() and predecessors[i] lists the tasks that must have
+    // finished before task i starts. Predecessors must have lower indices, so that running the tasks in index order is valid.
+    // Returns when all tasks are done. If a task throws, tasks that have not started yet are skipped and the first
+    // exception is rethrown. Runs the tasks in index order on the calling thread if it is a worker itself (nested
+    // evaluation) or if the pool is busy with tasks of another thread.
+    void Run(const std::vector<std::vector<size_t>>& predecessors, const std::function<void(size_t)>& task);
+
+    size_t GetNumWorkers() const { return m_workers.size(); }
+    unsigned long GetScheduleSeed() const { return m_scheduleSeed; }
+
+    // Returns the process-wide scheduler as configured by Globals::SetInterOpParallelism(),
+    // or nullptr if nodes are to be executed one at a time.
+    static std::shared_ptr<InterOpScheduler> Get();
+
+private:
+    struct Job;
+    struct WorkerQueue
+    {
+        std::mutex m_mutex;
+        std::deque<size_t> m_tasks;
+    };
+
+    void WorkerLoop(size_t worker);
+    void RunJob(Job& job, size_t worker);
+    bool TryGetTask(Job& job, size_t worker, std::mt19937& rng, size_t& task);
+    void Execute(Job& job, size_t worker, size_t task);
+    void Enqueue(Job& job, size_t worker, size_t task);
+
+    const int m_numIntraOpThreads;
+    const unsigned long m_scheduleSeed;
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    // m_mutex guards the hand-over of a job to the workers and its completion
+    std::mutex m_mutex;
+    std::condition_variable m_jobAvailable;
+    std::condition_variable m_jobDone;
+    Job* m_job;                // job being executed, or nullptr
+    size_t m_jobGeneration;    // incremented for each job, so that a worker joins every job once
+    size_t m_numActiveWorkers; // workers that have joined m_job and not yet left it
+    bool m_stopping;
+
+    // m_idleMutex guards the sleep of workers that have run out of ready tasks
+    std::mutex m_idleMutex;
+    std::condition_variable m_taskAvailable;
+};
+
+}}}
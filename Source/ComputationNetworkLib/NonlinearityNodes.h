@@ -171,6 +171,102 @@ DeclareUnaryElementWiseWithOpCodeNode(StableSigmoid,         StableSigmoid,
 
 #pragma pop_macro("DeclareUnaryElementWiseWithOpCodeNode")
 
+// -----------------------------------------------------------------------
+// ActivationOfPlusNodeBase (summand1, summand2) -- base for an activation
+// applied to the sum of two inputs, e.g. Sigmoid(Plus(a, b)).
+// These are created by ComputationNetwork::FuseElementwiseOperations(),
+// which replaces a Plus node and the activation that is its only consumer.
+// The fused op reads the inputs and writes the output once, and the sum
+// needs no output matrix of its own. Fusion only lives in memory: models are
+// saved with the original Plus and activation nodes.
+// -----------------------------------------------------------------------
+
+template <class ElemType, ElementWiseOperator opForward, ElementWiseOperator opBackward>
+class ActivationOfPlusNodeBase : public BinaryElementWiseNode<ElemType>, public IActivationOfPlusNode
+{
+    typedef BinaryElementWiseNode<ElemType> Base;
+    UsingComputationNodeMembers;
+
+public:
+    ActivationOfPlusNodeBase(DEVICEID_TYPE deviceId, const wstring& name)
+        : Base(deviceId, name)
+    {
+    }
+
+    virtual void /*ComputationNode::*/ ForwardProp(const FrameRange& fr) override
+    {
+        size_t rank = DetermineElementwiseTensorRank();
+        auto result =             ValueTensorFor(rank, fr);
+        auto input0 = InputRef(0).ValueTensorFor(rank, fr.AllowBroadcast());
+        auto input1 = InputRef(1).ValueTensorFor(rank, fr.AllowBroadcast());
+        result.DoBinaryOpOf(0, input0, input1, 1, opForward, opSum);
+    }
+
+    virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override
+    {
+        size_t rank = DetermineElementwiseTensorRank();
+        auto gradient      =                    GradientTensorFor(rank, fr);
+        auto value         =                    ValueTensorFor(rank, fr);
+        auto inputGradient = Input(inputIndex)->GradientTensorFor(rank, fr.AllowBroadcast());
+
+        // if reduction then mask the respective input(s) (zero out the gaps)
+        if (Input(inputIndex)->ReducesInTimeWrt(shared_from_this()))
+            MaskMissingGradientColumnsToZero(fr);
+
+        // both summands receive the gradient of the activation, computed from its output
+        inputGradient.DoBinaryOpOf(1, gradient, value, 1, opBackward, opSum);
+    }
+
+    virtual bool OutputUsedInComputingInputNodesGradients() const override { return true; }
+    virtual bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const override { return false; }
+
+    virtual void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override
+    {
+        Base::CopyTo(nodeP, newName, flags);
+        auto node = dynamic_pointer_cast<ActivationOfPlusNodeBase<ElemType, opForward, opBackward>>(nodeP);
+        node->m_plusNodeName = m_plusNodeName;
+    }
+
+    // the name of the Plus node that was fused away; nodes that were not created by fusion get a derived one
+    virtual std::wstring PlusNodeName() const override { return m_plusNodeName.empty() ? NodeName() + L".plus" : m_plusNodeName; }
+    virtual void SetPlusNodeName(const std::wstring& name) override { m_plusNodeName = name; }
+
+private:
+    std::wstring m_plusNodeName;
+};
+
+#pragma push_macro("DeclareActivationOfPlusNode")
+#define DeclareActivationOfPlusNode(Name, Activation, Forward, Backward)                                             \
+    template <class ElemType>                                                                                        \
+    class Name##Node : public ActivationOfPlusNodeBase<ElemType, op##Forward, op##Backward>                          \
+    {                                                                                                                \
+        typedef ActivationOfPlusNodeBase<ElemType, op##Forward, op##Backward> Base;                                  \
+        UsingBinaryElementwiseNodeBaseMembers;                                                                       \
+        static const std::wstring TypeName()                                                                         \
+        {                                                                                                            \
+            return L## #Name;                                                                                        \
+        }                                                                                                            \
+                                                                                                                     \
+    public:                                                                                                          \
+        DeclareConstructorFromConfigWithNumInputs(Name##Node);                                                       \
+        Name##Node(DEVICEID_TYPE deviceId, const wstring& Name) :                                                    \
+            Base(deviceId, Name)                                                                                     \
+        {                                                                                                            \
+        }                                                                                                            \
+                                                                                                                     \
+        virtual std::wstring ActivationOperationName() const override                                                \
+        {                                                                                                            \
+            return OperationNameOf(Activation##Node);                                                                \
+        }                                                                                                            \
+    }
+
+//                          Name                   Activation       Forward opcode        Backward opcode (from output)
+DeclareActivationOfPlusNode(SigmoidOfPlus,         Sigmoid,         SigmoidOfSum,         ElementwiseProductWithSigmoidDerivativeFromOutput);
+DeclareActivationOfPlusNode(TanhOfPlus,            Tanh,            TanhOfSum,            ElementwiseProductWithTanhDerivativeFromOutput);
+DeclareActivationOfPlusNode(RectifiedLinearOfPlus, RectifiedLinear, LinearRectifierOfSum, ElementwiseProductWithLinearRectifierDerivativeFromOutput);
+
+#pragma pop_macro("DeclareActivationOfPlusNode")
+
 // -----------------------------------------------------------------------
 // SoftmaxNodeBase (input) -- shared base of Softmax and LogSoftmax
 // -----------------------------------------------------------------------
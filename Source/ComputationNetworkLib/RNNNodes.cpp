@@ -22,7 +22,6 @@
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
-vector<size_t> numSequencesForFrame;
 // -----------------------------------------------------------------------
 // OptimizedRNNStackNode
 // -----------------------------------------------------------------------
@@ -130,8 +129,8 @@ void OptimizedRNNStackNode<ElemType>::ForwardProp(const FrameRange& fr)
         shapeYT = TensorShape(shapeYT.GetDims());
 
         // create a vector with the correct number of timesteps(shapeXT[2]) containing the sequence count (shapeXT[1])
-        numSequencesForFrame = vector<size_t>(shapeXT[2], shapeXT[1]);
-        m_transposedOutput->RNNForward(*m_transposedInput, paramW, shapeXT[0], shapeYT[0], numSequencesForFrame, m_rnnAttributes, *m_reserve, *m_workspace);
+        m_numSequencesForFrame = vector<size_t>(shapeXT[2], shapeXT[1]);
+        m_transposedOutput->RNNForward(*m_transposedInput, paramW, shapeXT[0], shapeYT[0], m_numSequencesForFrame, m_rnnAttributes, *m_reserve, *m_workspace);
 
         // No one uses shapeY, but it is necessary
         TensorShape shapeY;
@@ -146,12 +145,12 @@ void OptimizedRNNStackNode<ElemType>::ForwardProp(const FrameRange& fr)
         shapeYT = TensorShape(          GetTensorSliceFor(SIZE_MAX, fr));
 
         // This changes the data from "minibatch paking" in InputRef(0).Value() to "dense CuDNN packing" in m_transposedInput
-        this->PackSequencesForCuDNN(InputRef(1).Value(), *m_transposedInput, numSequencesForFrame);
+        this->PackSequencesForCuDNN(InputRef(1).Value(), *m_transposedInput, m_numSequencesForFrame);
 
         // ensure enough storage
         m_transposedOutput->Resize(this->Value().GetNumRows(), m_transposedInput->GetNumCols());
 
-        m_transposedOutput->RNNForward(*m_transposedInput, paramW, shapeXT[0], shapeYT[0], numSequencesForFrame, m_rnnAttributes, *m_reserve, *m_workspace);
+        m_transposedOutput->RNNForward(*m_transposedInput, paramW, shapeXT[0], shapeYT[0], m_numSequencesForFrame, m_rnnAttributes, *m_reserve, *m_workspace);
         this->UnpackSequencesFromCuDNN(*m_transposedOutput, this->Value());
     }
     m_BackwardDataCalledYet = false;
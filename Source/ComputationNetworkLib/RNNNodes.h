@@ -96,6 +96,9 @@ protected:
     shared_ptr<Matrix<ElemType>> m_reserve;
     shared_ptr<Matrix<ElemType>> m_packingIndex;
 
+    // number of sequences active in each time step of the packed input, as computed by the last forward pass
+    vector<size_t> m_numSequencesForFrame;
+
 private:
     void TransposeHelper(const MatrixBasePtr matX, const TensorShape &shapeX, MatrixBasePtr matY, TensorShape &shapeY);
 
@@ -429,6 +429,32 @@ void CNTKEvalExtended<ElemType>::ForwardPass(const ValueRefs<ElemType>& inputs,
     ForwardPassT(inputs, outputs, resetRNN);
 }
 
+template <typename ElemType>
+IEvaluateModelExtended<ElemType>* CNTKEvalExtended<ElemType>::CreateExecutionContext()
+{
+    if (!m_started)
+        RuntimeError("CreateExecutionContext() called before StartForwardEvaluation()");
+
+    std::vector<wstring> outputNodeNames;
+    for (const auto& node : m_outputNodes)
+        outputNodeNames.push_back(node->NodeName());
+
+    // the context gets its own copy of the network, in which only the parameters refer to ours
+    auto context = new CNTKEvalExtended<ElemType>();
+    try
+    {
+        context->m_config = this->m_config;
+        context->m_net = this->m_net->template CloneWithSharedParameters<ElemType>();
+        context->StartForwardEvaluation(outputNodeNames);
+    }
+    catch (...)
+    {
+        context->Destroy();
+        throw;
+    }
+    return context;
+}
+
 template <typename ElemType>
 void CNTKEvalExtended<ElemType>::Destroy()
 {
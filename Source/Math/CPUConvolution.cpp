@@ -0,0 +1,695 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include "CPUConvolution.h"
+#include "ssefloat4.h"
+#include <algorithm>
+#include <string.h>
+#include <omp.h>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// 4 x BlockSize accumulators of the direct kernels, updated with rank-1 products of 4 scalars and a block
+// of channels. The compiler does not reliably keep plain arrays in registers, so for float the tile is
+// made of SSE registers. The blocks of channels are always aligned as they start at multiples of BlockSize.
+template <class ElemType>
+class AccumulatorTile
+{
+public:
+    AccumulatorTile()
+    {
+        memset(m_acc, 0, sizeof(m_acc));
+    }
+
+    // m_acc[r][:] += x_r * v[:]
+    void MultiplyAdd(ElemType x0, ElemType x1, ElemType x2, ElemType x3, const ElemType* v)
+    {
+        for (size_t i = 0; i < 8; i++)
+        {
+            m_acc[0][i] += x0 * v[i];
+            m_acc[1][i] += x1 * v[i];
+            m_acc[2][i] += x2 * v[i];
+            m_acc[3][i] += x3 * v[i];
+        }
+    }
+
+    void Store(ElemType (&dst)[4][8]) const
+    {
+        memcpy(dst, m_acc, sizeof(m_acc));
+    }
+
+private:
+    ElemType m_acc[4][8];
+};
+
+#if !defined(__aarch64__)
+template <>
+class AccumulatorTile<float>
+{
+    typedef msra::math::float4 float4;
+
+public:
+    AccumulatorTile()
+    {
+        for (size_t r = 0; r < 4; r++)
+            m_acc[r][0] = m_acc[r][1] = float4(0.0f);
+    }
+
+    void MultiplyAdd(float x0, float x1, float x2, float x3, const float* v)
+    {
+        float4 v0 = ((const float4*)v)[0];
+        float4 v1 = ((const float4*)v)[1];
+        float4 b0(x0), b1(x1), b2(x2), b3(x3);
+        m_acc[0][0] += b0 * v0; m_acc[0][1] += b0 * v1;
+        m_acc[1][0] += b1 * v0; m_acc[1][1] += b1 * v1;
+        m_acc[2][0] += b2 * v0; m_acc[2][1] += b2 * v1;
+        m_acc[3][0] += b3 * v0; m_acc[3][1] += b3 * v1;
+    }
+
+    void Store(float (&dst)[4][8]) const
+    {
+        memcpy(dst, m_acc, sizeof(m_acc));
+    }
+
+private:
+    float4 m_acc[4][2];
+};
+#endif
+
+template <class ElemType>
+CPUBlockedConvolution<ElemType>::CPUBlockedConvolution(const ConvolveGeometry& geometry)
+{
+    if (!IsSupported(geometry))
+        InvalidArgument("CPUBlockedConvolution: Unsupported convolution geometry: %s.", ((string)geometry).c_str());
+
+    const auto& inT = geometry.InputShape();
+    const auto& outT = geometry.OutputShape();
+    const auto& kernT = geometry.KernelShape();
+    size_t rank = inT.GetRank();
+    bool is2D = rank == 3;
+
+    m_shape.inW = inT[0];
+    m_shape.inH = is2D ? inT[1] : 1;
+    m_shape.inC = inT[rank - 1];
+    m_shape.outW = outT[0];
+    m_shape.outH = is2D ? outT[1] : 1;
+    m_shape.outC = geometry.GetMapCount(rank - 1);
+    m_shape.kW = kernT[0];
+    m_shape.kH = is2D ? kernT[1] : 1;
+    m_shape.strideW = geometry.GetStride(0);
+    m_shape.strideH = is2D ? geometry.GetStride(1) : 1;
+    m_shape.padW = geometry.GetLowerPad(0);
+    m_shape.padH = is2D ? geometry.GetLowerPad(1) : 0;
+
+    m_winograd = m_shape.kW == 3 && m_shape.kH == 3 && m_shape.strideW == 1 && m_shape.strideH == 1;
+}
+
+template <class ElemType>
+bool CPUBlockedConvolution<ElemType>::IsSupported(const ConvolveGeometry& geometry)
+{
+    const auto& inT = geometry.InputShape();
+    const auto& outT = geometry.OutputShape();
+    const auto& kernT = geometry.KernelShape();
+    size_t rank = inT.GetRank();
+    if (rank < 2 || rank > 3 || kernT.GetRank() != rank)
+        return false;
+    for (size_t i = 0; i < rank; i++)
+    {
+        if (!geometry.GetSharing(i) || geometry.GetDilation(i) != 1)
+            return false;
+    }
+    // The kernel has to span all input channels, and produce exactly one output per map.
+    return kernT[rank - 1] == inT[rank - 1] &&
+           outT[rank - 1] == geometry.GetMapCount(rank - 1) &&
+           geometry.GetLowerPad(rank - 1) == 0;
+}
+
+template <class ElemType>
+ElemType* CPUBlockedConvolution<ElemType>::Reserve(std::vector<ElemType>& buffer, size_t size)
+{
+    if (buffer.size() < size)
+        buffer.resize(size);
+    return buffer.data();
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::PaddedExtents(const Shape& s, bool winograd, size_t& Wp, size_t& Hp)
+{
+    // The direct kernels compute RowBlock outputs of a row at a time, also at the end of the row.
+    Wp = (PaddedOutputWidth(s) - 1) * s.strideW + s.kW;
+    Hp = (s.outH - 1) * s.strideH + s.kH;
+    if (winograd)
+    {
+        // Tiles of 2x2 outputs read 4x4 inputs.
+        Wp = std::max(Wp, 2 * ((s.outW + 1) / 2) + 2);
+        Hp = std::max(Hp, 2 * ((s.outH + 1) / 2) + 2);
+    }
+}
+
+template <class ElemType>
+size_t CPUBlockedConvolution<ElemType>::PaddedOutputWidth(const Shape& s)
+{
+    return (s.outW + RowBlock - 1) / RowBlock * RowBlock;
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::PackInput(const Shape& s, size_t Wp, size_t Hp, const ElemType* in, size_t batchSize, ElemType* dst)
+{
+    const size_t B = BlockSize;
+    size_t inBlocks = s.InBlocks();
+    size_t blockSize = B * Wp * Hp;
+    size_t sampleSize = s.inW * s.inH * s.inC;
+
+#pragma omp parallel for
+    for (long task = 0; task < (long)(batchSize * inBlocks); task++)
+    {
+        size_t n = task / inBlocks;
+        size_t cb = task % inBlocks;
+        ElemType* d = dst + task * blockSize;
+        std::fill(d, d + blockSize, (ElemType)0);
+        for (size_t l = 0; l < B && cb * B + l < s.inC; l++)
+        {
+            const ElemType* plane = in + n * sampleSize + (cb * B + l) * s.inH * s.inW;
+            for (size_t y = 0; y < s.inH; y++)
+            {
+                int by = (int)y + s.padH;
+                if (by < 0 || by >= (int)Hp)
+                    continue;
+                ElemType* drow = d + by * Wp * B + l;
+                const ElemType* srow = plane + y * s.inW;
+                for (size_t x = 0; x < s.inW; x++)
+                {
+                    int bx = (int)x + s.padW;
+                    if (bx >= 0 && bx < (int)Wp)
+                        drow[bx * B] = srow[x];
+                }
+            }
+        }
+    }
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::PackOutput(const Shape& s, const ElemType* out, size_t batchSize, ElemType* dst)
+{
+    const size_t B = BlockSize;
+    size_t outBlocks = s.OutBlocks();
+    size_t Wp = PaddedOutputWidth(s);
+    size_t blockSize = B * Wp * s.outH;
+    size_t mapSize = s.outW * s.outH;
+    size_t sampleSize = mapSize * s.outC;
+
+#pragma omp parallel for
+    for (long task = 0; task < (long)(batchSize * outBlocks); task++)
+    {
+        size_t n = task / outBlocks;
+        size_t kb = task % outBlocks;
+        ElemType* d = dst + task * blockSize;
+        std::fill(d, d + blockSize, (ElemType)0);
+        for (size_t l = 0; l < B && kb * B + l < s.outC; l++)
+        {
+            const ElemType* plane = out + n * sampleSize + (kb * B + l) * mapSize;
+            for (size_t y = 0; y < s.outH; y++)
+            {
+                for (size_t x = 0; x < s.outW; x++)
+                    d[(y * Wp + x) * B + l] = plane[y * s.outW + x];
+            }
+        }
+    }
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::PackKernel(const Shape& s, const ElemType* kernel, bool transpose, ElemType* dst)
+{
+    const size_t B = BlockSize;
+    size_t inBlocks = s.InBlocks();
+    size_t outBlocks = s.OutBlocks();
+    size_t kernelSize = s.kW * s.kH * s.inC;
+    std::fill(dst, dst + inBlocks * outBlocks * s.kH * s.kW * B * B, (ElemType)0);
+
+#pragma omp parallel for
+    for (long k = 0; k < (long)s.outC; k++)
+    {
+        size_t kb = k / B, kl = k % B;
+        for (size_t c = 0; c < s.inC; c++)
+        {
+            size_t cb = c / B, cl = c % B;
+            for (size_t kh = 0; kh < s.kH; kh++)
+            {
+                for (size_t kw = 0; kw < s.kW; kw++)
+                {
+                    ElemType w = kernel[k * kernelSize + (c * s.kH + kh) * s.kW + kw];
+                    if (!transpose)
+                        dst[((((kb * inBlocks + cb) * s.kH + kh) * s.kW + kw) * B + cl) * B + kl] = w;
+                    else
+                        dst[((((cb * outBlocks + kb) * s.kH + kh) * s.kW + kw) * B + kl) * B + cl] = w;
+                }
+            }
+        }
+    }
+}
+
+template <class ElemType>
+typename CPUBlockedConvolution<ElemType>::Shape CPUBlockedConvolution<ElemType>::TransposedShape() const
+{
+    // With stride 1, the input gradient is the convolution of the output gradient with the kernel flipped
+    // in both spatial dimensions and with input and output channels swapped, padded by kernel size - 1 - pad.
+    const Shape& s = m_shape;
+    Shape t = s;
+    t.inW = s.outW; t.inH = s.outH; t.inC = s.outC;
+    t.outW = s.inW; t.outH = s.inH; t.outC = s.inC;
+    t.padW = (int)s.kW - 1 - s.padW;
+    t.padH = (int)s.kH - 1 - s.padH;
+    return t;
+}
+
+template <class ElemType>
+const ElemType* CPUBlockedConvolution<ElemType>::FlipKernel(const ElemType* kernel)
+{
+    const Shape& s = m_shape;
+    size_t taps = s.kW * s.kH;
+    ElemType* flipped = Reserve(m_flippedKernel, taps * s.inC * s.outC);
+    for (size_t k = 0; k < s.outC; k++)
+    {
+        for (size_t c = 0; c < s.inC; c++)
+        {
+            const ElemType* g = kernel + (k * s.inC + c) * taps;
+            ElemType* f = flipped + (c * s.outC + k) * taps;
+            for (size_t i = 0; i < taps; i++)
+                f[taps - 1 - i] = g[i];
+        }
+    }
+    return flipped;
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::Direct(const Shape& s, const ElemType* in, const ElemType* kernel, ElemType* out, size_t batchSize, bool accumulate)
+{
+    const size_t B = BlockSize;
+    const size_t R = RowBlock;
+    size_t inBlocks = s.InBlocks();
+    size_t outBlocks = s.OutBlocks();
+    size_t Wp, Hp;
+    PaddedExtents(s, false, Wp, Hp);
+    size_t inSampleSize = B * Wp * Hp * inBlocks;
+    size_t outSampleSize = s.outW * s.outH * s.outC;
+
+    ElemType* packedIn = Reserve(m_packedIn, batchSize * inSampleSize);
+    PackInput(s, Wp, Hp, in, batchSize, packedIn);
+    ElemType* packedKernel = Reserve(m_packedKernel, outBlocks * inBlocks * s.kH * s.kW * B * B);
+    PackKernel(s, kernel, /*transpose=*/false, packedKernel);
+
+#pragma omp parallel for
+    for (long task = 0; task < (long)(batchSize * outBlocks * s.outH); task++)
+    {
+        size_t oh = task % s.outH;
+        size_t kb = (task / s.outH) % outBlocks;
+        size_t n = task / (s.outH * outBlocks);
+        const ElemType* x = packedIn + n * inSampleSize;
+        ElemType* y = out + n * outSampleSize + (kb * B * s.outH + oh) * s.outW;
+
+        // RowBlock outputs x B maps are accumulated in registers, each weight is loaded once for all of them.
+        static_assert(R == 4 && B == 8, "The accumulator tile is 4 x 8.");
+        size_t step = s.strideW * B;
+        for (size_t ow0 = 0; ow0 < s.outW; ow0 += R)
+        {
+            AccumulatorTile<ElemType> tile;
+            for (size_t cb = 0; cb < inBlocks; cb++)
+            {
+                for (size_t kh = 0; kh < s.kH; kh++)
+                {
+                    const ElemType* row = x + ((cb * Hp + oh * s.strideH + kh) * Wp + ow0 * s.strideW) * B;
+                    for (size_t kw = 0; kw < s.kW; kw++)
+                    {
+                        const ElemType* w = packedKernel + (((kb * inBlocks + cb) * s.kH + kh) * s.kW + kw) * B * B;
+                        const ElemType* xp = row + kw * B;
+                        for (size_t cl = 0; cl < B; cl++)
+                            tile.MultiplyAdd(xp[cl], xp[step + cl], xp[2 * step + cl], xp[3 * step + cl], w + cl * B);
+                    }
+                }
+            }
+
+            ElemType acc[R][B];
+            tile.Store(acc);
+            size_t count = std::min(R, s.outW - ow0);
+            for (size_t kl = 0; kl < B && kb * B + kl < s.outC; kl++)
+            {
+                ElemType* yp = y + kl * s.outH * s.outW + ow0;
+                for (size_t r = 0; r < count; r++)
+                    yp[r] = accumulate ? yp[r] + acc[r][kl] : acc[r][kl];
+            }
+        }
+    }
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::ForwardDirect(const ElemType* in, const ElemType* kernel, ElemType* out, size_t batchSize)
+{
+    Direct(m_shape, in, kernel, out, batchSize, /*accumulate=*/false);
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::BackwardDataDirect(const ElemType* srcGrad, const ElemType* kernel, ElemType* grad, size_t batchSize)
+{
+    const Shape& s = m_shape;
+    if (s.strideW == 1 && s.strideH == 1)
+        return Direct(TransposedShape(), srcGrad, FlipKernel(kernel), grad, batchSize, /*accumulate=*/true);
+
+    // Strided convolutions scatter the output gradients into a padded gradient of each block of input channels.
+    const size_t B = BlockSize;
+    const size_t R = RowBlock;
+    size_t inBlocks = s.InBlocks();
+    size_t outBlocks = s.OutBlocks();
+    size_t Wp, Hp;
+    PaddedExtents(s, false, Wp, Hp);
+    size_t outWp = PaddedOutputWidth(s);
+    size_t outSampleSize = B * outWp * s.outH * outBlocks;
+    size_t inSampleSize = s.inW * s.inH * s.inC;
+
+    ElemType* packedOut = Reserve(m_packedOut, batchSize * outSampleSize);
+    PackOutput(s, srcGrad, batchSize, packedOut);
+    ElemType* packedKernel = Reserve(m_packedKernel, outBlocks * inBlocks * s.kH * s.kW * B * B);
+    PackKernel(s, kernel, /*transpose=*/true, packedKernel);
+
+#pragma omp parallel
+    {
+        std::vector<ElemType> padded(Hp * Wp * B);
+#pragma omp for
+        for (long task = 0; task < (long)(batchSize * inBlocks); task++)
+        {
+            size_t n = task / inBlocks;
+            size_t cb = task % inBlocks;
+
+            ElemType* a = padded.data();
+            std::fill(a, a + Hp * Wp * B, (ElemType)0);
+            const ElemType* g = packedOut + n * outSampleSize;
+            for (size_t oh = 0; oh < s.outH; oh++)
+            {
+                for (size_t kh = 0; kh < s.kH; kh++)
+                {
+                    ElemType* drow = a + (oh * s.strideH + kh) * Wp * B;
+                    for (size_t kw = 0; kw < s.kW; kw++)
+                    {
+                        for (size_t ow0 = 0; ow0 < s.outW; ow0 += R)
+                        {
+                            // Contributions of RowBlock outputs x all maps to B input channels.
+                            AccumulatorTile<ElemType> tile;
+                            for (size_t kb = 0; kb < outBlocks; kb++)
+                            {
+                                const ElemType* gp = g + ((kb * s.outH + oh) * outWp + ow0) * B;
+                                const ElemType* w = packedKernel + (((cb * outBlocks + kb) * s.kH + kh) * s.kW + kw) * B * B;
+                                for (size_t kl = 0; kl < B; kl++)
+                                    tile.MultiplyAdd(gp[kl], gp[B + kl], gp[2 * B + kl], gp[3 * B + kl], w + kl * B);
+                            }
+
+                            ElemType sum[R][B];
+                            tile.Store(sum);
+                            size_t count = std::min(R, s.outW - ow0);
+                            for (size_t r = 0; r < count; r++)
+                            {
+                                ElemType* dp = drow + ((ow0 + r) * s.strideW + kw) * B;
+                                for (size_t cl = 0; cl < B; cl++)
+                                    dp[cl] += sum[r][cl];
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Inputs that no output looks at (outside of the padded extents) get no gradient.
+            ElemType* x = grad + n * inSampleSize;
+            for (size_t cl = 0; cl < B && cb * B + cl < s.inC; cl++)
+            {
+                ElemType* plane = x + (cb * B + cl) * s.inH * s.inW;
+                for (size_t y = 0; y < s.inH; y++)
+                {
+                    int by = (int)y + s.padH;
+                    if (by < 0 || by >= (int)Hp)
+                        continue;
+                    for (size_t xx = 0; xx < s.inW; xx++)
+                    {
+                        int bx = (int)xx + s.padW;
+                        if (bx >= 0 && bx < (int)Wp)
+                            plane[y * s.inW + xx] += a[(by * Wp + bx) * B + cl];
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::BackwardKernelDirect(const ElemType* srcGrad, const ElemType* in, ElemType* kernelGrad, size_t batchSize)
+{
+    const size_t B = BlockSize;
+    const size_t H = B / 2;
+    const Shape& s = m_shape;
+    size_t inBlocks = s.InBlocks();
+    size_t outBlocks = s.OutBlocks();
+    size_t Wp, Hp;
+    PaddedExtents(s, false, Wp, Hp);
+    size_t outWp = PaddedOutputWidth(s);
+    size_t inSampleSize = B * Wp * Hp * inBlocks;
+    size_t outSampleSize = B * outWp * s.outH * outBlocks;
+
+    ElemType* packedIn = Reserve(m_packedIn, batchSize * inSampleSize);
+    PackInput(s, Wp, Hp, in, batchSize, packedIn);
+    ElemType* packedOut = Reserve(m_packedOut, batchSize * outSampleSize);
+    PackOutput(s, srcGrad, batchSize, packedOut);
+
+    // Every (map block, channel block) pair owns its part of the gradient. If there are fewer pairs
+    // than threads, the minibatch is sliced as well and the partial sums are added up afterwards.
+    size_t blocks = outBlocks * inBlocks;
+    size_t numThreads = (size_t)omp_get_max_threads();
+    size_t slices = std::max((size_t)1, std::min(batchSize, (numThreads + blocks - 1) / blocks));
+    size_t partSize = s.kH * s.kW * B * B;
+    ElemType* partials = Reserve(m_partials, slices * blocks * partSize);
+
+#pragma omp parallel for
+    for (long task = 0; task < (long)(slices * blocks); task++)
+    {
+        size_t slice = task / blocks;
+        size_t kb = (task % blocks) / inBlocks;
+        size_t cb = (task % blocks) % inBlocks;
+        size_t nBegin = batchSize * slice / slices;
+        size_t nEnd = batchSize * (slice + 1) / slices;
+
+        // For each tap, half a block of channels x B maps is accumulated in registers over all outputs.
+        ElemType* dw = partials + task * partSize;
+        for (size_t kh = 0; kh < s.kH; kh++)
+        {
+            for (size_t kw = 0; kw < s.kW; kw++)
+            {
+                for (size_t half = 0; half < B; half += H)
+                {
+                    AccumulatorTile<ElemType> tile;
+                    for (size_t n = nBegin; n < nEnd; n++)
+                    {
+                        const ElemType* x = packedIn + n * inSampleSize + half;
+                        const ElemType* g = packedOut + n * outSampleSize;
+                        for (size_t oh = 0; oh < s.outH; oh++)
+                        {
+                            const ElemType* grow = g + (kb * s.outH + oh) * outWp * B;
+                            const ElemType* xrow = x + ((cb * Hp + oh * s.strideH + kh) * Wp + kw) * B;
+                            for (size_t ow = 0; ow < s.outW; ow++)
+                            {
+                                const ElemType* xp = xrow + ow * s.strideW * B;
+                                tile.MultiplyAdd(xp[0], xp[1], xp[2], xp[3], grow + ow * B);
+                            }
+                        }
+                    }
+                    ElemType acc[H][B];
+                    tile.Store(acc);
+                    memcpy(dw + ((kh * s.kW + kw) * B + half) * B, acc, sizeof(acc));
+                }
+            }
+        }
+    }
+
+    size_t kernelSize = s.kW * s.kH * s.inC;
+#pragma omp parallel for
+    for (long k = 0; k < (long)s.outC; k++)
+    {
+        size_t kb = k / B, kl = k % B;
+        for (size_t c = 0; c < s.inC; c++)
+        {
+            size_t cb = c / B, cl = c % B;
+            for (size_t kh = 0; kh < s.kH; kh++)
+            {
+                for (size_t kw = 0; kw < s.kW; kw++)
+                {
+                    ElemType sum = 0;
+                    for (size_t slice = 0; slice < slices; slice++)
+                        sum += partials[(slice * blocks + kb * inBlocks + cb) * partSize + ((kh * s.kW + kw) * B + cl) * B + kl];
+                    kernelGrad[k * kernelSize + (c * s.kH + kh) * s.kW + kw] += sum;
+                }
+            }
+        }
+    }
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::Winograd(const Shape& s, const ElemType* in, const ElemType* kernel, ElemType* out, size_t batchSize, bool accumulate)
+{
+    const size_t B = BlockSize;
+    size_t inBlocks = s.InBlocks();
+    size_t paddedC = inBlocks * B;
+    size_t K = s.outC;
+    size_t Wp, Hp;
+    PaddedExtents(s, true, Wp, Hp);
+    size_t inSampleSize = B * Wp * Hp * inBlocks;
+    size_t tilesW = (s.outW + 1) / 2;
+    size_t tilesH = (s.outH + 1) / 2;
+    size_t tilesPerSample = tilesW * tilesH;
+    size_t T = batchSize * tilesPerSample;
+
+    ElemType* packedIn = Reserve(m_packedIn, batchSize * inSampleSize);
+    PackInput(s, Wp, Hp, in, batchSize, packedIn);
+
+    // Kernel transform U = G g G^T. U[xi] is a [paddedC x K] matrix for each of the 16 tile positions xi.
+    ElemType* U = Reserve(m_transformedKernel, 16 * paddedC * K);
+    std::fill(U, U + 16 * paddedC * K, (ElemType)0);
+#pragma omp parallel for
+    for (long k = 0; k < (long)K; k++)
+    {
+        for (size_t c = 0; c < s.inC; c++)
+        {
+            const ElemType* g = kernel + (k * s.inC + c) * 9;
+            ElemType t[4][3];
+            for (size_t j = 0; j < 3; j++)
+            {
+                t[0][j] = g[j];
+                t[1][j] = (g[j] + g[3 + j] + g[6 + j]) / 2;
+                t[2][j] = (g[j] - g[3 + j] + g[6 + j]) / 2;
+                t[3][j] = g[6 + j];
+            }
+            for (size_t i = 0; i < 4; i++)
+            {
+                ElemType u[4] = { t[i][0], (t[i][0] + t[i][1] + t[i][2]) / 2, (t[i][0] - t[i][1] + t[i][2]) / 2, t[i][2] };
+                for (size_t j = 0; j < 4; j++)
+                    U[(i * 4 + j) * paddedC * K + k * paddedC + c] = u[j];
+            }
+        }
+    }
+
+    // Input transform V = B^T d B. V[xi] is a [paddedC x T] matrix.
+    ElemType* V = Reserve(m_transformedIn, 16 * paddedC * T);
+#pragma omp parallel for
+    for (long task = 0; task < (long)(T * inBlocks); task++)
+    {
+        size_t t = task / inBlocks;
+        size_t cb = task % inBlocks;
+        size_t n = t / tilesPerSample;
+        size_t ty = (t % tilesPerSample) / tilesW;
+        size_t tx = (t % tilesPerSample) % tilesW;
+
+        const ElemType* d = packedIn + n * inSampleSize + ((cb * Hp + 2 * ty) * Wp + 2 * tx) * B;
+        ElemType tmp[4][4][B];
+        for (size_t j = 0; j < 4; j++)
+        {
+            const ElemType* d0 = d + j * B;
+            const ElemType* d1 = d0 + Wp * B;
+            const ElemType* d2 = d1 + Wp * B;
+            const ElemType* d3 = d2 + Wp * B;
+            for (size_t l = 0; l < B; l++)
+            {
+                tmp[0][j][l] = d0[l] - d2[l];
+                tmp[1][j][l] = d1[l] + d2[l];
+                tmp[2][j][l] = d2[l] - d1[l];
+                tmp[3][j][l] = d1[l] - d3[l];
+            }
+        }
+        ElemType* v = V + t * paddedC + cb * B;
+        for (size_t i = 0; i < 4; i++)
+        {
+            ElemType* v0 = v + (i * 4 + 0) * paddedC * T;
+            ElemType* v1 = v + (i * 4 + 1) * paddedC * T;
+            ElemType* v2 = v + (i * 4 + 2) * paddedC * T;
+            ElemType* v3 = v + (i * 4 + 3) * paddedC * T;
+            for (size_t l = 0; l < B; l++)
+            {
+                v0[l] = tmp[i][0][l] - tmp[i][2][l];
+                v1[l] = tmp[i][1][l] + tmp[i][2][l];
+                v2[l] = tmp[i][2][l] - tmp[i][1][l];
+                v3[l] = tmp[i][1][l] - tmp[i][3][l];
+            }
+        }
+    }
+
+    // M[xi] = U[xi]^T V[xi], a [K x T] matrix for each tile position.
+    ElemType* M = Reserve(m_products, 16 * K * T);
+    for (size_t xi = 0; xi < 16; xi++)
+    {
+        CPUMatrix<ElemType> u(paddedC, K, U + xi * paddedC * K, matrixFlagDontOwnBuffer);
+        CPUMatrix<ElemType> v(paddedC, T, V + xi * paddedC * T, matrixFlagDontOwnBuffer);
+        CPUMatrix<ElemType> m(K, T, M + xi * K * T, matrixFlagDontOwnBuffer);
+        CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, u, true, v, false, 0, m);
+    }
+
+    // Output transform Y = A^T M A, each tile gives 2x2 outputs.
+    size_t outSampleSize = s.outW * s.outH * K;
+#pragma omp parallel for
+    for (long t = 0; t < (long)T; t++)
+    {
+        size_t n = t / tilesPerSample;
+        size_t ty = (t % tilesPerSample) / tilesW;
+        size_t tx = (t % tilesPerSample) % tilesW;
+        bool hasRight = 2 * tx + 1 < s.outW;
+        bool hasBottom = 2 * ty + 1 < s.outH;
+        ElemType* y = out + n * outSampleSize + (2 * ty) * s.outW + 2 * tx;
+        for (size_t k = 0; k < K; k++)
+        {
+            const ElemType* m = M + t * K + k;
+            ElemType mm[4][4];
+            for (size_t xi = 0; xi < 16; xi++)
+                mm[xi / 4][xi % 4] = m[xi * K * T];
+            ElemType r[2][4];
+            for (size_t j = 0; j < 4; j++)
+            {
+                r[0][j] = mm[0][j] + mm[1][j] + mm[2][j];
+                r[1][j] = mm[1][j] - mm[2][j] - mm[3][j];
+            }
+            ElemType res[2][2];
+            for (size_t i = 0; i < 2; i++)
+            {
+                res[i][0] = r[i][0] + r[i][1] + r[i][2];
+                res[i][1] = r[i][1] - r[i][2] - r[i][3];
+            }
+
+            ElemType* yk = y + k * s.outH * s.outW;
+            for (size_t i = 0; i < (hasBottom ? 2 : 1); i++)
+            {
+                for (size_t j = 0; j < (hasRight ? 2 : 1); j++)
+                {
+                    ElemType& dst = yk[i * s.outW + j];
+                    dst = accumulate ? dst + res[i][j] : res[i][j];
+                }
+            }
+        }
+    }
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::ForwardWinograd(const ElemType* in, const ElemType* kernel, ElemType* out, size_t batchSize)
+{
+    if (!m_winograd)
+        LogicError("CPUBlockedConvolution: Winograd convolution requires a 3x3 kernel with stride 1.");
+
+    Winograd(m_shape, in, kernel, out, batchSize, /*accumulate=*/false);
+}
+
+template <class ElemType>
+void CPUBlockedConvolution<ElemType>::BackwardDataWinograd(const ElemType* srcGrad, const ElemType* kernel, ElemType* grad, size_t batchSize)
+{
+    if (!m_winograd)
+        LogicError("CPUBlockedConvolution: Winograd convolution requires a 3x3 kernel with stride 1.");
+
+    Winograd(TransposedShape(), srcGrad, FlipKernel(kernel), grad, batchSize, /*accumulate=*/true);
+}
+
+template class CPUBlockedConvolution<float>;
+template class CPUBlockedConvolution<double>;
+
+}}}
@@ -0,0 +1,120 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPUConvolution.h -- direct and Winograd CPU kernels for 2D convolutions, working on channel-blocked data
+//
+
+#pragma once
+
+#include "CPUMatrix.h"
+#include "ConvolveGeometry.h"
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// CPUBlockedConvolution implements 2D convolutions with full sharing for data in the CHW/cudnn layout,
+// i.e. input [W x H x C], kernel [kW x kH x C] with K maps (stored as a row-major [K x kW*kH*C] matrix)
+// and output [W' x H' x K], each sample being one column.
+//
+// Internally the data is converted to a channel-blocked layout in which BlockSize consecutive channels
+// of the same pixel are adjacent in memory ([BlockSize x W x H x C/BlockSize], channels padded with zeros,
+// spatial padding materialized). The inner loops then run over a block of channels with unit stride,
+// which the compiler vectorizes, and no bounds checks are needed.
+//
+// Two algorithms are provided:
+//  - Direct: loops over the kernel taps and accumulates RowBlock x BlockSize outputs in registers. Supports any
+//    kernel size, stride and padding. Forward is parallel over (sample, map block, output row). Backward data
+//    is the forward convolution with the flipped kernel for stride 1, and otherwise scatters the gradients
+//    in parallel over (sample, input channel block). Backward kernel is parallel over (map block, channel block)
+//    and, if that does not give enough work, slices of the minibatch.
+//  - Winograd F(2x2, 3x3): for 3x3 kernels with stride 1. The input is cut into overlapping 4x4 tiles that
+//    are transformed (V = B^T d B), multiplied with the transformed kernel (U = G g G^T) by 16 GEMMs
+//    over the channels and transformed back (Y = A^T M A) into 2x2 output tiles. This uses 2.25x fewer
+//    multiplications than the direct method. Backward data is computed as the forward Winograd convolution
+//    of the output gradients with the flipped, transposed kernel.
+//
+// The backward methods always accumulate into their results, just like the GEMM engine does.
+// Scratch memory is kept between calls, so an instance must not be used by several threads at once.
+template <class ElemType>
+class CPUBlockedConvolution
+{
+public:
+    static const size_t BlockSize = 8;
+    // Number of adjacent outputs of a row the direct kernels compute at once.
+    static const size_t RowBlock = 4;
+
+    CPUBlockedConvolution(const ConvolveGeometry& geometry);
+
+    // Returns true if the geometry describes a 2D (or 1D) convolution this class can compute.
+    static bool IsSupported(const ConvolveGeometry& geometry);
+
+    bool SupportsWinograd() const { return m_winograd; }
+
+    // out[W'H'K x batchSize] = convolution of in[WHC x batchSize] with kernel.
+    void ForwardDirect(const ElemType* in, const ElemType* kernel, ElemType* out, size_t batchSize);
+    void ForwardWinograd(const ElemType* in, const ElemType* kernel, ElemType* out, size_t batchSize);
+
+    // grad[WHC x batchSize] += gradient of the input given srcGrad[W'H'K x batchSize].
+    void BackwardDataDirect(const ElemType* srcGrad, const ElemType* kernel, ElemType* grad, size_t batchSize);
+    void BackwardDataWinograd(const ElemType* srcGrad, const ElemType* kernel, ElemType* grad, size_t batchSize);
+
+    // kernelGrad += gradient of the kernel given srcGrad[W'H'K x batchSize] and in[WHC x batchSize].
+    void BackwardKernelDirect(const ElemType* srcGrad, const ElemType* in, ElemType* kernelGrad, size_t batchSize);
+
+private:
+    // Dimensions of a 2D convolution. The backward data pass of Winograd is described by a second
+    // instance, with the roles of input and output swapped.
+    struct Shape
+    {
+        size_t inW, inH, inC;
+        size_t outW, outH, outC;
+        size_t kW, kH;
+        size_t strideW, strideH;
+        int padW, padH;
+
+        size_t InBlocks() const  { return (inC + BlockSize - 1) / BlockSize; }
+        size_t OutBlocks() const { return (outC + BlockSize - 1) / BlockSize; }
+    };
+
+    // Extents of the padded, blocked input of a shape. Large enough for all taps of all outputs
+    // (and, for Winograd, for all tiles including the ones that stick out at the right and bottom).
+    static void PaddedExtents(const Shape& s, bool winograd, size_t& padW, size_t& padH);
+
+    // Converts batchSize samples of [inW x inH x inC] to [BlockSize x Wp x Hp x InBlocks()] each.
+    static void PackInput(const Shape& s, size_t Wp, size_t Hp, const ElemType* in, size_t batchSize, ElemType* dst);
+    // Converts batchSize samples of [outW x outH x outC] to [BlockSize x Wp x outH x OutBlocks()] each,
+    // where Wp is outW rounded up to a multiple of RowBlock.
+    static size_t PaddedOutputWidth(const Shape& s);
+    static void PackOutput(const Shape& s, const ElemType* out, size_t batchSize, ElemType* dst);
+
+    // kernel[k, (c, kh, kw)] -> [BlockSize(k) x BlockSize(c) x kW x kH x InBlocks() x OutBlocks()],
+    // or with transpose = true -> [BlockSize(c) x BlockSize(k) x kW x kH x OutBlocks() x InBlocks()].
+    static void PackKernel(const Shape& s, const ElemType* kernel, bool transpose, ElemType* dst);
+
+    // Shape and kernel that compute backward data as a forward convolution (stride 1 only).
+    Shape TransposedShape() const;
+    const ElemType* FlipKernel(const ElemType* kernel);
+
+    // Forward convolution of a shape with a kernel with layout [kW x kH x inC x outC].
+    // The result is assigned to out, or added to it if accumulate is true.
+    void Direct(const Shape& s, const ElemType* in, const ElemType* kernel, ElemType* out, size_t batchSize, bool accumulate);
+    void Winograd(const Shape& s, const ElemType* in, const ElemType* kernel, ElemType* out, size_t batchSize, bool accumulate);
+
+    static ElemType* Reserve(std::vector<ElemType>& buffer, size_t size);
+
+    Shape m_shape;
+    bool m_winograd;
+
+    std::vector<ElemType> m_packedIn;
+    std::vector<ElemType> m_packedOut;
+    std::vector<ElemType> m_packedKernel;
+    std::vector<ElemType> m_partials;
+    std::vector<ElemType> m_flippedKernel;
+    // Winograd: transformed kernel, transformed input tiles and their products.
+    std::vector<ElemType> m_transformedKernel;
+    std::vector<ElemType> m_transformedIn;
+    std::vector<ElemType> m_products;
+};
+
+}}}
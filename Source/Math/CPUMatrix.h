@@ -415,10 +415,21 @@ public:
     void BatchNormalizationBackward(const CPUMatrix<ElemType>& in, CPUMatrix<ElemType>& grad, const CPUMatrix<ElemType>& scale, double blendFactor, const CPUMatrix<ElemType>& saveMean, const CPUMatrix<ElemType>& saveInvStdDev,
                                     CPUMatrix<ElemType>& scaleGrad, CPUMatrix<ElemType>& biasGrad) const;
 
+    void RNNForward(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& paramW, size_t xDim, size_t yDim, const vector<size_t>& numSequencesForFrame, const struct RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& workspace);
+    void RNNBackwardData(const CPUMatrix<ElemType>& outputDY, const CPUMatrix<ElemType>& paramW, CPUMatrix<ElemType>& outputDX, const struct RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& workspace);
+    void RNNBackwardWeights(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& outputY, CPUMatrix<ElemType>& dw, const struct RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& workspace);
+
 public:
     // This functions do not depend on <ElemType>, i.e. you can call them on any <ElemType>
     static int SetNumThreads(int numThreads);
     static int GetMaxNumThreads();
+    // Limits the OpenMP and MKL threads of operations issued by the calling thread only.
+    static void SetNumThreadsForCurrentThread(int numThreads);
+
+    // TensorOp() splits ops across OpenMP threads such that each thread gets at least this many elements
+    // (output elements times reduction length); smaller ops run serially. 0 disables the parallel path.
+    static void SetTensorOpMinElementsPerThread(size_t minElementsPerThread);
+    static size_t GetTensorOpMinElementsPerThread();
 
     static void SetCompatibleMode();
 
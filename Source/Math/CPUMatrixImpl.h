@@ -12,6 +12,7 @@
 
 #include "CPUMatrix.h"
 #include "TensorOps.h"
+#include "CPURNN.h"
 #include <assert.h>
 #include <stdexcept>
 #include <omp.h>
@@ -104,10 +105,11 @@ CPUMatrix<ElemType>::CPUMatrix()
     ZeroInit();
 }
 
-// helper to allocate an array of ElemType
-// Use this instead of new[] to get NaN initialization for debugging.
+// helper to allocate the element buffer of a CPUMatrix from the pooling allocator
+// The buffer must be released with CPUPoolingMemAllocator::Deallocate(), not delete[].
+// Pass zeroFill=false where the caller overwrites the content anyway.
 template <class ElemType>
-static ElemType* NewArray(size_t n)
+static ElemType* NewArray(size_t n, bool zeroFill = true)
 {
     // We need to allocate possibly one more element for the following reason.
     // At some point we might want to fill a buffer with the result of a random
@@ -117,7 +119,7 @@ static ElemType* NewArray(size_t n)
     // number gaussians on the GPU is not supported so we must always 
     // generate an even number. So since we wouldn't know how to update the tally
     // we are making this allocate one more element in the worst case.
-    ElemType* p = new ElemType[AsMultipleOf(n, 2)]();
+    ElemType* p = (ElemType*) CPUPoolingMemAllocator::Allocate(AsMultipleOf(n, 2) * sizeof(ElemType), zeroFill);
 #if 0 // _DEBUG
         ElemType nan = Matrix<ElemType>::MakeNan(__LINE__);
         for (size_t i = 0; i < n; i++)
@@ -875,7 +877,8 @@ void CPUMatrix<ElemType>::SetValue(const size_t numRows, const size_t numCols, E
     if (matrixFlags & matrixFlagDontOwnBuffer)
     {
         // free previous array allocation if any before overwriting
-        delete[] Buffer();
+        if (OwnBuffer())
+            CPUPoolingMemAllocator::Deallocate(Buffer());
 
         m_numRows = numRows;
         m_numCols = numCols;
@@ -1523,10 +1526,10 @@ void CPUMatrix<ElemType>::Resize(const size_t numRows, const size_t numCols, boo
         ElemType* pArray = nullptr;
         if (numElements > 0)
         {
-            pArray = NewArray<ElemType>(numElements);
+            pArray = NewArray<ElemType>(numElements, /*zeroFill=*/false); // content is not preserved
         }
         // success: update the object
-        delete[] Buffer();
+        CPUPoolingMemAllocator::Deallocate(Buffer());
 
         SetBuffer(pArray, numElements * sizeof(ElemType));
         SetSizeAllocated(numElements);
@@ -1546,7 +1549,7 @@ ElemType* CPUMatrix<ElemType>::CopyToArray() const
     size_t numElements = GetNumElements();
     if (numElements != 0)
     {
-        ElemType* arrayCopyTo = NewArray<ElemType>(numElements);
+        ElemType* arrayCopyTo = new ElemType[numElements];
         memcpy(arrayCopyTo, Data(), sizeof(ElemType) * numElements);
         return arrayCopyTo;
     }
@@ -1566,7 +1569,7 @@ size_t CPUMatrix<ElemType>::CopyToArray(ElemType*& arrayCopyTo, size_t& currentA
     if (numElements > currentArraySize)
     {
         delete arrayCopyTo;
-        arrayCopyTo = NewArray<ElemType>(numElements);
+        arrayCopyTo = new ElemType[numElements];
         currentArraySize = numElements;
     }
 
@@ -4959,6 +4962,31 @@ void CPUMatrix<ElemType>::BatchNormalizationBackward(const CPUMatrix<ElemType>&
     RuntimeError("Batch normalization training on CPU is not yet implemented.");
 }
 
+template <class ElemType>
+void CPUMatrix<ElemType>::RNNForward(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& paramW, size_t xDim, size_t yDim, const vector<size_t>& numSequencesForFrame,
+                                     const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& workspace)
+{
+    // The executor holds no state between calls, so unlike the cuDNN one it is not kept with the matrix.
+    CPURNNExecutor<ElemType> executor(xDim, yDim, rnnAttributes);
+    executor.ForwardCore(paramW, inputX, *this, numSequencesForFrame, workspace);
+}
+
+template <class ElemType>
+void CPUMatrix<ElemType>::RNNBackwardData(const CPUMatrix<ElemType>& outputDY, const CPUMatrix<ElemType>& paramW, CPUMatrix<ElemType>& outputDX, const RnnAttributes& rnnAttributes,
+                                          CPUMatrix<ElemType>& workspace)
+{
+    UNUSED(outputDY); UNUSED(paramW); UNUSED(outputDX); UNUSED(rnnAttributes); UNUSED(workspace);
+    RuntimeError("OptimizedRNNStack training on CPU is not yet implemented.");
+}
+
+template <class ElemType>
+void CPUMatrix<ElemType>::RNNBackwardWeights(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& outputY, CPUMatrix<ElemType>& dw, const RnnAttributes& rnnAttributes,
+                                             CPUMatrix<ElemType>& workspace)
+{
+    UNUSED(inputX); UNUSED(outputY); UNUSED(dw); UNUSED(rnnAttributes); UNUSED(workspace);
+    RuntimeError("OptimizedRNNStack training on CPU is not yet implemented.");
+}
+
 
 #pragma region Static BLAS Functions
 
@@ -6798,6 +6826,20 @@ int CPUMatrix<ElemType>::GetMaxNumThreads()
     return numThreads;
 }
 
+// Used by threads that execute network nodes concurrently, so that together they do not oversubscribe the cores.
+// The OpenMP setting is per thread for threads not created by OpenMP; OpenBLAS has no per-thread setting.
+template <class ElemType>
+void CPUMatrix<ElemType>::SetNumThreadsForCurrentThread(int numThreads)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(numThreads);
+
+    #ifdef USE_MKL
+        mkl_set_num_threads_local(numThreads);
+    #endif
+#endif
+}
+
 // To ensure Intel MKL calls return the same results on all Intel or Intel compatible CPUs,
 // the function set CBWR compatible mode.
 template <class ElemType>
@@ -6986,20 +7028,16 @@ struct TensorOpIteration<ElemType, OPFN, ReductionOp, 3, true /*vectorizable*/,
         size_t K = regularOpDims[0];
         // special-case beta and alpha to allow the compiler to short-circuit it
         if (beta != 0)
-#pragma omp parallel for
             for (int k = 0; k < (int) K; k++)
                 TensorOpIteration<ElemType, OPFN, ReductionOp, 3, true /*vectorizable*/, -1 /*no reduction*/, -1 /*scalar*/>::Loop(beta, array<ElemType*, 3>{pa + k, pb + k, pc + k}, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
         else if (alpha != 1)
-#pragma omp parallel for
             for (int k = 0; k < (int) K; k++)
                 TensorOpIteration<ElemType, OPFN, ReductionOp, 3, true /*vectorizable*/, -1 /*no reduction*/, -1 /*scalar*/>::Loop(0, array<ElemType*, 3>{pa + k, pb + k, pc + k}, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
         else
-#pragma omp parallel for
             for (int k = 0; k < (int) K; k++)
                 TensorOpIteration<ElemType, OPFN, ReductionOp, 3, true /*vectorizable*/, -1 /*no reduction*/, -1 /*scalar*/>::Loop(0, array<ElemType*, 3>{pa + k, pb + k, pc + k}, 1, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
         // TODO: According to Amit, the VS compiler is not able to vectorize into lambdas. Solution: change the lambda to take an N, or to implement the loop inside (with 1 element by default).
-        // TODO: The signedness of k (required for omp) causes an extra sign-extend.
-        // TODO: OMP adds LOTS of overhead. Do we need a guard, a min size when to use it?
+        // Note: This loop runs serially. Large ops are split across threads further out, see TensorOpParallelIteration.
     }
 };
 // and unary
@@ -7015,15 +7053,12 @@ struct TensorOpIteration<ElemType, OPFN, ReductionOp, 2, true /*vectorizable*/,
         size_t K = regularOpDims[0];
         // special-case beta and alpha to allow the compiler to short-circuit it
         if (beta != 0)
-#pragma omp parallel for
             for (int k = 0; k < (int) K; k++)
                 TensorOpIteration<ElemType, OPFN, ReductionOp, 2, true /*vectorizable*/, -1 /*no reduction*/, -1 /*scalar*/>::Loop(beta, array<ElemType*, 2>{pa + k, pb + k}, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
         else if (alpha != 1)
-#pragma omp parallel for
             for (int k = 0; k < (int) K; k++)
                 TensorOpIteration<ElemType, OPFN, ReductionOp, 2, true /*vectorizable*/, -1 /*no reduction*/, -1 /*scalar*/>::Loop(0, array<ElemType*, 2>{pa + k, pb + k}, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
         else
-#pragma omp parallel for
             for (int k = 0; k < (int) K; k++)
                 TensorOpIteration<ElemType, OPFN, ReductionOp, 2, true /*vectorizable*/, -1 /*no reduction*/, -1 /*scalar*/>::Loop(0, array<ElemType*, 2>{pa + k, pb + k}, 1, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
     }
@@ -7091,6 +7126,162 @@ struct TensorArgOpIteration<ElemType, N, -1>
     }
 };
 
+// -----------------------------------------------------------------------
+// parallel execution of the loops above
+// Large ops are cut into one contiguous slice per thread along a single dimension, and each
+// thread runs the regular (serial, possibly vectorized) loop nest on its slice.
+// -----------------------------------------------------------------------
+
+// number of elements below which an op is not worth splitting across threads
+// This is inline (not static) so that all ElemTypes share the same setting.
+inline size_t& TensorOpMinElementsPerThread()
+{
+    static size_t minElementsPerThread = 16384;
+    return minElementsPerThread;
+}
+
+template <class ElemType>
+void CPUMatrix<ElemType>::SetTensorOpMinElementsPerThread(size_t minElementsPerThread)
+{
+    TensorOpMinElementsPerThread() = minElementsPerThread;
+}
+
+template <class ElemType>
+size_t CPUMatrix<ElemType>::GetTensorOpMinElementsPerThread()
+{
+    return TensorOpMinElementsPerThread();
+}
+
+// determine the number of threads to run an op with (1 = serial on the calling thread)
+// The cost of an op is approximated by the number of output elements times the reduction length.
+static int TensorOpNumThreads(const SmallVector<size_t>& regularOpDims, const SmallVector<size_t>& reducingOpDims)
+{
+#ifdef _OPENMP
+    size_t minElementsPerThread = TensorOpMinElementsPerThread();
+    if (minElementsPerThread == 0 || omp_in_parallel()) // disabled, or we are already inside a parallel region
+        return 1;
+    size_t numElements = 1;
+    for (size_t i = 0; i < regularOpDims.size(); i++)
+        numElements *= regularOpDims[i];
+    for (size_t i = 0; i < reducingOpDims.size(); i++)
+        numElements *= reducingOpDims[i];
+    size_t numThreads = min((size_t) omp_get_max_threads(), numElements / minElementsPerThread);
+    return (int) max(numThreads, (size_t) 1);
+#else
+    UNUSED(regularOpDims); UNUSED(reducingOpDims);
+    return 1;
+#endif
+}
+
+// split the loop over regular index k across threads
+// The slices are taken along the outermost regular dimension that has at least one iteration per thread (or
+// the largest one if there is none), so that each thread streams over a contiguous block of the output.
+// Regular dimensions are not reduced, so the slices write disjoint sets of output elements.
+template <class ElemType, typename OPFN, typename ReductionOp, size_t N, bool vectorizable, int m, int k>
+struct TensorOpParallelIteration
+{
+    static void Loop(int numThreads, ElemType beta, const array<ElemType*, N>& pointers, ElemType alpha, const OPFN& opfn, const ReductionOp& reductionOp,
+                     const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, N>& regularStrides,
+                     const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+    {
+        size_t splitDim = (size_t) k;
+        for (int j = k; j >= 0; j--)
+        {
+            if (regularOpDims[(size_t) j] >= (size_t) numThreads)
+            {
+                splitDim = (size_t) j;
+                break;
+            }
+            if (regularOpDims[(size_t) j] > regularOpDims[splitDim])
+                splitDim = (size_t) j;
+        }
+        size_t splitDimSize = regularOpDims[splitDim];
+        if (splitDimSize < 2 || regularStrides[N - 1][splitDim] == 0) // nothing to split (or an unexpected output layout)
+            return TensorOpIteration<ElemType, OPFN, ReductionOp, N, vectorizable, m, k>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+
+        int numSlices = (int) min((size_t) numThreads, splitDimSize);
+#pragma omp parallel for num_threads(numSlices) schedule(static, 1)
+        for (int slice = 0; slice < numSlices; slice++)
+        {
+            size_t begin = splitDimSize * slice / numSlices;
+            size_t end = splitDimSize * (slice + 1) / numSlices;
+            SmallVector<size_t> sliceOpDims = regularOpDims;
+            sliceOpDims[splitDim] = end - begin;
+            array<ElemType*, N> slicePointers = pointers;
+            for (size_t i = 0; i < N; i++)
+                slicePointers[i] += (ptrdiff_t) begin * regularStrides[i][splitDim];
+            TensorOpIteration<ElemType, OPFN, ReductionOp, N, vectorizable, m, k>::Loop(beta, slicePointers, alpha, opfn, reductionOp, sliceOpDims, regularStrides, reducingOpDims, reducingStrides);
+        }
+    }
+};
+
+// special version for a scalar result (all dimensions are reduced)
+// Here the outermost reducing dimension is split; each thread computes a partial aggregate, and the partial
+// aggregates are combined in a fixed order, so results only depend on the number of threads, not on their timing.
+// Note that this changes the order of the summation w.r.t. the serial version, so results may differ in the last bits.
+template <class ElemType, typename OPFN, typename ReductionOp, size_t N, bool vectorizable, int m>
+struct TensorOpParallelIteration<ElemType, OPFN, ReductionOp, N, vectorizable, m, -1>
+{
+    static void Loop(int numThreads, ElemType beta, const array<ElemType*, N>& pointers, ElemType alpha, const OPFN& opfn, const ReductionOp& reductionOp,
+                     const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, N>& regularStrides,
+                     const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+    {
+        size_t splitDimSize = reducingOpDims[(size_t) m];
+        if (splitDimSize < 2)
+            return TensorOpIteration<ElemType, OPFN, ReductionOp, N, vectorizable, m, -1>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+
+        int numSlices = (int) min((size_t) numThreads, splitDimSize);
+        vector<double> partialAggregates(numSlices);
+#pragma omp parallel for num_threads(numSlices) schedule(static, 1)
+        for (int slice = 0; slice < numSlices; slice++)
+        {
+            size_t begin = splitDimSize * slice / numSlices;
+            size_t end = splitDimSize * (slice + 1) / numSlices;
+            SmallVector<size_t> sliceOpDims = reducingOpDims;
+            sliceOpDims[(size_t) m] = end - begin;
+            array<ElemType*, N> slicePointers = pointers;
+            for (size_t i = 0; i < N - 1; i++) // last one is the result pointer, which is not advanced in reduction
+                slicePointers[i] += (ptrdiff_t) begin * reducingStrides[i][(size_t) m];
+            partialAggregates[slice] = TensorOpReduction<ElemType, OPFN, ReductionOp, N, m>::Loop(slicePointers, opfn, reductionOp, sliceOpDims, reducingStrides);
+        }
+        double aggregate = partialAggregates[0];
+        for (int slice = 1; slice < numSlices; slice++)
+            aggregate = reductionOp(aggregate, partialAggregates[slice]);
+
+        // same as TensorOpIteration<..., -1>
+        ElemType val = (ElemType) aggregate;
+        val *= alpha;
+        auto* pout = pointers.back();
+        if (beta != 0)
+            val += beta * *pout;
+        *pout = val;
+    }
+};
+
+// a single output element without reduction: nothing to split
+template <class ElemType, typename OPFN, typename ReductionOp, size_t N, bool vectorizable>
+struct TensorOpParallelIteration<ElemType, OPFN, ReductionOp, N, vectorizable, -1, -1>
+{
+    static void Loop(int, ElemType beta, const array<ElemType*, N>& pointers, ElemType alpha, const OPFN& opfn, const ReductionOp& reductionOp,
+                     const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, N>& regularStrides,
+                     const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+    {
+        TensorOpIteration<ElemType, OPFN, ReductionOp, N, vectorizable, -1, -1>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+    }
+};
+
+// run the loop nest for regular index k and reducing index m, serially or split across threads
+template <class ElemType, typename OPFN, typename ReductionOp, size_t N, bool vectorizable, int m, int k>
+static inline void TensorOpLoop(int numThreads, ElemType beta, const array<ElemType*, N>& pointers, ElemType alpha, const OPFN& opfn, const ReductionOp& reductionOp,
+                                const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, N>& regularStrides,
+                                const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+{
+    if (numThreads > 1)
+        TensorOpParallelIteration<ElemType, OPFN, ReductionOp, N, vectorizable, m, k>::Loop(numThreads, beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+    else
+        TensorOpIteration<ElemType, OPFN, ReductionOp, N, vectorizable, m, k>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+}
+
 // -----------------------------------------------------------------------
 // map runtime parameters N to template parameters
 // -----------------------------------------------------------------------
@@ -7102,12 +7293,13 @@ static void TensorOpWithRegularLoop(ElemType beta, const array<ElemType*, N>& po
                                     const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
 {
     size_t dims = reducingOpDims.size();
+    int numThreads = TensorOpNumThreads(regularOpDims, reducingOpDims);
     switch (dims)
     {
     case 2:
-        return TensorOpIteration<ElemType, OPFN, ReductionOp, N, false /*vectorizable*/, 1, k>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+        return TensorOpLoop<ElemType, OPFN, ReductionOp, N, false /*vectorizable*/, 1, k>(numThreads, beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
     case 1:
-        return TensorOpIteration<ElemType, OPFN, ReductionOp, N, false /*vectorizable*/, 0, k>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+        return TensorOpLoop<ElemType, OPFN, ReductionOp, N, false /*vectorizable*/, 0, k>(numThreads, beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
     case 0:
     {
         // if all leading dimensions are 1, we can let the compiler do some unrolling
@@ -7115,9 +7307,9 @@ static void TensorOpWithRegularLoop(ElemType beta, const array<ElemType*, N>& po
         for (size_t i = 0; i < N; i++)
             leadingAllOne &= k >= 0 && regularStrides[i][0] == 1;
         if (leadingAllOne) // special version that uses a hard-coded increment of 1 for all leading dimensions
-            return TensorOpIteration<ElemType, OPFN, ReductionOp, N, true /*vectorizable*/, -1, k>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+            return TensorOpLoop<ElemType, OPFN, ReductionOp, N, true /*vectorizable*/, -1, k>(numThreads, beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
         else
-            return TensorOpIteration<ElemType, OPFN, ReductionOp, N, false /*vectorizable*/, -1, k>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+            return TensorOpLoop<ElemType, OPFN, ReductionOp, N, false /*vectorizable*/, -1, k>(numThreads, beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
     }
     default:
         LogicError("TensorOp: %d non-flattened reduction dimensions are not supported.", (int) dims);
@@ -0,0 +1,255 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPUPoolingMemAllocator.cpp -- caching allocator for the storage of CPU matrices
+//
+
+#include "stdafx.h"
+#include "CPUPoolingMemAllocator.h"
+#include "Basics.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+namespace
+{
+    // Every block is preceded by one alignment unit holding its size class, so that
+    // Deallocate() can find the free list without being told the size.
+    struct BlockHeader
+    {
+        uint64_t magic;
+        size_t classBytes;
+    };
+    static_assert(sizeof(BlockHeader) <= CPUPoolingMemAllocator::Alignment, "BlockHeader must fit into one alignment unit");
+
+    const uint64_t BlockMagic = 0x6c6f6f50554d4e43ull; // "CNMUPool"
+    const size_t PageSize = 4096;
+
+    struct Pool
+    {
+        std::mutex mutex;
+        std::unordered_map<size_t, std::vector<void*>> freeLists; // size class -> cached raw blocks
+        size_t maxCachedBytes = (size_t)512 * 1024 * 1024;
+        bool firstTouch = false;
+        CPUMemAllocatorStatistics stats = {};
+    };
+
+    // Intentionally leaked: matrices with static storage duration may release their
+    // buffers after the destructors of other statics have run.
+    Pool& GetPool()
+    {
+        static Pool* pool = new Pool();
+        return *pool;
+    }
+
+    // Round up to a size class: multiples of the alignment up to 4 units, beyond that
+    // four classes per power of two (at most 25% slack).
+    size_t RoundToSizeClass(size_t size)
+    {
+        const size_t a = CPUPoolingMemAllocator::Alignment;
+        if (size <= 4 * a)
+            return std::max(a, (size + a - 1) / a * a);
+        size_t highBit = 1;
+        for (size_t v = (size - 1) >> 1; v != 0; v >>= 1)
+            highBit <<= 1;
+        size_t step = highBit / 4;
+        return (size + step - 1) / step * step;
+    }
+
+    void* SystemAlloc(size_t bytes)
+    {
+#ifdef _WIN32
+        void* p = _aligned_malloc(bytes, CPUPoolingMemAllocator::Alignment);
+#else
+        void* p = nullptr;
+        if (posix_memalign(&p, CPUPoolingMemAllocator::Alignment, bytes) != 0)
+            p = nullptr;
+#endif
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void SystemFree(void* p)
+    {
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+    }
+
+    // Write every page from the OpenMP worker threads so that the OS backs each page
+    // on the NUMA node of the thread that will process it.
+    void FirstTouch(char* p, size_t bytes)
+    {
+        const long numPages = (long)((bytes + PageSize - 1) / PageSize);
+#pragma omp parallel for schedule(static)
+        for (long i = 0; i < numPages; i++)
+        {
+            size_t begin = (size_t)i * PageSize;
+            memset(p + begin, 0, std::min(PageSize, bytes - begin));
+        }
+    }
+}
+
+void* CPUPoolingMemAllocator::Allocate(size_t size, bool zeroFill)
+{
+    if (size == 0)
+        return nullptr;
+
+    size_t classBytes = RoundToSizeClass(size);
+    Pool& pool = GetPool();
+    char* raw = nullptr;
+    bool firstTouch;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        auto iter = pool.freeLists.find(classBytes);
+        if (iter != pool.freeLists.end() && !iter->second.empty())
+        {
+            raw = (char*)iter->second.back();
+            iter->second.pop_back();
+            pool.stats.cachedBytes -= classBytes;
+            pool.stats.numCacheHits++;
+        }
+        pool.stats.numAllocations++;
+        pool.stats.liveBytes += classBytes;
+        pool.stats.peakBytes = std::max(pool.stats.peakBytes, pool.stats.liveBytes);
+        firstTouch = pool.firstTouch;
+    }
+
+    bool reused = raw != nullptr;
+    if (!reused)
+    {
+        try
+        {
+            raw = (char*)SystemAlloc(Alignment + classBytes);
+        }
+        catch (const std::bad_alloc&)
+        {
+            // give the cached blocks back and retry once before failing
+            ReleaseCachedMemory();
+            try
+            {
+                raw = (char*)SystemAlloc(Alignment + classBytes);
+            }
+            catch (const std::bad_alloc&)
+            {
+                std::lock_guard<std::mutex> lock(pool.mutex);
+                pool.stats.liveBytes -= classBytes;
+                throw;
+            }
+        }
+        auto header = (BlockHeader*)raw;
+        header->magic = BlockMagic;
+        header->classBytes = classBytes;
+    }
+
+    char* p = raw + Alignment;
+    if (!reused && firstTouch)
+        FirstTouch(p, size); // also zeroes the requested range
+    else if (zeroFill)
+        memset(p, 0, size);
+    return p;
+}
+
+void CPUPoolingMemAllocator::Deallocate(void* p)
+{
+    if (p == nullptr)
+        return;
+
+    char* raw = (char*)p - Alignment;
+    auto header = (const BlockHeader*)raw;
+    if (header->magic != BlockMagic)
+        LogicError("CPUPoolingMemAllocator::Deallocate: The pointer was not obtained from this allocator.");
+    size_t classBytes = header->classBytes;
+
+    Pool& pool = GetPool();
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.stats.liveBytes -= classBytes;
+        if (pool.stats.cachedBytes + classBytes <= pool.maxCachedBytes)
+        {
+            pool.freeLists[classBytes].push_back(raw);
+            pool.stats.cachedBytes += classBytes;
+            return;
+        }
+    }
+    SystemFree(raw);
+}
+
+void* CPUPoolingMemAllocator::Malloc(size_t size)
+{
+    return Allocate(size, /*zeroFill=*/false);
+}
+
+void CPUPoolingMemAllocator::Free(void* p)
+{
+    Deallocate(p);
+}
+
+void CPUPoolingMemAllocator::SetMaxCachedBytes(size_t maxCachedBytes)
+{
+    {
+        Pool& pool = GetPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.maxCachedBytes = maxCachedBytes;
+        if (pool.stats.cachedBytes <= maxCachedBytes)
+            return;
+    }
+    ReleaseCachedMemory();
+}
+
+size_t CPUPoolingMemAllocator::GetMaxCachedBytes()
+{
+    Pool& pool = GetPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.maxCachedBytes;
+}
+
+void CPUPoolingMemAllocator::SetFirstTouchPlacement(bool enable)
+{
+    Pool& pool = GetPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.firstTouch = enable;
+}
+
+bool CPUPoolingMemAllocator::GetFirstTouchPlacement()
+{
+    Pool& pool = GetPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.firstTouch;
+}
+
+void CPUPoolingMemAllocator::ReleaseCachedMemory()
+{
+    std::unordered_map<size_t, std::vector<void*>> freeLists;
+    {
+        Pool& pool = GetPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        freeLists.swap(pool.freeLists);
+        pool.stats.cachedBytes = 0;
+    }
+    for (auto& freeList : freeLists)
+        for (auto raw : freeList.second)
+            SystemFree(raw);
+}
+
+CPUMemAllocatorStatistics CPUPoolingMemAllocator::GetStatistics()
+{
+    Pool& pool = GetPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.stats;
+}
+} } }
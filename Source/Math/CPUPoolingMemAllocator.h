@@ -0,0 +1,71 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPUPoolingMemAllocator.h -- caching allocator for the storage of CPU matrices
+//
+
+#pragma once
+
+#include "MemAllocator.h"
+#include <cstddef>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+#ifdef _WIN32
+#ifdef MATH_EXPORTS
+#define MATH_API __declspec(dllexport)
+#else
+#define MATH_API __declspec(dllimport)
+#endif
+#else // no DLLs on Linux
+#define MATH_API
+#endif
+
+// byte counters reported by CPUPoolingMemAllocator::GetStatistics()
+struct CPUMemAllocatorStatistics
+{
+    size_t liveBytes;    // bytes currently handed out to callers
+    size_t peakBytes;    // high-water mark of liveBytes
+    size_t cachedBytes;  // bytes held in the free lists for reuse
+    size_t numAllocations;
+    size_t numCacheHits; // allocations served from the free lists
+};
+
+// Allocator used for the element buffers of CPUMatrix and CPUSparseMatrix.
+// Requests are rounded up to a size class (four classes per power of two) and
+// released blocks are kept on a per-class free list, so that the allocate/free
+// pattern of a training or evaluation loop reuses the same blocks instead of
+// going back to the heap for every minibatch. All blocks are aligned to
+// CPUPoolingMemAllocator::Alignment bytes. Memory is only zeroed when the caller
+// asks for it.
+// Blocks must be released through Deallocate() (or Free()), never with delete[].
+class MATH_API CPUPoolingMemAllocator : public MemAllocator
+{
+public:
+    static const size_t Alignment = 64;
+
+    void* Malloc(size_t size) override;
+    void Free(void* p) override;
+
+    static void* Allocate(size_t size, bool zeroFill);
+    static void Deallocate(void* p);
+
+    // Upper bound on the bytes kept in the free lists; blocks released beyond it
+    // go straight back to the system. 0 disables caching.
+    static void SetMaxCachedBytes(size_t maxCachedBytes);
+    static size_t GetMaxCachedBytes();
+
+    // When enabled, pages of newly obtained blocks are first touched by the OpenMP
+    // worker threads with a static schedule, so that on NUMA systems each page lands
+    // on the node of the thread that later processes it in the (statically scheduled)
+    // element-wise kernels. Blocks served from the free lists keep their placement.
+    static void SetFirstTouchPlacement(bool enable);
+    static bool GetFirstTouchPlacement();
+
+    // return all cached blocks to the system
+    static void ReleaseCachedMemory();
+
+    static CPUMemAllocatorStatistics GetStatistics();
+};
+} } }
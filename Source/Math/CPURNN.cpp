@@ -0,0 +1,237 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include "CPURNN.h"
+#include "TensorOps.h"
+#include <algorithm>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+template <class ElemType>
+CPURNNExecutor<ElemType>::CPURNNExecutor(size_t xDim, size_t yDim, const RnnAttributes& rnnAttributes)
+    : m_rnnAttributes(rnnAttributes), m_xDim(xDim), m_yDim(yDim)
+{
+    if      (m_rnnAttributes.m_recurrentOp == wstring(L"lstm"))    m_cellType = CellType::LSTM;
+    else if (m_rnnAttributes.m_recurrentOp == wstring(L"gru"))     m_cellType = CellType::GRU;
+    else if (m_rnnAttributes.m_recurrentOp == wstring(L"rnnReLU")) m_cellType = CellType::ReLU;
+    else if (m_rnnAttributes.m_recurrentOp == wstring(L"rnnTanh")) m_cellType = CellType::Tanh;
+    else InvalidArgument("Unknown cell type '%ls'. Supported values are 'lstm', 'gru', 'rnnReLU', 'rnnTanh'.", m_rnnAttributes.m_recurrentOp.c_str());
+
+    if (m_rnnAttributes.IsSpatialRecurrence() && m_rnnAttributes.m_axis != 2)
+        InvalidArgument("CPURNNExecutor: Unsupported recurrence axis %d.", m_rnnAttributes.m_axis);
+    if (m_rnnAttributes.m_numLayers == 0 || m_rnnAttributes.m_hiddenSize == 0)
+        InvalidArgument("CPURNNExecutor: The number of layers and the hidden size must be positive.");
+    if (m_yDim != (m_rnnAttributes.m_bidirectional ? 2 : 1) * m_rnnAttributes.m_hiddenSize)
+        InvalidArgument("CPURNNExecutor: Output leading dimension must be twice hidden size for bidirectional networks");
+}
+
+template <class ElemType>
+size_t CPURNNExecutor<ElemType>::NumGates() const
+{
+    switch (m_cellType)
+    {
+    case CellType::LSTM: return 4;
+    case CellType::GRU:  return 3;
+    default:             return 1;
+    }
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::ForwardCore(const CPUMatrix<ElemType>& weightsW, const CPUMatrix<ElemType>& inputX, CPUMatrix<ElemType>& outputY,
+                                           const std::vector<size_t>& numSequencesForFrame, CPUMatrix<ElemType>& workspace)
+{
+    const size_t hiddenSize = m_rnnAttributes.m_hiddenSize;
+    const size_t numLayers = m_rnnAttributes.m_numLayers;
+    const size_t numDirections = m_rnnAttributes.m_bidirectional ? 2 : 1;
+    const size_t numGates = NumGates();
+
+    // locate the time steps in the packed data
+    m_numSequencesForFrame = numSequencesForFrame;
+    m_frameOffsets.resize(numSequencesForFrame.size());
+    size_t numFrames = 0;
+    size_t maxNumSequences = 0;
+    for (size_t t = 0; t < numSequencesForFrame.size(); t++)
+    {
+        if (t > 0 && numSequencesForFrame[t] > numSequencesForFrame[t - 1])
+            InvalidArgument("CPURNNExecutor: Sequences must be sorted by decreasing length.");
+        m_frameOffsets[t] = numFrames;
+        numFrames += numSequencesForFrame[t];
+        maxNumSequences = std::max(maxNumSequences, numSequencesForFrame[t]);
+    }
+
+    if (inputX.GetNumRows() != m_xDim || inputX.GetNumCols() != numFrames)
+        InvalidArgument("CPURNNExecutor: Input is [%d x %d], expected [%d x %d].", (int)inputX.GetNumRows(), (int)inputX.GetNumCols(), (int)m_xDim, (int)numFrames);
+
+    let numParameters = m_rnnAttributes.GetNumParameters(m_xDim);
+    if (weightsW.GetNumElements() != numParameters.first * numParameters.second)
+        InvalidArgument("RNN needs %ld parameters, but %ld were allocated", numParameters.first * numParameters.second, weightsW.GetNumElements());
+
+    outputY.RequireSize(m_yDim, numFrames);
+    if (numFrames == 0)
+        return;
+
+    // All parameter blocks are multiples of hiddenSize, so they can be taken as column slices of [hiddenSize x *].
+    CPUMatrix<ElemType> parameters = weightsW.ColumnSlice(0, weightsW.GetNumCols());
+    parameters.Reshape(hiddenSize, weightsW.GetNumElements() / hiddenSize);
+
+    // The workspace is carved into column slices of [hiddenSize x *] as well:
+    //  - the gate pre-activations of all time steps,
+    //  - up to two buffers for the output of intermediate layers, which are the input of the next one,
+    //  - the result of the recurrent GEMM and the hidden and cell state of the current time step.
+    const size_t numLayerBuffers = std::min(numLayers - 1, (size_t)2);
+    const size_t gatesCols     = numGates * numFrames;
+    const size_t layerCols     = numDirections * numFrames;
+    const size_t recurrentCols = numGates * maxNumSequences;
+    const size_t stateCols     = maxNumSequences;
+    workspace.RequireSize(hiddenSize, gatesCols + numLayerBuffers * layerCols + recurrentCols + 2 * stateCols);
+
+    size_t col = 0;
+    auto carve = [&](size_t numRows, size_t numCols)
+    {
+        CPUMatrix<ElemType> slice = workspace.ColumnSlice(col, numRows * numCols / hiddenSize);
+        slice.Reshape(numRows, numCols);
+        col += numRows * numCols / hiddenSize;
+        return slice;
+    };
+    CPUMatrix<ElemType> gates = carve(numGates * hiddenSize, numFrames);
+    CPUMatrix<ElemType> layerOutputs[2];
+    for (size_t i = 0; i < numLayerBuffers; i++)
+        layerOutputs[i] = carve(numDirections * hiddenSize, numFrames);
+    CPUMatrix<ElemType> recurrent = carve(numGates * hiddenSize, maxNumSequences);
+    CPUMatrix<ElemType> h = carve(hiddenSize, maxNumSequences);
+    CPUMatrix<ElemType> c = carve(hiddenSize, maxNumSequences);
+
+    size_t weightOffset = 0;
+    size_t biasOffset = numParameters.first * numParameters.second - numLayers * numDirections * 2 * numGates * hiddenSize;
+    for (size_t layer = 0; layer < numLayers; layer++)
+    {
+        const CPUMatrix<ElemType>& input = (layer == 0) ? inputX : layerOutputs[(layer - 1) % 2];
+        CPUMatrix<ElemType>& output = (layer == numLayers - 1) ? outputY : layerOutputs[layer % 2];
+        const size_t inputDim = input.GetNumRows();
+
+        for (size_t direction = 0; direction < numDirections; direction++)
+        {
+            CPUMatrix<ElemType> W = parameters.ColumnSlice(weightOffset / hiddenSize, inputDim * numGates);
+            W.Reshape(inputDim, numGates * hiddenSize);
+            weightOffset += inputDim * numGates * hiddenSize;
+
+            CPUMatrix<ElemType> R = parameters.ColumnSlice(weightOffset / hiddenSize, hiddenSize * numGates);
+            R.Reshape(hiddenSize, numGates * hiddenSize);
+            weightOffset += hiddenSize * numGates * hiddenSize;
+
+            const ElemType* bW = parameters.Data() + biasOffset;
+            const ElemType* bR = bW + numGates * hiddenSize;
+            biasOffset += 2 * numGates * hiddenSize;
+
+            ForwardDirection(W, R, bW, bR, input, output, direction * hiddenSize, /*reverse=*/direction == 1, gates, recurrent, h, c);
+        }
+    }
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::ForwardDirection(const CPUMatrix<ElemType>& W, const CPUMatrix<ElemType>& R, const ElemType* bW, const ElemType* bR,
+                                                const CPUMatrix<ElemType>& input, CPUMatrix<ElemType>& outputY, size_t outputRow, bool reverse,
+                                                CPUMatrix<ElemType>& gates, CPUMatrix<ElemType>& recurrent, CPUMatrix<ElemType>& h, CPUMatrix<ElemType>& c)
+{
+    const size_t hiddenSize = m_rnnAttributes.m_hiddenSize;
+    const size_t numGates = NumGates();
+    const size_t numSteps = m_numSequencesForFrame.size();
+
+    // input projection of all time steps at once
+    CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, W, true, input, false, 0, gates);
+
+    // Both biases are added to the pre-activations, except for the recurrent bias of the GRU candidate,
+    // which cuDNN applies before the multiplication with the reset gate.
+    std::vector<ElemType> bias(numGates * hiddenSize);
+    for (size_t k = 0; k < bias.size(); k++)
+        bias[k] = bW[k] + ((m_cellType == CellType::GRU && k >= 2 * hiddenSize) ? 0 : bR[k]);
+    const ElemType* candidateBias = (m_cellType == CellType::GRU) ? bR + 2 * hiddenSize : nullptr;
+
+    // All sequences start with a zero state. Going backwards, sequences join as their last frame is reached;
+    // their state columns have not been touched before, so they are still zero.
+    h.SetValue(0);
+    c.SetValue(0);
+
+    const size_t ldy = outputY.GetNumRows();
+    for (size_t step = 0; step < numSteps; step++)
+    {
+        const size_t t = reverse ? numSteps - 1 - step : step;
+        const size_t numSequences = m_numSequencesForFrame[t];
+        if (numSequences == 0)
+            continue;
+
+        // recurrent projection, not needed for the first step where the state is zero
+        const ElemType* recurrentData = nullptr;
+        if (step > 0)
+        {
+            CPUMatrix<ElemType> recurrentSlice = recurrent.ColumnSlice(0, numSequences);
+            CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, R, true, h.ColumnSlice(0, numSequences), false, 0, recurrentSlice);
+            recurrentData = recurrentSlice.Data();
+        }
+
+        UpdateStep(gates.Data() + m_frameOffsets[t] * numGates * hiddenSize, recurrentData, bias.data(), candidateBias, numSequences,
+                   h.Data(), c.Data(), outputY.Data() + m_frameOffsets[t] * ldy + outputRow, ldy);
+    }
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::UpdateStep(const ElemType* gates, const ElemType* recurrent, const ElemType* bias, const ElemType* candidateBias,
+                                          size_t numSequences, ElemType* h, ElemType* c, ElemType* y, size_t ldy) const
+{
+    const size_t hiddenSize = m_rnnAttributes.m_hiddenSize;
+    const size_t numGates = NumGates();
+    const size_t H = hiddenSize;
+
+#pragma omp parallel for if (numSequences * numGates * hiddenSize > 16384)
+    for (int j = 0; j < (int)numSequences; j++)
+    {
+        const ElemType* z = gates + j * numGates * H;
+        const ElemType* u = recurrent ? recurrent + j * numGates * H : nullptr;
+        ElemType* hj = h + j * H;
+        ElemType* cj = c + j * H;
+        ElemType* yj = y + j * ldy;
+
+        switch (m_cellType)
+        {
+        case CellType::LSTM:
+            for (size_t k = 0; k < H; k++)
+            {
+                ElemType i = StableSigmoid(z[k]         + bias[k]         + (u ? u[k]         : 0));
+                ElemType f = StableSigmoid(z[H + k]     + bias[H + k]     + (u ? u[H + k]     : 0));
+                ElemType g = tanh_(        z[2 * H + k] + bias[2 * H + k] + (u ? u[2 * H + k] : 0));
+                ElemType o = StableSigmoid(z[3 * H + k] + bias[3 * H + k] + (u ? u[3 * H + k] : 0));
+                cj[k] = f * cj[k] + i * g;
+                yj[k] = hj[k] = o * tanh_(cj[k]);
+            }
+            break;
+        case CellType::GRU:
+            for (size_t k = 0; k < H; k++)
+            {
+                ElemType r = StableSigmoid(z[k]     + bias[k]     + (u ? u[k]     : 0));
+                ElemType g = StableSigmoid(z[H + k] + bias[H + k] + (u ? u[H + k] : 0));
+                ElemType n = tanh_(z[2 * H + k] + bias[2 * H + k] + r * ((u ? u[2 * H + k] : 0) + candidateBias[k]));
+                yj[k] = hj[k] = (1 - g) * n + g * hj[k];
+            }
+            break;
+        case CellType::ReLU:
+            for (size_t k = 0; k < H; k++)
+            {
+                ElemType a = z[k] + bias[k] + (u ? u[k] : 0);
+                yj[k] = hj[k] = a > 0 ? a : 0;
+            }
+            break;
+        case CellType::Tanh:
+            for (size_t k = 0; k < H; k++)
+                yj[k] = hj[k] = tanh_(z[k] + bias[k] + (u ? u[k] : 0));
+            break;
+        }
+    }
+}
+
+template class CPURNNExecutor<float>;
+template class CPURNNExecutor<double>;
+
+}}}
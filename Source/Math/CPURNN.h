@@ -0,0 +1,76 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPURNN.h -- CPU implementation of the OptimizedRNNStack forward pass, using the cuDNN parameter layout
+//
+
+#pragma once
+
+#include "CPUMatrix.h"
+#include "RNNCommon.h"
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// CPURNNExecutor computes the output of a stack of RNN/LSTM/GRU layers on the CPU. It takes the
+// parameters in the same monolithic block as CuDnnRNNExecutor, so that models trained on the GPU
+// run unchanged on the CPU.
+//
+// The parameter block is laid out the way cuDNN does it (with CUDNN_LINEAR_INPUT):
+//  - first the weights of all layers, for each layer and direction (forward first) the input weights W
+//    followed by the recurrent weights R, each stored as [inputDim x numGates * hiddenSize] column-major,
+//    i.e. one column per gate unit,
+//  - then the biases of all layers, for each layer and direction two vectors bW and bR of numGates * hiddenSize.
+// The gates are ordered (i, f, c, o) for LSTM and (r, u, c) for GRU.
+//
+// Data is expected in the packed format of cuDNN: the frames of all sequences are sorted by time step,
+// and within a time step by decreasing sequence length, so that the numSequencesForFrame[t] sequences
+// active at time step t are always the first ones.
+//
+// For each layer and direction, the input projection of all time steps is computed by a single GEMM.
+// The time steps then only need a GEMM with the recurrent weights, followed by one pass that applies
+// the bias, the gate nonlinearities and the state update for all units at once.
+template <class ElemType>
+class CPURNNExecutor
+{
+public:
+    CPURNNExecutor(size_t xDim, size_t yDim, const RnnAttributes& rnnAttributes);
+
+    // outputY[yDim x numFrames] = RNN stack applied to inputX[xDim x numFrames].
+    // The workspace is resized as needed and can be reused across calls.
+    void ForwardCore(const CPUMatrix<ElemType>& weightsW, const CPUMatrix<ElemType>& inputX, CPUMatrix<ElemType>& outputY,
+                     const std::vector<size_t>& numSequencesForFrame, CPUMatrix<ElemType>& workspace);
+
+private:
+    enum class CellType
+    {
+        LSTM,
+        GRU,
+        ReLU,
+        Tanh
+    };
+
+    // Computes one direction of one layer. The output is written to rows [outputRow, outputRow + hiddenSize) of outputY.
+    void ForwardDirection(const CPUMatrix<ElemType>& W, const CPUMatrix<ElemType>& R, const ElemType* bW, const ElemType* bR,
+                          const CPUMatrix<ElemType>& input, CPUMatrix<ElemType>& outputY, size_t outputRow, bool reverse,
+                          CPUMatrix<ElemType>& gates, CPUMatrix<ElemType>& recurrent, CPUMatrix<ElemType>& h, CPUMatrix<ElemType>& c);
+
+    // Applies the biases, the gate nonlinearities and the state update to the first numSequences columns
+    // of the current time step. recurrent is null if the state is zero. h and c are updated in place,
+    // h is also written to y.
+    void UpdateStep(const ElemType* gates, const ElemType* recurrent, const ElemType* bias, const ElemType* candidateBias,
+                    size_t numSequences, ElemType* h, ElemType* c, ElemType* y, size_t ldy) const;
+
+    size_t NumGates() const;
+
+    RnnAttributes m_rnnAttributes;
+    CellType m_cellType;
+    size_t m_xDim, m_yDim;
+
+    // offset of the first column of each time step in the packed data
+    std::vector<size_t> m_frameOffsets;
+    std::vector<size_t> m_numSequencesForFrame;
+};
+
+}}}
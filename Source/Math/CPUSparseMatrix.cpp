@@ -747,8 +747,8 @@ void CPUSparseMatrix<ElemType>::Allocate(const size_t numRows, const size_t numC
     {
         if (GetFormat() == MatrixFormat::matrixFormatSparseCSC || GetFormat() == MatrixFormat::matrixFormatSparseCSR)
         {
-            // The initialization of the following buffer is done by new []().
-            auto* pArray      = new ElemType[numNZElemToReserve]();
+            // The initialization of the following buffers is done by new []() and the zero-filling allocation.
+            auto* pArray      = (ElemType*) CPUPoolingMemAllocator::Allocate(numNZElemToReserve * sizeof(ElemType), /*zeroFill=*/true);
             auto* unCompIndex = new CPUSPARSE_INDEX_TYPE[numNZElemToReserve]();
             auto* compIndex   = new CPUSPARSE_INDEX_TYPE[newCompIndexSize]();
 
@@ -764,7 +764,7 @@ void CPUSparseMatrix<ElemType>::Allocate(const size_t numRows, const size_t numC
             }
 
             // TODO: This is super ugly. The internals of the storage object should be a shared_ptr.
-            delete[] Buffer();
+            CPUPoolingMemAllocator::Deallocate(Buffer());
             delete[] GetUnCompIndex();
             delete[] GetCompIndex();
 
@@ -774,7 +774,7 @@ void CPUSparseMatrix<ElemType>::Allocate(const size_t numRows, const size_t numC
         }
         else if (GetFormat() == MatrixFormat::matrixFormatSparseBlockCol || GetFormat() == MatrixFormat::matrixFormatSparseBlockRow)
         {
-            ElemType* blockVal = new ElemType[numNZElemToReserve];
+            ElemType* blockVal = (ElemType*) CPUPoolingMemAllocator::Allocate(numNZElemToReserve * sizeof(ElemType), /*zeroFill=*/false);
             size_t* blockIds = new size_t[newCompIndexSize];
 
             if (keepExistingValues && (NzCount() > numNZElemToReserve || GetCompIndexSize() > newCompIndexSize))
@@ -787,7 +787,7 @@ void CPUSparseMatrix<ElemType>::Allocate(const size_t numRows, const size_t numC
                 memcpy(blockIds, GetBlockIds(), sizeof(size_t) * GetCompIndexSize());
             }
 
-            delete[] Buffer();
+            CPUPoolingMemAllocator::Deallocate(Buffer());
             delete[] GetBlockIds();
 
             SetBuffer(blockVal, numNZElemToReserve, false);
@@ -870,6 +870,16 @@ void CPUSparseMatrix<ElemType>::Reset()
     SetBlockIdShift(0);
 }
 
+// Splits [0, size) into one contiguous range per thread of the current parallel region. The ranges are multiples
+// of 16 elements so that threads writing to contiguous ranges do not share cache lines.
+static void GetThreadRange(size_t size, size_t& begin, size_t& end)
+{
+    size_t numThreads = omp_get_num_threads();
+    size_t chunk = ((size + numThreads - 1) / numThreads + 15) & ~(size_t)15;
+    begin = std::min(size, omp_get_thread_num() * chunk);
+    end = std::min(size, begin + chunk);
+}
+
 // Implements product of one sparse and one dense matrix updating a third dense matrix. Input matrices are optionally transposed.
 // NOTE: The only for using a class template instead of a function template was that I couldn't make the function template compile.
 template <class ElemType, bool denseTimesSparse /* false means SparseTimesDense */, bool transposeA, bool transposeB>
@@ -929,20 +939,28 @@ public:
         // * Initialized the output matrix c
 
         // Now do the actual multiplication.
-        ElemType* valueBuffer = sparse.Buffer() + *sparse.SecondaryIndexLocation(); // Points to the value buffer of the current view (i.e. buffer containing values of non-zero elements).
-        int* rowIndexBuffer = sparse.MajorIndexLocation();                          // Points to the index buffer of the current view (i.e. buffer containing indices of non-zero elements).
-        size_t iNonzero = 0;                                                           // Number of nonzero elements handled so far for current slice view.
-        int numPreviosNonzero = sparse.SecondaryIndexLocation()[0];                 // Total number of nonzero values handled in previous slices.
-
-        // Loop over columns of the sparse matrix
-        for (size_t colSparse = 0; colSparse < sparse.GetNumCols(); colSparse++)
+        const ElemType* valueBuffer = sparse.Buffer() + *sparse.SecondaryIndexLocation(); // Points to the value buffer of the current view (i.e. buffer containing values of non-zero elements).
+        const int* rowIndexBuffer = sparse.MajorIndexLocation();                          // Points to the index buffer of the current view (i.e. buffer containing indices of non-zero elements).
+        const int* colStart = sparse.SecondaryIndexLocation();                            // Start of each column, including the nonzeros of previous slices.
+        const int numPreviousNonzero = colStart[0];                                       // Total number of nonzero values handled in previous slices.
+
+        // Strides of the outer index of the dense matrix in the dense matrix and in c, and of the other indices.
+        // Below expressions are evaluated at compile time, except for the leading dimensions.
+        const ElemType* denseData = dense.Data();
+        ElemType* cData = c.Data();
+        const bool denseOuterIsRow = denseTimesSparse ? !transposeA : transposeB;
+        const size_t denseOuterStride = denseOuterIsRow ? 1 : dense.GetNumRows();
+        const size_t denseInnerStride = denseOuterIsRow ? dense.GetNumRows() : 1;
+        const size_t cDenseStride = denseTimesSparse ? 1 : c.GetNumRows();
+        const size_t cSparseStride = denseTimesSparse ? c.GetNumRows() : 1;
+
+        // Adds the products of the nonzeros of one column of the sparse matrix with the range [begin, end) of the outer index of the dense matrix.
+        auto multiplyColumn = [&](size_t colSparse, size_t begin, size_t end)
         {
-            size_t numNonzeroInSparseCol = sparse.SecondaryIndexLocation()[colSparse + 1] - numPreviosNonzero;
-            // Loop over the nonzero rows of the current column of the sparse matrix
-            for (; iNonzero < numNonzeroInSparseCol; iNonzero++)
+            for (int iNonzero = colStart[colSparse] - numPreviousNonzero; iNonzero < colStart[colSparse + 1] - numPreviousNonzero; iNonzero++)
             {
                 size_t rowSparse = rowIndexBuffer[iNonzero]; // RowLocation
-                ElemType sparseVal = valueBuffer[iNonzero];
+                ElemType sparseVal = alpha * valueBuffer[iNonzero];
 
                 // Determine the index of the 'outer' dimension of the sparse matrix and the common inner index.
                 size_t outerIndexSparse;
@@ -953,24 +971,42 @@ public:
                 else if (!denseTimesSparse && !transposeA) { outerIndexSparse = rowSparse; innerIndex = colSparse; }
                 else if (!denseTimesSparse &&  transposeA) { outerIndexSparse = colSparse; innerIndex = rowSparse; }
 
-                // Loop over the outer index of the dense matrix
-                for (size_t outerIndexDense = 0; outerIndexDense < outerDimensionDense; outerIndexDense++)
+                const ElemType* denseVals = denseData + innerIndex * denseInnerStride;
+                ElemType* results = cData + outerIndexSparse * cSparseStride;
+                if (denseOuterStride == 1 && cDenseStride == 1)
                 {
-                    // Determine the row index of the dense input matrix.
-                    // Below if-statements are evaluated at compile time.
-                    ElemType denseVal;
-                    if      ( denseTimesSparse && !transposeA) denseVal = dense(outerIndexDense,      innerIndex);
-                    else if ( denseTimesSparse &&  transposeA) denseVal = dense(     innerIndex, outerIndexDense);
-                    else if (!denseTimesSparse && !transposeB) denseVal = dense(     innerIndex, outerIndexDense);
-                    else if (!denseTimesSparse &&  transposeB) denseVal = dense(outerIndexDense,      innerIndex);
-                    
-
-                    // Update matrix c.
-                    if (denseTimesSparse)
-                        c(outerIndexDense, outerIndexSparse) += alpha * denseVal * sparseVal;
-                    else /*Sparse times dense */
-                        c(outerIndexSparse, outerIndexDense) += alpha * denseVal * sparseVal;
+                    // Contiguous in both matrices, vectorized by the compiler.
+                    for (size_t outerIndexDense = begin; outerIndexDense < end; outerIndexDense++)
+                        results[outerIndexDense] += sparseVal * denseVals[outerIndexDense];
                 }
+                else
+                {
+                    for (size_t outerIndexDense = begin; outerIndexDense < end; outerIndexDense++)
+                        results[outerIndexDense * cDenseStride] += sparseVal * denseVals[outerIndexDense * denseOuterStride];
+                }
+            }
+        };
+
+        // If the outer index of the sparse matrix is its column, every column of the sparse matrix updates its own part of c, and the
+        // columns are distributed over the threads. Otherwise different columns update the same elements of c, so the outer dimension
+        // of the dense matrix is partitioned over the threads once and every thread visits all nonzeros. The latter is also used if
+        // there are too few columns to keep the threads busy (e.g. a single one-hot sample).
+        const size_t numSparseCols = sparse.GetNumCols();
+        const bool columnsUpdateDisjointParts = (denseTimesSparse && !transposeB) || (!denseTimesSparse && transposeA);
+        if (columnsUpdateDisjointParts && numSparseCols >= 4 * (size_t)omp_get_max_threads())
+        {
+#pragma omp parallel for
+            for (long colSparse = 0; colSparse < (long)numSparseCols; colSparse++)
+                multiplyColumn(colSparse, 0, outerDimensionDense);
+        }
+        else
+        {
+#pragma omp parallel
+            {
+                size_t begin, end;
+                GetThreadRange(outerDimensionDense, begin, end);
+                for (size_t colSparse = 0; colSparse < numSparseCols && begin < end; colSparse++)
+                    multiplyColumn(colSparse, begin, end);
             }
         }
     }
@@ -1079,21 +1115,34 @@ void CPUSparseMatrix<ElemType>::MultiplyAndAdd(ElemType alpha, const CPUMatrix<E
             memset(c.Data() + m * blockSizePrev, 0, sizeof(ElemType) * m * (blockSizeCurr - blockSizePrev));
         }
 
-        for (size_t rhsCol = 0; rhsCol < rhs.GetNumCols(); rhsCol++)
+        // Look up the block of every nonzero once, before going parallel.
+        size_t firstNonzero = rhs.SecondaryIndexLocation()[0];
+        size_t numNonzero = rhs.SecondaryIndexLocation()[rhs.GetNumCols()] - firstNonzero;
+        std::vector<size_t> nonzeroBlockIds(numNonzero);
+        for (size_t p = 0; p < numNonzero; p++)
+            nonzeroBlockIds[p] = col2BlockId[rhs.MajorIndexLocation()[firstNonzero + p]];
+
+        // Nonzeros in different columns of rhs may update the same block, so instead the rows of the result
+        // are partitioned over the threads and every thread visits all nonzeros.
+        const ElemType* lhsData = lhs.Data();
+        const size_t lhsRows = lhs.GetNumRows();
+        ElemType* resultData = c.Buffer();
+#pragma omp parallel
         {
-            size_t start = rhs.SecondaryIndexLocation()[rhsCol];
-            size_t end = rhs.SecondaryIndexLocation()[rhsCol + 1];
-
-            for (size_t p = start; p < end; p++)
+            size_t rowBegin, rowEnd;
+            GetThreadRange(m, rowBegin, rowEnd);
+            for (size_t rhsCol = 0; rhsCol < rhs.GetNumCols() && rowBegin < rowEnd; rhsCol++)
             {
-                size_t rhsRow = rhs.MajorIndexLocation()[p];
-                ElemType val = rhs.Buffer()[p];
+                size_t start = rhs.SecondaryIndexLocation()[rhsCol];
+                size_t end = rhs.SecondaryIndexLocation()[rhsCol + 1];
+                const ElemType* lhsCol = lhsData + rhsCol * lhsRows;
 
-                ElemType* results = c.Buffer() + col2BlockId[rhsRow] * m;
-                #pragma omp parallel for
-                for (int lhsRow = 0; lhsRow < (int)m; lhsRow++)
+                for (size_t p = start; p < end; p++)
                 {
-                    results[lhsRow] += alpha * lhs((size_t)lhsRow, rhsCol) * val;
+                    ElemType val = alpha * rhs.Buffer()[p];
+                    ElemType* results = resultData + nonzeroBlockIds[p - firstNonzero] * m;
+                    for (size_t lhsRow = rowBegin; lhsRow < rowEnd; lhsRow++)
+                        results[lhsRow] += val * lhsCol[lhsRow];
                 }
             }
         }
@@ -1133,16 +1182,21 @@ void CPUSparseMatrix<ElemType>::ColumnwiseScaleAndWeightedAdd(ElemType alpha, co
     {
         auto start = a.SecondaryIndexLocation()[col];
         auto end = a.SecondaryIndexLocation()[col + 1];
+        ElemType scale = alpha * vd[col];
+        ElemType* cCol = c.Data() + col * c.GetNumRows();
 
-        for (auto p = start; p < end; p++)
+        if (beta == 0) // don't even read the memory if beta is 0
         {
-            auto row = a.MajorIndexLocation()[p];
-            ElemType val = a.Buffer()[p];
-
-            if (beta == 0) // don't even read the memory if beta is 0
-                c(row, col) = alpha * vd[col] * val;
-            else
-                c(row, col) = alpha * vd[col] * val + beta * c(row, col);
+            for (auto p = start; p < end; p++)
+                cCol[a.MajorIndexLocation()[p]] = scale * a.Buffer()[p];
+        }
+        else
+        {
+            for (auto p = start; p < end; p++)
+            {
+                auto row = a.MajorIndexLocation()[p];
+                cCol[row] = scale * a.Buffer()[p] + beta * cCol[row];
+            }
         }
     }
 }
@@ -1290,22 +1344,24 @@ void CPUSparseMatrix<ElemType>::InnerProduct(const CPUSparseMatrix<ElemType>& a,
     {
         c.RequireSize(m, 1);
 
-#pragma omp parallel for
-        foreach_row(i, c)
+        // The nonzeros of a row are spread over all columns, so the rows are partitioned over the threads
+        // and every thread visits all nonzeros once, keeping the sums of its own rows.
+        ElemType* sums = c.Data();
+#pragma omp parallel
         {
-            ElemType sum = 0;
-            for(CPUSPARSE_INDEX_TYPE j = 0; j < n; ++j)
+            size_t rowBegin, rowEnd;
+            GetThreadRange(m, rowBegin, rowEnd);
+            for (size_t i = rowBegin; i < rowEnd; i++)
+                sums[i] = 0;
+            for (CPUSPARSE_INDEX_TYPE j = 0; j < n && rowBegin < rowEnd; ++j)
             {
                 for (CPUSPARSE_INDEX_TYPE iRow = a.ColLocation()[j]; iRow < a.ColLocation()[j + 1]; ++iRow)
                 {
-                    if (a.RowLocation()[iRow] == i)
-                    {
-                        sum += a.Data()[iRow] * b(i, j);
-                        break;
-                    }
+                    size_t i = a.RowLocation()[iRow];
+                    if (i >= rowBegin && i < rowEnd)
+                        sums[i] += a.Data()[iRow] * b(i, j);
                 }
             }
-            c(i, 0) = sum;
         }
     }
 }
@@ -1331,18 +1387,33 @@ void CPUSparseMatrix<ElemType>::NormalGrad(CPUMatrix<ElemType>& c, const ElemTyp
     if (GetFormat() == MatrixFormat::matrixFormatSparseBlockCol || GetFormat() == MatrixFormat::matrixFormatSparseBlockRow)
     {
         const auto isSparseBlockCol = (GetFormat() == MatrixFormat::matrixFormatSparseBlockCol);
-        for (size_t j = 0; j < GetBlockSize(); j++)
+        size_t len = (isSparseBlockCol) ? GetNumRows() : GetNumCols();
+        // Every block updates its own column (row) of c. Along a block column c is contiguous, along a block row
+        // its elements are GetNumRows() apart.
+        size_t stride = (isSparseBlockCol) ? 1 : c.GetNumRows();
+        ElemType* smoothed = c.Data();
+#pragma omp parallel for
+        for (long j = 0; j < (long)GetBlockSize(); j++)
         {
             size_t i = GetBlockIds()[j] - GetBlockIdShift();
-            size_t len = (isSparseBlockCol) ? GetNumRows() : GetNumCols();
-            size_t start = j * len;
-            for (size_t p = start; p < start + len; p++)
+            ElemType* values = Buffer() + j * len;
+            ElemType* smoothedBlock = smoothed + ((isSparseBlockCol) ? i * c.GetNumRows() : i);
+            if (stride == 1)
             {
-                ElemType val = Buffer()[p];
-                size_t row = (isSparseBlockCol) ? (p - start) : i;
-                size_t col = (isSparseBlockCol) ? i : (p - start);
-                c(row, col) = unitGainFactor * val + momentum * c(row, col);
-                Buffer()[p] = c(row, col);
+                for (size_t p = 0; p < len; p++)
+                {
+                    smoothedBlock[p] = unitGainFactor * values[p] + momentum * smoothedBlock[p];
+                    values[p] = smoothedBlock[p];
+                }
+            }
+            else
+            {
+                for (size_t p = 0; p < len; p++)
+                {
+                    ElemType& s = smoothedBlock[p * stride];
+                    s = unitGainFactor * values[p] + momentum * s;
+                    values[p] = s;
+                }
             }
         }
     }
@@ -1444,23 +1515,24 @@ void CPUSparseMatrix<ElemType>::AdaDelta(CPUMatrix<ElemType>& c, CPUMatrix<ElemT
     ElemType* smoothX2 = c.Data() + n;
     ElemType* val = functionValues.Data();
 
+    // Every block updates its own column of the dense matrices; within a block all accesses are contiguous,
+    // so the inner loop is vectorized by the compiler.
+    size_t len = GetNumRows();
 #pragma omp parallel for
-    // TODO: Unroll 4-times for better performance leveraging vectorization
-    for (int j = 0; j < (int)GetBlockSize(); j++)
+    for (long j = 0; j < (long)GetBlockSize(); j++)
     {
         size_t i = GetBlockIds()[j] - GetBlockIdShift();
-        size_t len = GetNumRows();
-        size_t start = j * len;
-        for (size_t p = start; p < start + len; p++)
+        const ElemType* g = grad + j * len;
+        ElemType* ada = smoothAda + i * len;
+        ElemType* x2 = smoothX2 + i * len;
+        ElemType* v = val + i * len;
+        for (size_t p = 0; p < len; p++)
         {
-            size_t denseIndex = i * len + (p - start);
-            ElemType g = grad[p];
-            ElemType adaSqr = rho * smoothAda[denseIndex] + (1 - rho) * g * g;
-            smoothAda[denseIndex] = adaSqr;
-            ElemType x2 = smoothX2[denseIndex];
-            ElemType deltaX = -sqrt(x2 + epsilon) / sqrt(adaSqr + epsilon) * g;
-            smoothX2[denseIndex] = rho * smoothX2[denseIndex] + (1 - rho) * deltaX * deltaX;
-            val[denseIndex] += learningRate * deltaX;
+            ElemType adaSqr = rho * ada[p] + (1 - rho) * g[p] * g[p];
+            ada[p] = adaSqr;
+            ElemType deltaX = -sqrt(x2[p] + epsilon) / sqrt(adaSqr + epsilon) * g[p];
+            x2[p] = rho * x2[p] + (1 - rho) * deltaX * deltaX;
+            v[p] += learningRate * deltaX;
         }
     }
 }
@@ -15,6 +15,7 @@
 
 #include "Basics.h"
 #include "basetypes.h"
+#include "CPUPoolingMemAllocator.h"
 #include <string>
 #include <stdint.h>
 #include <memory>
@@ -106,6 +107,8 @@ enum ElementWiseOperator
     opElementwiseProductWithAbsDerivative, opElementwiseProductWithSqrtDerivative,
     opElementwiseProductWithReciprocalDerivative, opSqrOfDifference,
     opElementwiseProductWithExponentialLinearUnitDerivativeFromOutput,
+    // binary ops that apply an activation to a sum (used for fusing Plus and the activation node that follows it)
+    opSigmoidOfSum, opTanhOfSum, opLinearRectifierOfSum,
     // binary ops for indexing
     // opIndex,
     // ternary
@@ -182,7 +185,10 @@ enum ElementWiseOperator
     Macro(ElementwiseProductWithReciprocalDerivative);                       \
     Macro(ElementwiseProductWithSqrtDerivative);                             \
     Macro(SqrOfDifference);                                                  \
-    Macro(ElementwiseProductWithExponentialLinearUnitDerivativeFromOutput);
+    Macro(ElementwiseProductWithExponentialLinearUnitDerivativeFromOutput);  \
+    Macro(SigmoidOfSum);                                                     \
+    Macro(TanhOfSum);                                                        \
+    Macro(LinearRectifierOfSum);
     //Macro(Index);
 
 #define ForAllTernaryOps(Macro)                         \
@@ -273,7 +279,7 @@ public:
         {
             if (m_computeDevice < 0)
             {
-                delete[] m_pArray;
+                CPUPoolingMemAllocator::Deallocate(m_pArray);
                 m_pArray = nullptr;
                 m_nzValues = nullptr;
 
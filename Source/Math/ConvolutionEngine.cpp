@@ -6,6 +6,8 @@
 #include "stdafx.h"
 #include "ConvolutionEngine.h"
 #include "CuDnnFactories.h"
+#include "CPUConvolution.h"
+#include <chrono>
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -854,6 +856,214 @@ public:
     }
 };
 
+//------------------------------------------------------------------
+// Direct convolution engine.
+//------------------------------------------------------------------
+
+// Computes 2D convolutions on the CPU with the channel-blocked direct and Winograd kernels of CPUBlockedConvolution.
+// Which implementation is the fastest depends on the layer: Winograd usually wins for 3x3 kernels with many channels,
+// the direct kernels for few channels or strided kernels, and GEMM often for 1x1 kernels with many channels.
+// So the first time each of forward, backward data and backward kernel is called, all implementations that
+// apply (including the GEMM one of the base class) are timed on the actual minibatch and the fastest one is used
+// from then on. Timing makes the choice, and hence the results, vary from run to run; with deterministic algorithms
+// forced, Winograd is used where it applies and the direct kernels elsewhere. Pooling is handled by the base classes.
+template <class ElemType>
+class DirectConvolutionEngine : public GemmConvolutionEngine<ElemType>
+{
+public:
+    using Base = GemmConvolutionEngine<ElemType>;
+    using typename Base::Mat;
+
+public:
+    DirectConvolutionEngine(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId, ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind, bool poolIncludePad,
+                            const std::wstring& logPrefix, bool forceDeterministicAlgorithms)
+        : Base(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad),
+        m_logPrefix(logPrefix), m_forceDeterministicAlgorithms(forceDeterministicAlgorithms),
+        m_forwardAlgo(Algo::None), m_backwardDataAlgo(Algo::None), m_backwardKernelAlgo(Algo::None)
+    {
+    }
+
+protected:
+    using Base::m_geometry;
+    using Base::m_maxTempMemSizeInSamples;
+
+    enum class Algo
+    {
+        None,
+        Gemm,
+        Direct,
+        Winograd
+    };
+
+    void EnsureCompatible() override
+    {
+        Base::EnsureCompatible();
+        if (!CPUBlockedConvolution<ElemType>::IsSupported(*m_geometry))
+            LogicError("Direct convolution engine supports only 2D convolutions with full sharing. Geometry: %s", ((string)*m_geometry).c_str());
+    }
+
+    void EnsureConvolutionInitialized() override
+    {
+        Base::EnsureConvolutionInitialized();
+        if (m_kernels == nullptr)
+            m_kernels = std::make_unique<CPUBlockedConvolution<ElemType>>(*m_geometry);
+    }
+
+    void ForwardCore(const Mat& in, const Mat& kernel, Mat& out, Mat& workspace) override
+    {
+        auto run = [&](Algo algo)
+        {
+            if (algo == Algo::Gemm)
+                return Base::ForwardCore(in, kernel, out, workspace);
+            ForEachSubBatch(in.GetNumCols(), [&](size_t start, size_t count)
+            {
+                const ElemType* inData = in.Data() + start * in.GetNumRows();
+                ElemType* outData = out.Data() + start * out.GetNumRows();
+                if (algo == Algo::Winograd)
+                    m_kernels->ForwardWinograd(inData, kernel.Data(), outData, count);
+                else
+                    m_kernels->ForwardDirect(inData, kernel.Data(), outData, count);
+            });
+        };
+        if (m_forwardAlgo == Algo::None)
+            m_forwardAlgo = Autotune("forward", m_kernels->SupportsWinograd(), nullptr, run);
+        else
+            run(m_forwardAlgo);
+    }
+
+    // Like the GEMM engine, always accumulates into grad.
+    void BackwardDataCore(const Mat& srcGrad, const Mat& kernel, Mat& grad, bool accumulateGradient, Mat& workspace) override
+    {
+        auto run = [&](Algo algo)
+        {
+            if (algo == Algo::Gemm)
+                return Base::BackwardDataCore(srcGrad, kernel, grad, accumulateGradient, workspace);
+            ForEachSubBatch(srcGrad.GetNumCols(), [&](size_t start, size_t count)
+            {
+                const ElemType* srcGradData = srcGrad.Data() + start * srcGrad.GetNumRows();
+                ElemType* gradData = grad.Data() + start * grad.GetNumRows();
+                if (algo == Algo::Winograd)
+                    m_kernels->BackwardDataWinograd(srcGradData, kernel.Data(), gradData, count);
+                else
+                    m_kernels->BackwardDataDirect(srcGradData, kernel.Data(), gradData, count);
+            });
+        };
+        if (m_backwardDataAlgo == Algo::None)
+            m_backwardDataAlgo = Autotune("backward data", m_kernels->SupportsWinograd(), &grad, run);
+        else
+            run(m_backwardDataAlgo);
+    }
+
+    // Like the GEMM engine, always accumulates into kernelGrad. There is no Winograd variant of this one.
+    void BackwardKernelCore(const Mat& srcGrad, const Mat& in, Mat& kernelGrad, bool accumulateGradient, bool allowReuse, Mat& workspace) override
+    {
+        auto run = [&](Algo algo)
+        {
+            if (algo == Algo::Gemm)
+                return Base::BackwardKernelCore(srcGrad, in, kernelGrad, accumulateGradient, allowReuse, workspace);
+            ForEachSubBatch(in.GetNumCols(), [&](size_t start, size_t count)
+            {
+                m_kernels->BackwardKernelDirect(srcGrad.Data() + start * srcGrad.GetNumRows(), in.Data() + start * in.GetNumRows(), kernelGrad.Data(), count);
+            });
+        };
+        if (m_backwardKernelAlgo == Algo::None)
+            m_backwardKernelAlgo = Autotune("backward kernel", /*hasWinograd=*/false, &kernelGrad, run);
+        else
+            run(m_backwardKernelAlgo);
+    }
+
+private:
+    template <class Fn>
+    void ForEachSubBatch(size_t batchSize, const Fn& fn)
+    {
+        size_t subBatchSize = m_maxTempMemSizeInSamples == 0 ? batchSize : min(batchSize, m_maxTempMemSizeInSamples);
+        for (size_t start = 0; start < batchSize; start += subBatchSize)
+            fn(start, min(subBatchSize, batchSize - start));
+    }
+
+    // Runs all candidates and returns the fastest one. When done, the result of the fastest one is in place.
+    // result is the matrix the operation accumulates into (nullptr if it is overwritten); every candidate starts
+    // from its original value.
+    template <class Fn>
+    Algo Autotune(const char* operation, bool hasWinograd, Mat* result, const Fn& run)
+    {
+        if (m_forceDeterministicAlgorithms)
+        {
+            Algo algo = hasWinograd ? Algo::Winograd : Algo::Direct;
+            run(algo);
+            if (GetMathLibTraceLevel() > 0)
+                fprintf(stderr, "%lsdirect convolution engine uses %s for %s (deterministic).\n", m_logPrefix.c_str(), AlgoName(algo), operation);
+            return algo;
+        }
+
+        std::vector<Algo> candidates = { Algo::Gemm, Algo::Direct };
+        if (hasWinograd)
+            candidates.push_back(Algo::Winograd);
+
+        std::unique_ptr<Mat> original;
+        if (result != nullptr)
+            original = std::make_unique<Mat>(*result, result->GetDeviceId());
+
+        Algo best = Algo::None;
+        double bestTime = std::numeric_limits<double>::max();
+        for (auto algo : candidates)
+        {
+            // The first run allocates and touches the scratch memory, only the second one is timed.
+            double time = 0;
+            for (int i = 0; i < 2; i++)
+            {
+                if (original != nullptr)
+                    result->AssignValuesOf(*original);
+                auto start = std::chrono::steady_clock::now();
+                run(algo);
+                time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+            if (GetMathLibTraceLevel() > 1)
+                fprintf(stderr, "%lsdirect convolution engine: %s %s took %.3f ms.\n", m_logPrefix.c_str(), operation, AlgoName(algo), time * 1000);
+            if (time < bestTime)
+            {
+                best = algo;
+                bestTime = time;
+            }
+        }
+
+        if (best != candidates.back())
+        {
+            if (original != nullptr)
+                result->AssignValuesOf(*original);
+            run(best);
+        }
+
+        if (GetMathLibTraceLevel() > 0)
+            fprintf(stderr, "%lsdirect convolution engine uses %s for %s.\n", m_logPrefix.c_str(), AlgoName(best), operation);
+        return best;
+    }
+
+    static const char* AlgoName(Algo algo)
+    {
+        switch (algo)
+        {
+        case Algo::Gemm:     return "GEMM";
+        case Algo::Direct:   return "direct";
+        case Algo::Winograd: return "Winograd";
+        default:             return "none";
+        }
+    }
+
+    std::wstring m_logPrefix;
+    bool m_forceDeterministicAlgorithms;
+    std::unique_ptr<CPUBlockedConvolution<ElemType>> m_kernels;
+    Algo m_forwardAlgo;
+    Algo m_backwardDataAlgo;
+    Algo m_backwardKernelAlgo;
+
+public:
+    static bool IsSupported(DEVICEID_TYPE deviceId, ConvolveGeometryPtr geometry)
+    {
+        return deviceId < 0 && CPUBlockedConvolution<ElemType>::IsSupported(*geometry);
+    }
+};
+
 template <class ElemType>
 std::unique_ptr<ConvolutionEngine<ElemType>> ConvolutionEngine<ElemType>::Create(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId,
                                                                                  ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind,
@@ -892,6 +1102,14 @@ std::unique_ptr<ConvolutionEngine<ElemType>> ConvolutionEngine<ElemType>::Create
                                                                forceDeterministicAlgorithms, poolIncludePad, inputHasFreeDimension);
     }
 
+    if (isEnabled(ConvolutionEngineKind::Direct) && DirectConvolutionEngine<ElemType>::IsSupported(deviceId, geometry))
+    {
+        if (GetMathLibTraceLevel() > 0)
+            fprintf(stderr, "%lsusing direct convolution engine for geometry: %s.\n", logPrefix.c_str(), engStr.c_str());
+
+        return std::make_unique<DirectConvolutionEngine<ElemType>>(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad, logPrefix, forceDeterministicAlgorithms);
+    }
+
     if (isEnabled(ConvolutionEngineKind::Gemm) && GemmConvolutionEngine<ElemType>::IsSupported(deviceId, geometry))
     {
         if (GetMathLibTraceLevel() > 0)
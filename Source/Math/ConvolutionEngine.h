@@ -22,6 +22,8 @@ enum class ConvolutionEngineKind
     CuDnn     = 1 << 1, // cuDNN, works only for 2D/3D convos with full sharing.
     Legacy    = 1 << 2, // Legacy, for backwards compatibility. REVIEW alexeyk: implement sparse version and remove Legacy altogether.
     Gemm      = 1 << 3, // Uses convolution unrolling+GEMM technique. Works only for convos with full sharing.
+    Direct    = 1 << 4, // CPU only, channel-blocked direct and Winograd kernels, autotuned against GEMM. Works only for 2D convos with full sharing.
+                        // Not part of All: the autotuned choice can differ from run to run, so it has to be enabled explicitly.
 
     All       = Reference | CuDnn | Legacy | Gemm
 };
@@ -4880,7 +4880,7 @@ void Matrix<ElemType>::RNNForward(const Matrix<ElemType> &inputX, const Matrix<E
 
     DISPATCH_MATRIX_ON_FLAG(this,
                             this,
-                            NOT_IMPLEMENTED,
+                            m_CPUMatrix->RNNForward(*(inputX.m_CPUMatrix), *(paramW.m_CPUMatrix), xDim, yDim, numSequencesForFrame, rnnAttributes, *(workspace.m_CPUMatrix)),
                             m_GPUMatrix->RNNForward(*(inputX.m_GPUMatrix), *(paramW.m_GPUMatrix), xDim, yDim, numSequencesForFrame, rnnAttributes, *(reserve.m_GPUMatrix), *(workspace.m_GPUMatrix)),
                             NOT_IMPLEMENTED,
                             NOT_IMPLEMENTED);
@@ -4895,7 +4895,7 @@ void Matrix<ElemType>::RNNBackwardData(const Matrix<ElemType>& outputDY, const M
     workspace._transferToDevice(GetDeviceId());
     DISPATCH_MATRIX_ON_FLAG(this,
                             this,
-                            NOT_IMPLEMENTED,
+                            m_CPUMatrix->RNNBackwardData(*(outputDY.m_CPUMatrix), *(paramW.m_CPUMatrix), *(outputDX.m_CPUMatrix), rnnAttributes, *(workspace.m_CPUMatrix)),
                             m_GPUMatrix->RNNBackwardData(*(outputDY.m_GPUMatrix), *(paramW.m_GPUMatrix), *(outputDX.m_GPUMatrix), rnnAttributes, *(reserve.m_GPUMatrix), *(workspace.m_GPUMatrix)),
                             NOT_IMPLEMENTED,
                             NOT_IMPLEMENTED);
@@ -4910,7 +4910,7 @@ void Matrix<ElemType>::RNNBackwardWeights(const Matrix<ElemType>& inputX, const
     workspace._transferToDevice(GetDeviceId());
     DISPATCH_MATRIX_ON_FLAG(this,
                             this,
-                            NOT_IMPLEMENTED,
+                            m_CPUMatrix->RNNBackwardWeights(*(inputX.m_CPUMatrix), *(outputY.m_CPUMatrix), *(dw.m_CPUMatrix), rnnAttributes, *(workspace.m_CPUMatrix)),
                             m_GPUMatrix->RNNBackwardWeights(*(inputX.m_GPUMatrix), *(outputY.m_GPUMatrix), *(dw.m_GPUMatrix), rnnAttributes, *(reserve.m_GPUMatrix), *(workspace.m_GPUMatrix)),
                             NOT_IMPLEMENTED,
                             NOT_IMPLEMENTED);
@@ -0,0 +1,223 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// QuantizedGemm.h -- blocked, packed GEMM for 16-bit quantized matrices with 32-bit accumulation
+//
+
+#pragma once
+
+#include "Basics.h"
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <intrin.h> // for intrinsics
+#endif
+#ifdef __unix__
+#if !defined(__aarch64__)
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// -----------------------------------------------------------------------
+// Int16GemmSimd -- the few vector operations needed by the Int16Gemm kernel
+//
+// An Operand holds 'Lanes' pairs of 16-bit values, an Accumulator holds 'Lanes' 32-bit sums.
+// MultiplyAddPairs() multiplies the operands pairwise and adds both products of each pair to
+// the corresponding accumulator lane (pmaddwd, or a single vpdpwssd with AVX-512 VNNI).
+// The widest instruction set enabled at compile time is used.
+// -----------------------------------------------------------------------
+
+#if defined(__AVX512BW__)
+struct Int16GemmSimd
+{
+    typedef __m512i Operand;
+    typedef __m512i Accumulator;
+    static const size_t Lanes = 16;
+    static Accumulator Zero()                       { return _mm512_setzero_si512(); }
+    static Operand Load(const short* p)             { return _mm512_loadu_si512((const void*) p); }
+    static Operand Broadcast(const short* p)        { int32_t v; memcpy(&v, p, sizeof(v)); return _mm512_set1_epi32(v); }
+#if defined(__AVX512VNNI__)
+    static Accumulator MultiplyAddPairs(Accumulator acc, Operand a, Operand b) { return _mm512_dpwssd_epi32(acc, a, b); }
+#else
+    static Accumulator MultiplyAddPairs(Accumulator acc, Operand a, Operand b) { return _mm512_add_epi32(acc, _mm512_madd_epi16(a, b)); }
+#endif
+    static void Store(int32_t* p, Accumulator acc)  { _mm512_storeu_si512((void*) p, acc); }
+};
+#elif defined(__AVX2__)
+struct Int16GemmSimd
+{
+    typedef __m256i Operand;
+    typedef __m256i Accumulator;
+    static const size_t Lanes = 8;
+    static Accumulator Zero()                       { return _mm256_setzero_si256(); }
+    static Operand Load(const short* p)             { return _mm256_loadu_si256((const __m256i*) p); }
+    static Operand Broadcast(const short* p)        { int32_t v; memcpy(&v, p, sizeof(v)); return _mm256_set1_epi32(v); }
+    static Accumulator MultiplyAddPairs(Accumulator acc, Operand a, Operand b) { return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b)); }
+    static void Store(int32_t* p, Accumulator acc)  { _mm256_storeu_si256((__m256i*) p, acc); }
+};
+#elif !defined(__aarch64__)
+// SSE2 is part of every x64 CPU
+struct Int16GemmSimd
+{
+    typedef __m128i Operand;
+    typedef __m128i Accumulator;
+    static const size_t Lanes = 4;
+    static Accumulator Zero()                       { return _mm_setzero_si128(); }
+    static Operand Load(const short* p)             { return _mm_loadu_si128((const __m128i*) p); }
+    static Operand Broadcast(const short* p)        { int32_t v; memcpy(&v, p, sizeof(v)); return _mm_set1_epi32(v); }
+    static Accumulator MultiplyAddPairs(Accumulator acc, Operand a, Operand b) { return _mm_add_epi32(acc, _mm_madd_epi16(a, b)); }
+    static void Store(int32_t* p, Accumulator acc)  { _mm_storeu_si128((__m128i*) p, acc); }
+};
+#else
+// portable fallback for targets without SSE2, e.g. ARM64
+struct Int16GemmSimd
+{
+    static const size_t Lanes = 4;
+    struct Operand     { short v[2 * Lanes]; };
+    struct Accumulator { int32_t v[Lanes]; };
+    static Accumulator Zero()                       { Accumulator acc; memset(&acc, 0, sizeof(acc)); return acc; }
+    static Operand Load(const short* p)             { Operand a; memcpy(a.v, p, sizeof(a.v)); return a; }
+    static Operand Broadcast(const short* p)        { Operand a; for (size_t i = 0; i < Lanes; i++) { a.v[2 * i] = p[0]; a.v[2 * i + 1] = p[1]; } return a; }
+    static Accumulator MultiplyAddPairs(Accumulator acc, const Operand& a, const Operand& b)
+    {
+        for (size_t i = 0; i < Lanes; i++)
+            acc.v[i] += (int32_t) a.v[2 * i] * b.v[2 * i] + (int32_t) a.v[2 * i + 1] * b.v[2 * i + 1];
+        return acc;
+    }
+    static void Store(int32_t* p, const Accumulator& acc) { memcpy(p, acc.v, sizeof(acc.v)); }
+};
+#endif
+
+// -----------------------------------------------------------------------
+// Int16Gemm -- C[m,n] = A[m,k] * B[k,n] for column-major 16-bit matrices, accumulated in 32 bits
+//
+// Pairs of consecutive k are processed by one instruction, so both operands are packed into
+// panels of interleaved k-pairs (an odd k is padded with a zero):
+//  - A into panels of MR rows,    A panel r at pair p: (A(rMR + i, 2p), A(rMR + i, 2p+1)) for i < MR
+//  - B into panels of NR columns, B panel c at pair p: (B(2p, cNR + j), B(2p+1, cNR + j)) for j < NR
+// Packing A is the expensive one (its k-pairs are m elements apart), so callers that multiply
+// with constant weights should pack them once and keep the packed copy.
+// Each MR x NR output tile is computed in registers over the full k; a pair of A and B panels
+// is small enough to stay in L1/L2 for all usual k. Tiles are distributed across OpenMP threads.
+// -----------------------------------------------------------------------
+
+class Int16Gemm
+{
+public:
+    static const size_t MR = 2 * Int16GemmSimd::Lanes; // rows per A panel (two vectors)
+    static const size_t NR = 4;                         // columns per B panel (the micro-kernel is unrolled for 4)
+
+    static size_t NumPairs(size_t k) { return (k + 1) / 2; }
+
+    // pack column-major A[m,k] into panels of MR rows
+    static void PackA(const short* A, size_t m, size_t k, std::vector<short>& packedA)
+    {
+        const size_t numPanels = (m + MR - 1) / MR;
+        const size_t numPairs = NumPairs(k);
+        packedA.assign(numPanels * numPairs * 2 * MR, 0);
+#pragma omp parallel for if (m * k > 65536)
+        for (int r = 0; r < (int) numPanels; r++)
+        {
+            short* panel = packedA.data() + r * numPairs * 2 * MR;
+            const size_t rowBegin = r * MR;
+            const size_t rowEnd = std::min(rowBegin + MR, m);
+            for (size_t l = 0; l < k; l++)
+            {
+                const short* column = A + l * m;
+                short* dst = panel + (l / 2) * 2 * MR + (l % 2);
+                for (size_t i = rowBegin; i < rowEnd; i++)
+                    dst[2 * (i - rowBegin)] = column[i];
+            }
+        }
+    }
+
+    // pack column-major B[k,n] into panels of NR columns
+    // The k-pairs of B are adjacent in memory already, so this is mostly a copy.
+    static void PackB(const short* B, size_t k, size_t n, std::vector<short>& packedB)
+    {
+        const size_t numPanels = (n + NR - 1) / NR;
+        const size_t numPairs = NumPairs(k);
+        packedB.assign(numPanels * numPairs * 2 * NR, 0);
+#pragma omp parallel for if (n * k > 65536)
+        for (int j = 0; j < (int) n; j++)
+        {
+            short* panel = packedB.data() + (j / NR) * numPairs * 2 * NR;
+            const short* column = B + j * k;
+            for (size_t l = 0; l < k; l++)
+                panel[(l / 2) * 2 * NR + 2 * (j % NR) + (l % 2)] = column[l];
+        }
+    }
+
+    // C[m,n] = packedA * packedB, where C is column-major with leading dimension ldc
+    template <class ElemType>
+    static void Multiply(const std::vector<short>& packedA, const std::vector<short>& packedB, size_t m, size_t n, size_t k, ElemType* C, size_t ldc)
+    {
+        const size_t numRowPanels = (m + MR - 1) / MR;
+        const size_t numColPanels = (n + NR - 1) / NR;
+        const size_t numPairs = NumPairs(k);
+        if (packedA.size() != numRowPanels * numPairs * 2 * MR || packedB.size() != numColPanels * numPairs * 2 * NR)
+            LogicError("Int16Gemm::Multiply: Packed operands do not match the dimensions [%d x %d] * [%d x %d].", (int) m, (int) k, (int) k, (int) n);
+
+        const int numTiles = (int) (numRowPanels * numColPanels);
+#pragma omp parallel for schedule(static) if (m * n * k > 65536)
+        for (int t = 0; t < numTiles; t++)
+        {
+            // consecutive tiles share the same A panel, which then stays in cache
+            const size_t r = t / numColPanels;
+            const size_t c = t % numColPanels;
+            int32_t tile[MR * NR];
+            MultiplyTile(packedA.data() + r * numPairs * 2 * MR, packedB.data() + c * numPairs * 2 * NR, numPairs, tile);
+
+            // write out the part of the tile that is inside C
+            const size_t rows = std::min((size_t) MR, m - r * MR);
+            const size_t cols = std::min((size_t) NR, n - c * NR);
+            for (size_t j = 0; j < cols; j++)
+            {
+                ElemType* dst = C + (c * NR + j) * ldc + r * MR;
+                for (size_t i = 0; i < rows; i++)
+                    dst[i] = (ElemType) tile[i + j * MR];
+            }
+        }
+    }
+
+private:
+    // micro-kernel: one MR x NR tile (column-major) over all k-pairs
+    static void MultiplyTile(const short* aPanel, const short* bPanel, size_t numPairs, int32_t* tile)
+    {
+        typedef Int16GemmSimd Simd;
+        Simd::Accumulator c00 = Simd::Zero(), c10 = Simd::Zero();
+        Simd::Accumulator c01 = Simd::Zero(), c11 = Simd::Zero();
+        Simd::Accumulator c02 = Simd::Zero(), c12 = Simd::Zero();
+        Simd::Accumulator c03 = Simd::Zero(), c13 = Simd::Zero();
+        for (size_t p = 0; p < numPairs; p++)
+        {
+            const short* a = aPanel + p * 2 * MR;
+            const short* b = bPanel + p * 2 * NR;
+            Simd::Operand a0 = Simd::Load(a);
+            Simd::Operand a1 = Simd::Load(a + 2 * Simd::Lanes);
+            Simd::Operand bj = Simd::Broadcast(b);
+            c00 = Simd::MultiplyAddPairs(c00, a0, bj);
+            c10 = Simd::MultiplyAddPairs(c10, a1, bj);
+            bj = Simd::Broadcast(b + 2);
+            c01 = Simd::MultiplyAddPairs(c01, a0, bj);
+            c11 = Simd::MultiplyAddPairs(c11, a1, bj);
+            bj = Simd::Broadcast(b + 4);
+            c02 = Simd::MultiplyAddPairs(c02, a0, bj);
+            c12 = Simd::MultiplyAddPairs(c12, a1, bj);
+            bj = Simd::Broadcast(b + 6);
+            c03 = Simd::MultiplyAddPairs(c03, a0, bj);
+            c13 = Simd::MultiplyAddPairs(c13, a1, bj);
+        }
+        Simd::Store(tile + 0 * MR, c00); Simd::Store(tile + 0 * MR + Simd::Lanes, c10);
+        Simd::Store(tile + 1 * MR, c01); Simd::Store(tile + 1 * MR + Simd::Lanes, c11);
+        Simd::Store(tile + 2 * MR, c02); Simd::Store(tile + 2 * MR + Simd::Lanes, c12);
+        Simd::Store(tile + 3 * MR, c03); Simd::Store(tile + 3 * MR + Simd::Lanes, c13);
+    }
+};
+
+}}}
@@ -4,6 +4,7 @@
 //
 #pragma once
 #include "Quantizers.h"
+#include "QuantizedGemm.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -21,6 +22,9 @@ class QuantizedMultiplier
     // Placeholders for quantized matrices A and B
     vector<short> m_pMatA, m_pMatB;
 
+    // Quantized matrices A and B, packed for Int16Gemm
+    vector<short> m_packedA, m_packedB;
+
     // Whether matrices A and B are constant (i.e. weights)
     // If the matrix is constant, the size of the underlying container for quatized values will be preserved for
     // the lifespan of the object
@@ -44,12 +48,13 @@ public:
     // A[m,k]*B[k,n] = C[m,n]
     void Multiply(int m, int n, int k, ElemType* A, ElemType* B, ElemType* C)
     {
-        // Quantize
+        // Quantize and pack
         if (!m_isAConstant || m_firstPass)
         {
             m_pMatA.resize(m*k);
             ArrayRef<short> refMatA(m_pMatA.data(), m_pMatA.size());
             m_pQuantizerA->Quantize(ArrayRef<ElemType>(A, m_pMatA.size()), refMatA);
+            Int16Gemm::PackA(m_pMatA.data(), m, k, m_packedA);
         }
         
         if (!m_isBConstant || m_firstPass)
@@ -57,24 +62,14 @@ public:
             m_pMatB.resize(n*k);
             ArrayRef<short> refMatB(m_pMatB.data(), m_pMatB.size());
             m_pQuantizerB->Quantize(ArrayRef<ElemType>(B, m_pMatB.size()), refMatB);
+            Int16Gemm::PackB(m_pMatB.data(), k, n, m_packedB);
         }
 
         m_firstPass = false;
 
         // Do multiply
-        // Naive inefficient product, just for demonstation
-        // TODO: replace with an efficient version, e.g. IPG, block multiplier, Eigen, gemmlowp, etc.
-        for (size_t i = 0; i < m; i++)
-            for (size_t j = 0; j < n; j++)
-            {
-                int dotProduct=0;
-                for (size_t l = 0; l < k; l++)
-                {
-                    // CNTK is using column-major storage
-                    dotProduct += m_pMatA[i + l*m] * m_pMatB[l + k*j];
-                }
-                C[i + j*m] = (ElemType)dotProduct;
-            }
+        // CNTK is using column-major storage
+        Int16Gemm::Multiply(m_packedA, m_packedB, m, n, k, C, m);
 
         // De-quantize
         int mn = m*n;
@@ -17,8 +17,12 @@
 #include "fileutil.h"
 #include "TimerUtility.h"
 #include <algorithm>
+#include <climits>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 #include <stdio.h>
 #ifndef CPUONLY
 #include <cuda_runtime_api.h>
@@ -28,6 +32,7 @@
 #include <Windows.h>
 #else
 #include <sys/syscall.h>
+#include <unistd.h>
 #endif 
 
 
@@ -67,6 +72,7 @@ static const FixedEventDesc c_fixedEvtDesc[profilerEvtMax] = {
     { "", profilerEvtSeparator, false },                            // profilerSepSpace2
 
     { "Prefetch Minibatch", profilerEvtTime, false },               // profilerEvtPrefetchMinibatch
+    { "Wait For Minibatch", profilerEvtTime, false },               // profilerEvtWaitForMinibatch
 };
 
 
@@ -91,6 +97,23 @@ struct CustomEventRecord
     unsigned int    threadId;
 };
 
+//
+// Aggregated profiling data of one computation node, keyed by the node name.
+//
+struct NodeEventRecord
+{
+    std::string     operationName;
+    int             forwardCnt;             // number of forward passes
+    int             backwardCnt;            // number of backward passes
+    long long       forwardSum;             // forward time (ticks)
+    long long       backwardSum;            // backward time (ticks)
+    long long       bytes;                  // estimated bytes read and written
+    long long       flops;                  // estimated floating point operations
+    long long       maxAllocatedBytes;      // peak bytes held by the value and gradient matrices
+
+    NodeEventRecord() : forwardCnt(0), backwardCnt(0), forwardSum(0), backwardSum(0), bytes(0), flops(0), maxAllocatedBytes(0) {}
+};
+
 
 //
 // Global state of the profiler
@@ -99,6 +122,7 @@ struct ProfilerState
 {
     bool                    enabled;                     // Profiler enabled (active)
     bool                    syncGpu;                     // Sync GPU per each profiling event
+    bool                    profileNodes;                // Record computation node events
     bool                    cudaSyncEnabled;             // Runtime state of CUDA kernel sync
     std::wstring            profilerDir;                 // Directory where reports/logs are saved
     std::wstring            logSuffix;                   // Suffix to append to report/log file names
@@ -107,6 +131,7 @@ struct ProfilerState
     unsigned long long      customEventBufferBytes;      // Number of bytes allocated for the custom event buffer
     unsigned long long      customEventOffset;           // Offset to current place in buffer
     unique_ptr<char[]>      customEventBuffer;           // Pointer to custom event buffer
+    std::map<std::string, NodeEventRecord> nodeEvents;   // Profiling data for each computation node
 };
 
 
@@ -124,6 +149,9 @@ void FormatTimeStr(char* str, size_t strLen, double value);
 void FormatThroughputStr(char* str, size_t strLen, double value);
 void FormatBytesStr(char* str, size_t strLen, long long bytes);
 void ProfilerGenerateDetailFile(const std::wstring& fileName);
+void ProfilerGenerateNodeReport(const std::wstring& fileName, struct tm* timeInfo);
+void ProfilerGenerateTraceFile(const std::wstring& fileName);
+std::string EscapeJsonString(const char* str);
 
 
 double TicksToSeconds(long long ticks)
@@ -145,9 +173,10 @@ double TicksSqToSecondsSq(double ticksSq)
 // customEventBufferBytes: Size of the custom event buffer.
 // logSuffix: Suffix string to append to log file names.
 // syncGpu: Wait for GPU to complete processing for each profiling event with syncGpu flag set.
+// profileNodes: Record the forward and backward pass of each computation node.
 //
 void PERF_PROFILER_API ProfilerInit(const std::wstring& profilerDir, const unsigned long long customEventBufferBytes,
-    const std::wstring& logSuffix, const bool syncGpu)
+    const std::wstring& logSuffix, const bool syncGpu, const bool profileNodes)
 {
     if (g_profilerState != nullptr)
     {
@@ -164,6 +193,7 @@ void PERF_PROFILER_API ProfilerInit(const std::wstring& profilerDir, const unsig
     g_profilerState->customEventBuffer.reset(new char[customEventBufferBytes]);
 
     g_profilerState->syncGpu = syncGpu;
+    g_profilerState->profileNodes = profileNodes;
     g_profilerState->enabled = false;
 
     if (_wmkdir(g_profilerState->profilerDir.c_str()) == -1 && errno != EEXIST)
@@ -342,6 +372,58 @@ void PERF_PROFILER_API ProfilerThroughputEnd(const long long stateId, const int
 }
 
 
+//
+// Measure the forward or backward pass of a computation node.
+// ProfilerNodesEnabled() is cheap, and callers should test it once per pass over the network before
+// gathering any node statistics. The stateId is returned by ProfilerTimeBegin().
+//
+bool PERF_PROFILER_API ProfilerNodesEnabled()
+{
+    // A nullptr state indicates that the profiler is globally disabled, and not initialized
+    return g_profilerState != nullptr && g_profilerState->enabled && g_profilerState->profileNodes;
+}
+
+
+void PERF_PROFILER_API ProfilerNodeTimeEnd(const long long stateId, const char* nodeName, const char* operationName, const bool backward,
+    const long long bytes, const long long flops, const long long allocatedBytes)
+{
+    // A nullptr state indicates that the profiler is globally disabled, and not initialized
+    if (g_profilerState == nullptr)
+        return;
+
+    // attribute the GPU work to the node that launched it
+    ProfilerSyncGpu();
+
+    long long endClock = Clock::GetTimeStamp();
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+
+        if (!g_profilerState->enabled)
+            return;
+
+        auto& nodeEvent = g_profilerState->nodeEvents[nodeName];
+        if (nodeEvent.operationName.empty())
+            nodeEvent.operationName = operationName;
+        if (backward)
+        {
+            nodeEvent.backwardSum += endClock - stateId;
+            nodeEvent.backwardCnt++;
+        }
+        else
+        {
+            nodeEvent.forwardSum += endClock - stateId;
+            nodeEvent.forwardCnt++;
+        }
+        nodeEvent.bytes += bytes;
+        nodeEvent.flops += flops;
+        nodeEvent.maxAllocatedBytes = std::max(allocatedBytes, nodeEvent.maxAllocatedBytes);
+    }
+
+    std::string eventDescription = std::string(backward ? "Backward " : "Forward ") + nodeName + " (" + operationName + ")";
+    ProfilerTimeRecordToBuffer(eventDescription.c_str(), stateId, endClock);
+}
+
+
 //
 // Generate reports and release all resources.
 //
@@ -366,6 +448,17 @@ void PERF_PROFILER_API ProfilerClose()
     fileName = g_profilerState->profilerDir + L"/" + std::wstring(timeStr) + L"_detail_" + g_profilerState->logSuffix + L".csv";
     ProfilerGenerateDetailFile(fileName);
 
+    // Generate per-node report
+    if (g_profilerState->profileNodes)
+    {
+        fileName = g_profilerState->profilerDir + L"/" + std::wstring(timeStr) + L"_nodes_" + g_profilerState->logSuffix + L".txt";
+        ProfilerGenerateNodeReport(fileName, timeInfo);
+    }
+
+    // Generate Chrome trace file
+    fileName = g_profilerState->profilerDir + L"/" + std::wstring(timeStr) + L"_trace_" + g_profilerState->logSuffix + L".json";
+    ProfilerGenerateTraceFile(fileName);
+
     g_profilerState.reset();
 }
 
@@ -555,13 +648,153 @@ void ProfilerGenerateDetailFile(const std::wstring& fileName)
 }
 
 
+//
+// Generate per-node report, sorted by descending total (forward + backward) time.
+//
+void ProfilerGenerateNodeReport(const std::wstring& fileName, struct tm* timeInfo)
+{
+    FILE* f = _wfopen(fileName.c_str(), L"wt");
+    if (f == NULL)
+    {
+        RuntimeError("Error: ProfilerGenerateNodeReport: Cannot create file <%ls>.\n", fileName.c_str());
+    }
+
+    fprintfOrDie(f, "CNTK Performance Profiler Node Report\n\n");
+    char timeStr[32];
+    strftime(timeStr, sizeof(timeStr), "%Y/%m/%d %H:%M:%S", timeInfo);
+    fprintfOrDie(f, "Time Stamp: %s\n\n", timeStr);
+
+    std::vector<std::pair<std::string, NodeEventRecord>> nodeEvents(g_profilerState->nodeEvents.begin(), g_profilerState->nodeEvents.end());
+    std::sort(nodeEvents.begin(), nodeEvents.end(), [](const std::pair<std::string, NodeEventRecord>& a, const std::pair<std::string, NodeEventRecord>& b)
+    {
+        return a.second.forwardSum + a.second.backwardSum > b.second.forwardSum + b.second.backwardSum;
+    });
+
+    long long totalSum = 0;
+    for (const auto& nodeEvent : nodeEvents)
+        totalSum += nodeEvent.second.forwardSum + nodeEvent.second.backwardSum;
+
+    fprintfOrDie(f, "Node.................................... Operation............... .........Forward ........Backward ...........Total ......%% .....Count ...GFLOP/s ......GB/s .......Allocated\n\n");
+
+    for (const auto& nodeEvent : nodeEvents)
+    {
+        const auto& record = nodeEvent.second;
+        fprintfOrDie(f, "%-40s %-24s ", nodeEvent.first.c_str(), record.operationName.c_str());
+
+        char str[32];
+
+        FormatTimeStr(str, sizeof(str), TicksToSeconds(record.forwardSum));
+        fprintfOrDie(f, "%s ", str);
+
+        FormatTimeStr(str, sizeof(str), TicksToSeconds(record.backwardSum));
+        fprintfOrDie(f, "%s ", str);
+
+        double seconds = TicksToSeconds(record.forwardSum + record.backwardSum);
+        FormatTimeStr(str, sizeof(str), seconds);
+        fprintfOrDie(f, "%s ", str);
+
+        fprintfOrDie(f, "%7.2f ", totalSum > 0 ? 100.0 * (record.forwardSum + record.backwardSum) / totalSum : 0.0);
+        fprintfOrDie(f, "%10d ", record.forwardCnt + record.backwardCnt);
+
+        // GFLOP/s and GB/s use decimal units, like the throughput events
+        fprintfOrDie(f, "%10.3f ", seconds > 0.0 ? record.flops / seconds / 1e9 : 0.0);
+        fprintfOrDie(f, "%10.3f ", seconds > 0.0 ? record.bytes / seconds / 1e9 : 0.0);
+
+        FormatBytesStr(str, sizeof(str), record.maxAllocatedBytes);
+        fprintfOrDie(f, "%s\n", str);
+    }
+
+    fclose(f);
+}
+
+
+//
+// Generate trace file in the Chrome trace_event format (load in chrome://tracing).
+// All events of the custom event buffer are written as complete events, with times relative to the first event.
+//
+void ProfilerGenerateTraceFile(const std::wstring& fileName)
+{
+    FILE* f = _wfopen(fileName.c_str(), L"wt");
+    if (f == NULL)
+    {
+        RuntimeError("Error: ProfilerGenerateTraceFile: Cannot create file <%ls>.\n", fileName.c_str());
+    }
+
+#ifdef _WIN32
+    unsigned int processId = (unsigned int)GetCurrentProcessId();
+#else
+    unsigned int processId = (unsigned int)getpid();
+#endif
+
+    char* bufferBegin = g_profilerState->customEventBuffer.get();
+    char* bufferEnd = bufferBegin + g_profilerState->customEventOffset;
+
+    // Events are recorded when they end, so the first event to begin can be anywhere in the buffer
+    long long firstClock = LLONG_MAX;
+    for (char* eventPtr = bufferBegin; eventPtr < bufferEnd; eventPtr += sizeof(CustomEventRecord))
+    {
+        eventPtr += strlen(eventPtr) + 1;
+        firstClock = std::min(((CustomEventRecord*)eventPtr)->beginClock, firstClock);
+    }
+
+    fprintfOrDie(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    const char* separator = "\n";
+    for (char* eventPtr = bufferBegin; eventPtr < bufferEnd; eventPtr += sizeof(CustomEventRecord))
+    {
+        // Leading underscores only indent fixed events in the summary report
+        char* descriptionStr = eventPtr;
+        eventPtr += strlen(descriptionStr) + 1;
+        while (*descriptionStr == '_')
+            descriptionStr++;
+
+        CustomEventRecord* eventRecord = (CustomEventRecord*)eventPtr;
+
+        fprintfOrDie(f, "%s{\"name\":\"%s\",\"cat\":\"cntk\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u}",
+            separator, EscapeJsonString(descriptionStr).c_str(),
+            1000000.0 * TicksToSeconds(eventRecord->beginClock - firstClock),
+            1000000.0 * TicksToSeconds(eventRecord->endClock - eventRecord->beginClock),
+            processId, eventRecord->threadId);
+        separator = ",\n";
+    }
+
+    fprintfOrDie(f, "\n]}\n");
+
+    fclose(f);
+}
+
+std::string EscapeJsonString(const char* str)
+{
+    std::string escaped;
+    for (; *str; str++)
+    {
+        if (*str == '"' || *str == '\\')
+        {
+            escaped += '\\';
+            escaped += *str;
+        }
+        else if ((unsigned char)*str < 0x20)
+        {
+            char hexStr[8];
+            sprintf_s(hexStr, sizeof(hexStr), "\\u%04x", (unsigned int)(unsigned char)*str);
+            escaped += hexStr;
+        }
+        else
+        {
+            escaped += *str;
+        }
+    }
+    return escaped;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Scoped helpers.
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void ProfilerContext::Init(const std::wstring& profilerDir, const unsigned long long customEventBufferBytes, const std::wstring& logSuffix, const bool syncGpu)
+void ProfilerContext::Init(const std::wstring& profilerDir, const unsigned long long customEventBufferBytes, const std::wstring& logSuffix, const bool syncGpu, const bool profileNodes)
 {
-    ProfilerInit(profilerDir, customEventBufferBytes, logSuffix, syncGpu);
+    ProfilerInit(profilerDir, customEventBufferBytes, logSuffix, syncGpu, profileNodes);
 }
 
 ProfilerContext::~ProfilerContext()
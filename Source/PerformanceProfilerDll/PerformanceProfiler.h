@@ -26,6 +26,11 @@
 // and ProfilerThroughputEnd() calls should be used. The throughput APIs can only be used
 // with fixed events.
 //
+// When node profiling is requested in ProfilerInit(), the computation network reports each node
+// evaluation through ProfilerNodeTimeEnd(). This adds a per-node report, sorted by total time.
+// In all cases, a Chrome trace_event file (chrome://tracing) is written with the recorded events
+// of all threads.
+//
 // CNTK specifics
 //
 // The profiler is turned off during the very first epoch to avoid polluting profile data with
@@ -38,6 +43,15 @@
 
 #define PROFILE_SCOPE(eventId)      /*nothing*/
 
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// Node profiling is never enabled, so the network does not gather node statistics.
+inline bool ProfilerNodesEnabled() { return false; }
+inline long long ProfilerTimeBegin() { return 0; }
+inline void ProfilerNodeTimeEnd(const long long, const char*, const char*, const bool, const long long, const long long, const long long) {}
+
+}}}
+
 #else
 
 #include <string>
@@ -79,6 +93,7 @@ enum ProfilerEvents
 
     // Data reader events
     profilerEvtPrefetchMinibatch,           // Prefetching the next minibatch in a background thread
+    profilerEvtWaitForMinibatch,            // Waiting for the background thread because no minibatch was prepared
 
     profilerEvtMax
 };
@@ -90,9 +105,10 @@ enum ProfilerEvents
 // customEventBufferBytes: Bytes to allocate for the custom event buffer.
 // logSuffix: Suffix string to append to log files.
 // syncGpu: Wait for GPU to complete processing for each profiling event.
+// profileNodes: Record the forward and backward pass of each computation node.
 //
 void PERF_PROFILER_API ProfilerInit(const std::wstring& profilerDir, const unsigned long long customEventBufferBytes,
-    const std::wstring& logSuffix, const bool syncGpu);
+    const std::wstring& logSuffix, const bool syncGpu, const bool profileNodes);
 
 
 //
@@ -128,6 +144,19 @@ long long PERF_PROFILER_API ProfilerThroughputBegin();
 void PERF_PROFILER_API ProfilerThroughputEnd(const long long stateId, const int eventId, const long long bytes);
 
 
+//
+// Measure the forward or backward pass of a computation node.
+// ProfilerNodesEnabled() is cheap, and callers should test it once per pass over the network before
+// gathering any node statistics. The stateId is returned by ProfilerTimeBegin().
+// bytes: Estimated number of bytes read and written by the node.
+// flops: Estimated number of floating point operations.
+// allocatedBytes: Bytes held by the value and gradient matrices of the node.
+//
+bool PERF_PROFILER_API ProfilerNodesEnabled();
+void PERF_PROFILER_API ProfilerNodeTimeEnd(const long long stateId, const char* nodeName, const char* operationName, const bool backward,
+    const long long bytes, const long long flops, const long long allocatedBytes);
+
+
 //
 // Generate reports and release all resources.
 //
@@ -139,7 +168,7 @@ void PERF_PROFILER_API ProfilerClose();
 //
 struct PERF_PROFILER_API ProfilerContext
 {
-    void Init(const std::wstring& profilerDir = L"", const unsigned long long customEventBufferBytes = (32 * 1024 * 1024), const std::wstring& logSuffix = L"", const bool syncGpu = false);
+    void Init(const std::wstring& profilerDir = L"", const unsigned long long customEventBufferBytes = (32 * 1024 * 1024), const std::wstring& logSuffix = L"", const bool syncGpu = false, const bool profileNodes = false);
     ~ProfilerContext();
 };
 
@@ -52,6 +52,9 @@ BinaryChunkDeserializer::BinaryChunkDeserializer(const BinaryConfigHelper& helpe
     SetTraceLevel(helper.GetTraceLevel());
 
     Initialize(helper.GetRename(), helper.GetElementType());
+
+    if (helper.UseMemoryMapping())
+        m_mappedFile = make_unique<MemoryMappedFile>(helper.GetFilePath());
 }
 
 
@@ -60,6 +63,8 @@ BinaryChunkDeserializer::BinaryChunkDeserializer(const std::wstring& filename) :
     m_file(FileWrapper::OpenOrDie(filename, L"rb")),
     m_headerOffset(0),
     m_chunkTableOffset(0),
+    m_lastMappedChunkId(ChunkIdMax),
+    m_readAheadChunkId(ChunkIdMax),
     m_traceLevel(0)
 {
 }
@@ -188,8 +193,38 @@ unique_ptr<byte[]> BinaryChunkDeserializer::ReadChunk(ChunkIdType chunkId)
 }
 
 
+MemoryMappedViewPtr BinaryChunkDeserializer::MapChunk(ChunkIdType chunkId)
+{
+    auto map = [this](ChunkIdType id)
+    {
+        // The pages are only read when accessed, ask the OS to start reading them right away.
+        return m_mappedFile->Map(m_chunkTable->GetDataStartOffset(id), m_chunkTable->GetChunkSize(id), MemoryAccessHint::WillNeed);
+    };
+
+    std::lock_guard<std::mutex> lock(m_mappingLock);
+
+    MemoryMappedViewPtr view = (m_readAheadChunkId == chunkId) ? m_readAheadView : map(chunkId);
+    m_readAheadView.reset();
+    m_readAheadChunkId = ChunkIdMax;
+
+    // Without randomization the chunks are requested one after another (the first one wraps around ChunkIdMax).
+    // With randomization, the randomizer prefetches the chunks it needs, which already maps them ahead of time.
+    ChunkIdType next = chunkId + 1;
+    if (chunkId == m_lastMappedChunkId + 1 && next < m_numChunks && m_chunkTable->GetChunkSize(next) > 0)
+    {
+        m_readAheadView = map(next);
+        m_readAheadChunkId = next;
+    }
+
+    m_lastMappedChunkId = chunkId;
+    return view;
+}
+
 ChunkPtr BinaryChunkDeserializer::GetChunk(ChunkIdType chunkId)
 {
+    if (m_mappedFile && m_chunkTable->GetChunkSize(chunkId) > 0)
+        return make_shared<BinaryDataChunk>(chunkId, m_chunkTable->GetNumSequences(chunkId), MapChunk(chunkId), m_deserializers);
+
     // Read the chunk into memory
     unique_ptr<byte[]> buffer = ReadChunk(chunkId);
 
@@ -9,6 +9,8 @@
 #include "BinaryConfigHelper.h"
 #include "BinaryDataChunk.h"
 #include "BinaryDataDeserializer.h"
+#include "MemoryMappedFile.h"
+#include <mutex>
 
 namespace CNTK {
 
@@ -111,6 +113,10 @@ private:
     // Reads a chunk from disk into buffer
     unique_ptr<byte[]> ReadChunk(ChunkIdType chunkId);
 
+    // Maps the data of a chunk from the input file. When the chunks are requested in order,
+    // the next chunk is mapped as well, so that the OS can read it ahead.
+    MemoryMappedViewPtr MapChunk(ChunkIdType chunkId);
+
     BinaryChunkDeserializer(const wstring& filename);
 
     void SetTraceLevel(unsigned int traceLevel);
@@ -124,6 +130,13 @@ private:
     ChunkTablePtr m_chunkTable;
     void* m_chunkBuffer;
 
+    // Input file mapping, null unless memory mapping is enabled.
+    std::unique_ptr<MemoryMappedFile> m_mappedFile;
+    ChunkIdType m_lastMappedChunkId;
+    ChunkIdType m_readAheadChunkId;
+    MemoryMappedViewPtr m_readAheadView;
+    std::mutex m_mappingLock;
+
     
     uint32_t m_numChunks;
     uint32_t m_numInputs;
@@ -65,7 +65,10 @@ namespace CNTK {
         }
 
         m_filepath = msra::strfun::utf16(config(L"file"));
-        m_keepDataInMemory = config(L"keepDataInMemory", false);
+        m_chunkCacheSizeBytes = config(L"chunkCacheSizeInBytes", (size_t)0);
+        m_chunkCacheSpillFile = (wstring)config(L"chunkCacheSpillFile", L"");
+        m_keepDataInMemory = config(L"keepDataInMemory", m_chunkCacheSizeBytes != 0);
+        m_useMemoryMapping = config(L"useMemoryMapping", false);
 
         m_randomizationWindow = GetRandomizationWindowFromConfig(config);
         m_sampleBasedRandomizationWindow = config(L"sampleBasedRandomizationWindow", false);
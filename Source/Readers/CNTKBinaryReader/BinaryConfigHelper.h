@@ -35,8 +35,17 @@ public:
 
     bool ShouldKeepDataInMemory() const { return m_keepDataInMemory; }
 
+    // Memory budget of the chunk cache, 0 - no limit.
+    size_t GetChunkCacheSize() const { return m_chunkCacheSizeBytes; }
+
+    // File to spill cached chunks to, empty - no spilling.
+    const wstring& GetChunkCacheSpillFile() const { return m_chunkCacheSpillFile; }
+
     DataType GetElementType() const { return m_elementType; }
 
+    // If true, chunks are memory mapped instead of being read into a buffer.
+    bool UseMemoryMapping() const { return m_useMemoryMapping; }
+
     DISABLE_COPY_AND_MOVE(BinaryConfigHelper);
 
 private:
@@ -49,6 +58,9 @@ private:
     bool m_sampleBasedRandomizationWindow;
     unsigned int m_traceLevel;
     bool m_keepDataInMemory; // if true the whole dataset is kept in memory
+    size_t m_chunkCacheSizeBytes; // if not 0, chunks are cached in memory up to this size (implies m_keepDataInMemory)
+    std::wstring m_chunkCacheSpillFile; // if not empty, chunks evicted from the cache are reloaded from this file
+    bool m_useMemoryMapping; // if true, the sequence data points directly into the memory mapped input file
 };
 
 }
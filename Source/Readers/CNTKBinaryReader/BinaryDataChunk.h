@@ -9,6 +9,7 @@
 #include "BinaryConfigHelper.h"
 #include "BinaryChunkDeserializer.h"
 #include "BinaryDataDeserializer.h"
+#include "MemoryMappedFile.h"
 
 namespace CNTK {
 
@@ -25,6 +26,17 @@ public:
         m_deserializers(deserializer)
     { }
 
+    // A chunk mapped from the input file, the sequences point directly into the mapping.
+    explicit BinaryDataChunk(ChunkIdType chunkId,
+        size_t numSequences,
+        MemoryMappedViewPtr view,
+        std::vector<BinaryDataDeserializerPtr> deserializer)
+        : m_chunkId(chunkId),
+        m_numSequences(numSequences),
+        m_view(view),
+        m_deserializers(deserializer)
+    { }
+
     // Gets a sequence using its index inside the chunk.
     void GetSequence(size_t sequenceIdx, std::vector<SequenceDataPtr>& result) override
     {
@@ -54,11 +66,13 @@ protected:
     {
         m_data.resize(m_deserializers.size());
 
+        const byte* data = m_view ? (const byte*)m_view->Data() : m_buffer.get();
+
         // the number of bytes of buffer that have been processed by the deserializer so far
         size_t bytesProcessed = 0;
         // Now call all of the deserializers on the chunk, in order
         for (size_t i = 0; i < m_deserializers.size(); i++)
-            bytesProcessed += m_deserializers[i]->GetSequenceDataForChunk(m_numSequences, m_buffer.get() + bytesProcessed, m_data[i]);
+            bytesProcessed += m_deserializers[i]->GetSequenceDataForChunk(m_numSequences, data + bytesProcessed, m_data[i]);
     }
 
     // chunk id (copied from the descriptor)
@@ -71,6 +85,9 @@ protected:
     // This is the actual chunk read from disk. We will call back to the deserializer for it to be deserialized
     unique_ptr<byte[]> m_buffer;
 
+    // Alternatively, the chunk mapped from the input file.
+    MemoryMappedViewPtr m_view;
+
     // This is the deserializer who knows how to interpret the m_data chunk that we read in
     std::vector<BinaryDataDeserializerPtr> m_deserializers;
     
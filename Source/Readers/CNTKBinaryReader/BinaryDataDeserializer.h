@@ -35,7 +35,7 @@ public:
         m_precision = precision;
     }
 
-    virtual size_t GetSequenceDataForChunk(size_t numSequences, void* data, std::vector<SequenceDataPtr>& result) = 0;
+    virtual size_t GetSequenceDataForChunk(size_t numSequences, const void* data, std::vector<SequenceDataPtr>& result) = 0;
 
     virtual StorageFormat GetStorageFormat() = 0;
 
@@ -111,7 +111,7 @@ protected:
             return m_sampleShape;
         }
 
-        void* m_data;
+        const void* m_data;
         DataType m_dataType;
         NDShape m_sampleShape;
     };
@@ -133,7 +133,7 @@ protected:
             return m_sampleShape;
         }
 
-        void* m_data;
+        const void* m_data;
         NDShape m_sampleShape;
     };
 
@@ -152,7 +152,7 @@ public:
 
     virtual  StorageFormat GetStorageFormat() override { return StorageFormat::Dense; }
 
-    size_t GetSequenceDataForChunk(size_t numSequences, void* data, std::vector<SequenceDataPtr>& result)
+    size_t GetSequenceDataForChunk(size_t numSequences, const void* data, std::vector<SequenceDataPtr>& result)
     {
         size_t valueSize = SizeOfDataType();
         result.resize(numSequences);
@@ -160,9 +160,9 @@ public:
         for (size_t i = 0; i < numSequences; i++)
         {
             shared_ptr<DenseInputStreamBuffer> sequenceDataPtr = make_shared<DenseInputStreamBuffer>();
-            sequenceDataPtr->m_numberOfSamples = *(uint32_t*)((char*)data + offset);
+            sequenceDataPtr->m_numberOfSamples = *(const uint32_t*)((const char*)data + offset);
             offset += sizeof(uint32_t);
-            sequenceDataPtr->m_data = (char*)data + offset;
+            sequenceDataPtr->m_data = (const char*)data + offset;
             sequenceDataPtr->m_sampleShape = GetSampleShape();
             sequenceDataPtr->m_elementType = m_precision;
             result[i]  = sequenceDataPtr;
@@ -194,14 +194,14 @@ public:
     //   ElemType[nnz]: the values for the sparse sequences
     //   int32_t[nnz]: the row offsets for the sparse sequences
     //   int32_t[numSamples]: sizes (nnz counts) for each sample in the sequence
-    size_t GetSequenceDataForChunk(size_t numSequences, void* data, std::vector<SequenceDataPtr>& result)
+    size_t GetSequenceDataForChunk(size_t numSequences, const void* data, std::vector<SequenceDataPtr>& result)
     {
         size_t offset = 0;
         result.resize(numSequences);
         for (size_t i = 0; i < numSequences; i++)
         {
             shared_ptr<SparseInputStreamBuffer> sequenceDataPtr = make_shared<SparseInputStreamBuffer>();
-            offset += GetSequenceData((char*)data + offset, sequenceDataPtr);
+            offset += GetSequenceData((const char*)data + offset, sequenceDataPtr);
             sequenceDataPtr->m_sampleShape = GetSampleShape();
             sequenceDataPtr->m_elementType = m_precision;
             result[i] = sequenceDataPtr;
@@ -210,17 +210,17 @@ public:
         return offset;
     }
 
-    size_t GetSequenceData(void* data, shared_ptr<SparseInputStreamBuffer>& sequence)
+    size_t GetSequenceData(const void* data, shared_ptr<SparseInputStreamBuffer>& sequence)
     {
         size_t valueSize = SizeOfDataType();
         size_t offset = 0;
 
         // The very first value in the buffer is the number of samples in this sequence.
-        sequence->m_numberOfSamples = *(uint32_t*)data;
+        sequence->m_numberOfSamples = *(const uint32_t*)data;
         offset += sizeof(uint32_t);
 
         // Next is the total number of elements in all of the samples.
-        uint32_t nnz = *(uint32_t*)((char*)data + offset);
+        uint32_t nnz = *(const uint32_t*)((const char*)data + offset);
         if (IndexType(nnz) < 0) 
         {
             RuntimeError("NNZ count is too large for an IndexType value.");
@@ -232,16 +232,16 @@ public:
         // Since we're not templating on ElemType, we use void for the values. Note that this is the only place
         // this deserializer uses ElemType, the rest are int32_t for this deserializer.
         // The data is already properly packed, so just use it.
-        sequence->m_data = (char*)data + offset;
+        sequence->m_data = (const char*)data + offset;
         offset += valueSize * sequence->m_totalNnzCount;
 
         // The indices are supposed to be correctly packed (i.e., in increasing order)
-        sequence->m_indices = (int32_t*)((char*)data + offset);
+        sequence->m_indices = (const int32_t*)((const char*)data + offset);
         offset += sizeof(int32_t) * sequence->m_totalNnzCount;
         
-        int32_t* begin = (int32_t*)((char*)data + offset);
+        const int32_t* begin = (const int32_t*)((const char*)data + offset);
         offset += sizeof(int32_t) * sequence->m_numberOfSamples;
-        int32_t* end = (int32_t*)((char*)data + offset);
+        const int32_t* end = (const int32_t*)((const char*)data + offset);
         
         sequence->m_nnzCounts.reserve(sequence->m_numberOfSamples);
         sequence->m_nnzCounts.assign(begin, end);
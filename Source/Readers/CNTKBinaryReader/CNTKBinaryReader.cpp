@@ -33,7 +33,8 @@ CNTKBinaryReader::CNTKBinaryReader(const ConfigParameters& config)
 
         if (configHelper.ShouldKeepDataInMemory())
         {
-            m_deserializer = shared_ptr<DataDeserializer>(new ChunkCache(m_deserializer));
+            m_deserializer = shared_ptr<DataDeserializer>(new ChunkCache(m_deserializer, configHelper.GetChunkCacheSize(),
+                                                                         configHelper.GetChunkCacheSpillFile(), configHelper.GetTraceLevel()));
             log << " | keeping data in memory";
         }
 
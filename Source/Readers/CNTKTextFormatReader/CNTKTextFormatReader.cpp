@@ -35,7 +35,8 @@ CNTKTextFormatReader::CNTKTextFormatReader(const ConfigParameters& config)
             m_deserializer = make_shared<TextParser<double>>(corpus, configHelper, true);
 
         if (configHelper.ShouldKeepDataInMemory())
-            m_deserializer = make_shared<ChunkCache>(m_deserializer);
+            m_deserializer = make_shared<ChunkCache>(m_deserializer, configHelper.GetChunkCacheSize(),
+                                                     configHelper.GetChunkCacheSpillFile(), configHelper.GetTraceLevel());
 
         size_t window = configHelper.GetRandomizationWindow();
         if (window > 0)
@@ -39,8 +39,17 @@ public:
 
     size_t GetChunkSize() const { return m_chunkSizeBytes; }
 
+    // Maximum number of threads building the index, 0 - number of hardware threads.
+    size_t GetNumIndexingThreads() const { return m_numIndexingThreads; }
+
     bool ShouldKeepDataInMemory() const { return m_keepDataInMemory; }
 
+    // Memory budget of the chunk cache, 0 - no limit.
+    size_t GetChunkCacheSize() const { return m_chunkCacheSizeBytes; }
+
+    // File to spill cached chunks to, empty - no spilling.
+    const wstring& GetChunkCacheSpillFile() const { return m_chunkCacheSpillFile; }
+
     bool IsInFrameMode() const { return m_frameMode; }
 
     DataType GetDataType() const { return m_elementType; }
@@ -59,7 +68,10 @@ private:
     unsigned int m_maxErrors;
     unsigned int m_traceLevel;
     size_t m_chunkSizeBytes; // chunks size in bytes
+    size_t m_numIndexingThreads; // number of threads scanning the input file while building the index
     bool m_keepDataInMemory; // if true the whole dataset is kept in memory
+    size_t m_chunkCacheSizeBytes; // if not 0, chunks are cached in memory up to this size (implies m_keepDataInMemory)
+    std::wstring m_chunkCacheSpillFile; // if not empty, chunks evicted from the cache are reloaded from this file
     bool m_frameMode; // if true, the maximum expected sequence length in the dataset is one sample.
     bool m_cacheIndex; // When true, the index will be loaded from a cache file it if exists.
                        // If cache does not exist, the index, once created, will be written out to a file.
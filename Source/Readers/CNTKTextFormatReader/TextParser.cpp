@@ -13,6 +13,11 @@
 #include "TextReaderConstants.h"
 #include "File.h"
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CTF_USE_SSE2
+#endif
+
 #define isSign(c) ((c == '-' || c == '+'))
 #define isE(c) ((c == 'e' || c == 'E'))
 
@@ -37,6 +42,221 @@ enum State
     Exponent
 };
 
+// Helpers for the bulk parser (see TextParser::TryParseSequenceInBulk), which works on a contiguous
+// buffer where every row is terminated by a ROW_DELIMITER, so that no bounds checks are needed
+// while looking for the end of a number or an index.
+
+// Returns the first position in [p, end) that terminates the list of values of a sample
+// (a name prefix or a non-printable character other than a tab), or end if there is none.
+inline const char* FindEndOfSample(const char* p, const char* end)
+{
+#ifdef CTF_USE_SSE2
+    const __m128i prefix = _mm_set1_epi8(NAME_PREFIX);
+    const __m128i space = _mm_set1_epi8(SPACE_CHAR);
+    const __m128i tab = _mm_set1_epi8(TAB_CHAR);
+    for (; p + sizeof(__m128i) <= end; p += sizeof(__m128i))
+    {
+        __m128i chars = _mm_loadu_si128((const __m128i*)p);
+        // signed comparison, same as isNonPrintable() for a (signed) char
+        __m128i nonPrintable = _mm_andnot_si128(_mm_cmpeq_epi8(chars, tab), _mm_cmplt_epi8(chars, space));
+        int mask = _mm_movemask_epi8(_mm_or_si128(nonPrintable, _mm_cmpeq_epi8(chars, prefix)));
+        if (mask != 0)
+        {
+            for (; !(*p == NAME_PREFIX || (isNonPrintable(*p) && *p != TAB_CHAR)); ++p);
+            return p;
+        }
+    }
+#endif
+    for (; p < end; ++p)
+    {
+        if (*p == NAME_PREFIX || (isNonPrintable(*p) && *p != TAB_CHAR))
+            return p;
+    }
+    return end;
+}
+
+// Returns the first position in [p, end) with a name prefix, or end if there is none.
+inline const char* FindNamePrefix(const char* p, const char* end)
+{
+    auto found = (const char*)memchr(p, NAME_PREFIX, end - p);
+    return found ? found : end;
+}
+
+// Exact powers of 10, as long as the number of digits is small enough for all integers to be exact in a double.
+static const size_t MaxExactDigits = 15;
+static const double PowersOf10[MaxExactDigits + 1] = 
+{ 
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 
+};
+
+// Parses a floating point number starting at p and moves p past it. Returns false if there is
+// no valid number at p, in which case p is not moved.
+// Digits are accumulated in integers, otherwise the arithmetic is the same as in TryReadRealNumber,
+// so that both produce identical values: up to MaxExactDigits digits the accumulated doubles are exact there, too.
+template <class ElemType>
+inline bool TryParseRealNumber(const char*& p, ElemType& value)
+{
+    const char* s = p;
+    bool negative = false;
+    if (isSign(*s))
+    {
+        negative = (*s == '-');
+        ++s;
+    }
+
+    if (!IsDigit(*s))
+        return false;
+
+    uint64_t digits = 0;
+    size_t count = 0;
+    for (; IsDigit(*s) && count < MaxExactDigits; ++s, ++count)
+        digits = digits * 10 + (*s - '0');
+
+    double number = (double)digits;
+    for (; IsDigit(*s); ++s)
+        number = number * 10 + (*s - '0');
+
+    double coefficient = number;
+    if (*s == '.')
+    {
+        ++s;
+        if (IsDigit(*s))
+        {
+            digits = 0;
+            count = 0;
+            for (; IsDigit(*s) && count < MaxExactDigits; ++s, ++count)
+                digits = digits * 10 + (*s - '0');
+
+            double fraction = (double)digits, divider = PowersOf10[count];
+            for (; IsDigit(*s); ++s)
+            {
+                fraction = fraction * 10 + (*s - '0');
+                divider *= 10;
+            }
+
+            coefficient += (fraction / divider);
+            if (isE(*s))
+            {
+                ++s;
+                if (negative)
+                    coefficient = -coefficient;
+            }
+            else
+            {
+                value = static_cast<ElemType>((negative) ? -coefficient : coefficient);
+                p = s;
+                return true;
+            }
+        }
+        else
+        {
+            // a period not followed by a digit ends the number.
+            value = static_cast<ElemType>((negative) ? -number : number);
+            p = s;
+            return true;
+        }
+    }
+    else if (isE(*s))
+    {
+        ++s;
+        coefficient = (negative) ? -number : number;
+    }
+    else
+    {
+        value = static_cast<ElemType>((negative) ? -number : number);
+        p = s;
+        return true;
+    }
+
+    // exponent: optional sign, followed by a non-empty sequence of digits
+    negative = false;
+    if (isSign(*s))
+    {
+        negative = (*s == '-');
+        ++s;
+    }
+
+    if (!IsDigit(*s))
+        return false;
+
+    number = 0;
+    for (; IsDigit(*s); ++s)
+        number = number * 10 + (*s - '0');
+
+    double exponent = (negative) ? -number : number;
+    value = static_cast<ElemType>(coefficient * pow(10.0, exponent));
+    p = s;
+    return true;
+}
+
+// Parses the values of a dense sample in [p, end) and appends them to the provided vector.
+// Returns false if the sample is malformed or has a different size.
+template <class ElemType>
+inline bool TryParseDenseSample(const char* p, const char* end, std::vector<ElemType>& values, size_t sampleSize)
+{
+    size_t size = values.size();
+    values.resize(size + sampleSize);
+    ElemType* data = values.data() + size;
+    size_t counter = 0;
+    while (p < end)
+    {
+        if (isValueDelimiter(*p))
+        {
+            ++p;
+            continue;
+        }
+
+        if (counter == sampleSize || !TryParseRealNumber(p, data[counter]))
+            return false;
+
+        ++counter;
+        if (p < end && !isValueDelimiter(*p))
+            return false;
+    }
+
+    return counter == sampleSize;
+}
+
+// Parses the index:value pairs of a sparse sample in [p, end) and appends them to the provided vectors.
+// Returns false if the sample is malformed or an index is out of range.
+template <class ElemType>
+inline bool TryParseSparseSample(const char* p, const char* end, std::vector<ElemType>& values,
+    std::vector<SparseIndexType>& indices, size_t sampleSize)
+{
+    while (p < end)
+    {
+        if (isValueDelimiter(*p))
+        {
+            ++p;
+            continue;
+        }
+
+        if (!IsDigit(*p))
+            return false;
+
+        // A sample size always fits into 19 digits, longer indices are out of range or overflow.
+        size_t index = 0, count = 0;
+        for (; IsDigit(*p) && count < 19; ++p, ++count)
+            index = index * 10 + (*p - '0');
+
+        if (IsDigit(*p) || index >= sampleSize || *p != INDEX_DELIMITER)
+            return false;
+
+        ++p;
+        ElemType value;
+        if (!TryParseRealNumber(p, value))
+            return false;
+
+        if (p < end && !isValueDelimiter(*p))
+            return false;
+
+        values.push_back(value);
+        indices.push_back(static_cast<SparseIndexType>(index));
+    }
+
+    return true;
+}
+
 template <class ElemType>
 class TextParser<ElemType>::TextDataChunk : public Chunk, public std::enable_shared_from_this<Chunk>
 {
@@ -68,6 +288,7 @@ TextParser(corpus, helper.GetFilePath(), helper.GetStreams(), primary)
     SetTraceLevel(helper.GetTraceLevel());
     SetMaxAllowedErrors(helper.GetMaxAllowedErrors());
     SetChunkSize(helper.GetChunkSize());
+    SetNumIndexingThreads(helper.GetNumIndexingThreads());
     SetSkipSequenceIds(helper.ShouldSkipSequenceIds());
 
     SetCacheIndex(helper.ShouldCacheIndex());
@@ -86,6 +307,7 @@ TextParser<ElemType>::TextParser(CorpusDescriptorPtr corpus, const std::wstring&
     m_streamInfos(streams.size()),
     m_index(nullptr),
     m_chunkSizeBytes(0),
+    m_numIndexingThreads(0),
     m_traceLevel(TraceLevel::Error),
     m_hadWarnings(false),
     m_numAllowedErrors(0),
@@ -93,7 +315,8 @@ TextParser<ElemType>::TextParser(CorpusDescriptorPtr corpus, const std::wstring&
     m_numRetries(5),
     m_corpus(corpus),
     m_useMaximumAsSequenceLength(true),
-    m_cacheIndex(false)
+    m_cacheIndex(false),
+    m_bulkParsing(true)
 {
     assert(streams.size() > 0);
 
@@ -187,7 +410,9 @@ void TextParser<ElemType>::Initialize()
             .SetCorpus(m_corpus)
             .SetPrimary(m_primary)
             .SetChunkSize(m_chunkSizeBytes)
-            .SetCachingEnabled(m_cacheIndex);
+            .SetCachingEnabled(m_cacheIndex)
+            .SetNumberOfThreads(m_numIndexingThreads)
+            .SetVerbosity(m_traceLevel >= Info);
 
         if (!m_useMaximumAsSequenceLength)
         {
@@ -311,23 +536,19 @@ typename TextParser<ElemType>::SequenceBuffer TextParser<ElemType>::LoadSequence
 
     size_t bytesToRead = sequenceDsc.SizeInBytes();
 
-    SequenceBuffer sequence;
+    SequenceBuffer sequence = CreateSequenceBuffer(sequenceDsc);
 
-    // TODO: reuse loaded sequences instead of creating new ones!
-    for (auto const & stream : m_streamInfos)
+    size_t numRowsRead = 0, expectedRowCount = sequenceDsc.m_numberOfSamples;
+    if (m_bulkParsing && TryParseSequenceInBulk(sequence, bytesToRead, numRowsRead))
     {
-        if (stream.m_type == StorageFormat::Dense)
-        {
-            sequence.push_back(make_unique<DenseInputStreamBuffer>(
-                stream.m_sampleShape.Dimensions()[0] * sequenceDsc.m_numberOfSamples, stream.m_sampleShape));
-        }
-        else
-        {
-            sequence.push_back(make_unique<SparseInputStreamBuffer>(stream.m_sampleShape));
-        }
+        bytesToRead = 0;
+    }
+    else if (m_bulkParsing)
+    {
+        // Start over with the character-wise parser, which reports the problem.
+        sequence = CreateSequenceBuffer(sequenceDsc);
     }
 
-    size_t numRowsRead = 0, expectedRowCount = sequenceDsc.m_numberOfSamples;
     size_t rowNumber = 1;
     while(bytesToRead)
     {
@@ -433,6 +654,129 @@ typename TextParser<ElemType>::SequenceBuffer TextParser<ElemType>::LoadSequence
     return sequence;
 }
 
+template <class ElemType>
+typename TextParser<ElemType>::SequenceBuffer TextParser<ElemType>::CreateSequenceBuffer(const SequenceDescriptor& sequenceDsc)
+{
+    SequenceBuffer sequence;
+
+    // TODO: reuse loaded sequences instead of creating new ones!
+    for (auto const & stream : m_streamInfos)
+    {
+        if (stream.m_type == StorageFormat::Dense)
+        {
+            sequence.push_back(make_unique<DenseInputStreamBuffer>(
+                stream.m_sampleShape.Dimensions()[0] * sequenceDsc.m_numberOfSamples, stream.m_sampleShape));
+        }
+        else
+        {
+            sequence.push_back(make_unique<SparseInputStreamBuffer>(stream.m_sampleShape));
+        }
+    }
+
+    return sequence;
+}
+
+template <class ElemType>
+bool TextParser<ElemType>::TryParseSequenceInBulk(SequenceBuffer& sequence, size_t bytesToRead, size_t& numRowsRead)
+{
+    const char* p = m_fileReader->TryGetBlock(bytesToRead);
+    if (p == nullptr)
+        return false;
+
+    const char* end = p + bytesToRead;
+    size_t numRows = 0;
+    while (p < end)
+    {
+        // Every row must be terminated by a row delimiter (otherwise the trailing newline is missing).
+        auto rowEnd = (const char*)memchr(p, ROW_DELIMITER, end - p);
+        if (rowEnd == nullptr)
+            return false;
+
+        // skip sequence ids
+        for (; IsDigit(*p); ++p);
+
+        size_t numSampleRead = 0;
+        while (p < rowEnd)
+        {
+            if (isColumnDelimiter(*p))
+            {
+                ++p;
+                continue;
+            }
+
+            if (*p != NAME_PREFIX)
+                return false;
+            ++p;
+
+            if (*p == ESCAPE_SYMBOL)
+            {
+                // skip the escaped part until the next input or the end of row.
+                p = FindNamePrefix(p + 1, rowEnd);
+                continue;
+            }
+
+            auto nameEnd = p;
+            for (; !(isValueDelimiter(*nameEnd) || *nameEnd == NAME_PREFIX || isNonPrintable(*nameEnd)); ++nameEnd);
+
+            size_t nameLength = nameEnd - p, id = 0;
+            if (nameLength == 0)
+                return false;
+
+            for (; id < m_streamDescriptors.size(); ++id)
+            {
+                const auto& alias = m_streamDescriptors[id].m_alias;
+                if (alias.length() == nameLength && memcmp(alias.data(), p, nameLength) == 0)
+                    break;
+            }
+
+            if (id == m_streamDescriptors.size())
+            {
+                // Unknown inputs are skipped, unless they have to be reported.
+                if (m_traceLevel >= Info)
+                    return false;
+
+                p = FindNamePrefix(nameEnd, rowEnd);
+                continue;
+            }
+
+            p = nameEnd;
+            auto sampleEnd = FindEndOfSample(p, rowEnd);
+            const StreamInfo& stream = m_streamInfos[id];
+            if (stream.m_type == StorageFormat::Dense)
+            {
+                auto data = static_cast<DenseInputStreamBuffer*>(sequence[id].get());
+                if (!TryParseDenseSample(p, sampleEnd, data->m_buffer, stream.m_sampleShape.Dimensions()[0]))
+                    return false;
+                ++data->m_numberOfSamples;
+            }
+            else
+            {
+                auto data = static_cast<SparseInputStreamBuffer*>(sequence[id].get());
+                size_t size = data->m_buffer.size();
+                if (!TryParseSparseSample(p, sampleEnd, data->m_buffer, data->m_indicesBuffer, stream.m_sampleShape.Dimensions()[0]))
+                    return false;
+                ++data->m_numberOfSamples;
+                SparseIndexType count = static_cast<SparseIndexType>(data->m_buffer.size() - size);
+                data->m_nnzCounts.push_back(count);
+                data->m_totalNnzCount += count;
+            }
+
+            p = sampleEnd;
+            ++numSampleRead;
+        }
+
+        if (numSampleRead == 0 || numSampleRead > m_streams.size())
+            return false;
+
+        p = rowEnd + 1;
+        ++numRows;
+    }
+
+    m_fileReader->Skip(bytesToRead, numRows);
+    numRowsRead = numRows;
+    return true;
+}
+
 template<class ElemType>
 void TextParser<ElemType>::FillSequenceMetadata(SequenceBuffer& sequenceData, const SequenceKey& sequenceKey)
 {
@@ -1220,6 +1564,12 @@ void TextParser<ElemType>::SetChunkSize(size_t size)
     m_chunkSizeBytes = size;
 }
 
+template <class ElemType>
+void TextParser<ElemType>::SetNumIndexingThreads(size_t numThreads)
+{
+    m_numIndexingThreads = numThreads;
+}
+
 template <class ElemType>
 void TextParser<ElemType>::SetNumRetries(unsigned int numRetries)
 {
@@ -1232,6 +1582,12 @@ void TextParser<ElemType>::SetCacheIndex(bool value)
     m_cacheIndex = value;
 }
 
+template <class ElemType>
+void TextParser<ElemType>::SetBulkParsing(bool value)
+{
+    m_bulkParsing = value;
+}
+
 template<class ElemType>
 inline bool TextParser<ElemType>::CanRead()
 {
@@ -128,11 +128,13 @@ private:
     bool m_useMaximumAsSequenceLength;
 
     size_t m_chunkSizeBytes;
+    size_t m_numIndexingThreads;
     unsigned int m_traceLevel;
     bool m_hadWarnings;
     unsigned int m_numAllowedErrors;
     bool m_skipSequenceIds;
     bool m_cacheIndex;
+    bool m_bulkParsing; // when true, well-formed sequences are parsed directly from the file buffer.
     unsigned int m_numRetries; // specifies the number of times an unsuccessful
                                // file operation should be repeated (default value is 5).
 
@@ -181,6 +183,14 @@ private:
     // Returns true if the trace level is greater or equal to 'Warning'
     bool inline ShouldWarn() { m_hadWarnings = true; return m_traceLevel >= Warning; }
 
+    // Tries to parse the whole sequence directly from the file buffer, bypassing the character-wise
+    // parser above. Bails out (returning false without moving the file position) on anything that
+    // the character-wise parser would warn about, so that it can start over and report the problem.
+    bool TryParseSequenceInBulk(SequenceBuffer& sequence, size_t bytesToRead, size_t& numRowsRead);
+
+    // Creates empty stream buffers for the given sequence.
+    SequenceBuffer CreateSequenceBuffer(const SequenceDescriptor& descriptor);
+
     // Given a descriptor and the file offset of the containing chunk,
     // retrieves the data for the corresponding sequence from the file.
     SequenceBuffer LoadSequence(const SequenceDescriptor& descriptor, size_t chunkOffset);
@@ -199,10 +209,14 @@ private:
 
     void SetChunkSize(size_t size);
 
+    void SetNumIndexingThreads(size_t numThreads);
+
     void SetNumRetries(unsigned int numRetries);
 
     void SetCacheIndex(bool value);
 
+    void SetBulkParsing(bool value);
+
     friend class CNTKTextFormatReaderTestRunner<ElemType>;
 
     DISABLE_COPY_AND_MOVE(TextParser);
@@ -14,6 +14,7 @@
 #include "CompositeDataReader.h"
 #include "Bundler.h"
 #include "BlockRandomizer.h"
+#include "ChunkCache.h"
 #include "NoRandomizer.h"
 #include "FramePacker.h"
 #include "SequencePacker.h"
@@ -164,8 +165,17 @@ CompositeDataReader::CompositeDataReader(const ConfigParameters& config) :
             }
 
             bool shouldPrefetch = true;
+
+            // Number of chunks loaded ahead of the randomization window, the number of concurrent chunk loads
+            // (only deserializers that support concurrent GetChunk() calls can use more than one) and
+            // the memory budget for the prefetched chunks (0 - no limit).
+            size_t prefetchDepth = config(L"prefetchDepth", (size_t)1);
+            size_t prefetchThreads = config(L"prefetchThreads", (size_t)1);
+            size_t prefetchBudgetInBytes = config(L"prefetchBudgetInBytes", (size_t)0);
+
             m_sequenceEnumerator = std::make_shared<BlockRandomizer>(verbosity, randomizationWindow, deserializer, shouldPrefetch,
-                multiThreadedDeserialization, maxErrors, sampleBasedRandomizationWindow, GetRandomSeed(config));
+                multiThreadedDeserialization, maxErrors, sampleBasedRandomizationWindow, GetRandomSeed(config),
+                prefetchDepth, prefetchThreads, prefetchBudgetInBytes);
         }
         else
             m_sequenceEnumerator = std::make_shared<NoRandomizer>(deserializer, multiThreadedDeserialization, maxErrors);
@@ -278,6 +288,23 @@ DataDeserializerPtr CompositeDataReader::CreateDeserializer(const ConfigParamete
         RuntimeError("Cannot create deserializer. Please check module and type in the configuration.");
     }
 
+    // Optionally cache the deserialized chunks up to the given size in memory (and spill them to a local file),
+    // so that subsequent sweeps do not have to deserialize them again. Cache statistics are printed with traceLevel >= 2.
+    // Chunks of the image deserializer only hold the paths of the images and decode them on every access,
+    // so caching them would not save any work.
+    size_t chunkCacheSize = deserializerConfig(L"chunkCacheSizeInBytes", (size_t)0);
+    unsigned int traceLevel = deserializerConfig(L"traceLevel", 1);
+    if (chunkCacheSize != 0 && deserializerType == L"ImageDeserializer")
+    {
+        if (traceLevel >= 1)
+            fprintf(stderr, "WARNING: chunkCacheSizeInBytes is ignored for the ImageDeserializer, its chunks are decoded on every access.\n");
+    }
+    else if (chunkCacheSize != 0)
+    {
+        std::wstring spillFile = deserializerConfig(L"chunkCacheSpillFile", L"");
+        d = std::make_shared<ChunkCache>(d, chunkCacheSize, spillFile, traceLevel);
+    }
+
     // Create transformers if necessary.
     CreateTransforms(deserializerConfig);
 
@@ -139,12 +139,21 @@ public:
             htkfeatreader reader;
 
             // read all utterances; if they are in the same archive, htkfeatreader will be efficient in not closing the file
+            // Runs of utterances that are stored back to back in the same archive (e.g. in archives written
+            // per chunk by Scripts/htk2pack.py) are read with a single read into the consecutive chunk frames.
             m_frames.resize(featureDimension, m_totalFrames);
-            foreach_index(i, m_utterances)
+            size_t numUtterances = m_utterances.size();
+            for (size_t i = 0; i < numUtterances;)
             {
-                // read features for this file
-                auto framesWrapper = GetUtteranceFrames(i);
-                reader.read(m_utterances[i].GetPath(), featureKind, samplePeriod, framesWrapper);
+                htkfeatreader::parsedpath path = m_utterances[i].GetPath();
+                size_t end = i + 1;
+                while (end < numUtterances && IsContinuation(path, m_utterances[end].GetPath()))
+                    path.e = m_utterances[end++].GetPath().e;
+
+                // read features for this run of utterances
+                msra::dbn::matrixstripe framesWrapper(m_frames, m_firstFrames[i], path.numframes());
+                reader.read(path, featureKind, samplePeriod, framesWrapper);
+                i = end;
             }
 
             if (verbosity)
@@ -190,6 +199,15 @@ public:
         m_frames.resize(0, 0);
     }
 
+    // Tests if 'next' starts at the frame right after the end of 'current' in the same archive,
+    // so that both can be read with a single read.
+    static bool IsContinuation(const htkfeatreader::parsedpath& current, const htkfeatreader::parsedpath& next)
+    {
+        return current.isarchive && next.isarchive && !current.isidxformat && !next.isidxformat &&
+               current.archivePathIdx == next.archivePathIdx &&
+               current.e != UINT_MAX && next.s == current.e + 1;
+    }
+
     private:
         // test if data is in memory at the moment
         bool IsInRam() const
@@ -179,6 +179,8 @@ class htkfeatreader : protected htkfeatio
     size_t curframe;                     // current # samples read so far
     size_t numframes;                    // number of samples for current logical file
     size_t energyElements;               // how many energy elements to add if addEnergy is true
+    vector<char> bulkbuffer;             // raw frames of a bulk read
+    vector<float> bulkframes;            // decoded frames of a bulk read, featdim values per frame
 
 public:
     // parser for complex a=b[s,e] syntax
@@ -508,10 +510,72 @@ public:
         }
         curframe++;
     }
+    // read frames [curframe, curframe + n) from the open file with a single read, and decode them into bulkframes
+    // Byte swapping and decompression run over the whole block in flat loops the compiler can vectorize.
+    void readbulk(size_t n)
+    {
+        if (curframe + n > numframes)
+            RuntimeError("htkfeatreader:attempted to read beyond end");
+        const size_t numvalues = n * featdim;
+        bulkbuffer.resize(n * vecbytesize);
+        if (n > 0)
+            freadOrDie(bulkbuffer.data(), vecbytesize, n, f);
+        bulkframes.resize(numvalues);
+        float* out = bulkframes.data();
+        if (isidxformat)
+        {
+            const unsigned char* in = (const unsigned char*)bulkbuffer.data();
+            for (size_t i = 0; i < numvalues; i++)
+                out[i] = (float)in[i];
+        }
+        else if (!compressed)
+        {
+            uint32_t* in = (uint32_t*)bulkbuffer.data();
+            if (needbyteswapping)
+            {
+                for (size_t i = 0; i < numvalues; i++)
+                {
+                    const uint32_t v = in[i];
+                    in[i] = (v >> 24) | ((v >> 8) & 0xff00u) | ((v << 8) & 0xff0000u) | (v << 24);
+                }
+            }
+            memcpy(out, in, numvalues * sizeof(float));
+        }
+        else // need to decompress
+        {
+            uint16_t* in = (uint16_t*)bulkbuffer.data();
+            if (needbyteswapping)
+            {
+                for (size_t i = 0; i < numvalues; i++)
+                    in[i] = (uint16_t)((in[i] >> 8) | (in[i] << 8));
+            }
+            const float* pa = a.data();
+            const float* pb = b.data();
+            for (size_t t = 0; t < n; t++)
+            {
+                const int16_t* src = (const int16_t*)in + t * featdim;
+                float* dst = out + t * featdim;
+                for (size_t k = 0; k < featdim; k++)
+                    dst[k] = (src[k] + pb[k]) / pa[k];
+            }
+        }
+        curframe += n;
+    }
+
     // read a sequence of vectors from the open file into a range of frames [ts,te)
     template <class MATRIX>
     void read(MATRIX& feat, size_t ts, size_t te)
     {
+        if (!addEnergy) // read all frames at once
+        {
+            readbulk(te - ts);
+            const float* v = bulkframes.data();
+            for (size_t t = ts; t < te; t++, v += featdim)
+                for (size_t k = 0; k < featdim; k++)
+                    feat(k, t) = v[k];
+            return;
+        }
+
         // read vectors from file and push to our target structure
         vector<float> v(featdim + energyElements);
         for (size_t t = ts; t < te; t++)
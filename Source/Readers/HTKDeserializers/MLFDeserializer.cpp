@@ -324,6 +324,8 @@ MLFDeserializer::MLFDeserializer(CorpusDescriptorPtr corpus, const ConfigParamet
     // Same behavior as for the old deserializer - keep almost all in memory,
     // because there are a lot of none aligned sets.
     m_chunkSizeBytes = cfg(L"chunkSizeInBytes", g_64MB);
+    m_numIndexingThreads = cfg(L"numIndexingThreads", (size_t)0);
+    m_verbosity = cfg(L"verbosity", 0);
 
     ConfigParameters input = cfg("input");
     auto inputName = input.GetMemberIds().front();
@@ -368,6 +370,8 @@ MLFDeserializer::MLFDeserializer(CorpusDescriptorPtr corpus, const ConfigParamet
     // Same behavior as for the old deserializer - keep almost all in memory,
     // because there are a lot of none aligned sets.
     m_chunkSizeBytes = labelConfig(L"chunkSizeInBytes", g_64MB);
+    m_numIndexingThreads = labelConfig(L"numIndexingThreads", (size_t)0);
+    m_verbosity = labelConfig(L"verbosity", 0);
 
     wstring precision = labelConfig(L"precision", L"float");;
     m_elementType = AreEqualIgnoreCase(precision, L"float") ? DataType::Float : DataType::Double;
@@ -405,7 +409,10 @@ void MLFDeserializer::InitializeChunkInfos(CorpusDescriptorPtr corpus, const Con
         attempt(5, [this, path, enableCaching, corpus]()
         {
             MLFIndexBuilder builder(FileWrapper(path, L"rbS"), corpus);
-            builder.SetChunkSize(m_chunkSizeBytes).SetCachingEnabled(enableCaching);
+            builder.SetChunkSize(m_chunkSizeBytes)
+                .SetCachingEnabled(enableCaching)
+                .SetNumberOfThreads(m_numIndexingThreads)
+                .SetVerbosity(m_verbosity);
             m_indices.emplace_back(builder.Build());
         });
 
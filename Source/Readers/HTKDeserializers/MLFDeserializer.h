@@ -76,6 +76,10 @@ private:
     size_t m_dimension;
     size_t m_chunkSizeBytes;
 
+    // Maximum number of threads building the index of an MLF file, 0 - number of hardware threads.
+    size_t m_numIndexingThreads;
+    int m_verbosity;
+
     // Track phone boundaries
     bool m_withPhoneBoundaries;
 
@@ -53,28 +53,49 @@ namespace CNTK {
     {
         m_input.CheckIsOpenOrDie();
 
-        index->Reserve(filesize(m_input.File()));
+        size_t fileSize = filesize(m_input.File());
+        index->Reserve(fileSize);
 
-        BufferedFileReader reader(m_bufferSize, m_input);
-
-        if (reader.Empty())
+        if (BufferedFileReader(m_bufferSize, m_input).Empty())
             RuntimeError("Input file is empty");
    
         if (!m_corpus)
             RuntimeError("MLFIndexBuilder: corpus descriptor was not specified.");
 
+        PopulateInParallel(index, 0, fileSize, 0);
+    }
 
-        size_t id = 0;
-        State currentState = State::Header;
+    // An utterance ends with a single dot on a line, so the next one starts right after it.
+    /*virtual*/ size_t MLFIndexBuilder::FindSequenceBoundary(BufferedFileReader& reader, size_t end) /*override*/
+    {
+        string line;
+        while (reader.GetFileOffset() < end && reader.TryReadLine(line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+
+            if (line == ".")
+                return min(reader.GetFileOffset(), end);
+        }
+
+        return end;
+    }
+
+    /*virtual*/ void MLFIndexBuilder::IndexRange(BufferedFileReader& reader, size_t end, bool first, IndexedRange& range) /*override*/
+    {
+        // Only the first range starts with the MLF header, others start at an utterance.
+        State currentState = first ? State::Header : State::UtteranceKey;
         vector<boost::iterator_range<char*>> tokens;
         bool isValid = true; // Flag indicating whether the current sequence is valid.
         size_t sequenceStartOffset = 0; // Offset in file where current sequence starts.
         string lastNonEmptyLine; // Needed to parse information about last frame
         IndexedSequence sequence;
-        string line;
+        string line, key;
         while (true)
         {
             auto offset = reader.GetFileOffset();
+            if (offset >= end)
+                break;
 
             if (!reader.TryReadLine(line))
                 break;
@@ -104,7 +125,9 @@ namespace CNTK {
                 lastNonEmptyLine.clear();
 
                 sequenceStartOffset = offset;
-                isValid = TryParseSequenceKey(line, id, m_corpus->KeyToId);
+                isValid = TryParseSequenceKey(line, key);
+                if (!isValid)
+                    key = line;
                 currentState = State::UtteranceFrames;
             }
             break;
@@ -137,14 +160,15 @@ namespace CNTK {
 
                 if (isValid)
                 {
-                    sequence.SetKey(id)
-                        .SetNumberOfSamples(numberOfSamples)
+                    // The key is converted to an id when the range is added to the index.
+                    sequence.SetNumberOfSamples(numberOfSamples)
                         .SetOffset(sequenceStartOffset)
                         .SetSize(sequenceEndOffset - sequenceStartOffset);
-                    index->AddSequence(sequence);
+                    range.m_sequences.push_back(sequence);
+                    range.m_keys.push_back(key);
                 }
                 else
-                    fprintf(stderr, "WARNING: Cannot parse the utterance '%s' at offset (%" PRIu64 ")\n", m_corpus->IdToKey(id).c_str(), sequenceStartOffset);
+                    fprintf(stderr, "WARNING: Cannot parse the utterance '%s' at offset (%" PRIu64 ")\n", key.c_str(), sequenceStartOffset);
                 currentState = State::UtteranceKey; // Let's try the next one.
             }
             break;
@@ -157,11 +181,9 @@ namespace CNTK {
 
     // Tries to parse sequence key
     // In MLF a sequence key should be in quotes. During parsing the extension should be removed.
-    bool MLFIndexBuilder::TryParseSequenceKey(const string& line, size_t& id, function<size_t(const string&)> keyToId)
+    /*static*/ bool MLFIndexBuilder::TryParseSequenceKey(const string& line, string& key)
     {
-        id = 0;
-
-        string key(line);
+        key = line;
 
         boost::trim_right(key);
 
@@ -174,8 +196,6 @@ namespace CNTK {
 
         // Remove extension if specified.
         key = key.substr(0, key.find_last_of("."));
-
-        id = keyToId(key);
         return true;
     }
 }
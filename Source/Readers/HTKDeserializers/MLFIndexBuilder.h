@@ -21,6 +21,10 @@ namespace CNTK {
 
         virtual void Populate(std::shared_ptr<Index>& index) override;
 
+        virtual size_t FindSequenceBoundary(BufferedFileReader& reader, size_t end) override;
+
+        virtual void IndexRange(BufferedFileReader& reader, size_t end, bool first, IndexedRange& range) override;
+
         enum class State
         {
             Header,
@@ -28,7 +32,7 @@ namespace CNTK {
             UtteranceFrames
         };
 
-        inline bool TryParseSequenceKey(const std::string& line, size_t& id, std::function<size_t(const std::string&)> keyToId);
+        static bool TryParseSequenceKey(const std::string& line, std::string& key);
     };
 
 } // namespace
@@ -64,15 +64,31 @@ ImageReader::ImageReader(const ConfigParameters& config)
     ConfigParameters featureStream = config(featureName);
 
     std::vector<Transformation> transformations;
-    transformations.push_back(Transformation{ std::make_shared<CropTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<ScaleTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<ColorTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<IntensityTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<MeanTransformer>(featureStream), featureName });
 
-    if (configHelper.GetDataFormat() == CHW)
+    // Color and intensity jittering are off unless configured.
+    bool colorOrIntensity =
+        (double)featureStream(L"brightnessRadius", "0.0") != 0.0 ||
+        (double)featureStream(L"contrastRadius", "0.0") != 0.0 ||
+        (double)featureStream(L"saturationRadius", "0.0") != 0.0 ||
+        (double)featureStream(L"intensityStdDev", "0.0") != 0.0;
+
+    if (colorOrIntensity)
+    {
+        transformations.push_back(Transformation{ std::make_shared<CropTransformer>(featureStream), featureName });
+        transformations.push_back(Transformation{ std::make_shared<ScaleTransformer>(featureStream), featureName });
+        transformations.push_back(Transformation{ std::make_shared<ColorTransformer>(featureStream), featureName });
+        transformations.push_back(Transformation{ std::make_shared<IntensityTransformer>(featureStream), featureName });
+        transformations.push_back(Transformation{ std::make_shared<MeanTransformer>(featureStream), featureName });
+
+        if (configHelper.GetDataFormat() == CHW)
+        {
+            transformations.push_back(Transformation{ std::make_shared<TransposeTransformer>(featureStream), featureName });
+        }
+    }
+    else
     {
-        transformations.push_back(Transformation{ std::make_shared<TransposeTransformer>(featureStream), featureName });
+        // Otherwise crop, scale, mean and transpose are done in a single pass.
+        transformations.push_back(Transformation{ std::make_shared<FusedImageTransformer>(featureStream, configHelper.GetDataFormat() == CHW), featureName });
     }
 
     // We should always have cast at the end. 
@@ -127,24 +127,35 @@ StreamInformation CropTransformer::Transform(const StreamInformation& inputStrea
 }
 
 void CropTransformer::Apply(uint8_t copyId, cv::Mat &mat)
+{
+    bool flip;
+    mat = mat(GetCropRect(copyId, mat.rows, mat.cols, flip));
+    if (flip)
+    {
+        cv::flip(mat, mat, 1);
+    }
+}
+
+cv::Rect CropTransformer::GetCropRect(uint8_t copyId, int rows, int cols, bool& flip)
 {
     auto seed = GetSeed();
     auto rng = m_rngs.pop_or_create([seed]() { return std::make_unique<std::mt19937>(seed); }); 
     int viewIndex = m_cropType == CropType::MultiView10 ? (int)(copyId % ImageDeserializerBase::NumMultiViewCopies) : 0;
 
+    cv::Rect rect;
     switch (m_cropType)
     {
     case CropType::Center: 
-        mat = mat(GetCropRectCenter(mat.rows, mat.cols, *rng));
+        rect = GetCropRectCenter(rows, cols, *rng);
         break; 
     case CropType::RandomSide: 
-        mat = mat(GetCropRectRandomSide(mat.rows, mat.cols, *rng)); 
+        rect = GetCropRectRandomSide(rows, cols, *rng); 
         break; 
     case CropType::RandomArea: 
-        mat = mat(GetCropRectRandomArea(mat.rows, mat.cols, *rng));
+        rect = GetCropRectRandomArea(rows, cols, *rng);
         break;
     case CropType::MultiView10: 
-        mat = mat(GetCropRectMultiView10(viewIndex, mat.rows, mat.cols, *rng));
+        rect = GetCropRectMultiView10(viewIndex, rows, cols, *rng);
         break; 
     default: 
         RuntimeError("Invalid crop type."); 
@@ -152,13 +163,10 @@ void CropTransformer::Apply(uint8_t copyId, cv::Mat &mat)
     }
 
     // for MultiView10 m_hFlip is false, hence the first 5 will be unflipped, the later 5 will be flipped
-    if ((m_hFlip && boost::random::bernoulli_distribution<>()(*rng)) ||
-        viewIndex >= 5)
-    {
-        cv::flip(mat, mat, 1);
-    }
+    flip = (m_hFlip && boost::random::bernoulli_distribution<>()(*rng)) || viewIndex >= 5;
 
     m_rngs.push(std::move(rng));
+    return rect;
 }
 
 CropTransformer::RatioJitterType
@@ -371,14 +379,22 @@ StreamInformation ScaleTransformer::Transform(const StreamInformation& inputStre
 
 void ScaleTransformer::Apply(uint8_t, cv::Mat &mat)
 {
+    cv::Mat buffer;
+    mat = Scale(mat, buffer);
+}
+
+cv::Mat ScaleTransformer::Scale(const cv::Mat& image, cv::Mat& buffer) const
+{
+    cv::Mat mat;
     if (m_scaleMode == ScaleMode::Fill)
     { // warp the image to the given target size
-        cv::resize(mat, mat, cv::Size((int)m_imgWidth, (int)m_imgHeight), 0, 0, m_interp);
+        cv::resize(image, buffer, cv::Size((int)m_imgWidth, (int)m_imgHeight), 0, 0, m_interp);
+        mat = buffer;
     }
     else
     {
-        int height = mat.rows;
-        int width = mat.cols;
+        int height = image.rows;
+        int width = image.cols;
 
         // which dimension is our scaled one?
         bool scaleW;
@@ -399,7 +415,8 @@ void ScaleTransformer::Apply(uint8_t, cv::Mat &mat)
             targetW = (size_t)round(width * m_imgHeight / (double)height);
         }
 
-        cv::resize(mat, mat, cv::Size((int)targetW, (int)targetH), 0, 0, m_interp);
+        cv::resize(image, buffer, cv::Size((int)targetW, (int)targetH), 0, 0, m_interp);
+        mat = buffer;
 
         if (m_scaleMode == ScaleMode::Crop)
         { // crop the overlap
@@ -416,9 +433,11 @@ void ScaleTransformer::Apply(uint8_t, cv::Mat &mat)
             size_t bottom = m_imgHeight - top - mat.rows;
             size_t left = wdiff;
             size_t right = m_imgWidth - left - mat.cols;
-            cv::copyMakeBorder(mat, mat, (int)top, (int)bottom, (int)left, (int)right, m_borderType, cv::Scalar(m_padValue, m_padValue, m_padValue));
+            cv::copyMakeBorder(buffer, mat, (int)top, (int)bottom, (int)left, (int)right, m_borderType, cv::Scalar(m_padValue, m_padValue, m_padValue));
         }
     }
+
+    return mat;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -595,6 +614,160 @@ SequenceDataPtr TransposeTransformer::TypedTranspose<TElementTo>::Apply(ImageSeq
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+FusedImageTransformer::FusedImageTransformer(const ConfigParameters& config, bool transpose) : TransformBase(config),
+    m_crop(config), m_scale(config), m_transpose(transpose), m_width(0), m_height(0), m_channels(0)
+{
+    MeanTransformer meanTransformer(config);
+    const cv::Mat& mean = meanTransformer.GetMeanImage();
+    if (!mean.empty())
+    {
+        mean.convertTo(m_meanFloat, CV_32F);
+        mean.convertTo(m_meanDouble, CV_64F);
+    }
+}
+
+// The method describes how input stream is transformed to the output stream. Called once per applied stream.
+// Outputs the dense stream of the scaled dimensions in the requested precision, as CHW if transposing.
+StreamInformation FusedImageTransformer::Transform(const StreamInformation& inputStream)
+{
+    TransformBase::Transform(inputStream);
+
+    ImageDimensions dimensions(TensorShape(m_scale.Transform(inputStream).m_sampleLayout.Dimensions()), HWC);
+    m_width = dimensions.m_width;
+    m_height = dimensions.m_height;
+    m_channels = dimensions.m_numChannels;
+
+    if (!m_meanFloat.empty() &&
+        (m_meanFloat.cols != (int)m_width || m_meanFloat.rows != (int)m_height || m_meanFloat.channels() != (int)m_channels))
+    {
+        fprintf(stderr, "WARNING: Mean file does not match the size of the scaled image, will be ignored.\n"
+            "Please remove mean options from the config.\n");
+        m_meanFloat.release();
+        m_meanDouble.release();
+    }
+
+    auto dims = dimensions.AsTensorShape(m_transpose ? CHW : HWC).GetDims();
+    m_outputStream.m_sampleLayout = NDShape(std::vector<size_t>(dims.begin(), dims.end()));
+    m_outputStream.m_elementType = m_precision;
+    return m_outputStream;
+}
+
+// Transformation of the sequence.
+SequenceDataPtr FusedImageTransformer::Transform(SequenceDataPtr sequence)
+{
+    auto inputSequence = dynamic_cast<ImageSequenceData*>(sequence.get());
+    if (inputSequence == nullptr)
+        RuntimeError("Currently the fused image transform only works with images.");
+
+    if (m_precision == DataType::Float)
+        return Apply<float>(inputSequence, m_meanFloat, m_floatBuffers);
+    return Apply<double>(inputSequence, m_meanDouble, m_doubleBuffers);
+}
+
+template <class TElementTo>
+SequenceDataPtr FusedImageTransformer::Apply(ImageSequenceData* inputSequence, const cv::Mat& mean, conc_stack<std::vector<TElementTo>>& buffers)
+{
+    assert(inputSequence->m_numberOfSamples == 1);
+
+    const cv::Mat& image = inputSequence->m_image;
+    if (image.channels() != (int)m_channels)
+        RuntimeError("Image has %d channels, the fused image transform expects %d.", image.channels(), (int)m_channels);
+
+    auto scratch = m_scratch.pop_or_create([]() { return std::make_unique<Scratch>(); });
+
+    // Crop is a view, only the flipped crop has to be materialized.
+    bool flip;
+    cv::Mat cropped = image(m_crop.GetCropRect(inputSequence->m_copyIndex, image.rows, image.cols, flip));
+    if (flip)
+    {
+        cv::flip(cropped, scratch->m_flipped, 1);
+        cropped = scratch->m_flipped;
+    }
+
+    cv::Mat scaled = m_scale.Scale(cropped, scratch->m_scaled);
+    assert(scaled.cols == (int)m_width && scaled.rows == (int)m_height);
+
+    auto dims = ImageDimensions(m_width, m_height, m_channels).AsTensorShape(m_transpose ? CHW : HWC).GetDims();
+    NDShape resultShape(std::vector<size_t>(dims.begin(), dims.end()));
+    auto result = std::make_shared<DenseSequenceWithBuffer<TElementTo>>(buffers, m_width * m_height * m_channels, resultShape);
+    result->m_key = inputSequence->m_key;
+    result->m_numberOfSamples = inputSequence->m_numberOfSamples;
+    result->m_elementType = m_precision;
+
+    switch (scaled.depth())
+    {
+    case CV_8U:
+        WriteOutput<TElementTo, unsigned char>(scaled, mean, result->GetBuffer());
+        break;
+    case CV_32F:
+        WriteOutput<TElementTo, float>(scaled, mean, result->GetBuffer());
+        break;
+    case CV_64F:
+        WriteOutput<TElementTo, double>(scaled, mean, result->GetBuffer());
+        break;
+    default:
+        RuntimeError("Unsupported OpenCV type '%d' in the fused image transform.", scaled.depth());
+    }
+
+    // Release the views before the scratch buffers can be reused by another sample.
+    cropped.release();
+    scaled.release();
+    m_scratch.push(std::move(scratch));
+    return result;
+}
+
+// Subtracts the mean, converts to the output precision and optionally transposes in a single pass.
+// Values are converted before the mean is subtracted, as in the chain of transforms.
+template <class TElementTo, class TElementFrom>
+void FusedImageTransformer::WriteOutput(const cv::Mat& image, const cv::Mat& mean, TElementTo* dst) const
+{
+    const size_t rows = image.rows;
+    const size_t cols = image.cols;
+    const size_t channels = image.channels();
+    const size_t planeSize = rows * cols;
+
+    for (size_t i = 0; i < rows; ++i)
+    {
+        const TElementFrom* x = image.ptr<TElementFrom>((int)i);
+        const TElementTo* m = mean.empty() ? nullptr : mean.ptr<TElementTo>((int)i);
+
+        if (m_transpose)
+        {
+            for (size_t c = 0; c < channels; ++c)
+            {
+                TElementTo* out = dst + c * planeSize + i * cols;
+                if (m)
+                {
+                    for (size_t j = 0; j < cols; ++j)
+                        out[j] = static_cast<TElementTo>(x[j * channels + c]) - m[j * channels + c];
+                }
+                else
+                {
+                    for (size_t j = 0; j < cols; ++j)
+                        out[j] = static_cast<TElementTo>(x[j * channels + c]);
+                }
+            }
+        }
+        else
+        {
+            TElementTo* out = dst + i * cols * channels;
+            const size_t count = cols * channels;
+            if (m)
+            {
+                for (size_t k = 0; k < count; ++k)
+                    out[k] = static_cast<TElementTo>(x[k]) - m[k];
+            }
+            else
+            {
+                for (size_t k = 0; k < count; ++k)
+                    out[k] = static_cast<TElementTo>(x[k]);
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 IntensityTransformer::IntensityTransformer(const ConfigParameters &config) : ImageTransformerBase(config)
 {
     m_stdDev = config(L"intensityStdDev", "0.0");
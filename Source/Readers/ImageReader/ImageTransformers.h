@@ -92,6 +92,10 @@ public:
 
     StreamInformation Transform(const StreamInformation& inputStream);
 
+    // Picks the crop rectangle for an image of the given size and decides whether the crop is flipped horizontally.
+    // Thread-safe, draws from the same random generators as Apply().
+    cv::Rect GetCropRect(uint8_t copyId, int rows, int cols, bool& flip);
+
 private:
     void Apply(uint8_t copyId, cv::Mat &mat) override;
 
@@ -141,6 +145,11 @@ public:
 
     StreamInformation Transform(const StreamInformation& inputStream) override;
 
+    // Scales the image to the requested dimensions. The resized image is written to 'buffer',
+    // which keeps its memory if it already has the right size and type.
+    // Returns the scaled image, that can be a view into 'buffer'.
+    cv::Mat Scale(const cv::Mat& image, cv::Mat& buffer) const;
+
 private:
     enum class ScaleMode
     {
@@ -166,6 +175,12 @@ class MeanTransformer : public ImageTransformerBase
 public:
     explicit MeanTransformer(const Microsoft::MSR::CNTK::ConfigParameters& config);
 
+    // Mean image, empty if no mean file is specified.
+    const cv::Mat& GetMeanImage() const
+    {
+        return m_meanImg;
+    }
+
 private:
     void Apply(uint8_t copyId, cv::Mat &mat) override;
 
@@ -205,6 +220,55 @@ private:
     TypedTranspose<double> m_doubleTransform;
 };
 
+// Crop, scale, mean subtraction and (optionally) transpose from HWC to CHW done in a single transform.
+// Gives the same result as the chain of the corresponding transforms, but the crop is only a view,
+// the scaled image goes into a per-thread scratch buffer that is reused across samples, and the mean
+// subtraction, conversion to the output precision and transposition are one pass over the scaled image
+// into a reused output buffer.
+// Configured with the union of the options of Crop, Scale and Mean.
+class FusedImageTransformer : public TransformBase
+{
+public:
+    explicit FusedImageTransformer(const Microsoft::MSR::CNTK::ConfigParameters& config, bool transpose = true);
+
+    // Transformation of the stream.
+    StreamInformation Transform(const StreamInformation& inputStream) override;
+
+    // Transformation of the sequence.
+    SequenceDataPtr Transform(SequenceDataPtr sequence) override;
+
+private:
+    // Per-thread intermediate images.
+    struct Scratch
+    {
+        cv::Mat m_flipped;
+        cv::Mat m_scaled;
+    };
+
+    template <class TElementTo>
+    SequenceDataPtr Apply(ImageSequenceData* inputSequence, const cv::Mat& mean, Microsoft::MSR::CNTK::conc_stack<std::vector<TElementTo>>& buffers);
+
+    template <class TElementTo, class TElementFrom>
+    void WriteOutput(const cv::Mat& image, const cv::Mat& mean, TElementTo* dst) const;
+
+    CropTransformer m_crop;
+    ScaleTransformer m_scale;
+    bool m_transpose;
+
+    // Mean image in both output precisions, empty if not used.
+    cv::Mat m_meanFloat;
+    cv::Mat m_meanDouble;
+
+    // Scaled layout in HWC.
+    size_t m_width;
+    size_t m_height;
+    size_t m_channels;
+
+    Microsoft::MSR::CNTK::conc_stack<std::unique_ptr<Scratch>> m_scratch;
+    Microsoft::MSR::CNTK::conc_stack<std::vector<float>> m_floatBuffers;
+    Microsoft::MSR::CNTK::conc_stack<std::vector<double>> m_doubleBuffers;
+};
+
 // Intensity jittering based on PCA transform as described in original AlexNet paper
 // (http://papers.nips.cc/paper/4824-imagenet-classification-with-deep-convolutional-neural-networks.pdf)
 // Currently uses precomputed values from 
@@ -13,6 +13,7 @@
 
 #include "DataReader.h"
 #include "ExceptionCapture.h"
+#include "TimerUtility.h"
 
 namespace CNTK {
 
@@ -24,7 +25,10 @@ BlockRandomizer::BlockRandomizer(
     bool multithreadedGetNextSequence,
     size_t maxNumberOfInvalidSequences,
     bool sampleBasedRandomizationWindow,
-    size_t seedOffset)
+    size_t seedOffset,
+    size_t prefetchDepth,
+    size_t prefetchThreads,
+    size_t prefetchBudgetInBytes)
     : m_verbosity(verbosity),
       m_deserializer(deserializer),
       m_sweep(SIZE_MAX),
@@ -34,15 +38,38 @@ BlockRandomizer::BlockRandomizer(
       m_sweepSizeInSamples(0),
       m_chunkRandomizer(std::make_shared<ChunkRandomizer>(deserializer, randomizationRange, sampleBasedRandomizationWindow)),
       m_multithreadedGetNextSequences(multithreadedGetNextSequence),
-      m_prefetchedChunk(ChunkIdMax),
       m_cleaner(maxNumberOfInvalidSequences),
-      m_seedOffset(seedOffset)
+      m_seedOffset(seedOffset),
+      m_prefetchDepth(prefetchDepth),
+      m_prefetchThreads(prefetchThreads),
+      m_prefetchBudgetInBytes(prefetchBudgetInBytes)
 {
     assert(deserializer != nullptr);
 
+    if (m_prefetchDepth == 0)
+        InvalidArgument("BlockRandomizer: prefetch depth must be at least 1.");
+
+    if (m_prefetchThreads == 0)
+        InvalidArgument("BlockRandomizer: number of prefetch threads must be at least 1.");
+
     m_launchType = shouldPrefetch ? launch::async : launch::deferred;
 
     m_streams = m_deserializer->StreamInfos();
+
+    // Estimate the in-memory size of a sample to keep the prefetched chunks under the budget.
+    // Sparse streams are assumed to have a single non-zero value per sample.
+    m_estimatedSampleSizeInBytes = 0;
+    for (const auto& stream : m_streams)
+    {
+        if (stream.m_elementType != DataType::Float && stream.m_elementType != DataType::Double)
+            continue;
+
+        size_t elementSize = DataTypeSize(stream.m_elementType);
+        if (stream.m_storageFormat != StorageFormat::Dense)
+            m_estimatedSampleSizeInBytes += elementSize + sizeof(SparseIndexType);
+        else if (!stream.m_sampleLayout.IsUnknown() && !stream.m_sampleLayout.HasUnboundDimension())
+            m_estimatedSampleSizeInBytes += elementSize * stream.m_sampleLayout.TotalSize();
+    }
     m_sequenceRandomizer = std::make_shared<SequenceRandomizer>(verbosity, m_deserializer, m_chunkRandomizer);
 
     // Calculate total number of samples.
@@ -61,6 +88,8 @@ std::map<std::wstring, size_t> BlockRandomizer::GetState()
 // Start a new epoch.
 void BlockRandomizer::StartEpoch(const EpochConfiguration& config)
 {
+    ReportPrefetchStatistics();
+
     m_currentWindowRange = ClosedOpenChunkInterval{};
 
     m_config = config;
@@ -234,8 +263,7 @@ std::pair<size_t, size_t> BlockRandomizer::LoadSequenceData(size_t globalSampleC
     }
 
     // Now it is safe to start the new chunk prefetch.
-    ChunkIdType chunkToPrefetchNext = GetChunkToPrefetch(windowRange);
-    Prefetch(chunkToPrefetchNext);
+    Prefetch(windowRange);
 
     return { numGlobalSamples, numLocalSamples };
 }
@@ -395,10 +423,10 @@ void BlockRandomizer::LoadDataChunks(const ClosedOpenChunkInterval& windowRange)
         }
 
         auto const& chunk = m_chunkRandomizer->GetRandomizedChunks()[i];
-        if (chunk.m_original->m_id == m_prefetchedChunk && m_prefetch.valid())
+        if (m_prefetchedChunks.find(chunk.m_original->m_id) != m_prefetchedChunks.end())
         {
             // Taking prefetched chunk.
-            m_chunks[chunk.m_original->m_id] = m_prefetch.get();
+            m_chunks[chunk.m_original->m_id] = TakePrefetchedChunk(chunk.m_original->m_id);
             if (m_verbosity >= Information)
                 fprintf(stderr, "BlockRandomizer::RetrieveDataChunks: paged in prefetched chunk %u (original chunk: %u), now %" PRIu64 " chunks in memory\n",
                 chunk.m_chunkId,
@@ -407,13 +435,13 @@ void BlockRandomizer::LoadDataChunks(const ClosedOpenChunkInterval& windowRange)
         }
         else
         {
-            // Make sure we have no outstanding prefetches.
-            if (m_prefetch.valid())
-            {
-                m_prefetch.wait();
-            }
+            Microsoft::MSR::CNTK::Timer timer;
+            timer.Start();
+            m_chunks[chunk.m_original->m_id] = LoadChunk(chunk.m_original->m_id).first;
+            timer.Stop();
 
-            m_chunks[chunk.m_original->m_id] = m_deserializer->GetChunk(chunk.m_original->m_id);
+            m_prefetchStatistics.m_numStalls++;
+            m_prefetchStatistics.m_totalStallSeconds += timer.ElapsedSeconds();
             if (m_verbosity >= Information)
                 fprintf(stderr, "BlockRandomizer::RetrieveDataChunks: paged in randomized chunk %u (original chunk: %u), now %" PRIu64 " chunks in memory\n",
                 chunk.m_chunkId,
@@ -429,45 +457,153 @@ void BlockRandomizer::LoadDataChunks(const ClosedOpenChunkInterval& windowRange)
                 m_chunkRandomizer->GetRandomizedChunks()[windowRange.m_end - 1].m_chunkId);
 }
 
-// Identifies chunk id that should be prefetched.
-ChunkIdType BlockRandomizer::GetChunkToPrefetch(const ClosedOpenChunkInterval& windowRange)
+// Identifies chunk ids that should be prefetched, in the order they will be needed.
+void BlockRandomizer::GetChunksToPrefetch(const ClosedOpenChunkInterval& windowRange, std::vector<const ChunkInfo*>& chunks)
 {
-    ChunkIdType toBePrefetched = ChunkIdMax;
+    chunks.clear();
     auto current = windowRange.m_end;
-    while (current < m_chunkRandomizer->GetRandomizedChunks().size())
+    while (current < m_chunkRandomizer->GetRandomizedChunks().size() && chunks.size() < m_prefetchDepth)
     {
         const auto& chunk = m_chunkRandomizer->GetRandomizedChunks()[current];
         if (chunk.m_chunkId % m_config.m_numberOfWorkers == m_config.m_workerRank &&
             m_chunks.find(chunk.m_original->m_id) == m_chunks.end())
         {
-            toBePrefetched = chunk.m_original->m_id;
-            break;
+            chunks.push_back(chunk.m_original);
         }
         ++current;
     }
-    return toBePrefetched;
 }
 
-// Performs io prefetch of the specified chunk if needed.
-void BlockRandomizer::Prefetch(ChunkIdType chunkId)
+// Performs io prefetch of the chunks following the window if needed.
+void BlockRandomizer::Prefetch(const ClosedOpenChunkInterval& windowRange)
 {
-    // Start new prefetch if necessary.
-    if (m_prefetchedChunk != chunkId && chunkId != ChunkIdMax)
+    std::vector<const ChunkInfo*> toBePrefetched;
+    GetChunksToPrefetch(windowRange, toBePrefetched);
+
+    auto isLoading = [](const PrefetchedChunk& p)
+    {
+        return p.m_data.wait_for(std::chrono::seconds(0)) == std::future_status::timeout;
+    };
+
+    // Drop prefetched chunks that are not needed anymore (i.e. after the sweep has been re-randomized or
+    // the position has been reset). Chunks that are still loading are kept until they finish,
+    // because destroying the future would block.
+    size_t numLoading = 0, prefetchedSizeInBytes = 0;
+    for (auto it = m_prefetchedChunks.begin(); it != m_prefetchedChunks.end();)
     {
-        // Wait to make sure there is no outstanding prefetches.
-        if (m_prefetch.valid())
+        bool loading = isLoading(it->second);
+        if (!loading && std::none_of(toBePrefetched.begin(), toBePrefetched.end(), [&](const ChunkInfo* c) { return c->m_id == it->first; }))
         {
-            m_prefetch.wait();
+            if (m_verbosity >= Debug)
+                fprintf(stderr, "BlockRandomizer::Prefetch: dropping prefetched original chunk: %u\n", it->first);
+            it = m_prefetchedChunks.erase(it);
+            continue;
         }
 
-        m_prefetchedChunk = chunkId;
-        m_prefetch = std::async(m_launchType, [this, chunkId]() { return m_deserializer->GetChunk(chunkId); });
+        numLoading += loading ? 1 : 0;
+        prefetchedSizeInBytes += it->second.m_estimatedSizeInBytes;
+        ++it;
+    }
+
+    // Start new prefetches in the order the chunks are needed, as long as there are free I/O threads
+    // and the memory budget allows. The remaining ones are started on subsequent calls.
+    for (auto chunkInfo : toBePrefetched)
+    {
+        auto chunkId = chunkInfo->m_id;
+        if (m_prefetchedChunks.find(chunkId) != m_prefetchedChunks.end())
+            continue;
+
+        if (numLoading >= m_prefetchThreads)
+            break;
+
+        size_t estimatedSizeInBytes = chunkInfo->m_numberOfSamples * m_estimatedSampleSizeInBytes;
+        if (m_prefetchBudgetInBytes != 0 && !m_prefetchedChunks.empty() &&
+            prefetchedSizeInBytes + estimatedSizeInBytes > m_prefetchBudgetInBytes)
+            break;
+
+        auto& prefetched = m_prefetchedChunks[chunkId];
+        prefetched.m_estimatedSizeInBytes = estimatedSizeInBytes;
+        prefetched.m_data = std::async(m_launchType, [this, chunkId]() { return LoadChunk(chunkId); });
+        prefetchedSizeInBytes += estimatedSizeInBytes;
+        numLoading += m_launchType == launch::async ? 1 : 0;
 
         if (m_verbosity >= Debug)
             fprintf(stderr, "BlockRandomizer::Prefetch: prefetching original chunk: %u\n", chunkId);
     }
 }
 
+// Loads the chunk from the deserializer and measures the load latency.
+std::pair<ChunkPtr, double> BlockRandomizer::LoadChunk(ChunkIdType chunkId)
+{
+    // Deserializers usually read all chunks through the same file handle,
+    // so unless several I/O threads are requested, the loads are serialized.
+    std::unique_lock<std::mutex> lock(m_deserializerLock, std::defer_lock);
+    if (m_prefetchThreads == 1)
+        lock.lock();
+
+    Microsoft::MSR::CNTK::Timer timer;
+    timer.Start();
+    ChunkPtr chunk = m_deserializer->GetChunk(chunkId);
+    timer.Stop();
+    return std::make_pair(chunk, timer.ElapsedSeconds());
+}
+
+// Takes the prefetched chunk, waiting for it if it is still loading.
+ChunkPtr BlockRandomizer::TakePrefetchedChunk(ChunkIdType chunkId)
+{
+    auto it = m_prefetchedChunks.find(chunkId);
+    assert(it != m_prefetchedChunks.end());
+
+    auto& prefetched = it->second.m_data;
+    if (prefetched.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        Microsoft::MSR::CNTK::Timer timer;
+        timer.Start();
+        prefetched.wait();
+        timer.Stop();
+
+        m_prefetchStatistics.m_numStalls++;
+        m_prefetchStatistics.m_totalStallSeconds += timer.ElapsedSeconds();
+    }
+
+    auto result = prefetched.get();
+    m_prefetchedChunks.erase(it);
+
+    RecordChunkLoad(result.second);
+    return result.first;
+}
+
+// Records the load latency of a prefetched chunk in the statistics.
+void BlockRandomizer::RecordChunkLoad(double seconds)
+{
+    auto& stats = m_prefetchStatistics;
+    stats.m_minLoadSeconds = stats.m_numLoadedChunks == 0 ? seconds : std::min(stats.m_minLoadSeconds, seconds);
+    stats.m_maxLoadSeconds = std::max(stats.m_maxLoadSeconds, seconds);
+    stats.m_totalLoadSeconds += seconds;
+    stats.m_numLoadedChunks++;
+}
+
+// Prints and resets chunk load statistics.
+void BlockRandomizer::ReportPrefetchStatistics()
+{
+    const auto& stats = m_prefetchStatistics;
+    if (m_verbosity >= Notification && (stats.m_numLoadedChunks > 0 || stats.m_numStalls > 0))
+    {
+        fprintf(stderr, "BlockRandomizer: prefetched %" PRIu64 " chunks (depth %" PRIu64 ", %" PRIu64 " I/O threads), "
+                "load latency avg %.4f min %.4f max %.4f seconds; waited %" PRIu64 " times for chunks, %.4f seconds in total\n",
+                stats.m_numLoadedChunks,
+                m_prefetchDepth,
+                m_prefetchThreads,
+                stats.m_numLoadedChunks > 0 ? stats.m_totalLoadSeconds / stats.m_numLoadedChunks : 0.0,
+                stats.m_minLoadSeconds,
+                stats.m_maxLoadSeconds,
+                stats.m_numStalls,
+                stats.m_totalStallSeconds);
+    }
+
+    m_prefetchStatistics = PrefetchStatistics();
+}
+
 void BlockRandomizer::SetState(const std::map<std::wstring, size_t>& state)
 {
     auto it = state.find(g_minibatchSourcePosition);
@@ -13,6 +13,7 @@
 #include "SequenceRandomizer.h"
 #include "ReaderUtil.h"
 #include <future>
+#include <mutex>
 
 namespace CNTK {
 
@@ -32,6 +33,13 @@ namespace CNTK {
 //
 // This class is responsible for decimation and loading the data chunks in to memory.
 // Actual randomization happens in ChunkRandomizer and SequenceRandomizer.
+//
+// Chunks following the current randomization window are prefetched asynchronously: up to prefetchDepth chunks
+// are kept loaded or loading ahead of the window, using at most prefetchThreads loads in flight. Most deserializers
+// share a single file handle between chunks, so by default there is a single I/O thread and all calls
+// to GetChunk() are serialized; more threads are only safe for deserializers that support concurrent GetChunk() calls.
+// The estimated size of the prefetched chunks is kept under prefetchBudgetInBytes (0 - no limit),
+// but at least one chunk is always prefetched.
 // TODO: The behavior can be simplified by only randomizing sequences forward.
 class BlockRandomizer : public SequenceEnumerator
 {
@@ -44,7 +52,21 @@ public:
         bool multithreadedGetNextSequences = false,
         size_t maxNumberOfInvalidSequences = 0, // per worker
         bool sampleBasedRandomizationWindow = true,
-        size_t seedOffset = 0);
+        size_t seedOffset = 0,
+        size_t prefetchDepth = 1,
+        size_t prefetchThreads = 1,
+        size_t prefetchBudgetInBytes = 0);
+
+    // Chunk load statistics, collected since the start of the epoch.
+    struct PrefetchStatistics
+    {
+        size_t m_numLoadedChunks = 0;     // number of chunks loaded by the prefetch
+        double m_totalLoadSeconds = 0;    // sum of the load latencies of these chunks
+        double m_minLoadSeconds = 0;      // fastest chunk load
+        double m_maxLoadSeconds = 0;      // slowest chunk load
+        size_t m_numStalls = 0;           // number of times a chunk was needed before its prefetch finished (or started)
+        double m_totalStallSeconds = 0;   // time spent waiting for such chunks
+    };
 
     // Starts a new epoch.
     virtual void StartEpoch(const EpochConfiguration& config) override;
@@ -65,9 +87,12 @@ public:
 
     ~BlockRandomizer()
     {
-        if (m_prefetch.valid())
+        for (auto& p : m_prefetchedChunks)
         {
-            m_prefetch.wait();
+            if (p.second.m_data.valid())
+            {
+                p.second.m_data.wait();
+            }
         }
     }
 
@@ -75,6 +100,12 @@ public:
 
     void SetConfiguration(const ReaderConfiguration& config) override;
 
+    // Returns chunk load statistics of the current epoch.
+    const PrefetchStatistics& GetPrefetchStatistics() const
+    {
+        return m_prefetchStatistics;
+    }
+
 private:
     // Load data for chunks if needed.
     void LoadDataChunks(const ClosedOpenChunkInterval& windowRange);
@@ -97,11 +128,23 @@ private:
     // Prepares a new sweep if needed.
     void PrepareNewSweepIfNeeded(size_t samplePosition);
 
-    // Performs io prefetch of the specified chunk if needed.
-    void Prefetch(ChunkIdType chunkId);
+    // Performs io prefetch of the chunks following the window if needed.
+    void Prefetch(const ClosedOpenChunkInterval& windowRange);
 
-    // Returns next candidate for the prefetch in the given range.
-    ChunkIdType GetChunkToPrefetch(const ClosedOpenChunkInterval& windowRange);
+    // Returns next candidates for the prefetch after the given range, in the order they will be needed.
+    void GetChunksToPrefetch(const ClosedOpenChunkInterval& windowRange, std::vector<const ChunkInfo*>& chunks);
+
+    // Loads the chunk from the deserializer and measures the load latency.
+    std::pair<ChunkPtr, double> LoadChunk(ChunkIdType chunkId);
+
+    // Takes the prefetched chunk, waiting for it if it is still loading.
+    ChunkPtr TakePrefetchedChunk(ChunkIdType chunkId);
+
+    // Records the load latency of a chunk in the statistics.
+    void RecordChunkLoad(double seconds);
+
+    // Prints and resets chunk load statistics.
+    void ReportPrefetchStatistics();
 
     // Global sample position on the timeline.
     size_t m_globalSamplePosition;
@@ -153,12 +196,31 @@ private:
 
     int m_verbosity;
 
-    // Prefetch future.
-    std::future<ChunkPtr> m_prefetch;
+    // A chunk that is loaded or being loaded ahead of the randomization window.
+    struct PrefetchedChunk
+    {
+        // Chunk together with its load latency in seconds.
+        std::future<std::pair<ChunkPtr, double>> m_data;
+        // Estimated memory footprint of the chunk.
+        size_t m_estimatedSizeInBytes;
+    };
+
+    // Prefetched chunks by original chunk id.
+    std::map<ChunkIdType, PrefetchedChunk> m_prefetchedChunks;
     // Whether to have async or deferred prefetch.
     launch m_launchType;
-    // Prefetched original chunk id.
-    ChunkIdType m_prefetchedChunk;
+    // Maximum number of chunks loaded ahead of the window.
+    size_t m_prefetchDepth;
+    // Maximum number of concurrent chunk loads.
+    size_t m_prefetchThreads;
+    // Memory budget for the prefetched chunks, 0 if unlimited.
+    size_t m_prefetchBudgetInBytes;
+    // Estimated size of a sample across all streams, used to estimate the chunk memory footprint.
+    size_t m_estimatedSampleSizeInBytes;
+    // Serializes GetChunk() calls when there is a single I/O thread.
+    std::mutex m_deserializerLock;
+    // Chunk load statistics.
+    PrefetchStatistics m_prefetchStatistics;
 
     // Current loaded chunks.
     ClosedOpenChunkInterval m_currentWindowRange;
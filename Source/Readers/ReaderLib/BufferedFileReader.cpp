@@ -41,6 +41,29 @@ namespace CNTK {
         m_done = (bytesRead == 0);
     }
 
+    const char* BufferedFileReader::TryGetBlock(size_t size)
+    {
+        if (m_done)
+            return nullptr;
+
+        if (m_index + size > m_buffer.size())
+        {
+            if (size > m_maxSize)
+                return nullptr;
+
+            // Re-read the buffer, so that it starts at the current position.
+            size_t lineNumber = m_lineNumber;
+            m_file.SeekOrDie(GetFileOffset(), SEEK_SET);
+            Reset();
+            m_lineNumber = lineNumber;
+
+            if (size > m_buffer.size())
+                return nullptr;
+        }
+
+        return m_buffer.data() + m_index;
+    }
+
     bool BufferedFileReader::TryMoveToNextLine()
     {
         for (; !m_done; Refill())
@@ -67,6 +67,22 @@ public:
     // string reference (omitting the trailing EOL). Returns false upon reaching the EOF.
     bool TryReadLine(std::string& str);
     
+    // Returns a pointer to the next 'size' bytes, so that they can be parsed in bulk.
+    // If they are not all in the buffer yet, the buffer is refilled starting at the current position.
+    // Returns nullptr if they do not fit into the buffer or the file ends before.
+    const char* TryGetBlock(size_t size);
+
+    // Advances the current position by 'size' bytes (previously returned by TryGetBlock),
+    // which contain 'numberOfLines' EOL delimiters.
+    void Skip(size_t size, size_t numberOfLines)
+    {
+        assert(m_index + size <= m_buffer.size());
+        m_index += size;
+        m_lineNumber += numberOfLines;
+        if (m_index == m_buffer.size())
+            Refill();
+    }
+
     // Returns the current line number.
     inline size_t CurrentLineNumber() const { return m_lineNumber; }
 
@@ -5,22 +5,441 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <algorithm>
+#include <string.h>
 #include "ChunkCache.h"
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#endif
+
 namespace CNTK {
 
+// Layout of a chunk in the spill file:
+//     SpilledChunkHeader
+//     uint64_t offsets[numberOfSequences * numberOfStreams] - offsets of the sequences relative to the chunk start,
+//                                                              sequence major, 0 for absent sequences
+//     for every sequence and stream, aligned to 8 bytes:
+//         SpilledSequenceHeader
+//         uint64_t dimensions[rank]               - sample shape
+//         SparseIndexType nnzCounts[numberOfSamples], indices[totalNnzCount] - sparse sequences only
+//         values, aligned to 8 bytes              - numberOfSamples * sample size for dense sequences,
+//                                                   totalNnzCount for sparse sequences
+struct SpilledChunkHeader
+{
+    uint32_t m_numberOfSequences;
+    uint32_t m_numberOfStreams;
+};
+
+struct SpilledSequenceHeader
+{
+    uint32_t m_numberOfSamples;
+    uint32_t m_elementType;
+    uint32_t m_isValid;
+    uint32_t m_keySample;
+    uint64_t m_keySequence;
+    uint32_t m_rank;
+    uint32_t m_totalNnzCount;
+};
+
+static inline size_t AlignSpillOffset(size_t offset)
+{
+    return (offset + 7) & ~(size_t)7;
+}
+
+// Sequences of a spilled chunk point directly to the mapped memory and keep it alive.
+struct SpilledDenseSequenceData : DenseSequenceData
+{
+    const void* GetDataBuffer() override { return m_data; }
+    const NDShape& GetSampleShape() override { return m_sampleShape; }
+
+    const void* m_data;
+    NDShape m_sampleShape;
+    MemoryMappedViewPtr m_view;
+};
+
+struct SpilledSparseSequenceData : SparseSequenceData
+{
+    const void* GetDataBuffer() override { return m_data; }
+    const NDShape& GetSampleShape() override { return m_sampleShape; }
+
+    const void* m_data;
+    NDShape m_sampleShape;
+    MemoryMappedViewPtr m_view;
+};
+
+// A chunk mapped from the spill file.
+class SpilledDataChunk : public Chunk
+{
+public:
+    SpilledDataChunk(MemoryMappedViewPtr view, const std::vector<StreamInformation>& streams)
+        : m_view(view)
+    {
+        for (const auto& s : streams)
+            m_storageFormats.push_back(s.m_storageFormat);
+
+        memcpy(&m_header, m_view->Data(), sizeof(m_header));
+        if (m_header.m_numberOfStreams != m_storageFormats.size())
+            RuntimeError("ChunkCache: spilled chunk has %u streams, expected %" PRIu64 ".", m_header.m_numberOfStreams, (uint64_t)m_storageFormats.size());
+    }
+
+    void GetSequence(size_t sequenceIndex, std::vector<SequenceDataPtr>& result) override
+    {
+        if (sequenceIndex >= m_header.m_numberOfSequences)
+            LogicError("ChunkCache: sequence index %" PRIu64 " is out of range of the spilled chunk.", (uint64_t)sequenceIndex);
+
+        const char* chunkStart = m_view->Data();
+        const uint64_t* offsets = (const uint64_t*)(chunkStart + sizeof(SpilledChunkHeader));
+        for (size_t i = 0; i < m_storageFormats.size(); ++i)
+        {
+            uint64_t offset = offsets[sequenceIndex * m_storageFormats.size() + i];
+            if (offset == 0)
+                LogicError("ChunkCache: sequence %" PRIu64 " has not been spilled.", (uint64_t)sequenceIndex);
+
+            const char* current = m_view->Data() + offset;
+            SpilledSequenceHeader header;
+            memcpy(&header, current, sizeof(header));
+            current += sizeof(header);
+
+            std::vector<size_t> dimensions(header.m_rank);
+            for (auto& d : dimensions)
+            {
+                uint64_t dimension;
+                memcpy(&dimension, current, sizeof(dimension));
+                d = (size_t)dimension;
+                current += sizeof(dimension);
+            }
+
+            SequenceDataPtr sequence;
+            if (m_storageFormats[i] == StorageFormat::Dense)
+            {
+                auto dense = std::make_shared<SpilledDenseSequenceData>();
+                dense->m_sampleShape = NDShape(dimensions);
+                dense->m_data = m_view->Data() + AlignSpillOffset(current - m_view->Data());
+                dense->m_view = m_view;
+                sequence = dense;
+            }
+            else
+            {
+                auto sparse = std::make_shared<SpilledSparseSequenceData>();
+                sparse->m_sampleShape = NDShape(dimensions);
+                const SparseIndexType* nnzCounts = (const SparseIndexType*)current;
+                sparse->m_nnzCounts.assign(nnzCounts, nnzCounts + header.m_numberOfSamples);
+                current += header.m_numberOfSamples * sizeof(SparseIndexType);
+                sparse->m_indices = (const SparseIndexType*)current;
+                sparse->m_totalNnzCount = header.m_totalNnzCount;
+                current += header.m_totalNnzCount * sizeof(SparseIndexType);
+                sparse->m_data = m_view->Data() + AlignSpillOffset(current - m_view->Data());
+                sparse->m_view = m_view;
+                sequence = sparse;
+            }
+
+            sequence->m_numberOfSamples = header.m_numberOfSamples;
+            sequence->m_elementType = (DataType)header.m_elementType;
+            sequence->m_isValid = header.m_isValid != 0;
+            sequence->m_key = SequenceKey((size_t)header.m_keySequence, header.m_keySample);
+            result.push_back(sequence);
+        }
+    }
+
+private:
+    MemoryMappedViewPtr m_view;
+    std::vector<StorageFormat> m_storageFormats;
+    SpilledChunkHeader m_header;
+};
+
+ChunkCache::ChunkCache(DataDeserializerPtr deserializer, size_t maxSizeInBytes, const std::wstring& spillFile, unsigned int traceLevel)
+    : m_deserializer(deserializer),
+      m_maxSizeInBytes(maxSizeInBytes),
+      m_traceLevel(traceLevel),
+      m_canSpill(false),
+      m_numRequestsSinceReport(0),
+      m_spillFileSize(0)
+{
+    m_streams = m_deserializer->StreamInfos();
+    m_numberOfChunks = m_deserializer->ChunkInfos().size();
+
+    // Without a budget nothing is ever evicted, so there is no point in spilling.
+    if (m_maxSizeInBytes == 0 || spillFile.empty())
+        return;
+
+    // Several processes (e.g. the workers of distributed training) can be given the same configuration.
+    m_spillFileName = spillFile + L"." + std::to_wstring(GetCurrentProcessId());
+
+    m_canSpill = std::all_of(m_streams.begin(), m_streams.end(), [](const StreamInformation& s)
+    {
+        return s.m_elementType == DataType::Float || s.m_elementType == DataType::Double;
+    });
+
+    if (!m_canSpill)
+    {
+        if (m_traceLevel >= Warning)
+            fprintf(stderr, "WARNING: ChunkCache: spilling to '%ls' is only supported for streams with float or double elements, chunks will not be spilled.\n",
+                    m_spillFileName.c_str());
+        return;
+    }
+
+    m_spillFile.reset(new FileWrapper(FileWrapper::OpenOrDie(m_spillFileName, L"wb")));
+    m_mappedSpillFile.reset(new MemoryMappedFile(m_spillFileName));
+}
+
+ChunkCache::~ChunkCache()
+{
+    PrintStatistics();
+
+    if (m_spillFile)
+    {
+        // Chunks mapped from the file can outlive the cache, on Linux the file is removed once they are unmapped.
+        m_mappedSpillFile.reset();
+        m_spillFile.reset();
+        _wunlink(m_spillFileName.c_str());
+    }
+}
+
 ChunkPtr ChunkCache::GetChunk(ChunkIdType chunkId)
 {
-    auto it = m_chunkMap.find(chunkId);
-    if (it != m_chunkMap.end())
     {
-        return it->second;
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (++m_numRequestsSinceReport >= m_numberOfChunks)
+            PrintStatistics();
+
+        auto it = m_chunkMap.find(chunkId);
+        if (it != m_chunkMap.end())
+        {
+            m_lru.splice(m_lru.begin(), m_lru, it->second.m_lruPosition);
+            m_statistics.m_hits++;
+            return it->second.m_chunk;
+        }
+
+        auto spilled = m_spilledChunks.find(chunkId);
+        if (spilled != m_spilledChunks.end())
+        {
+            m_statistics.m_spillHits++;
+            auto view = m_mappedSpillFile->Map((size_t)spilled->second.m_offset, (size_t)spilled->second.m_sizeInBytes, MemoryAccessHint::WillNeed);
+            return std::make_shared<SpilledDataChunk>(view, m_streams);
+        }
+
+        // Evicted, but still being written to the spill file.
+        auto pending = m_pendingSpills.find(chunkId);
+        if (pending != m_pendingSpills.end())
+        {
+            m_statistics.m_hits++;
+            return pending->second;
+        }
+
+        m_statistics.m_misses++;
     }
- 
+
+    // Deserialization happens outside of the lock, so that chunks can be loaded concurrently
+    // if the underlying deserializer allows it.
     ChunkPtr chunk = m_deserializer->GetChunk(chunkId);
-    m_chunkMap[chunkId] = chunk;
- 
+    size_t sizeInBytes = m_maxSizeInBytes == 0 ? 0 : SerializeChunk(chunkId, chunk, nullptr);
+
+    std::vector<std::pair<ChunkIdType, ChunkPtr>> toSpill;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        Insert(chunkId, chunk, sizeInBytes, toSpill);
+    }
+
+    // Disk writes happen outside of m_lock, so that they do not block requests for cached chunks.
+    if (!toSpill.empty())
+        Spill(toSpill);
+
     return chunk;
 }
 
+void ChunkCache::Insert(ChunkIdType chunkId, const ChunkPtr& chunk, size_t sizeInBytes, std::vector<std::pair<ChunkIdType, ChunkPtr>>& toSpill)
+{
+    if (m_chunkMap.find(chunkId) != m_chunkMap.end())
+        return; // Has been loaded concurrently.
+
+    m_lru.push_front(chunkId);
+    m_chunkMap[chunkId] = CachedChunk{ chunk, sizeInBytes, m_lru.begin() };
+    m_statistics.m_cachedBytes += sizeInBytes;
+
+    // Evict least recently used chunks, but always keep the one just loaded.
+    while (m_maxSizeInBytes != 0 && m_statistics.m_cachedBytes > m_maxSizeInBytes && m_lru.size() > 1)
+    {
+        auto victim = m_chunkMap.find(m_lru.back());
+        if (m_canSpill && m_spilledChunks.find(victim->first) == m_spilledChunks.end() && m_pendingSpills.insert(std::make_pair(victim->first, victim->second.m_chunk)).second)
+            toSpill.push_back(std::make_pair(victim->first, victim->second.m_chunk));
+
+        m_statistics.m_cachedBytes -= victim->second.m_sizeInBytes;
+        m_chunkMap.erase(victim);
+        m_lru.pop_back();
+        m_statistics.m_evictions++;
+    }
+}
+
+void ChunkCache::Spill(const std::vector<std::pair<ChunkIdType, ChunkPtr>>& chunks)
+{
+    std::lock_guard<std::mutex> spillGuard(m_spillLock);
+    for (const auto& c : chunks)
+    {
+        std::vector<char> buffer;
+        SerializeChunk(c.first, c.second, &buffer);
+
+        SpilledChunk spilled = { m_spillFileSize, buffer.size() };
+        if (!buffer.empty())
+        {
+            m_spillFile->WriteOrDie(buffer.data(), 1, buffer.size());
+            m_spillFile->FlushOrDie();
+            m_spillFileSize += buffer.size();
+        }
+
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_pendingSpills.erase(c.first);
+        if (buffer.empty())
+        {
+            // Evicted chunks are deserialized again from now on.
+            if (m_canSpill && m_traceLevel >= Warning)
+                fprintf(stderr, "WARNING: ChunkCache: chunk %u cannot be spilled to '%ls', spilling is switched off.\n", c.first, m_spillFileName.c_str());
+            m_canSpill = false;
+            continue;
+        }
+
+        m_spilledChunks[c.first] = spilled;
+        m_statistics.m_spilledChunks++;
+        m_statistics.m_spilledBytes += buffer.size();
+    }
+}
+
+size_t ChunkCache::SerializeChunk(ChunkIdType chunkId, const ChunkPtr& chunk, std::vector<char>* buffer)
+{
+    std::vector<SequenceInfo> sequences;
+    m_deserializer->SequenceInfosForChunk(chunkId, sequences);
+
+    size_t numberOfSequences = 0;
+    for (const auto& s : sequences)
+        numberOfSequences = std::max(numberOfSequences, s.m_indexInChunk + 1);
+
+    size_t size = 0;
+    auto append = [&](const void* data, size_t bytes)
+    {
+        if (buffer)
+            buffer->insert(buffer->end(), (const char*)data, (const char*)data + bytes);
+        size += bytes;
+    };
+
+    auto align = [&]()
+    {
+        size_t aligned = AlignSpillOffset(size);
+        if (buffer)
+            buffer->resize(aligned, 0);
+        size = aligned;
+    };
+
+    SpilledChunkHeader chunkHeader = { (uint32_t)numberOfSequences, (uint32_t)m_streams.size() };
+    append(&chunkHeader, sizeof(chunkHeader));
+
+    size_t offsetTable = size;
+    if (buffer)
+        buffer->resize(buffer->size() + numberOfSequences * m_streams.size() * sizeof(uint64_t), 0);
+    size += numberOfSequences * m_streams.size() * sizeof(uint64_t);
+
+    std::vector<SequenceDataPtr> data;
+    for (const auto& s : sequences)
+    {
+        data.clear();
+        chunk->GetSequence(s.m_indexInChunk, data);
+        if (data.size() != m_streams.size())
+            LogicError("ChunkCache: chunk %u returned %" PRIu64 " streams, expected %" PRIu64 ".", chunkId, (uint64_t)data.size(), (uint64_t)m_streams.size());
+
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            const auto& sequence = data[i];
+            align();
+            if (buffer)
+            {
+                uint64_t offset = size;
+                memcpy(buffer->data() + offsetTable + (s.m_indexInChunk * m_streams.size() + i) * sizeof(uint64_t), &offset, sizeof(offset));
+            }
+
+            // The stream element type is authoritative, sequences do not always set theirs.
+            DataType elementType = m_streams[i].m_elementType != DataType::Unknown ? m_streams[i].m_elementType : sequence->m_elementType;
+            size_t elementSize = elementType == DataType::UChar || elementType == DataType::Unknown ? 1 : DataTypeSize(elementType);
+
+            const auto& shape = sequence->GetSampleShape();
+            SpilledSequenceHeader header = {};
+            header.m_numberOfSamples = sequence->m_numberOfSamples;
+            header.m_elementType = (uint32_t)elementType;
+            header.m_isValid = sequence->m_isValid ? 1 : 0;
+            header.m_keySample = sequence->m_key.m_sample;
+            header.m_keySequence = sequence->m_key.m_sequence;
+            header.m_rank = (uint32_t)shape.Rank();
+
+            size_t numberOfValues = 0;
+            const SparseSequenceData* sparse = nullptr;
+            if (m_streams[i].m_storageFormat == StorageFormat::Dense)
+            {
+                numberOfValues = sequence->m_isValid && !shape.HasUnboundDimension() ? sequence->m_numberOfSamples * shape.TotalSize() : 0;
+            }
+            else
+            {
+                sparse = static_cast<const SparseSequenceData*>(sequence.get());
+                header.m_totalNnzCount = sequence->m_isValid ? sparse->m_totalNnzCount : 0;
+                numberOfValues = header.m_totalNnzCount;
+            }
+
+            append(&header, sizeof(header));
+            for (size_t d = 0; d < shape.Rank(); ++d)
+            {
+                uint64_t dimension = shape[d];
+                append(&dimension, sizeof(dimension));
+            }
+
+            if (sparse)
+            {
+                // The packers read a non-zero count per sample, so a sequence without them cannot be spilled.
+                if (buffer && sparse->m_nnzCounts.size() != header.m_numberOfSamples)
+                {
+                    buffer->clear();
+                    buffer = nullptr;
+                }
+
+                append(buffer ? sparse->m_nnzCounts.data() : nullptr, header.m_numberOfSamples * sizeof(SparseIndexType));
+                append(sparse->m_indices, header.m_totalNnzCount * sizeof(SparseIndexType));
+            }
+
+            align();
+            append(numberOfValues ? sequence->GetDataBuffer() : nullptr, numberOfValues * elementSize);
+        }
+    }
+
+    // Keeps the next chunk in the spill file aligned.
+    align();
+    return size;
+}
+
+ChunkCache::Statistics ChunkCache::GetStatistics()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_statistics;
+}
+
+// Reports the statistics about once per sweep, i.e. after as many requests as there are chunks.
+void ChunkCache::PrintStatistics()
+{
+    m_numRequestsSinceReport = 0;
+    if (m_traceLevel < Info)
+        return;
+
+    const auto& s = m_statistics;
+    fprintf(stderr, "ChunkCache: %" PRIu64 " hits (%" PRIu64 " from the spill file), %" PRIu64 " misses, %" PRIu64 " evictions, "
+            "%" PRIu64 " chunks in memory (%.1f MB), %" PRIu64 " chunks spilled (%.1f MB)\n",
+            (uint64_t)s.m_hits,
+            (uint64_t)s.m_spillHits,
+            (uint64_t)s.m_misses,
+            (uint64_t)s.m_evictions,
+            (uint64_t)m_chunkMap.size(),
+            s.m_cachedBytes / (1024.0 * 1024.0),
+            (uint64_t)s.m_spilledChunks,
+            s.m_spilledBytes / (1024.0 * 1024.0));
+}
+
 }
@@ -6,21 +6,46 @@
 #pragma once
 
 #include <map>
+#include <list>
+#include <mutex>
 #include "DataDeserializer.h"
+#include "FileWrapper.h"
+#include "MemoryMappedFile.h"
 
 namespace CNTK {
 
-// A cache to store the complete dataset (all chunks) in memory. The caching can
-// be switched on/off by a boolean flag in the reader config section, independent 
-// of the randomization and chunking parameters. The caching should only be enabled 
-// when the whole dataset fits in memory.
-// Implemented as a wrapping proxy around a deserializer that stores pointers to
-// all chunks it sees in an internal map.
+// A cache of deserialized chunks, so that subsequent sweeps do not have to deserialize them again.
+// The caching can be switched on/off in the reader config section, independent of the randomization
+// and chunking parameters.
+// Implemented as a wrapping proxy around a deserializer that keeps pointers to the chunks it sees.
+//
+// Without a memory budget all chunks are kept, so this should only be used when the whole dataset fits in memory.
+// With a budget, the least recently used chunks are evicted once the total size of the cached chunks exceeds it.
+// Additionally, chunks can be spilled to a local binary file when they are evicted for the first time;
+// they are then mapped from this file instead of being deserialized again, which leaves
+// the paging to the OS. Spilling is only supported for chunks whose streams all have float or double elements.
+// Chunks that fit into the budget are never written to the file.
 class ChunkCache : public DataDeserializer
 {
 public:
+    struct Statistics
+    {
+        size_t m_hits = 0;           // chunks returned from memory
+        size_t m_spillHits = 0;      // chunks mapped from the spill file
+        size_t m_misses = 0;         // chunks that had to be deserialized
+        size_t m_evictions = 0;      // chunks evicted from memory
+        size_t m_spilledChunks = 0;  // chunks written to the spill file
+        size_t m_spilledBytes = 0;   // size of the spill file
+        size_t m_cachedBytes = 0;    // size of the chunks currently kept in memory
+    };
+
+    // maxSizeInBytes - memory budget for the cached chunks, 0 - no limit.
+    // spillFile - path of the file to spill chunks to, empty - no spilling. Only used when there is a memory budget.
+    //             The process id is appended to the path; the file is removed when the cache is destroyed.
+    // traceLevel - the reader's trace level: warnings from 1, statistics from 2.
+    ChunkCache(DataDeserializerPtr deserializer, size_t maxSizeInBytes = 0, const std::wstring& spillFile = std::wstring(), unsigned int traceLevel = 0);
 
-    ChunkCache(DataDeserializerPtr deserializer) : m_deserializer(deserializer) { }
+    ~ChunkCache();
 
     virtual std::vector<StreamInformation> StreamInfos() override
     {
@@ -45,10 +70,74 @@ public:
     // Gets chunk data given its id.
     virtual ChunkPtr GetChunk(ChunkIdType chunkId);
 
+    // Returns a snapshot of the cache statistics.
+    Statistics GetStatistics();
+
 private:
-    // A map of currently loaded chunks
-    std::map<size_t, ChunkPtr> m_chunkMap;
+    struct CachedChunk
+    {
+        ChunkPtr m_chunk;
+        size_t m_sizeInBytes;
+        std::list<ChunkIdType>::iterator m_lruPosition;
+    };
+
+    // Location of a chunk in the spill file.
+    struct SpilledChunk
+    {
+        uint64_t m_offset;
+        uint64_t m_sizeInBytes;
+    };
+
+    // Walks through all sequences of the chunk and returns the size of their data.
+    // If buffer is not null, the chunk is serialized into it in the spill file format.
+    // The buffer is left empty if the chunk cannot be represented in the spill file.
+    size_t SerializeChunk(ChunkIdType chunkId, const ChunkPtr& chunk, std::vector<char>* buffer);
+
+    // Adds the chunk to the memory cache, evicting least recently used chunks if the budget is exceeded.
+    // Evicted chunks that have to be spilled are returned in toSpill; they stay available from m_pendingSpills until then.
+    void Insert(ChunkIdType chunkId, const ChunkPtr& chunk, size_t sizeInBytes, std::vector<std::pair<ChunkIdType, ChunkPtr>>& toSpill);
+
+    // Writes the evicted chunks to the spill file. Must be called without holding m_lock.
+    void Spill(const std::vector<std::pair<ChunkIdType, ChunkPtr>>& chunks);
+
+    // Prints the statistics if the trace level allows.
+    void PrintStatistics();
+
+    enum TraceLevel
+    {
+        Error = 0,
+        Warning = 1,
+        Info = 2
+    };
+
     DataDeserializerPtr m_deserializer;
+    std::vector<StreamInformation> m_streams;
+    size_t m_numberOfChunks;
+    unsigned int m_traceLevel;
+
+    // Chunks currently kept in memory.
+    std::map<ChunkIdType, CachedChunk> m_chunkMap;
+    // Ids of chunks in memory, the most recently used first.
+    std::list<ChunkIdType> m_lru;
+    // Memory budget, 0 - no limit.
+    size_t m_maxSizeInBytes;
+
+    // Spill file, written on first eviction of a chunk and mapped on subsequent loads.
+    std::wstring m_spillFileName;
+    std::unique_ptr<FileWrapper> m_spillFile;
+    std::unique_ptr<MemoryMappedFile> m_mappedSpillFile;
+    std::map<ChunkIdType, SpilledChunk> m_spilledChunks;
+    // Evicted chunks that are being written to the spill file.
+    std::map<ChunkIdType, ChunkPtr> m_pendingSpills;
+    bool m_canSpill;
+
+    Statistics m_statistics;
+    size_t m_numRequestsSinceReport;
+    std::mutex m_lock;
+    // Serializes the writes to the spill file, taken before m_lock if both are needed.
+    std::mutex m_spillLock;
+    // End of the spill file, protected by m_spillLock.
+    size_t m_spillFileSize;
 
     DISABLE_COPY_AND_MOVE(ChunkCache);
 };
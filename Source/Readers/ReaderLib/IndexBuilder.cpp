@@ -11,6 +11,7 @@
 #include "ReaderConstants.h"
 #include "FileWrapper.h"
 #include "EnvironmentUtil.h"
+#include "TimerUtility.h"
 #include <sstream>
 
 namespace CNTK {
@@ -23,7 +24,10 @@ IndexBuilder::IndexBuilder(const FileWrapper& input)
     m_isCacheEnabled(false),
     m_chunkSize(g_32MB),
     m_bufferSize(g_2MB),
-    m_primary(true)
+    m_primary(true),
+    m_numberOfThreads(0),
+    m_verbosity(0),
+    m_numberOfThreadsUsed(1)
 {}
 
 shared_ptr<Index> IndexBuilder::Build()
@@ -46,9 +50,23 @@ shared_ptr<Index> IndexBuilder::Build()
     }
     
     auto index = make_shared<Index>(m_chunkSize);
-    
+
+    Microsoft::MSR::CNTK::Timer timer;
+    timer.Start();
+
     Populate(index);
 
+    timer.Stop();
+    if (m_verbosity)
+    {
+        double seconds = timer.ElapsedSeconds();
+        double megabytes = (double)m_input.Filesize() / g_1MB;
+        fprintf(stderr, "Indexed %" PRIu64 " sequences in %" PRIu64 " chunks of '%ls' in %.3f seconds "
+            "(%.1f MB/s, %" PRIu64 " thread(s)).\n",
+            (uint64_t)index->NumberOfSequences(), (uint64_t)index->Chunks().size(), m_input.Filename().c_str(),
+            seconds, seconds > 0 ? megabytes / seconds : 0.0, (uint64_t)m_numberOfThreadsUsed);
+    }
+
     if (!m_corpus || m_corpus->IsNumericSequenceKeys() || m_corpus->IsHashingEnabled())
     {
         // For now, we do not cache index if input contains non-numeric sequence ids 
@@ -121,6 +139,96 @@ void IndexBuilder::WriteIndexCacheAsync(shared_ptr<Index>& index)
     }).detach();
 }
 
+void IndexBuilder::PopulateInParallel(shared_ptr<Index>& index, size_t begin, size_t end, size_t firstLineNumber)
+{
+    size_t numberOfThreads = m_numberOfThreads ? m_numberOfThreads : max<size_t>(thread::hardware_concurrency(), 1);
+
+    // Ranges smaller than the read buffer are not worth a separate thread.
+    size_t numberOfRanges = max<size_t>(1, min(numberOfThreads, (end - begin) / m_bufferSize));
+
+    // Split the input evenly and move each split point forward to the next sequence boundary.
+    vector<size_t> boundaries(1, begin);
+    for (size_t i = 1; i < numberOfRanges; ++i)
+    {
+        size_t offset = begin + (end - begin) / numberOfRanges * i;
+        if (offset <= boundaries.back())
+            continue; // the previous boundary is already past this split point.
+
+        // Start one byte earlier, so that a line starting right at the offset is not skipped.
+        FileWrapper file(m_input.Filename(), L"rbS");
+        file.CheckIsOpenOrDie();
+        file.SeekOrDie(offset - 1, SEEK_SET);
+        BufferedFileReader reader(m_bufferSize, file);
+        if (!reader.TryMoveToNextLine())
+            break;
+
+        size_t boundary = FindSequenceBoundary(reader, end);
+        if (boundary >= end)
+            break;
+
+        if (boundary > boundaries.back())
+            boundaries.push_back(boundary);
+    }
+    boundaries.push_back(end);
+
+    vector<IndexedRange> ranges(boundaries.size() - 1);
+    m_numberOfThreadsUsed = ranges.size();
+    if (ranges.size() == 1)
+    {
+        m_input.SeekOrDie(begin, SEEK_SET);
+        BufferedFileReader reader(m_bufferSize, m_input);
+        IndexRange(reader, end, true, ranges.front());
+    }
+    else
+    {
+        // Each range is scanned with its own file handle.
+        vector<future<void>> workers;
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            workers.push_back(async(launch::async, [this, &boundaries, &ranges, i]()
+            {
+                FileWrapper file(m_input.Filename(), L"rbS");
+                file.CheckIsOpenOrDie();
+                file.SeekOrDie(boundaries[i], SEEK_SET);
+                BufferedFileReader reader(m_bufferSize, file);
+                IndexRange(reader, boundaries[i + 1], i == 0, ranges[i]);
+            }));
+        }
+
+        for (auto& worker : workers)
+            worker.wait();
+
+        // Rethrows the first exception, if any.
+        for (auto& worker : workers)
+            worker.get();
+    }
+
+    // Merge the ranges in file order, so that the chunks and the sequence ids are
+    // the same as if the file was scanned sequentially.
+    size_t lineNumber = firstLineNumber;
+    for (auto& range : ranges)
+    {
+        AddRange(index, range, lineNumber);
+        lineNumber += range.m_numberOfLines;
+        range = IndexedRange();
+    }
+}
+
+void IndexBuilder::AddRange(shared_ptr<Index>& index, IndexedRange& range, size_t firstLineNumber)
+{
+    assert(range.m_keys.empty() || range.m_keys.size() == range.m_sequences.size());
+    for (size_t i = 0; i < range.m_sequences.size(); ++i)
+    {
+        auto& sequence = range.m_sequences[i];
+        if (!range.m_keys.empty())
+            sequence.SetKey(m_corpus->KeyToId(range.m_keys[i]));
+        else if (range.m_keysAreLineNumbers)
+            sequence.SetKey(sequence.key + firstLineNumber);
+
+        index->AddSequence(sequence);
+    }
+}
+
 const static size_t s_sequenceSize = sizeof(IndexedSequence);
 const static size_t s_numSequencesToBuffer = (g_1MB >> 1) / s_sequenceSize;
 
@@ -157,6 +265,7 @@ const static size_t s_numSequencesToBuffer = (g_1MB >> 1) / s_sequenceSize;
 TextInputIndexBuilder::TextInputIndexBuilder(const FileWrapper& input)
     : IndexBuilder(input),
     m_skipSequenceIds(false),
+    m_linesAsSequences(false),
     m_streamPrefix('|'),
     m_mainStream(""),
     m_fileSize(0)
@@ -218,28 +327,29 @@ static const char s_BOM[3] = { '\xEF', '\xBB', '\xBF' };
     if (m_fileSize == 0)
         RuntimeError("Input file is empty");
 
-    m_reader.reset(new BufferedFileReader(m_bufferSize, m_input));
+    BufferedFileReader reader(m_bufferSize, m_input);
 
     index->Reserve(m_fileSize);
 
     // skip BOM prefix at the very beginning of the input file if it's there.
     for (char ch : s_BOM) 
     {
-        if (!m_reader->Empty() && m_reader->Peek() == ch)
-            m_reader->Pop();
+        if (!reader.Empty() && reader.Peek() == ch)
+            reader.Pop();
         else break;
     }
 
     if (!isspace(m_streamPrefix))
     {
         // as long as the stream prefix is not a white space, it's safe to skip all leading spaces.
-        while (isspace(m_reader->Peek()) && m_reader->Pop()); 
+        while (isspace(reader.Peek()) && reader.Pop()); 
     }
 
-    if (m_reader->Empty())
+    if (reader.Empty())
         RuntimeError("Input file is empty");
 
-    if (m_skipSequenceIds || (!m_reader->Empty() && m_reader->Peek() == m_streamPrefix))
+    m_linesAsSequences = m_skipSequenceIds || (!reader.Empty() && reader.Peek() == m_streamPrefix);
+    if (m_linesAsSequences)
     {
         // Skip sequence id parsing, treat lines as individual sequences
         // In this case the sequences do not have ids, they are assigned corresponding line numbers
@@ -247,106 +357,158 @@ static const char s_BOM[3] = { '\xEF', '\xBB', '\xBF' };
         if (m_corpus && !m_corpus->IsNumericSequenceKeys())
             RuntimeError("Corpus expects non-numeric sequence keys present but the input file does not have them."
                 "Please use the configuration to enable numeric keys instead.");
-
-        PopulateFromLines(index);
     }
-    else 
+
+    PopulateInParallel(index, reader.GetFileOffset(), m_fileSize, reader.CurrentLineNumber());
+}
+
+/*virtual*/ size_t TextInputIndexBuilder::FindSequenceBoundary(BufferedFileReader& reader, size_t end) /*override*/
+{
+    if (m_linesAsSequences)
+        return reader.Empty() ? end : min(reader.GetFileOffset(), end);
+
+    // A new sequence starts at a line with an id different from the last id found on the previous lines.
+    // Lines without an id belong to the preceding sequence, so skip them until the first id is found.
+    bool foundFirstId = false;
+    size_t firstId = 0, id = 0;
+    string firstKey, key;
+    while (!reader.Empty())
     {
-        PopulateImpl(index);
+        auto offset = reader.GetFileOffset();
+        if (offset >= end)
+            break;
+
+        if (TryGetSequenceId(reader, id, key))
+        {
+            if (!foundFirstId)
+            {
+                firstId = id;
+                firstKey = key;
+                foundFirstId = true;
+            }
+            else if (id != firstId || key != firstKey)
+                return offset;
+        }
+
+        reader.TryMoveToNextLine();
     }
+
+    return end;
 }
 
-void TextInputIndexBuilder::PopulateFromLines(shared_ptr<Index>& index)
+/*virtual*/ void TextInputIndexBuilder::IndexRange(BufferedFileReader& reader, size_t end, bool first, IndexedRange& range) /*override*/
 {
+    if (m_linesAsSequences)
+        PopulateFromLines(reader, end, range);
+    else
+        PopulateImpl(reader, end, first, range);
+
+    range.m_numberOfLines = reader.CurrentLineNumber();
+}
+
+void TextInputIndexBuilder::PopulateFromLines(BufferedFileReader& reader, size_t end, IndexedRange& range)
+{
+    range.m_keysAreLineNumbers = true;
+
     IndexedSequence sequence;
-    while (!m_reader->Empty())
+    while (!reader.Empty() && reader.GetFileOffset() < end)
     {
-        size_t offset = m_reader->GetFileOffset();
+        size_t offset = reader.GetFileOffset();
 
-        if (!FindMainStream())
+        if (!FindMainStream(reader))
         { 
             // skip lines that do not contain main stream name.
-            m_reader->TryMoveToNextLine();
+            reader.TryMoveToNextLine();
             continue;
         }
 
-        sequence.SetNumberOfSamples(1).SetOffset(offset).SetKey(m_reader->CurrentLineNumber());
+        sequence.SetNumberOfSamples(1).SetOffset(offset).SetKey(reader.CurrentLineNumber());
 
-        if (m_reader->TryMoveToNextLine())
+        if (reader.TryMoveToNextLine())
         {
-            sequence.SetSize(m_reader->GetFileOffset() - offset);
-            index->AddSequence(sequence);
+            sequence.SetSize(reader.GetFileOffset() - offset);
+            range.m_sequences.push_back(sequence);
         } 
         else  if (offset < m_fileSize)
         {
             // There's a number of characters, not terminated by a newline,
             // add a sequence to the index, parser will have to deal with it.
             sequence.SetSize(m_fileSize - offset);
-            index->AddSequence(sequence);
+            range.m_sequences.push_back(sequence);
             break;
         }
     }
 }
 
-void TextInputIndexBuilder::PopulateImpl(shared_ptr<Index>& index)
+void TextInputIndexBuilder::PopulateImpl(BufferedFileReader& reader, size_t end, bool first, IndexedRange& range)
 {
+    // Symbolic keys are converted to ids only when the range is added to the index.
+    bool symbolicKeys = m_corpus && !m_corpus->IsNumericSequenceKeys();
+
     IndexedSequence sequence;
     uint32_t numberOfSamples = 0;
     bool foundMainStream = false;
-    size_t prevId = 0, nextId = 0, prevOffset = m_reader->GetFileOffset();
+    size_t prevId = 0, nextId = 0, prevOffset = reader.GetFileOffset();
+    string prevKey, nextKey;
 
     // Go ahead and read the id of the very first sequence.
-    if (!TryGetSequenceId(prevId))
+    if (!TryGetSequenceId(reader, prevId, prevKey))
     {
-        RuntimeError("Expected a sequence id at the offset %zu, none was found.", prevOffset);
+        if (first)
+            RuntimeError("Expected a sequence id at the offset %zu, none was found.", prevOffset);
+        LogicError("Range of the input at the offset %zu does not start at a sequence boundary.", prevOffset);
     }
 
-    while (!m_reader->Empty())
+    auto addSequence = [&](size_t size)
     {
-        if (FindMainStream())
+        sequence.SetKey(prevId)
+            .SetNumberOfSamples(numberOfSamples)
+            .SetOffset(prevOffset)
+            .SetSize(size);
+
+        if (foundMainStream)
+        {
+            range.m_sequences.push_back(sequence);
+            if (symbolicKeys)
+                range.m_keys.push_back(prevKey);
+        }
+    };
+
+    while (!reader.Empty())
+    {
+        if (FindMainStream(reader))
         {
             numberOfSamples++;
             foundMainStream = true;
         }
 
-        m_reader->TryMoveToNextLine(); // ignore whatever is left on this line.
+        reader.TryMoveToNextLine(); // ignore whatever is left on this line.
 
-        auto offset = m_reader->GetFileOffset(); // a new line starts at this offset;
-        
-        if (TryGetSequenceId(nextId) && nextId != prevId)
+        auto offset = reader.GetFileOffset(); // a new line starts at this offset;
+        if (offset >= end)
+            break; // the next range starts here.
+
+        if (TryGetSequenceId(reader, nextId, nextKey) && (nextId != prevId || nextKey != prevKey))
         {
             // found a new sequence, which starts at the [offset] bytes into the file
             // adding the previous one to the index.
-            sequence.SetKey(prevId)
-                .SetNumberOfSamples(numberOfSamples)
-                .SetOffset(prevOffset)
-                .SetSize(offset - prevOffset);
+            addSequence(offset - prevOffset);
 
             prevId = nextId;
+            prevKey.swap(nextKey);
             prevOffset = offset;
             numberOfSamples = 0;
-            
-            if (foundMainStream)
-                index->AddSequence(sequence);
             foundMainStream = false;
         }
     }
 
-    if (prevOffset < m_fileSize)
-    {
-        sequence.SetKey(prevId)
-            .SetNumberOfSamples(numberOfSamples)
-            .SetOffset(prevOffset)
-            .SetSize(m_fileSize - prevOffset);
-        
-        if (foundMainStream)
-            index->AddSequence(sequence);
-    }
+    if (prevOffset < end)
+        addSequence(end - prevOffset);
 }
 
-inline bool TextInputIndexBuilder::FindMainStream()
+inline bool TextInputIndexBuilder::FindMainStream(BufferedFileReader& reader) const
 {
-    if (m_reader->Empty())
+    if (reader.Empty())
         return false;
     
     if (m_mainStream.empty())
@@ -357,7 +519,7 @@ inline bool TextInputIndexBuilder::FindMainStream()
     int i = 0;
     do  
     {
-        char c = m_reader->Peek();
+        char c = reader.Peek();
         if (i == length)
         {
             // we found a match, check to see if it's followed by either a space, 
@@ -375,30 +537,34 @@ inline bool TextInputIndexBuilder::FindMainStream()
 
         if (c == g_eol)
             break;
-    } while (m_reader->Pop());
+    } while (reader.Pop());
 
     // we hit either the EOL or the EOF, see if we have a match
     return (i == length);
 }
 
-inline bool TextInputIndexBuilder::TryGetSequenceId(size_t& id)
+inline bool TextInputIndexBuilder::TryGetSequenceId(BufferedFileReader& reader, size_t& id, string& key) const
 {
     if (m_corpus && !m_corpus->IsNumericSequenceKeys())
-        return TryGetSymbolicSequenceId(id, m_corpus->KeyToId);
+    {
+        id = 0;
+        return TryGetSymbolicSequenceId(reader, key);
+    }
 
-    return TryGetNumericSequenceId(id);
+    key.clear();
+    return TryGetNumericSequenceId(reader, id);
 }
 
-inline bool TextInputIndexBuilder::TryGetNumericSequenceId(size_t& id)
+inline bool TextInputIndexBuilder::TryGetNumericSequenceId(BufferedFileReader& reader, size_t& id)
 {
-    if (m_reader->Empty())
+    if (reader.Empty())
         return false;
 
     bool found = false;
     id = 0;
     do
     {
-        char c = m_reader->Peek();
+        char c = reader.Peek();
         if (!isdigit(c))
             // Stop as soon as there's a non-digit character
             return found;
@@ -409,35 +575,29 @@ inline bool TextInputIndexBuilder::TryGetNumericSequenceId(size_t& id)
             RuntimeError("Overflow while reading a numeric sequence id (%zu-bit value).", sizeof(id));
         
         found = true;
-    } while (m_reader->Pop());
+    } while (reader.Pop());
 
     // reached EOF without hitting the pipe character,
     // ignore it for now, parser will have to deal with it.
     return false;
 }
 
-inline bool TextInputIndexBuilder::TryGetSymbolicSequenceId(size_t& id, function<size_t(const string&)> keyToId)
+inline bool TextInputIndexBuilder::TryGetSymbolicSequenceId(BufferedFileReader& reader, string& key)
 {
-    if (m_reader->Empty())
+    if (reader.Empty())
         return false;
 
     bool found = false;
-    id = 0;
-    string key;
-    key.reserve(256);
+    key.clear();
     do
     {
-        char c = m_reader->Peek();
+        char c = reader.Peek();
         if (isspace(c))
-        {
-            if (found)
-                id = keyToId(key);
             return found;
-        }
 
         key += c;
         found = true;
-    } while (m_reader->Pop());
+    } while (reader.Pop());
 
     // reached EOF without hitting the pipe character,
     // ignore it for now, parser will have to deal with it.
@@ -25,6 +25,7 @@ class IndexedSequence
 
     friend class Index;
     friend class ChunkDescriptor;
+    friend class IndexBuilder;
     
 public:
     IndexedSequence& SetKey(size_t value) { key = value; return *this;  }
@@ -76,6 +77,12 @@ public:
 
     IndexBuilder& SetCachingEnabled(bool value) { m_isCacheEnabled = value; return *this; }
 
+    // Maximum number of threads scanning the input concurrently, 0 - number of hardware threads.
+    IndexBuilder& SetNumberOfThreads(size_t value) { m_numberOfThreads = value; return *this; }
+
+    // If not 0, the indexing time and throughput are printed to stderr.
+    IndexBuilder& SetVerbosity(int value) { m_verbosity = value; return *this; }
+
     virtual std::wstring GetCacheFilename() = 0;
 
 protected:
@@ -85,11 +92,47 @@ protected:
 
     virtual void Populate(std::shared_ptr<Index>&) = 0;
 
+    // Sequences found in a byte range of the input, in file order.
+    struct IndexedRange
+    {
+        IndexedRange() : m_keysAreLineNumbers(false), m_numberOfLines(0) {}
+
+        std::vector<IndexedSequence> m_sequences;
+
+        // Symbolic keys of the sequences, if any. They are converted to ids only when
+        // the range is added to the index, so that the ids are assigned in file order.
+        std::vector<std::string> m_keys;
+
+        // True if the sequence keys are line numbers, relative to the start of the range.
+        bool m_keysAreLineNumbers;
+
+        // Number of lines in the range.
+        size_t m_numberOfLines;
+    };
+
+    // Splits the input between the offsets [begin, end) into byte ranges starting at sequence boundaries,
+    // indexes the ranges concurrently and adds the found sequences to the index in file order.
+    // The resulting index is the same as the one built by a single sequential scan.
+    // firstLineNumber is the number of lines preceding the begin offset.
+    void PopulateInParallel(std::shared_ptr<Index>& index, size_t begin, size_t end, size_t firstLineNumber);
+
+    // Given a reader positioned at the beginning of a line, returns the offset of
+    // the first sequence starting at or after this position, or end if there is none.
+    // The boundary must be found by looking forward only, because it is used to split the input.
+    virtual size_t FindSequenceBoundary(BufferedFileReader& reader, size_t end) = 0;
+
+    // Scans the input from the reader position (a sequence boundary) up to the end offset.
+    // first is true for the range at the beginning of the input.
+    // Can be called concurrently for different ranges, so must not modify the builder state.
+    virtual void IndexRange(BufferedFileReader& reader, size_t end, bool first, IndexedRange& range) = 0;
+
     FileWrapper m_input;
     CorpusDescriptorPtr m_corpus;
     size_t m_bufferSize;
     bool m_primary;
     size_t m_chunkSize;
+    size_t m_numberOfThreads;
+    int m_verbosity;
 
     bool m_isCacheEnabled;
 
@@ -98,8 +141,12 @@ protected:
 private:
     static std::shared_ptr<Index> TryLoadFromCache(const std::wstring& cacheFilename, size_t chunkSize);
     void WriteIndexCacheAsync(std::shared_ptr<Index>& index);
+    void AddRange(std::shared_ptr<Index>& index, IndexedRange& range, size_t firstLineNumber);
     std::shared_ptr<Index> m_index;
 
+    // Number of threads used by the last call to PopulateInParallel.
+    size_t m_numberOfThreadsUsed;
+
     static const uint64_t s_magic = 0x636e746b5f696478; // 'cntk_idx'
 };
 
@@ -133,40 +180,43 @@ private:
 
     virtual void Populate(std::shared_ptr<Index>& index) override;
 
+    virtual size_t FindSequenceBoundary(BufferedFileReader& reader, size_t end) override;
+
+    virtual void IndexRange(BufferedFileReader& reader, size_t end, bool first, IndexedRange& range) override;
+
     size_t m_fileSize;
     bool m_skipSequenceIds; // true, when input contains one sequence per line 
                            // or when sequence id column was ignored during indexing.
+    bool m_linesAsSequences; // true, when the input is indexed line by line (see PopulateFromLines).
     char m_streamPrefix;
 
     // Stream that defines the size of the sequence.
     std::string m_mainStream;
     std::unique_ptr<KMP> m_nfa; 
 
-    std::unique_ptr<BufferedFileReader> m_reader;
-
     // Returns true if main stream name if found on the current line.
-    bool FindMainStream();
+    bool FindMainStream(BufferedFileReader& reader) const;
 
     // Invokes either TryGetNumericSequenceId or TryGetSymbolicSequenceId depending
-    // on the specified corpus settings.
-    bool TryGetSequenceId(size_t& id);
+    // on the specified corpus settings. Numeric ids are written to the id, symbolic ids to the key.
+    bool TryGetSequenceId(BufferedFileReader& reader, size_t& id, std::string& key) const;
 
     // Tries to get numeric sequence id.
     // Throws an exception if a non-numerical is read until the pipe character or 
     // EOF is reached without hitting the pipe character.
     // Returns false if no numerical characters are found preceding the pipe.
     // Otherwise, writes sequence id value to the provided reference, returns true.
-    bool TryGetNumericSequenceId(size_t& id);
+    static bool TryGetNumericSequenceId(BufferedFileReader& reader, size_t& id);
 
     // Same as above but for symbolic ids.
-    // It reads a symbolic key and converts it to numeric id using provided keyToId function.
-    bool TryGetSymbolicSequenceId(size_t& id, std::function<size_t(const std::string&)> keyToId);
+    // It reads a symbolic key, which is converted to a numeric id when the sequence is added to the index.
+    static bool TryGetSymbolicSequenceId(BufferedFileReader& reader, std::string& key);
 
-    void PopulateImpl(std::shared_ptr<Index>& index);
+    void PopulateImpl(BufferedFileReader& reader, size_t end, bool first, IndexedRange& range);
 
     // Parses input line by line, treating each line as an individual sequence.
     // Ignores sequence id information, using the line number instead as the id.
-    void PopulateFromLines(std::shared_ptr<Index>& index);
+    void PopulateFromLines(BufferedFileReader& reader, size_t end, IndexedRange& range);
 };
 
 }
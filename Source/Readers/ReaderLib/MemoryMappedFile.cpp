@@ -0,0 +1,139 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include "MemoryMappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace CNTK {
+
+// Returns the alignment of the file offset of a mapping.
+static size_t MappingGranularity()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+MemoryMappedView::~MemoryMappedView()
+{
+#ifdef _WIN32
+    UnmapViewOfFile(m_base);
+#else
+    munmap(m_base, m_mappedSize);
+#endif
+}
+
+MemoryMappedFile::MemoryMappedFile(const std::wstring& filename)
+    : m_filename(filename)
+{
+#ifdef _WIN32
+    // The file can be written by others, i.e. when it is a cache that is still being appended to.
+    m_handle = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_handle == INVALID_HANDLE_VALUE)
+        RuntimeError("Cannot open file '%ls' for memory mapping, error %x.", filename.c_str(), (unsigned int)GetLastError());
+#else
+    m_handle = open(msra::strfun::utf8(filename).c_str(), O_RDONLY);
+    if (m_handle == -1)
+        RuntimeError("Cannot open file '%ls' for memory mapping: %s.", filename.c_str(), strerror(errno));
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+#ifdef _WIN32
+    CloseHandle(m_handle);
+#else
+    close(m_handle);
+#endif
+}
+
+size_t MemoryMappedFile::Size() const
+{
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_handle, &size))
+        RuntimeError("Cannot retrieve the size of file '%ls', error %x.", m_filename.c_str(), (unsigned int)GetLastError());
+    return (size_t)size.QuadPart;
+#else
+    struct stat sb;
+    if (fstat(m_handle, &sb) == -1)
+        RuntimeError("Cannot retrieve the size of file '%ls': %s.", m_filename.c_str(), strerror(errno));
+    return (size_t)sb.st_size;
+#endif
+}
+
+MemoryMappedViewPtr MemoryMappedFile::Map(size_t offset, size_t size, MemoryAccessHint hint, MemoryMappingMode mode) const
+{
+    if (size == 0)
+        InvalidArgument("Cannot map an empty region of file '%ls'.", m_filename.c_str());
+
+    // Mappings have to start at a multiple of the allocation granularity.
+    static const size_t granularity = MappingGranularity();
+    size_t alignedOffset = offset - offset % granularity;
+    size_t mappedSize = size + (offset - alignedOffset);
+
+#ifdef _WIN32
+    // Windows has no paging hints for mapped files that would be supported by all versions, so the hint is ignored.
+    UNUSED(hint);
+
+    bool copyOnWrite = (mode == MemoryMappingMode::CopyOnWrite);
+    size_t end = offset + size;
+    HANDLE mapping = CreateFileMappingW(m_handle, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, (DWORD)(end >> 32), (DWORD)(end & 0xFFFFFFFF), NULL);
+    if (mapping == NULL)
+        RuntimeError("Cannot create a mapping of file '%ls', error %x.", m_filename.c_str(), (unsigned int)GetLastError());
+
+    void* base = MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, (DWORD)(alignedOffset >> 32), (DWORD)(alignedOffset & 0xFFFFFFFF), mappedSize);
+    DWORD error = GetLastError();
+
+    // The view keeps the mapping alive.
+    CloseHandle(mapping);
+    if (base == NULL)
+        RuntimeError("Cannot map %" PRIu64 " bytes at offset %" PRIu64 " of file '%ls', error %x.", (uint64_t)size, (uint64_t)offset, m_filename.c_str(), (unsigned int)error);
+#else
+    int protection = (mode == MemoryMappingMode::CopyOnWrite) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* base = mmap(nullptr, mappedSize, protection, MAP_PRIVATE, m_handle, (off_t)alignedOffset);
+    if (base == MAP_FAILED)
+        RuntimeError("Cannot map %" PRIu64 " bytes at offset %" PRIu64 " of file '%ls': %s.", (uint64_t)size, (uint64_t)offset, m_filename.c_str(), strerror(errno));
+
+    int advice = MADV_NORMAL;
+    switch (hint)
+    {
+    case MemoryAccessHint::Sequential: advice = MADV_SEQUENTIAL; break;
+    case MemoryAccessHint::Random:     advice = MADV_RANDOM; break;
+    case MemoryAccessHint::WillNeed:   advice = MADV_WILLNEED; break;
+    default: break;
+    }
+
+    // The advice is only a hint, failures are ignored.
+    if (advice != MADV_NORMAL)
+        madvise(base, mappedSize, advice);
+#endif
+
+    return MemoryMappedViewPtr(new MemoryMappedView(base, mappedSize, (char*)base + (offset - alignedOffset), size, mode));
+}
+
+}
@@ -0,0 +1,100 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include "Basics.h"
+
+namespace CNTK {
+
+// Expected access pattern of a mapped region, passed to the OS as a paging hint (madvise on Linux).
+enum class MemoryAccessHint
+{
+    Normal,
+    Sequential,
+    Random,
+    WillNeed,
+};
+
+// Protection of a mapped region.
+enum class MemoryMappingMode
+{
+    ReadOnly,    // writing to the data is an access violation
+    CopyOnWrite, // the data can be modified, but modifications get private pages and never reach the file
+};
+
+// A mapped region of a file. The region is unmapped when the view is destroyed,
+// the view stays valid after the file it was mapped from has been closed.
+class MemoryMappedView
+{
+public:
+    ~MemoryMappedView();
+
+    const char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+    // The data of a copy-on-write mapping, which may be modified.
+    char* WritableData() const
+    {
+        if (m_mode != MemoryMappingMode::CopyOnWrite)
+            LogicError("The data of a read-only mapping cannot be modified.");
+        return m_data;
+    }
+
+private:
+    friend class MemoryMappedFile;
+
+    MemoryMappedView(void* base, size_t mappedSize, char* data, size_t size, MemoryMappingMode mode)
+        : m_base(base), m_mappedSize(mappedSize), m_data(data), m_size(size), m_mode(mode)
+    {}
+
+    void* m_base;             // start of the mapping, aligned to the allocation granularity
+    size_t m_mappedSize;      // size of the mapping
+    char* m_data;             // start of the requested region
+    size_t m_size;            // size of the requested region
+    MemoryMappingMode m_mode;
+
+    DISABLE_COPY_AND_MOVE(MemoryMappedView);
+};
+
+typedef std::shared_ptr<MemoryMappedView> MemoryMappedViewPtr;
+
+// A file opened for memory mapping of its regions.
+// Regions can be mapped while the file is appended to by somebody else, as long as they have been flushed.
+class MemoryMappedFile
+{
+public:
+    explicit MemoryMappedFile(const std::wstring& filename);
+    ~MemoryMappedFile();
+
+    // Current size of the file.
+    size_t Size() const;
+
+    // Maps the region [offset, offset + size) of the file.
+    MemoryMappedViewPtr Map(size_t offset, size_t size, MemoryAccessHint hint = MemoryAccessHint::Normal,
+                            MemoryMappingMode mode = MemoryMappingMode::ReadOnly) const;
+
+    const std::wstring& Filename() const
+    {
+        return m_filename;
+    }
+
+private:
+    std::wstring m_filename;
+
+    // Platform specific file handle (a HANDLE on Windows, a file descriptor otherwise).
+#ifdef _WIN32
+    void* m_handle;
+#else
+    int m_handle;
+#endif
+
+    DISABLE_COPY_AND_MOVE(MemoryMappedFile);
+};
+
+}
@@ -12,6 +12,7 @@
 #endif
 
 #include <sstream>
+#include <inttypes.h>
 #include "Basics.h"
 
 #define DATAREADER_EXPORTS // creating the exports here
@@ -19,6 +20,7 @@
 #include "ReaderShim.h"
 #include "DataTransferer.h"
 #include "PerformanceProfiler.h"
+#include "TimerUtility.h"
 
 namespace CNTK {
 
@@ -42,8 +44,10 @@ inline TensorShape AsTensorShape(const NDShape& viewShape)
 template <class ElemType>
 ReaderShim<ElemType>::ReaderShim() :
     m_deviceId(CPUDEVICE),
-    m_dataTransferers(2, DataTransfererPtr()),
-    m_currentDataTransferIndex(0),
+    m_prefetch(true),
+    m_slots(1),
+    m_stopPrefetch(false),
+    m_verbosity(0),
     m_endOfEpoch(false),
     m_endOfSweep(false),
     m_reader(nullptr),
@@ -71,10 +75,19 @@ void ReaderShim<ElemType>::Init(const ConfigParameters& config)
     intargvector numberOfuttsPerMinibatchForAllEpochs =
         config(L"nbruttsineachrecurrentiter", ConfigParameters::Array(intargvector(vector<int> { 1 })));
 
-    bool prefetch = config(L"prefetch", true);
-    // if prefetch - launching asynchronously,
-    // otherwise deferring - synchronous execution during .get() call
-    m_launchType = prefetch ? launch::async : launch::deferred;
+    // if prefetch - minibatches are prepared on a dedicated thread,
+    // otherwise they are read synchronously during GetMinibatch
+    m_prefetch = config(L"prefetch", true);
+
+    // Number of minibatches the prefetch thread may prepare ahead of the network.
+    size_t prefetchMinibatches = config(L"prefetchMinibatches", (size_t)1);
+    if (prefetchMinibatches == 0)
+        InvalidArgument("ReaderShim: 'prefetchMinibatches' must be at least 1.");
+
+    StopPrefetching();
+    m_slots.resize(m_prefetch ? prefetchMinibatches : 1);
+
+    m_verbosity = config(L"verbosity", 0);
 
     m_numParallelSequences = numberOfuttsPerMinibatchForAllEpochs[0];
 
@@ -122,14 +135,8 @@ void ReaderShim<ElemType>::SetCurrentSamplePosition(size_t currentSamplePosition
     if (GetCurrentSamplePosition() == currentSamplePosition)
         return;
 
-    // Make sure there are no outstanding reads.
-    if (m_prefetchTask.valid())
-        m_prefetchTask.wait();
-
-    // Let's check that there is no outstanding copies.
-    // Wait on all events if there are any pending copy operations in flight.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    // Make sure there are no outstanding reads or copies.
+    StopPrefetching();
 
     // Set current position.
     std::map<std::wstring, size_t> state;
@@ -143,14 +150,9 @@ void ReaderShim<ElemType>::SetCurrentSamplePosition(size_t currentSamplePosition
 template <class ElemType>
 void ReaderShim<ElemType>::SetConfiguration(const ReaderConfiguration& config, const std::map<std::wstring, int>& inputDescriptions)
 {
-    // Make sure there are no outstanding reads.
-    if (m_prefetchTask.valid())
-        m_prefetchTask.get();
-
-    // Let's check that there is no outstanding copies.
-    // Wait on all events if there are any pending copy operations in flight.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    // Make sure there are no outstanding reads or copies.
+    // Minibatches prepared with the old configuration are dropped, the reader is rewound below.
+    StopPrefetching();
 
     m_reader->SetConfiguration(config, inputDescriptions);
     m_reader->SetState(m_currentState);
@@ -159,14 +161,9 @@ void ReaderShim<ElemType>::SetConfiguration(const ReaderConfiguration& config, c
 template <class ElemType>
 void ReaderShim<ElemType>::StartEpoch(const EpochConfiguration& config, const std::unordered_set<InputStreamDescription>& inputs)
 {
-    // For adaptive minibatch, make sure there are no outstanding reads.
-    if (m_prefetchTask.valid())
-        m_prefetchTask.get();
-
-    // Let's check that there is no outstanding copies.
-    // Wait on all events if there are any pending copy operations in flight.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    // For adaptive minibatch, make sure there are no outstanding reads or copies.
+    StopPrefetching();
+    ReportPipelineStatistics();
 
     // Now we can be sure, no prefetch thread is running and there are no outstanding memcopies.
     // Let's check that requested devices are ok and see whether we need to change our data transferers.
@@ -186,10 +183,15 @@ void ReaderShim<ElemType>::StartEpoch(const EpochConfiguration& config, const st
     {
         // Device changed. Let's change the data transferers.
         m_deviceId = deviceId;
-        m_dataTransferers.clear();
-        // We need two in order to support two operations in flight.
-        m_dataTransferers.push_back(m_deviceId == CPUDEVICE ? nullptr : CreatePrefetchDataTransferer(m_deviceId));
-        m_dataTransferers.push_back(m_deviceId == CPUDEVICE ? nullptr : CreatePrefetchDataTransferer(m_deviceId));
+        for (auto& slot : m_slots)
+            slot.m_dataTransferer = nullptr;
+    }
+
+    // We need one per slot in order to support all prepared minibatches in flight.
+    for (auto& slot : m_slots)
+    {
+        if (!slot.m_dataTransferer && m_deviceId != CPUDEVICE)
+            slot.m_dataTransferer = CreatePrefetchDataTransferer(m_deviceId);
     }
 
     // Let's create the buffers for the prefetch thread.
@@ -198,12 +200,15 @@ void ReaderShim<ElemType>::StartEpoch(const EpochConfiguration& config, const st
     {
         inputDescriptions[i.GetStreamName()] = i.GetDeviceId();
         // Creating buffers with the same properties the network expects.
-        m_prefetchBuffers[i.GetStreamName()] = StreamPrefetchBuffer
+        for (auto& slot : m_slots)
         {
-            std::make_shared<Matrix<ElemType>>(0, 0, i.GetDeviceId(), i.GetMatrixType(), i.GetMatrixFormat()),
-            std::make_shared<MBLayout>(),
-            NDShape::Unknown()
-        };
+            slot.m_buffers[i.GetStreamName()] = StreamPrefetchBuffer
+            {
+                std::make_shared<Matrix<ElemType>>(0, 0, i.GetDeviceId(), i.GetMatrixType(), i.GetMatrixFormat()),
+                std::make_shared<MBLayout>(),
+                NDShape::Unknown()
+            };
+        }
     }
 
     m_endOfEpoch = false;
@@ -215,14 +220,112 @@ void ReaderShim<ElemType>::StartEpoch(const EpochConfiguration& config, const st
 template <class ElemType>
 void ReaderShim<ElemType>::StartAsyncPrefetching()
 {
-    auto localCurrentDataTransferIndex = m_currentDataTransferIndex;
-    // Starting the prefetch task. There is always a single async read in flight.
-    // When the network requests a new minibatch, we wait for the current async to finish, swap the buffers
-    // and kick off the new prefetch.
-    m_prefetchTask = std::async(m_launchType, [this, localCurrentDataTransferIndex]()
+    StopPrefetching();
+
+    // In synchronous mode GetMinibatch reads into the first slot itself.
+    if (!m_prefetch)
+        return;
+
+    // Starting the prefetch thread. It keeps up to m_slots.size() minibatches prepared ahead of the network.
+    // When the network requests a new minibatch, we take the oldest prepared one, swap the buffers
+    // and hand its slot back to the prefetch thread.
+    m_prefetchThread = std::thread([this]() { PrefetchLoop(); });
+}
+
+template <class ElemType>
+void ReaderShim<ElemType>::StopPrefetching()
+{
+    if (m_prefetchThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_prefetchMutex);
+            m_stopPrefetch = true;
+        }
+        m_slotFreed.notify_all();
+        m_prefetchThread.join();
+    }
+
+    // Let's check that there is no outstanding copies.
+    // Wait on all events if there are any pending copy operations in flight.
+    for (auto& slot : m_slots)
     {
-        return PrefetchMinibatch(localCurrentDataTransferIndex);
-    });
+        if (slot.m_dataTransferer)
+            slot.m_dataTransferer->WaitForCopyCPUToGPU();
+    }
+
+    m_stopPrefetch = false;
+    m_prefetchError = nullptr;
+    m_readySlots.clear();
+    m_freeSlots.clear();
+    for (size_t i = 0; i < m_slots.size(); ++i)
+        m_freeSlots.push_back(i);
+}
+
+// Body of the prefetch thread: fills free slots in order until the end of the epoch
+// or until asked to stop.
+template <class ElemType>
+void ReaderShim<ElemType>::PrefetchLoop()
+{
+    for (;;)
+    {
+        size_t slotIndex;
+        {
+            std::unique_lock<std::mutex> lock(m_prefetchMutex);
+            m_slotFreed.wait(lock, [this]() { return m_stopPrefetch || !m_freeSlots.empty(); });
+            if (m_stopPrefetch)
+                return;
+
+            slotIndex = m_freeSlots.front();
+            m_freeSlots.pop_front();
+        }
+
+        PrefetchResult result;
+        try
+        {
+            result = PrefetchMinibatch(m_slots[slotIndex]);
+            m_slots[slotIndex].m_result = result;
+        }
+        catch (...)
+        {
+            // Rethrown on the main thread once the minibatches prepared before are consumed.
+            {
+                std::lock_guard<std::mutex> lock(m_prefetchMutex);
+                m_prefetchError = std::current_exception();
+            }
+            m_slotReady.notify_one();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_prefetchMutex);
+            m_readySlots.push_back(slotIndex);
+        }
+        m_slotReady.notify_one();
+
+        // Nothing to read past the end of the epoch.
+        if (result.m_isEndOfEpoch)
+            return;
+    }
+}
+
+// Prints and resets minibatch pipeline statistics.
+template <class ElemType>
+void ReaderShim<ElemType>::ReportPipelineStatistics()
+{
+    const auto& stats = m_pipelineStatistics;
+    if (m_verbosity >= 1 && stats.m_numMinibatches > 0)
+    {
+        fprintf(stderr, "ReaderShim: %" PRIu64 " minibatches (queue depth %" PRIu64 "), average queue occupancy %.2f; "
+                "waited %" PRIu64 " times for the reader, %.4f seconds in total, %.4f seconds max\n",
+                (uint64_t)stats.m_numMinibatches,
+                (uint64_t)m_slots.size(),
+                (double)stats.m_totalOccupancy / stats.m_numMinibatches,
+                (uint64_t)stats.m_numStalls,
+                stats.m_totalStallSeconds,
+                stats.m_maxStallSeconds);
+    }
+
+    m_pipelineStatistics = PipelineStatistics();
 }
 
 string EnumerateInputs(const unordered_map<wstring, size_t>& nameToStreamId)
@@ -272,15 +375,60 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
         }
     }
 
-    if (!m_prefetchTask.valid())
-        StartAsyncPrefetching();
+    size_t slotIndex = 0;
+    if (m_prefetch)
+    {
+        if (!m_prefetchThread.joinable())
+            StartAsyncPrefetching();
 
-    auto result = m_prefetchTask.get();
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(m_prefetchMutex);
+            m_pipelineStatistics.m_numMinibatches++;
+            m_pipelineStatistics.m_totalOccupancy += m_readySlots.size();
+            if (m_readySlots.empty() && !m_prefetchError)
+            {
+                // The pipeline is drained, we have to wait for the prefetch thread.
+                PROFILE_SCOPE(profilerEvtWaitForMinibatch);
+                Timer timer;
+                timer.Start();
+                m_slotReady.wait(lock, [this]() { return !m_readySlots.empty() || m_prefetchError; });
+                timer.Stop();
+
+                m_pipelineStatistics.m_numStalls++;
+                m_pipelineStatistics.m_totalStallSeconds += timer.ElapsedSeconds();
+                m_pipelineStatistics.m_maxStallSeconds = std::max(m_pipelineStatistics.m_maxStallSeconds, timer.ElapsedSeconds());
+            }
+
+            if (m_readySlots.empty())
+            {
+                error = m_prefetchError;
+            }
+            else
+            {
+                slotIndex = m_readySlots.front();
+                m_readySlots.pop_front();
+            }
+        }
+
+        if (error)
+        {
+            StopPrefetching();
+            std::rethrow_exception(error);
+        }
+    }
+    else
+    {
+        m_pipelineStatistics.m_numMinibatches++;
+        m_slots[0].m_result = PrefetchMinibatch(m_slots[0]);
+    }
 
     // Ok, prefetch is done.
+    auto& slot = m_slots[slotIndex];
+    const auto& result = slot.m_result;
 
     // Let's update our sample position.
-    m_currentState = m_reader->GetState();
+    m_currentState = slot.m_state;
 
     m_endOfEpoch = result.m_isEndOfEpoch;
     m_endOfSweep = result.m_isEndOfSweep;
@@ -290,23 +438,19 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
         return false;
     }
 
-    // Remember current data transfer, async memcpy for it already started on the prefetch thread.
-    auto currentDataTransferIndex = m_currentDataTransferIndex;
-
+    m_getKeyById = slot.m_getKeyById;
     matrices.m_getKeyById = m_getKeyById;
 
-    // Let's update the current data transferer.
-    m_currentDataTransferIndex = (m_currentDataTransferIndex + 1) % 2;
-
-    // Record an event that prefetch can wait on to ensure that prior compute has finished.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->RecordComputeStreamSyncPoint();
+    // Record an event that the next prefetch into this slot can wait on to ensure that prior compute
+    // on the matrices we are about to swap into the slot has finished.
+    if (slot.m_dataTransferer)
+        slot.m_dataTransferer->RecordComputeStreamSyncPoint();
 
     // We have some data - let's swap the matrices.
     // We cannot simply change pointers because it seems they are remembered deeper in the network.
     for (auto i = matrices.begin(); i != matrices.end(); ++i)
     {
-        std::swap(i->second.GetMatrix<ElemType>(), *m_prefetchBuffers[i->first].m_matrix);
+        std::swap(i->second.GetMatrix<ElemType>(), *slot.m_buffers[i->first].m_matrix);
 
         // Resetting layouts.
         i->second.pMBLayout->Init(1, 0);
@@ -318,7 +462,7 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
     // Let's now check the layouts and throw if the same layout is being assigned twice.
     for (auto i = matrices.begin(); i != matrices.end(); ++i)
     {
-        auto streamLayout = m_prefetchBuffers[i->first].m_mbLayout;
+        auto streamLayout = slot.m_buffers[i->first].m_mbLayout;
         auto& layout = i->second.pMBLayout;
         if (layout->GetNumCols() == 0) // just initialized, let's take the layout of the reader.
         {
@@ -335,7 +479,7 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
         }
 
         // Check sample shape.
-        const auto& sampleShape = m_prefetchBuffers[i->first].m_sampleShape;
+        const auto& sampleShape = slot.m_buffers[i->first].m_sampleShape;
         if (i->second.sampleLayout.size() == 0 || AsNDShape(i->second.sampleLayout).IsUnknown()) // Not set.
         {
             i->second.sampleLayout = AsTensorShape(sampleShape);
@@ -351,17 +495,23 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
     // So pick up the first one.
     m_numParallelSequences = matrices.begin()->second.pMBLayout->GetNumParallelSequences();
 
-    // It is time to issue the next prefetch.
-    if (!m_endOfEpoch)
+    // Let's wait till the memcopy of this minibatch has finished.
+    if (slot.m_dataTransferer)
+        slot.m_dataTransferer->WaitForCopyCPUToGPU();
+
+    bool isDataAvailable = result.m_isDataAvailable;
+
+    // Now the slot can be refilled by the prefetch thread.
+    if (m_prefetch)
     {
-        StartAsyncPrefetching();
+        {
+            std::lock_guard<std::mutex> lock(m_prefetchMutex);
+            m_freeSlots.push_back(slotIndex);
+        }
+        m_slotFreed.notify_one();
     }
 
-    // Let's wait till the previous memcopy has finished.
-    if (m_dataTransferers[currentDataTransferIndex])
-        m_dataTransferers[currentDataTransferIndex]->WaitForCopyCPUToGPU();
-
-    return result.m_isDataAvailable;
+    return isDataAvailable;
 }
 
 template <class ElemType>
@@ -390,16 +540,19 @@ void FillMatrixFromStream(StorageFormat type, Matrix<ElemType>* matrix, size_t n
 }
 
 template <class ElemType>
-typename ReaderShim<ElemType>::PrefetchResult ReaderShim<ElemType>::PrefetchMinibatch(size_t currentDataTransferIndex)
+typename ReaderShim<ElemType>::PrefetchResult ReaderShim<ElemType>::PrefetchMinibatch(PrefetchSlot& slot)
 {
     PROFILE_SCOPE(profilerEvtPrefetchMinibatch);
 
     // Resetting layouts.
-    for (auto& mx : m_prefetchBuffers)
+    for (auto& mx : slot.m_buffers)
         mx.second.m_mbLayout = std::make_shared<MBLayout>();
 
     Minibatch minibatch = m_reader->ReadMinibatch();
 
+    // Remember the position after this minibatch, the reader itself may run ahead.
+    slot.m_state = m_reader->GetState();
+
     // If there is no data we can simply return.
     if (minibatch.m_data.empty())
         return PrefetchResult{ minibatch.m_endOfSweep, minibatch.m_endOfEpoch, false };
@@ -408,12 +561,12 @@ typename ReaderShim<ElemType>::PrefetchResult ReaderShim<ElemType>::PrefetchMini
     // But before we need to make sure that corresponding compute has already finished from the last iteration.
 
     // We need to make sure that the compute for the current transfer is finished before we start prefetch.
-    if (m_dataTransferers[currentDataTransferIndex])
-        m_dataTransferers[currentDataTransferIndex]->WaitForSyncPointOnAssignStreamAsync();
+    if (slot.m_dataTransferer)
+        slot.m_dataTransferer->WaitForSyncPointOnAssignStreamAsync();
 
-    m_getKeyById = minibatch.m_getKeyById;
+    slot.m_getKeyById = minibatch.m_getKeyById;
 
-    for (auto& mx : m_prefetchBuffers)
+    for (auto& mx : slot.m_buffers)
     {
         size_t streamId = m_nameToStreamId[mx.first];
         const auto& stream = minibatch.m_data[streamId];
@@ -428,12 +581,12 @@ typename ReaderShim<ElemType>::PrefetchResult ReaderShim<ElemType>::PrefetchMini
         }
 
         size_t sampleSize = m_streams[streamId].m_sampleLayout.TotalSize();
-        FillMatrixFromStream(m_streams[streamId].m_storageFormat, mx.second.m_matrix.get(), sampleSize, stream, m_dataTransferers[currentDataTransferIndex].get());
+        FillMatrixFromStream(m_streams[streamId].m_storageFormat, mx.second.m_matrix.get(), sampleSize, stream, slot.m_dataTransferer.get());
     }
 
     // Let's record that we started the copy, so that the main thread can wait afterwards.
-    if (m_dataTransferers[currentDataTransferIndex])
-        m_dataTransferers[currentDataTransferIndex]->RecordCPUToGPUCopy();
+    if (slot.m_dataTransferer)
+        slot.m_dataTransferer->RecordCPUToGPUCopy();
 
     return PrefetchResult{ minibatch.m_endOfSweep, minibatch.m_endOfEpoch, true };
 }
@@ -480,14 +633,8 @@ void ReaderShim<ElemType>::SetState(const std::map<std::wstring, size_t>& state)
     if (m_currentState == state)
         return;
 
-    // Make sure there are no outstanding reads.
-    if (m_prefetchTask.valid())
-        m_prefetchTask.wait();
-
-    // Let's check that there is no outstanding copies.
-    // Wait on all events if there are any pending copy operations in flight.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    // Make sure there are no outstanding reads or copies.
+    StopPrefetching();
 
     // Set current position.
     m_reader->SetState(state);
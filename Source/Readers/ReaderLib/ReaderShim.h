@@ -10,7 +10,11 @@
 
 #include <unordered_map>
 #include <string>
-#include <future>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 #include "DataReader.h"
 #include "Reader.h"
 
@@ -37,7 +41,10 @@ public:
     explicit ReaderShim(ReaderFactory factory);
     explicit ReaderShim(ReaderPtr reader);
 
-    virtual ~ReaderShim() { }
+    virtual ~ReaderShim()
+    {
+        StopPrefetching();
+    }
 
     virtual void Init(const Microsoft::MSR::ScriptableObjects::IConfigRecord& /*config*/) override
     {
@@ -47,15 +54,8 @@ public:
 
     virtual void Destroy() override
     {
-        // Make sure there are no outstanding reads.
-        // Future destructor does not wait as of 2013 so probably it is not in VS2013:
-        // More info can be found here http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2013/n3679.html.
-        if (m_prefetchTask.valid())
-        {
-            // If there are some, give them time to finish.
-            m_prefetchTask.wait_for(std::chrono::seconds(60));
-            // TODO: if the prefetch is still valid, print a warning here!
-        }
+        // Make sure there are no outstanding reads: stops and joins the prefetch thread.
+        StopPrefetching();
 
         delete this;
     }
@@ -114,10 +114,33 @@ public:
         return m_endOfSweep;
     }
 
+    // Minibatch pipeline statistics, collected since the start of the epoch.
+    struct PipelineStatistics
+    {
+        size_t m_numMinibatches = 0;     // number of minibatches handed out by GetMinibatch()
+        size_t m_totalOccupancy = 0;     // sum of the prepared minibatches found in the queue by these calls
+        size_t m_numStalls = 0;          // number of calls that found the queue empty and had to wait
+        double m_totalStallSeconds = 0;  // time spent waiting for the reader thread
+        double m_maxStallSeconds = 0;    // longest single wait
+    };
+
+    const PipelineStatistics& GetPipelineStatistics() const
+    {
+        return m_pipelineStatistics;
+    }
+
 private:
 
     void StartAsyncPrefetching();
 
+    // Stops the prefetch thread and drops all prepared minibatches.
+    // The underlying reader may be ahead of m_currentState afterwards.
+    void StopPrefetching();
+
+    void PrefetchLoop();
+
+    void ReportPipelineStatistics();
+
     struct PrefetchResult
     {
         bool m_isEndOfSweep;
@@ -125,9 +148,36 @@ private:
         bool m_isDataAvailable;
     };
 
-    PrefetchResult PrefetchMinibatch(size_t currentDataTransferIndex);
+    // Data structure required for prefetch.
+    struct StreamPrefetchBuffer
+    {
+        std::shared_ptr<MSR_CNTK::Matrix<ElemType>> m_matrix;
+        MSR_CNTK::MBLayoutPtr m_mbLayout;
+        NDShape m_sampleShape;
+    };
+
+    // A minibatch prepared by the prefetch thread.
+    // When the main thread enters GetMinibatch it swaps the matrices from the oldest ready slot,
+    // waits if memCpy is still in progress and hands the slot back to the prefetch thread.
+    struct PrefetchSlot
+    {
+        std::unordered_map<std::wstring, StreamPrefetchBuffer> m_buffers;
+
+        // Each slot has its own data transfer, so that the copies of all prepared minibatches
+        // can be in flight at the same time.
+        MSR_CNTK::DataTransfererPtr m_dataTransferer;
+
+        PrefetchResult m_result;
+
+        // Id to key mapping of the minibatch.
+        std::function<std::string(size_t)> m_getKeyById;
+
+        // State of the reader right after this minibatch has been read.
+        std::map<std::wstring, size_t> m_state;
+    };
+
+    PrefetchResult PrefetchMinibatch(PrefetchSlot& slot);
 
-    std::future<PrefetchResult> m_prefetchTask;
     ReaderPtr m_reader;
     ReaderFactory m_factory;
     bool m_endOfEpoch;
@@ -138,32 +188,29 @@ private:
     std::unordered_map<std::wstring, size_t> m_nameToStreamId;
 
     std::vector<StreamInformation> m_streams;
-    launch m_launchType;
 
-    // Data structure required for prefetch.
-    struct StreamPrefetchBuffer
-    {
-        std::shared_ptr<MSR_CNTK::Matrix<ElemType>> m_matrix;
-        MSR_CNTK::MBLayoutPtr m_mbLayout;
-        NDShape m_sampleShape;
-    };
+    // If false, minibatches are read synchronously inside GetMinibatch using the first slot.
+    bool m_prefetch;
 
-    // Intermediate buffer where the prefetch thread puts its data to.
-    // When the main thread enters GetMinibatch it swaps the matrices from this buffer,
-    // triggers the next prefetch and waits if memCpy is still in progress.
-    std::unordered_map<std::wstring, StreamPrefetchBuffer> m_prefetchBuffers;
+    // Bounded queue of prepared minibatches ('prefetchMinibatches' in the config, 1 by default).
+    // The prefetch thread fills free slots in order, the main thread consumes ready slots in order.
+    // Slots can be resized only with no ongoing prefetch.
+    std::vector<PrefetchSlot> m_slots;
+    std::deque<size_t> m_freeSlots;
+    std::deque<size_t> m_readySlots;
 
-    // Alternating data transfer operations. In the current version these are only two - 
-    // currently waiting on the main thread and the one that can be started by the prefetch thread 
-    // in the meantime.
-    std::vector<MSR_CNTK::DataTransfererPtr> m_dataTransferers;
+    std::thread m_prefetchThread;
+    std::mutex m_prefetchMutex;
+    std::condition_variable m_slotFreed;
+    std::condition_variable m_slotReady;
+    bool m_stopPrefetch;
+    std::exception_ptr m_prefetchError;
 
-    // Id to key mapping.
-    std::function<std::string(size_t)> m_getKeyById;
+    PipelineStatistics m_pipelineStatistics;
+    int m_verbosity;
 
-    // Current data transfer. Flips 0 and 1.
-    // Can be changed only from the main thread with no ongoing prefetch.
-    size_t m_currentDataTransferIndex; 
+    // Id to key mapping of the last returned minibatch.
+    std::function<std::string(size_t)> m_getKeyById;
 
     // Device id.
     int m_deviceId;
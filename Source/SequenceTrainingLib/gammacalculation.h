@@ -8,6 +8,7 @@
 #include "Matrix.h"
 #include "CUDAPageLockedMemAllocator.h"
 
+#include <exception>
 #include <memory>
 #include <vector>
 
@@ -100,10 +101,8 @@ public:
     {
         // check total frame number to be added ?
         // int deviceid = loglikelihood.GetDeviceId();
-        size_t boundaryframenum;
         std::vector<size_t> validframes; // [s] cursor pointing to next utterance begin within a single parallel sequence [s]
         validframes.assign(samplesInRecurrentStep, 0);
-        ElemType objectValue = 0.0;
         // convert from Microsoft::MSR::CNTK::Matrix to  msra::math::ssematrixbase
         size_t numrows = loglikelihood.GetNumRows();
         size_t numcols = loglikelihood.GetNumCols();
@@ -126,15 +125,30 @@ public:
             assert(T == pMBLayout->GetNumTimeSteps());
         }
 
-        size_t mapi = 0; // parallel-sequence index for utterance [i]
-        // cal gamma for each utterance
+        // per-utterance bookkeeping, so that the lattice-level work can run separately from the copies
+        struct utterance
+        {
+            size_t ts;         // first column in pred/dengammas
+            size_t numframes;
+            size_t mapi;       // parallel-sequence index
+            size_t firstframe; // first time step within the parallel sequence
+            double numavlogp;
+            double denavlogp;
+        };
+        std::vector<utterance> utterances(lattices.size());
+
+        // prepare utterance [i]: copy its loglikelihoods into pred and compute the numerator score
         size_t ts = 0;
-        for (size_t i = 0; i < lattices.size(); i++)
+        auto prepare = [&](size_t i)
         {
+            auto& utt = utterances[i];
             const size_t numframes = lattices[i]->getnumframes();
+            utt.ts = ts;
+            utt.numframes = numframes;
+            utt.mapi = 0;
+            utt.firstframe = 0;
 
-            msra::dbn::matrixstripe predstripe(pred, ts, numframes);           // logLLs for this utterance
-            msra::dbn::matrixstripe dengammasstripe(dengammas, ts, numframes); // denominator gammas
+            msra::dbn::matrixstripe predstripe(pred, ts, numframes); // logLLs for this utterance
 
             if (samplesInRecurrentStep == 1) // no sequence parallelism
             {
@@ -150,16 +164,17 @@ public:
             else // multiple parallel sequences
             {
                 // get number of frames for the utterance
-                mapi = extrauttmap[i]; // parallel-sequence index; in case of >1 utterance within this parallel sequence, this is in order of concatenation
+                utt.mapi = extrauttmap[i]; // parallel-sequence index; in case of >1 utterance within this parallel sequence, this is in order of concatenation
+                utt.firstframe = validframes[utt.mapi];
 
                 // scan MBLayout for end of utterance
                 size_t mapframenum = SIZE_MAX; // duration of utterance [i] as determined from MBLayout
-                for (size_t t = validframes[mapi]; t < T; t++)
+                for (size_t t = utt.firstframe; t < T; t++)
                 {
                     // TODO: Adapt this to new MBLayout, m_sequences would be easier to work off.
-                    if (pMBLayout->IsEnd(mapi, t))
+                    if (pMBLayout->IsEnd(utt.mapi, t))
                     {
-                        mapframenum = t - validframes[mapi] + 1;
+                        mapframenum = t - utt.firstframe + 1;
                         break;
                     }
                 }
@@ -172,7 +187,7 @@ public:
                 if (numframes > tempmatrix.GetNumCols())
                     tempmatrix.Resize(numrows, numframes);
 
-                Microsoft::MSR::CNTK::Matrix<ElemType> loglikelihoodForCurrentParallelUtterance = loglikelihood.ColumnSlice(mapi + (validframes[mapi] * samplesInRecurrentStep), ((numframes - 1) * samplesInRecurrentStep) + 1);
+                Microsoft::MSR::CNTK::Matrix<ElemType> loglikelihoodForCurrentParallelUtterance = loglikelihood.ColumnSlice(utt.mapi + (utt.firstframe * samplesInRecurrentStep), ((numframes - 1) * samplesInRecurrentStep) + 1);
                 tempmatrix.CopyColumnsStrided(loglikelihoodForCurrentParallelUtterance, numframes, samplesInRecurrentStep, 1);
 
                 // if (doreferencealign || m_deviceid == CPUDEVICE)
@@ -184,42 +199,54 @@ public:
                 {
                     parallellattice.setloglls(tempmatrix);
                 }
+                validframes[utt.mapi] += numframes; // advance the cursor within the parallel sequence
             }
 
             array_ref<size_t> uidsstripe(&uids[ts], numframes);
-
-            if (doreferencealign)
-            {
-                boundaryframenum = numframes;
-            }
-            else
-                boundaryframenum = 0;
-            array_ref<size_t> boundariesstripe(&boundaries[ts], boundaryframenum);
-
             double numavlogp = 0;
-            foreach_column (t, dengammasstripe) // we do not allocate memory for numgamma now, should be the same as numgammasstripe
+            foreach_column (t, predstripe) // we do not allocate memory for numgamma now, should be the same as numgammasstripe
             {
                 const size_t s = uidsstripe[t];
                 numavlogp += predstripe(s, t) / amf;
             }
-            numavlogp /= numframes;
+            utt.numavlogp = numavlogp / numframes;
+            ts += numframes;
+        };
+
+        // lattice-level forward-backward for utterance [i]; touches only the columns of utterance [i]
+        auto compute = [&](size_t i)
+        {
+            auto& utt = utterances[i];
+            msra::dbn::matrixstripe predstripe(pred, utt.ts, utt.numframes);           // logLLs for this utterance
+            msra::dbn::matrixstripe dengammasstripe(dengammas, utt.ts, utt.numframes); // denominator gammas
+            array_ref<size_t> uidsstripe(&uids[utt.ts], utt.numframes);
+            array_ref<size_t> boundariesstripe(&boundaries[utt.ts], doreferencealign ? utt.numframes : 0);
 
             // auto_timer dengammatimer;
-            double denavlogp = lattices[i]->second.forwardbackward(parallellattice,
-                                                                   (const msra::math::ssematrixbase&) predstripe, (const msra::asr::simplesenonehmm&) m_hset,
-                                                                   (msra::math::ssematrixbase&) dengammasstripe, (msra::math::ssematrixbase&) gammasbuffer /*empty, not used*/,
-                                                                   lmf, wp, amf, boostmmifactor, seqsMBRmode, uidsstripe, boundariesstripe);
-            objectValue += (ElemType)((numavlogp - denavlogp) * numframes);
+            utt.denavlogp = lattices[i]->second.forwardbackward(parallellattice,
+                                                                (const msra::math::ssematrixbase&) predstripe, (const msra::asr::simplesenonehmm&) m_hset,
+                                                                (msra::math::ssematrixbase&) dengammasstripe, (msra::math::ssematrixbase&) gammasbuffer /*empty, not used*/,
+                                                                lmf, wp, amf, boostmmifactor, seqsMBRmode, uidsstripe, boundariesstripe);
+        };
+
+        // accumulate the objective and copy the gammas of utterance [i] back
+        ElemType objectValue = 0.0;
+        auto finish = [&](size_t i)
+        {
+            const auto& utt = utterances[i];
+            const size_t numframes = utt.numframes;
+            objectValue += (ElemType)((utt.numavlogp - utt.denavlogp) * numframes);
 
             if (samplesInRecurrentStep == 1)
             {
-                tempmatrix = gammafromlattice.ColumnSlice(ts, numframes);
+                tempmatrix = gammafromlattice.ColumnSlice(utt.ts, numframes);
             }
 
             // copy gamma to tempmatrix
             if (m_deviceid == CPUDEVICE)
             {
-                CopyFromSSEMatrixToCNTKMatrix(dengammas, numrows, numframes, tempmatrix, gammafromlattice.GetDeviceId());
+                msra::dbn::matrixstripe dengammasstripe(dengammas, utt.ts, numframes);
+                CopyFromSSEMatrixToCNTKMatrix(dengammasstripe, numrows, numframes, tempmatrix, gammafromlattice.GetDeviceId());
             }
             else
                 parallellattice.getgamma(tempmatrix);
@@ -227,25 +254,64 @@ public:
             // set gamma for multi channel
             if (samplesInRecurrentStep > 1)
             {
-                Microsoft::MSR::CNTK::Matrix<ElemType> gammaFromLatticeForCurrentParallelUtterance = gammafromlattice.ColumnSlice(mapi + (validframes[mapi] * samplesInRecurrentStep), ((numframes - 1) * samplesInRecurrentStep) + 1);
+                Microsoft::MSR::CNTK::Matrix<ElemType> gammaFromLatticeForCurrentParallelUtterance = gammafromlattice.ColumnSlice(utt.mapi + (utt.firstframe * samplesInRecurrentStep), ((numframes - 1) * samplesInRecurrentStep) + 1);
                 gammaFromLatticeForCurrentParallelUtterance.CopyColumnsStrided(tempmatrix, numframes, 1, samplesInRecurrentStep);
             }
 
             if (doreferencealign)
             {
+                array_ref<size_t> uidsstripe(&uids[utt.ts], numframes);
                 for (size_t nframe = 0; nframe < numframes; nframe++)
                 {
                     size_t uid = uidsstripe[nframe];
                     if (samplesInRecurrentStep > 1)
-                        labels(uid, (nframe + validframes[mapi]) * samplesInRecurrentStep + mapi) = 1.0;
+                        labels(uid, (nframe + utt.firstframe) * samplesInRecurrentStep + utt.mapi) = 1.0;
                     else
-                        labels(uid, ts + nframe) = 1.0;
+                        labels(uid, utt.ts + nframe) = 1.0;
                 }
             }
-            if (samplesInRecurrentStep > 1)
-                validframes[mapi] += numframes; // advance the cursor within the parallel sequence
-            fprintf(stderr, "dengamma value %f\n", denavlogp);
-            ts += numframes;
+            fprintf(stderr, "dengamma value %f\n", utt.denavlogp);
+        };
+
+        // cal gamma for each utterance
+        if (parallellattice.enabled())
+        {
+            // the CUDA implementation keeps one utterance's state on the device at a time
+            for (size_t i = 0; i < lattices.size(); i++)
+            {
+                prepare(i);
+                compute(i);
+                finish(i);
+            }
+        }
+        else
+        {
+            // on the CPU, the lattices of the minibatch are independent and processed concurrently;
+            // copies and the objective are done in utterance order, so results match the sequential version
+            for (size_t i = 0; i < lattices.size(); i++)
+                prepare(i);
+
+            const int numlattices = (int) lattices.size();
+            std::exception_ptr firsterror;
+#pragma omp parallel for schedule(dynamic, 1)
+            for (int i = 0; i < numlattices; i++)
+            {
+                try
+                {
+                    compute(i);
+                }
+                catch (...)
+                {
+#pragma omp critical
+                    if (!firsterror)
+                        firsterror = std::current_exception();
+                }
+            }
+            if (firsterror)
+                std::rethrow_exception(firsterror);
+
+            for (size_t i = 0; i < lattices.size(); i++)
+                finish(i);
         }
         functionValues.SetValue(objectValue);
     }
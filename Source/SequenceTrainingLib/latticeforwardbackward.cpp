@@ -15,6 +15,7 @@
 #include <unordered_map>
 #include <list>
 #include <stdexcept>
+#include <exception>
 
 using namespace std;
 
@@ -517,6 +518,13 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
     logbetas.assign(nodes.size(), LOGZERO);
     logbetas.back() = 0.0f;
 
+    // per-edge scores do not depend on the recursion, so they are computed up front in a flat loop
+    // Note: the logadd() accumulation into the nodes below stays in edge order, since a node
+    // receives contributions from several edges and a different order would round differently.
+    std::vector<double> edgescores(edges.size());
+    foreach_index (j, edges)
+        edgescores[j] = (edges[j].l * lmf + wp + edgeacscores[j]) / amf; // note: edgeacscores[j] == LOGZERO if edge was pruned
+
     // --- sMBR version
 
     if (sMBRmode)
@@ -535,7 +543,7 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
                 continue;
             const auto &e = edges[j];
             const double inscore = logalphas[e.S];
-            const double edgescore = (e.l * lmf + wp + edgeacscores[j]) / amf;
+            const double edgescore = edgescores[j];
             const double pathscore = inscore + edgescore;
             logadd(logalphas[e.E], pathscore);
 
@@ -568,7 +576,7 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
                 continue;
             const auto &e = edges[j];
             const double inscore = logbetas[e.E];
-            const double edgescore = (e.l * lmf + wp + edgeacscores[j]) / amf;
+            const double edgescore = edgescores[j];
             const double pathscore = inscore + edgescore;
             logadd(logbetas[e.S], pathscore);
 
@@ -610,8 +618,7 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
     {
         const auto &e = edges[j];
         const double inscore = logalphas[e.S];
-        const double edgescore = (e.l * lmf + wp + edgeacscores[j]) / amf; // note: edgeacscores[j] == LOGZERO if edge was pruned
-        const double pathscore = inscore + edgescore;
+        const double pathscore = inscore + edgescores[j];
         logadd(logalphas[e.E], pathscore);
     }
     const double totalfwscore = logalphas.back();
@@ -622,17 +629,20 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
     }
 
     // backward pass
-    // this also computes the word posteriors on the fly, since we are at it
     for (size_t j = edges.size() - 1; j + 1 > 0; j--)
     {
         const auto &e = edges[j];
         const double inscore = logbetas[e.E];
-        const double edgescore = (e.l * lmf + wp + edgeacscores[j]) / amf;
-        const double pathscore = inscore + edgescore;
+        const double pathscore = inscore + edgescores[j];
         logadd(logbetas[e.S], pathscore);
+    }
 
-        // compute lattice posteriors on the fly since we are at it
-        double logpp = logalphas[e.S] + edgescore + logbetas[e.E] - totalfwscore;
+    // lattice posteriors
+    // Once alphas and betas are final, the edges are independent of each other, so this is a flat loop as well.
+    foreach_index (j, edges)
+    {
+        const auto &e = edges[j];
+        double logpp = logalphas[e.S] + edgescores[j] + logbetas[e.E] - totalfwscore;
         if (logpp > 1e-2)
             fprintf(stderr, "forwardbackward: WARNING: edge J=%d log posterior %.10f > 0\n", (int) j, (float) logpp);
         if (logpp > 0.0)
@@ -952,26 +962,51 @@ void lattice::forwardbackwardalign(parallelstate &parallelstate,
             parallelstate.getedgeacscores(edgeacscoresgpu);
             parallelstate.copyalignments(thisedgealignmentsgpu);
         }
-        foreach_index (j, edges)
+        // Edges are independent of each other (each has its own abcs[j] and alignment slot),
+        // so they are processed concurrently; results are identical to the sequential order.
+        // When called from within a parallel region (one lattice per thread), this runs serially.
+        const int numedges = (int) edges.size();
+        thisedgealignments.getalignmentsbuffer(); // allocate up front; operator[] would do it lazily, which races
+        std::exception_ptr firsterror;
+#pragma omp parallel for schedule(dynamic, 16) if (!cpuverification)
+        for (int j = 0; j < numedges; j++)
         {
-            const edgeinfowithscores &e = edges[j];
-            const size_t ts = nodes[e.S].t;
-            const size_t te = nodes[e.E].t;
-            if (ts == te) // dummy !NULL edge at end
-                edgeacscores[j] = 0.0f;
-            else
+            try
             {
-                const auto &aligntokens = getaligninfo(j); // get alignment tokens
-                const auto edgeLLs = msra::math::ssematrixstriperef<msra::math::ssematrixbase>(const_cast<msra::math::ssematrixbase &>(logLLs), ts, te - ts);
-                if (minlogpp > LOGZERO && origlogpps[j] < minlogpp)
-                    edgeacscores[j] = LOGZERO; // will kill word level forwardbackward hypothesis
-                else if (softalignstates)
-                    edgeacscores[j] = forwardbackwardedge(aligntokens, hset, edgeLLs, *abcs[j], j);
+                const edgeinfowithscores &e = edges[j];
+                const size_t ts = nodes[e.S].t;
+                const size_t te = nodes[e.E].t;
+                if (ts == te) // dummy !NULL edge at end
+                    edgeacscores[j] = 0.0f;
                 else
-                    edgeacscores[j] = alignedge(aligntokens, hset, edgeLLs, *abcs[j], j, returnsenoneids, thisedgealignments[j]);
+                {
+                    const auto &aligntokens = getaligninfo(j); // get alignment tokens
+                    const auto edgeLLs = msra::math::ssematrixstriperef<msra::math::ssematrixbase>(const_cast<msra::math::ssematrixbase &>(logLLs), ts, te - ts);
+                    if (minlogpp > LOGZERO && origlogpps[j] < minlogpp)
+                        edgeacscores[j] = LOGZERO; // will kill word level forwardbackward hypothesis
+                    else if (softalignstates)
+                        edgeacscores[j] = forwardbackwardedge(aligntokens, hset, edgeLLs, *abcs[j], j);
+                    else
+                        edgeacscores[j] = alignedge(aligntokens, hset, edgeLLs, *abcs[j], j, returnsenoneids, thisedgealignments[j]);
+                }
             }
-            if (cpuverification)
+            catch (...)
+            {
+#pragma omp critical
+                if (!firsterror)
+                    firsterror = std::current_exception();
+            }
+        }
+        if (firsterror)
+            std::rethrow_exception(firsterror);
+
+        if (cpuverification)
+        {
+            foreach_index (j, edges)
             {
+                const edgeinfowithscores &e = edges[j];
+                const size_t ts = nodes[e.S].t;
+                const size_t te = nodes[e.E].t;
                 const auto &aligntokens = getaligninfo(j); // get alignment tokens
                 bool edgehassil = false;
                 foreach_index (i, aligntokens)
@@ -7,6 +7,7 @@
 
 #include "CNTKLibrary.h"
 #include "Common.h"
+#include <numeric>
 
 using namespace CNTK;
 using namespace std;
@@ -48,6 +49,45 @@ namespace
             totalNumberOfSamples, true);
     }
 
+    // Average training loss of the classifier on the first samples of the data.
+    double AverageLoss(const FeedForwardClassifier& classifier, const DeviceDescriptor& device)
+    {
+        const size_t numSamples = 500;
+        auto minibatchSource = TextFormatMinibatchSource(g_inputFile, { { g_featureStreamName, classifier.inputDim }, { g_labelsStreamName, classifier.outputDim } }, MinibatchSource::FullDataSweep, false);
+        auto minibatchData = minibatchSource->GetNextMinibatch(numSamples, device);
+
+        std::unordered_map<Variable, ValuePtr> outputs = { { classifier.trainingLoss->Output(), nullptr } };
+        classifier.trainingLoss->Forward({ { classifier.features, minibatchData[minibatchSource->StreamInfo(g_featureStreamName)].data },
+                                           { classifier.labels, minibatchData[minibatchSource->StreamInfo(g_labelsStreamName)].data } },
+                                         outputs, device);
+
+        auto loss = outputs[classifier.trainingLoss->Output()]->Data()->DeepClone(DeviceDescriptor::CPUDevice());
+        auto lossData = loss->DataBuffer<float>();
+        auto numLossValues = loss->Shape().TotalSize();
+        return std::accumulate(lossData, lossData + numLossValues, 0.0) / numLossValues;
+    }
+
+    // Data parallel training must leave the same parameters on all workers.
+    void VerifyParametersAgreeAcrossWorkers(const FeedForwardClassifier& classifier)
+    {
+        auto communicator = MPICommunicator();
+        auto numWorkers = communicator->Workers().size();
+        for (const auto& parameter : classifier.output->Parameters())
+        {
+            auto local = parameter.Value()->DeepClone(DeviceDescriptor::CPUDevice());
+            auto sum = local->DeepClone();
+            communicator->AggregateInPlace({ sum }, communicator->Workers());
+
+            auto numValues = local->Shape().TotalSize();
+            std::vector<float> expected(local->DataBuffer<float>(), local->DataBuffer<float>() + numValues);
+            for (auto& value : expected)
+                value *= numWorkers;
+
+            std::vector<float> actual(sum->DataBuffer<float>(), sum->DataBuffer<float>() + numValues);
+            FloatingPointVectorCompare(actual, expected, "Parameters differ across workers");
+        }
+    }
+
     void LoopBasedOnSamples(const std::wstring& name, const DeviceDescriptor& device, std::function<DistributedLearnerPtr(LearnerPtr)> factory, const FeedForwardClassifier& classifier)
     {
         printf("Training loop thru samples with %ls.\n", name.c_str());
@@ -71,7 +111,14 @@ namespace
             std::numeric_limits<size_t>::max(),
             CheckpointConfig(L"test", checkpointFrequency, false));
 
+        double lossBeforeTraining = AverageLoss(classifier, device);
         session->Train(device);
+        double lossAfterTraining = AverageLoss(classifier, device);
+
+        if (lossAfterTraining >= lossBeforeTraining)
+            ReportFailure("Training with %ls did not decrease the loss; before %g, after %g.", name.c_str(), lossBeforeTraining, lossAfterTraining);
+
+        VerifyParametersAgreeAcrossWorkers(classifier);
     }
 
     FeedForwardClassifier BuildFeedForwardClassifier(const DeviceDescriptor& device, bool noEval = false)
@@ -112,6 +159,7 @@ void TestFrameMode()
     // Create a set of trainers.
     std::map<std::wstring, std::function<DistributedLearnerPtr(LearnerPtr)>> learners;
     learners[L"simple"] = [](LearnerPtr l) { return CreateDataParallelDistributedLearner(MPICommunicator(), l, 0); };
+    learners[L"simpleasync"] = [](LearnerPtr l) { return CreateDataParallelDistributedLearner(MPICommunicator(), l, 0, true); };
 
     if (Is1bitSGDAvailable())
     {
@@ -0,0 +1,163 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// BeamSearchDecoding.cpp : Decode-throughput benchmark comparing beam search driven by per-hypothesis Function::Evaluate
+// calls with the BeamSearchDecoder, which advances all hypotheses of all sequences by one forward pass per step.
+//
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <stdio.h>
+#include "CNTKLibrary.h"
+
+using namespace CNTK;
+
+namespace
+{
+    struct StepModel
+    {
+        FunctionPtr m_function;
+        Variable m_token;
+        Variable m_state;
+        Variable m_context;
+        Variable m_scores;
+        Variable m_nextState;
+    };
+
+    // An untrained recurrent decoder step: the next state depends on the previous token, the state and the encoder context.
+    StepModel CreateStepModel(size_t vocabularySize, size_t stateDim, const DeviceDescriptor& device)
+    {
+        std::vector<Axis> batchAxis = { Axis::DefaultBatchAxis() };
+        auto token = InputVariable({ vocabularySize }, /*isSparse =*/ true, DataType::Float, L"token", batchAxis);
+        auto state = InputVariable({ stateDim }, DataType::Float, L"state", batchAxis);
+        auto context = InputVariable({ stateDim }, DataType::Float, L"context", batchAxis);
+
+        auto embedding = Parameter(NDArrayView::RandomNormal<float>({ stateDim, vocabularySize }, 0, 0.1, 1, device));
+        auto recurrence = Parameter(NDArrayView::RandomNormal<float>({ stateDim, stateDim }, 0, 0.1, 2, device));
+        auto projection = Parameter(NDArrayView::RandomNormal<float>({ vocabularySize, stateDim }, 0, 0.5, 3, device));
+        auto nextState = Tanh(Plus(Plus(Times(embedding, token), Times(recurrence, state)), context));
+        auto logits = Times(projection, nextState);
+        auto scores = Minus(logits, ReduceLogSum(logits, Axis(0)));
+
+        auto function = Combine({ scores, nextState });
+        return { function, token, state, context, function->Outputs()[0], function->Outputs()[1] };
+    }
+
+    // Decodes one sequence the way scripts calling Function::Evaluate do: one forward pass per hypothesis and token,
+    // with the state kept on the CPU. Returns the number of forward passes.
+    size_t DecodeStepByStep(const StepModel& model, const std::vector<float>& initialState, const std::vector<float>& context,
+                            size_t startToken, size_t endToken, size_t beamWidth, size_t maxLength, const DeviceDescriptor& device)
+    {
+        struct Hypothesis
+        {
+            std::vector<size_t> m_tokens;
+            std::vector<float> m_state;
+            double m_logProbability;
+        };
+        struct Candidate
+        {
+            double m_logProbability;
+            size_t m_parent;
+            size_t m_token;
+        };
+
+        size_t vocabularySize = model.m_token.Shape().TotalSize();
+        std::vector<Hypothesis> live = { { {}, initialState, 0.0 } };
+        std::vector<size_t> indices(vocabularySize);
+        size_t numEvaluations = 0;
+        for (size_t step = 0; step < maxLength && !live.empty(); step++)
+        {
+            std::vector<Candidate> candidates;
+            std::vector<std::vector<float>> nextStates(live.size());
+            for (size_t h = 0; h < live.size(); h++)
+            {
+                size_t previousToken = live[h].m_tokens.empty() ? startToken : live[h].m_tokens.back();
+                std::unordered_map<Variable, ValuePtr> arguments = {
+                    { model.m_token, Value::Create<float>(vocabularySize, std::vector<std::vector<size_t>>({ { previousToken } }), device, /*readOnly =*/ true) },
+                    { model.m_state, Value::CreateBatch(model.m_state.Shape(), live[h].m_state, device, /*readOnly =*/ true) },
+                    { model.m_context, Value::CreateBatch(model.m_context.Shape(), context, device, /*readOnly =*/ true) } };
+                std::unordered_map<Variable, ValuePtr> outputs = { { model.m_scores, nullptr }, { model.m_nextState, nullptr } };
+                model.m_function->Evaluate(arguments, outputs, device);
+                numEvaluations++;
+
+                auto scores = outputs[model.m_scores]->Data()->DeepClone(DeviceDescriptor::CPUDevice());
+                auto nextState = outputs[model.m_nextState]->Data()->DeepClone(DeviceDescriptor::CPUDevice());
+                nextStates[h].assign(nextState->DataBuffer<float>(), nextState->DataBuffer<float>() + nextState->Shape().TotalSize());
+
+                const float* scoreBuffer = scores->DataBuffer<float>();
+                std::iota(indices.begin(), indices.end(), (size_t)0);
+                std::partial_sort(indices.begin(), indices.begin() + beamWidth, indices.end(), [scoreBuffer](size_t a, size_t b) { return scoreBuffer[a] > scoreBuffer[b]; });
+                for (size_t i = 0; i < beamWidth; i++)
+                    candidates.push_back({ live[h].m_logProbability + scoreBuffer[indices[i]], h, indices[i] });
+            }
+
+            std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.m_logProbability > b.m_logProbability; });
+            std::vector<Hypothesis> nextLive;
+            for (size_t i = 0; i < candidates.size() && i < beamWidth; i++)
+            {
+                if (candidates[i].m_token == endToken)
+                    continue;
+
+                Hypothesis hypothesis{ live[candidates[i].m_parent].m_tokens, nextStates[candidates[i].m_parent], candidates[i].m_logProbability };
+                hypothesis.m_tokens.push_back(candidates[i].m_token);
+                nextLive.push_back(std::move(hypothesis));
+            }
+            live.swap(nextLive);
+        }
+        return numEvaluations;
+    }
+}
+
+/// <summary>
+/// Measures the decode throughput of beam search over a recurrent decoder step.
+/// </summary>
+/// <description>
+/// A batch of numSequences sequences is decoded with an untrained step model (so the scores are close to uniform and
+/// pruning does real work). First, every sequence is decoded by a loop that evaluates the step Function once per
+/// hypothesis and token, as decoding scripts do. Then the whole batch is decoded by a BeamSearchDecoder, which evaluates
+/// all live hypotheses of all sequences in one forward pass per step.
+/// </description>
+void BeamSearchDecodingBenchmark(const DeviceDescriptor& device)
+{
+    const size_t vocabularySize = 10000;
+    const size_t stateDim = 256;
+    const size_t numSequences = 32;
+    const size_t startToken = 0;
+    const size_t endToken = 1;
+    const size_t beamWidth = 4;
+    const size_t maxLength = 20;
+
+    printf("\n##### Run beam search decoding benchmark on device=%d. #####\n", device.Id());
+
+    auto model = CreateStepModel(vocabularySize, stateDim, device);
+    auto initialStates = NDArrayView::RandomUniform<float>({ stateDim, numSequences }, -1, 1, 4, DeviceDescriptor::CPUDevice());
+    auto contexts = NDArrayView::RandomUniform<float>({ stateDim, numSequences }, -1, 1, 5, DeviceDescriptor::CPUDevice());
+    auto sequenceData = [stateDim](const NDArrayViewPtr& data, size_t sequence)
+    {
+        return std::vector<float>(data->DataBuffer<float>() + sequence * stateDim, data->DataBuffer<float>() + (sequence + 1) * stateDim);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    size_t numEvaluations = 0;
+    for (size_t s = 0; s < numSequences; s++)
+        numEvaluations += DecodeStepByStep(model, sequenceData(initialStates, s), sequenceData(contexts, s), startToken, endToken, beamWidth, maxLength, device);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Per-hypothesis evaluation: %.1f sequences/s (%lu forward passes)\n", numSequences / seconds, (unsigned long)numEvaluations);
+
+    auto decoder = CreateBeamSearchDecoder(model.m_function, model.m_token, model.m_scores, { { model.m_state, model.m_nextState } }, startToken, endToken, beamWidth, maxLength, device);
+    std::unordered_map<Variable, ValuePtr> arguments = {
+        { model.m_state, MakeSharedObject<Value>(initialStates) },
+        { model.m_context, MakeSharedObject<Value>(contexts) } };
+
+    start = std::chrono::steady_clock::now();
+    auto results = decoder->Decode(arguments, /*nBest =*/ beamWidth);
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto statistics = decoder->Statistics();
+    printf("BeamSearchDecoder (beam width %lu): %.1f sequences/s (%lu forward passes over %lu hypotheses)\n",
+           (unsigned long)beamWidth, numSequences / seconds, (unsigned long)statistics.m_numSteps, (unsigned long)statistics.m_numHypothesisSteps);
+    printf("Evaluation %.3f s, search %.3f s; best hypothesis of the first sequence has %lu tokens.\n",
+           statistics.m_evaluationSeconds, statistics.m_searchSeconds, (unsigned long)results[0][0].m_tokens.size());
+    fflush(stdout);
+}
@@ -18,6 +18,8 @@ void EvaluationBatchOfSequencesUsingOneHot(const wchar_t*, const wchar_t*, const
 void EvaluationSingleSequenceUsingSparse(const wchar_t*, const wchar_t*, const wchar_t*, const CNTK::DeviceDescriptor&);
 void EvaluateIntermediateLayer(const wchar_t*, const CNTK::DeviceDescriptor& device);
 void EvaluateCombinedOutputs(const wchar_t*, const CNTK::DeviceDescriptor& device);
+void BatchingEvaluationBenchmark(const wchar_t*, const CNTK::DeviceDescriptor&);
+void BeamSearchDecodingBenchmark(const CNTK::DeviceDescriptor&);
 bool ShouldRunOnCpu();
 bool ShouldRunOnGpu();
 
@@ -43,6 +45,8 @@ int main()
         MultiThreadsEvaluationTests(oneHiddenModel, true);
         EvaluateIntermediateLayer(resnet20Model, CNTK::DeviceDescriptor::GPUDevice(0));
         EvaluateCombinedOutputs(resnet20Model, CNTK::DeviceDescriptor::GPUDevice(0));
+        BatchingEvaluationBenchmark(oneHiddenModel, CNTK::DeviceDescriptor::GPUDevice(0));
+        BeamSearchDecodingBenchmark(CNTK::DeviceDescriptor::GPUDevice(0));
     }
 
     if (ShouldRunOnCpu())
@@ -59,6 +63,8 @@ int main()
         MultiThreadsEvaluationTests(oneHiddenModel, false);
         EvaluateIntermediateLayer(resnet20Model, CNTK::DeviceDescriptor::CPUDevice());
         EvaluateCombinedOutputs(resnet20Model, CNTK::DeviceDescriptor::CPUDevice());
+        BatchingEvaluationBenchmark(oneHiddenModel, CNTK::DeviceDescriptor::CPUDevice());
+        BeamSearchDecodingBenchmark(CNTK::DeviceDescriptor::CPUDevice());
     }
 
     printf("Evaluation complete.\n");
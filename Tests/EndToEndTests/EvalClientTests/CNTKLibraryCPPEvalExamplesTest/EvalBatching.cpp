@@ -0,0 +1,114 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// EvalBatching.cpp : Load generator comparing single-sample evaluation with the BatchingEvaluator, which coalesces
+// concurrent single-sample requests into batches.
+//
+#include <chrono>
+#include <future>
+#include <random>
+#include <stdio.h>
+#include "CNTKLibrary.h"
+
+using namespace CNTK;
+
+namespace
+{
+    // Creates the data of a single request: one sample of the given shape.
+    NDArrayViewPtr CreateRequestData(const NDShape& sampleShape, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> pixel(0, 255);
+        auto data = MakeSharedObject<NDArrayView>(DataType::Float, sampleShape, DeviceDescriptor::CPUDevice());
+        auto buffer = data->WritableDataBuffer<float>();
+        for (size_t i = 0; i < sampleShape.TotalSize(); i++)
+            buffer[i] = pixel(rng);
+        return data;
+    }
+
+    void PrintHistogram(const char* name, const std::vector<size_t>& histogram)
+    {
+        printf("%s:", name);
+        for (size_t i = 0; i < histogram.size(); i++)
+        {
+            if (histogram[i] != 0)
+                printf(" %lu:%lu", (unsigned long)i, (unsigned long)histogram[i]);
+        }
+        printf("\n");
+    }
+}
+
+/// <summary>
+/// Measures the throughput of single-sample requests issued by several client threads.
+/// </summary>
+/// <description>
+/// Each client issues numRequestsPerClient requests of a single sample, and waits for the result before it issues the next one.
+/// First, each client evaluates its requests itself on its own clone of the model (sharing the parameters), which runs
+/// many batch-1 forward passes. Then all clients submit their requests to one BatchingEvaluator, which evaluates
+/// them in batches of up to maxBatchSize samples. The batch size and queue depth histograms show how well the
+/// requests could be coalesced.
+/// It uses the model trained by Examples\Image\GettingStarted\01_OneHidden.cntk; 01_OneHidden.model needs to be in the current directory.
+/// </description>
+void BatchingEvaluationBenchmark(const wchar_t* modelFileName, const DeviceDescriptor& device)
+{
+    const size_t numClients = 16;
+    const size_t numRequestsPerClient = 200;
+    const size_t maxBatchSize = 16;
+    const auto maxLatency = std::chrono::microseconds(1000);
+
+    printf("\n##### Run batching evaluation benchmark on device=%d with %lu clients. #####\n", device.Id(), (unsigned long)numClients);
+
+    auto model = Function::Load(modelFileName, device);
+    auto sampleShape = model->Arguments()[0].Shape();
+    auto input = model->Arguments()[0];
+    auto output = model->Output();
+
+    auto runClients = [&](const std::function<void(size_t client, const NDArrayViewPtr& data)>& evaluate) -> double
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::future<void>> clients;
+        for (size_t c = 0; c < numClients; c++)
+        {
+            clients.push_back(std::async(std::launch::async, [&, c]()
+            {
+                std::mt19937 rng((unsigned int)c);
+                for (size_t r = 0; r < numRequestsPerClient; r++)
+                    evaluate(c, CreateRequestData(sampleShape, rng));
+            }));
+        }
+        for (auto& client : clients)
+            client.get();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return numClients * numRequestsPerClient / seconds;
+    };
+
+    // Every client evaluates batches of one sample on its own clone.
+    std::vector<FunctionPtr> clones;
+    for (size_t c = 0; c < numClients; c++)
+        clones.push_back(model->Clone(ParameterCloningMethod::Share));
+
+    double singleSampleThroughput = runClients([&](size_t client, const NDArrayViewPtr& data)
+    {
+        auto clone = clones[client];
+        std::unordered_map<Variable, ValuePtr> outputs = { { clone->Output(), nullptr } };
+        clone->Evaluate({ { clone->Arguments()[0], Value::Create(sampleShape, { data }, device, /*readOnly =*/ true) } }, outputs, device);
+    });
+    printf("Single-sample evaluation: %.1f requests/s\n", singleSampleThroughput);
+
+    // All clients submit to the same batching evaluator.
+    auto evaluator = CreateBatchingEvaluator(model, maxBatchSize, maxLatency, device);
+    double batchedThroughput = runClients([&](size_t /*client*/, const NDArrayViewPtr& data)
+    {
+        evaluator->Evaluate({ { input, data } }).get().at(output);
+    });
+    printf("Batching evaluator (max batch size %lu, max latency %ld us): %.1f requests/s\n",
+           (unsigned long)maxBatchSize, (long)maxLatency.count(), batchedThroughput);
+
+    auto statistics = evaluator->Statistics();
+    printf("%lu requests in %lu batches, %.1f requests per batch.\n",
+           (unsigned long)statistics.m_numRequests, (unsigned long)statistics.m_numBatches, (double)statistics.m_numRequests / statistics.m_numBatches);
+    PrintHistogram("Batch sizes", statistics.m_batchSizeHistogram);
+    PrintHistogram("Queue depths", statistics.m_queueDepthHistogram);
+    fflush(stdout);
+}
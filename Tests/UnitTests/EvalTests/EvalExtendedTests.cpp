@@ -7,6 +7,7 @@
 #include "ComputationNode.h"
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
+#include <future>
 
 using namespace Microsoft::MSR::CNTK;
 
@@ -227,6 +228,66 @@ BOOST_AUTO_TEST_CASE(EvalDenseTimesTest)
     eval->Destroy();
 }
 
+BOOST_AUTO_TEST_CASE(EvalConcurrentExecutionContextsTest)
+{
+    std::string modelDefinition =
+        "deviceId = -1 \n"
+        "precision = \"float\" \n"
+        "traceLevel = 1 \n"
+        "run=NDLNetworkBuilder \n"
+        "NDLNetworkBuilder=[ \n"
+        "i1 = Input(4) \n"
+        "o1 = Times(Constant(2, rows=1, cols=4), Plus(i1, i1), tag=\"output\") \n"
+        "FeatureNodes = (i1) \n"
+        "] \n";
+
+    VariableSchema inputLayouts;
+    VariableSchema outputLayouts;
+    IEvaluateModelExtended<float> *eval;
+    eval = SetupNetworkAndGetLayouts(modelDefinition, inputLayouts, outputLayouts);
+
+    // Contexts can only be created once the outputs are known
+    IEvaluateModelExtended<float>* notStarted;
+    GetEvalExtendedF(&notStarted);
+    BOOST_REQUIRE_THROW(notStarted->CreateExecutionContext(), std::exception);
+    notStarted->Destroy();
+
+    const size_t numContexts = 4;
+    std::vector<IEvaluateModelExtended<float>*> contexts{ eval };
+    for (size_t i = 1; i < numContexts; i++)
+        contexts.push_back(eval->CreateExecutionContext());
+
+    // Every context evaluates its own inputs, concurrently with the others
+    std::vector<std::future<std::vector<float>>> results;
+    for (size_t i = 0; i < numContexts; i++)
+    {
+        results.push_back(std::async(std::launch::async, [&contexts, &outputLayouts, i]()
+        {
+            std::vector<float> outputs;
+            for (size_t r = 0; r < 100; r++)
+            {
+                Values<float> inputBuffer(1);
+                inputBuffer[0].m_buffer = { (float)i, (float)r, 0, 1 };
+                Values<float> outputBuffer = outputLayouts.CreateBuffers<float>({ 1 });
+                contexts[i]->ForwardPass(inputBuffer, outputBuffer);
+                outputs.push_back(outputBuffer[0].m_buffer[0]);
+            }
+            return outputs;
+        }));
+    }
+
+    for (size_t i = 0; i < numContexts; i++)
+    {
+        auto outputs = results[i].get();
+        for (size_t r = 0; r < outputs.size(); r++)
+            BOOST_CHECK_EQUAL(outputs[r], 4.0f * (i + r + 1));
+    }
+
+    for (size_t i = 1; i < numContexts; i++)
+        contexts[i]->Destroy();
+    eval->Destroy();
+}
+
 BOOST_AUTO_TEST_CASE(EvalSparseTimesTest)
 {
     std::string modelDefinition =
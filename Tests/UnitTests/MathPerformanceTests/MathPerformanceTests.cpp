@@ -9,8 +9,10 @@
 //#include "Windows.h"
 #include "Matrix.h"
 #include "CPUMatrix.h"
+#include "CPUSparseMatrix.h"
 #include "TensorView.h"
 #include "Sequences.h"
+#include "ConvolutionEngine.h"
 #include <chrono>
 #include <iostream>
 #include <vector>
@@ -279,6 +281,196 @@ struct TensorTest
     }
 };
 
+// compares the multithreaded CPU TensorOp engine against the serial one on typical shapes
+// Wall-clock time is used since clock() adds up the time of all threads.
+template <class ElemType>
+struct TensorOpParallelTest
+{
+    static TensorView<ElemType> CreateTensor(TensorShape shape, int randomSeed)
+    {
+        mt19937 rng(randomSeed);
+        uniform_real_distribution<float> nd(-1, 1);
+        vector<ElemType> init(shape.GetNumElements());
+        generate(begin(init), end(init), [&] { return nd(rng); });
+        let sob = make_shared<Matrix<ElemType>>(init.size()/*rows*/, 1/*cols*/, init.data(), CPUDEVICE);
+        return TensorView<ElemType>(sob, shape);
+    }
+
+    // run 'fn' 'count' times in serial and in parallel mode, and report the average time of each
+    template <typename FN>
+    static void OneTest(const char* what, int count, const FN& fn)
+    {
+        let defaultMinElementsPerThread = CPUMatrix<ElemType>::GetTensorOpMinElementsPerThread();
+        double secondsPerMode[2];
+        for (int parallel = 0; parallel < 2; parallel++)
+        {
+            CPUMatrix<ElemType>::SetTensorOpMinElementsPerThread(parallel ? defaultMinElementsPerThread : 0);
+            fn(); // warm-up
+            auto t_start = chrono::steady_clock::now();
+            for (int i = 0; i < count; i++)
+                fn();
+            auto t_end = chrono::steady_clock::now();
+            secondsPerMode[parallel] = chrono::duration<double>(t_end - t_start).count() / count;
+        }
+        CPUMatrix<ElemType>::SetTensorOpMinElementsPerThread(defaultMinElementsPerThread);
+        cout << what << ": serial " << secondsPerMode[0] * 1000 << " ms, parallel " << secondsPerMode[1] * 1000
+             << " ms (" << CPUMatrix<ElemType>::GetMaxNumThreads() << " threads), speed-up " << secondsPerMode[0] / secondsPerMode[1] << endl;
+    }
+
+    static void BinaryOpTest(const char* what, int count, TensorShape layerShape, TensorShape otherShape)
+    {
+        let  a = CreateTensor(layerShape, 1);
+        let  b = CreateTensor(otherShape, 2);
+        auto c = CreateTensor(layerShape, 3);
+        OneTest(what, count, [&]() { c.AssignSumOf(a, b); });
+    }
+
+    static void UnaryOpTest(const char* what, int count, TensorShape layerShape)
+    {
+        let  a = CreateTensor(layerShape, 1);
+        auto c = CreateTensor(layerShape, 2);
+        OneTest(what, count, [&]() { c.AssignSigmoidOf(a); });
+    }
+
+    static void ReductionTest(const char* what, int count, TensorShape layerShape, TensorShape resultShape)
+    {
+        let  a = CreateTensor(layerShape, 1);
+        auto c = CreateTensor(resultShape, 2);
+        OneTest(what, count, [&]() { c.DoCopyOf(0, a, 1); });
+    }
+
+    TensorOpParallelTest(int count)
+    {
+        BinaryOpTest("elementwise addition [512 x 256]",             count, TensorShape{ 512, 256 },        TensorShape{ 512, 256 });
+        BinaryOpTest("elementwise addition [4096 x 1024]",           count, TensorShape{ 4096, 1024 },      TensorShape{ 4096, 1024 });
+        BinaryOpTest("LSTM bias addition [4096 x 32]",               count, TensorShape{ 4096, 32 },        TensorShape{ 4096 });
+        BinaryOpTest("conv bias addition [28 x 28 x 128 x 32]",      count, TensorShape{ 28, 28, 128, 32 }, TensorShape{ 1, 1, 128 });
+        UnaryOpTest("sigmoid [4096 x 1024]",                         count, TensorShape{ 4096, 1024 });
+        ReductionTest("FF bias gradient [2048 x 1024] -> [2048]",    count, TensorShape{ 2048, 1024 },      TensorShape{ 2048 });
+        ReductionTest("conv bias gradient [56 x 56 x 64 x 32] -> [1 x 1 x 64]", count, TensorShape{ 56, 56, 64, 32 }, TensorShape{ 1, 1, 64 });
+        ReductionTest("full reduction [4096 x 1024] -> []",          count, TensorShape{ 4096, 1024 },      TensorShape{ 1 });
+    }
+};
+
+// compares the 16-bit quantized product (QuantizedMultiplier, constant weights A) against the float GEMM (cblas_sgemm)
+// for C[m,n] = A[m,k] * B[k,n]; n is the minibatch size
+template <class ElemType>
+void QuantizedMultiplyTest(int m, int k, int n, int count)
+{
+    CPUMatrix<ElemType> A = CPUMatrix<ElemType>::RandomUniform(m, k, -1, 1, 1);
+    CPUMatrix<ElemType> B = CPUMatrix<ElemType>::RandomUniform(k, n, -1, 1, 2);
+    CPUMatrix<ElemType> C(m, n), CQ(m, n);
+    auto quantizedMultiplier = make_shared<QuantizedMultiplier<ElemType>>(make_shared<SymmetricQuantizer<ElemType, short>>(3), true /*isAConstant*/,
+                                                                          make_shared<SymmetricQuantizer<ElemType, short>>(3), false /*isBConstant*/);
+
+    CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, A, false, B, false, 0, C); // warm-up, also packs the constant A
+    CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, A, false, B, false, 0, CQ, quantizedMultiplier);
+
+    auto t_start = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+        CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, A, false, B, false, 0, C);
+    auto t_mid = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+        CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, A, false, B, false, 0, CQ, quantizedMultiplier);
+    auto t_end = chrono::steady_clock::now();
+
+    let macs = (double) m * n * k;
+    let floatSeconds = chrono::duration<double>(t_mid - t_start).count() / count;
+    let quantizedSeconds = chrono::duration<double>(t_end - t_mid).count() / count;
+    CQ -= C;
+    cout << "A(" << m << "x" << k << ") * B(" << k << "x" << n << "): float GEMM " << macs / floatSeconds * 1e-9 << " GMAC/s, "
+         << "int16 quantized " << macs / quantizedSeconds * 1e-9 << " GMAC/s, speed-up " << floatSeconds / quantizedSeconds
+         << ", max abs error " << CQ.MatrixNormInf() << endl;
+}
+
+template <class ElemType>
+void ConvolutionEngineTest(size_t w, size_t h, size_t c, size_t kernelSize, size_t mapCount, size_t stride, size_t batchSize, int count)
+{
+    auto geometry = make_shared<ConvolveGeometry>(TensorShape(w, h, c), TensorShape(kernelSize, kernelSize, c), TensorShape(mapCount),
+                                                  TensorShape(stride, stride, c), ConvolveGeometry::BoolVec{true},
+                                                  ConvolveGeometry::BoolVec{true, true, false}, TensorShape(0), TensorShape(0));
+    size_t crowIn = geometry->InputShape().GetNumElements();
+    size_t crowOut = geometry->OutputShape().GetNumElements();
+    size_t ckernel = geometry->KernelShape().GetNumElements();
+    int deviceId = CPUDEVICE;
+
+    cout << w << "x" << h << "x" << c << " * " << kernelSize << "x" << kernelSize << "x" << mapCount << ", stride " << stride << ", batch " << batchSize << ":";
+    for (auto kind : {ConvolutionEngineKind::Gemm, ConvolutionEngineKind::Direct})
+    {
+        auto engine = ConvolutionEngine<ElemType>::Create(geometry, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, kind);
+        Matrix<ElemType> in = Matrix<ElemType>::RandomUniform(crowIn, batchSize, deviceId, -1, 1, 1);
+        Matrix<ElemType> kernel = Matrix<ElemType>::RandomUniform(mapCount, ckernel, deviceId, -1, 1, 2);
+        Matrix<ElemType> srcGrad = Matrix<ElemType>::RandomUniform(crowOut, batchSize, deviceId, -1, 1, 3);
+        Matrix<ElemType> out(crowOut, batchSize, deviceId);
+        Matrix<ElemType> grad(crowIn, batchSize, deviceId);
+        Matrix<ElemType> kernelGrad(mapCount, ckernel, deviceId);
+        Matrix<ElemType> workspace(deviceId);
+
+        // The first calls pick the algorithms of the direct engine.
+        engine->Forward(in, kernel, out, workspace);
+        engine->BackwardData(srcGrad, kernel, grad, true, workspace);
+        engine->BackwardKernel(srcGrad, in, kernelGrad, true, false, workspace);
+
+        auto t_start = chrono::steady_clock::now();
+        for (int i = 0; i < count; i++)
+            engine->Forward(in, kernel, out, workspace);
+        auto t_forward = chrono::steady_clock::now();
+        for (int i = 0; i < count; i++)
+            engine->BackwardData(srcGrad, kernel, grad, true, workspace);
+        auto t_backwardData = chrono::steady_clock::now();
+        for (int i = 0; i < count; i++)
+            engine->BackwardKernel(srcGrad, in, kernelGrad, true, false, workspace);
+        auto t_end = chrono::steady_clock::now();
+
+        cout << (kind == ConvolutionEngineKind::Gemm ? " gemm" : " direct")
+             << " forward " << chrono::duration<double, milli>(t_forward - t_start).count() / count << " ms,"
+             << " backward data " << chrono::duration<double, milli>(t_backwardData - t_forward).count() / count << " ms,"
+             << " backward kernel " << chrono::duration<double, milli>(t_end - t_backwardData).count() / count << " ms;";
+    }
+    cout << endl;
+}
+
+// Sparse x dense products of an embedding-like layer: forward W * X and gradient dY * X^T (as block sparse and dense),
+// for one-hot/bag-of-words inputs X with the given number of nonzeros per column.
+template <class ElemType>
+void SparseMultiplyTest(size_t vocabSize, size_t hiddenSize, size_t batchSize, size_t nonzerosPerColumn, int count)
+{
+    CPUMatrix<ElemType> W = CPUMatrix<ElemType>::RandomUniform(hiddenSize, vocabSize, -1, 1, 1);
+    CPUMatrix<ElemType> dY = CPUMatrix<ElemType>::RandomUniform(hiddenSize, batchSize, -1, 1, 2);
+    CPUSparseMatrix<ElemType> X(MatrixFormat::matrixFormatSparseCSC, vocabSize, batchSize, nonzerosPerColumn * batchSize);
+    for (size_t j = 0; j < batchSize; j++)
+    {
+        vector<size_t> rows;
+        for (size_t i = 0; i < nonzerosPerColumn; i++)
+            rows.push_back(rand() % vocabSize);
+        sort(rows.begin(), rows.end());
+        rows.erase(unique(rows.begin(), rows.end()), rows.end());
+        for (size_t row : rows)
+            X.SetValue(row, j, 1);
+    }
+    CPUMatrix<ElemType> Y(hiddenSize, batchSize);
+    CPUMatrix<ElemType> dW(hiddenSize, vocabSize);
+
+    auto t_start = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+        CPUSparseMatrix<ElemType>::MultiplyAndWeightedAdd(1, W, false, X, false, 0, Y);
+    auto t_forward = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        CPUSparseMatrix<ElemType> dWBlocks(MatrixFormat::matrixFormatSparseBlockCol, hiddenSize, vocabSize, 0);
+        CPUSparseMatrix<ElemType>::MultiplyAndAdd(1, dY, false, X, true, dWBlocks);
+    }
+    auto t_blockGradient = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+        CPUSparseMatrix<ElemType>::MultiplyAndWeightedAdd(1, dY, false, X, true, 1, dW);
+    auto t_end = chrono::steady_clock::now();
+
+    cout << "W(" << hiddenSize << "x" << vocabSize << "), X with " << nonzerosPerColumn << " nonzeros in each of " << batchSize << " columns:"
+         << " W * X " << chrono::duration<double, milli>(t_forward - t_start).count() / count << " ms,"
+         << " dY * X^T block sparse " << chrono::duration<double, milli>(t_blockGradient - t_forward).count() / count << " ms,"
+         << " dense " << chrono::duration<double, milli>(t_end - t_blockGradient).count() / count << " ms" << endl;
+}
+
 template <class ElemType>
 void MandSTest(int count, int devId)
 {
@@ -340,6 +532,24 @@ int wmain()
 {
     // MandSTest<float>(100, 2);
 
+    cout << endl << "********************CPU TensorOp serial vs. parallel TEST********************" << endl;
+    TensorOpParallelTest<float>(10);
+
+    cout << endl << "********************Quantized vs. float GEMM TEST********************" << endl;
+    for (int n : { 1, 4, 16, 64, 256 })
+        QuantizedMultiplyTest<float>(1024, 1024, n, 20);
+
+    cout << endl << "********************CPU sparse x dense products TEST********************" << endl;
+    for (size_t nonzerosPerColumn : { 1, 10, 100, 1000 })
+        SparseMultiplyTest<float>(100000, 512, 64, nonzerosPerColumn, 5);
+
+    cout << endl << "********************CPU convolution engines, GEMM vs. direct TEST********************" << endl;
+    ConvolutionEngineTest<float>(56, 56, 64, 3, 64, 1, 32, 5);
+    ConvolutionEngineTest<float>(28, 28, 128, 3, 128, 1, 32, 5);
+    ConvolutionEngineTest<float>(14, 14, 256, 3, 256, 1, 32, 5);
+    ConvolutionEngineTest<float>(56, 56, 64, 1, 256, 1, 32, 5);
+    ConvolutionEngineTest<float>(224, 224, 3, 7, 64, 2, 32, 5);
+
     /*cout<<endl<<"********************Matrix SquareMultiplyAndWeightedAdd10TimesAvg TEST********************"<<endl;
     SquareMultiplyAndAdd10TimesAvgTest<float>(4096,10);
 
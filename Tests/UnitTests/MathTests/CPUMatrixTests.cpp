@@ -4,6 +4,8 @@
 //
 #include "stdafx.h"
 #include "../../../Source/Math/CPUMatrix.h"
+#include "../../../Source/Math/RNNCommon.h"
+#include "../../../Source/Math/CPUPoolingMemAllocator.h"
 
 using namespace Microsoft::MSR::CNTK;
 
@@ -1127,6 +1129,201 @@ BOOST_FIXTURE_TEST_CASE(CPUMatrixGatherFromTarget, RandomSeedFixture)
     BOOST_CHECK(m2.IsEqualTo(expect, 1e-6));
 }
 
+BOOST_FIXTURE_TEST_CASE(CPUMatrixTensorOpParallel, RandomSeedFixture)
+{
+    const size_t rows = 64, cols = 300;
+    SMatrix a = SMatrix::RandomUniform(rows, cols, -1, 1, IncrementCounter());
+    SMatrix b = SMatrix::RandomUniform(rows, 1, -1, 1, IncrementCounter());
+    const size_t defaultMinElementsPerThread = SMatrix::GetTensorOpMinElementsPerThread();
+
+    // runs the same ops serially (0) or forced onto all threads (1)
+    auto runOps = [&](size_t minElementsPerThread, SMatrix& sum, SMatrix& rowSum, SMatrix& total)
+    {
+        SMatrix::SetTensorOpMinElementsPerThread(minElementsPerThread);
+
+        // broadcasting addition: sum = a + b
+        sum.Resize(rows, cols);
+        sum.TensorOp(0, a, b, 1, ElementWiseOperator::opSum, ElementWiseOperator::opSum,
+                     std::array<size_t, 3>{0, 0, 0},
+                     SmallVector<size_t>{rows, cols}, std::array<SmallVector<ptrdiff_t>, 3>{SmallVector<ptrdiff_t>{1, (ptrdiff_t) rows}, SmallVector<ptrdiff_t>{1, 0}, SmallVector<ptrdiff_t>{1, (ptrdiff_t) rows}},
+                     SmallVector<size_t>{}, std::array<SmallVector<ptrdiff_t>, 3>{SmallVector<ptrdiff_t>{}, SmallVector<ptrdiff_t>{}, SmallVector<ptrdiff_t>{}});
+
+        // reduction over columns: rowSum = 2 * sum_j a(:,j)
+        rowSum.Resize(rows, 1);
+        rowSum.TensorOp(0, a, 2, ElementWiseOperator::opCopy, ElementWiseOperator::opSum,
+                        std::array<size_t, 2>{0, 0},
+                        SmallVector<size_t>{rows}, std::array<SmallVector<ptrdiff_t>, 2>{SmallVector<ptrdiff_t>{1}, SmallVector<ptrdiff_t>{1}},
+                        SmallVector<size_t>{cols}, std::array<SmallVector<ptrdiff_t>, 2>{SmallVector<ptrdiff_t>{(ptrdiff_t) rows}, SmallVector<ptrdiff_t>{0}});
+
+        // reduction to a scalar: total = max_ij a(i,j)
+        total.Resize(1, 1);
+        total.TensorOp(0, a, 1, ElementWiseOperator::opCopy, ElementWiseOperator::opMax,
+                       std::array<size_t, 2>{0, 0},
+                       SmallVector<size_t>{}, std::array<SmallVector<ptrdiff_t>, 2>{SmallVector<ptrdiff_t>{}, SmallVector<ptrdiff_t>{}},
+                       SmallVector<size_t>{rows * cols}, std::array<SmallVector<ptrdiff_t>, 2>{SmallVector<ptrdiff_t>{1}, SmallVector<ptrdiff_t>{0}});
+    };
+
+    SMatrix sumSerial, rowSumSerial, totalSerial;
+    SMatrix sumParallel, rowSumParallel, totalParallel;
+    runOps(0, sumSerial, rowSumSerial, totalSerial);
+    runOps(1, sumParallel, rowSumParallel, totalParallel);
+    SMatrix::SetTensorOpMinElementsPerThread(defaultMinElementsPerThread);
+
+    BOOST_CHECK(sumParallel.IsEqualTo(sumSerial, c_epsilonFloatE5));
+    BOOST_CHECK(rowSumParallel.IsEqualTo(rowSumSerial, c_epsilonFloatE5));
+    BOOST_CHECK(totalParallel.IsEqualTo(totalSerial, c_epsilonFloatE5));
+
+    float expectedMax = a(0, 0);
+    foreach_coord (i, j, a)
+        expectedMax = std::max(expectedMax, a(i, j));
+    BOOST_CHECK_EQUAL(totalSerial(0, 0), expectedMax);
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUMatrixRNNForward, RandomSeedFixture)
+{
+    const size_t xDim = 5, hiddenSize = 3, numLayers = 2;
+    // sequences sorted by decreasing length, as packed for cuDNN
+    const std::vector<size_t> lengths = { 5, 3, 3, 1 };
+    const std::vector<size_t> numSequencesForFrame = { 4, 3, 3, 1, 1 };
+    std::vector<size_t> frameOffsets(numSequencesForFrame.size(), 0);
+    for (size_t t = 1; t < frameOffsets.size(); t++)
+        frameOffsets[t] = frameOffsets[t - 1] + numSequencesForFrame[t - 1];
+    const size_t numFrames = frameOffsets.back() + numSequencesForFrame.back();
+
+    DMatrix x = DMatrix::RandomUniform(xDim, numFrames, -1, 1, IncrementCounter());
+    auto sigmoid = [](double v) { return 1 / (1 + exp(-v)); };
+
+    for (const std::wstring recurrentOp : { L"lstm", L"gru", L"rnnReLU", L"rnnTanh" })
+    {
+        for (bool bidirectional : { false, true })
+        {
+            RnnAttributes attributes(bidirectional, numLayers, hiddenSize, recurrentOp, -1);
+            const size_t numDirections = bidirectional ? 2 : 1;
+            const size_t numGates = recurrentOp == L"lstm" ? 4 : recurrentOp == L"gru" ? 3 : 1;
+            const size_t gateDim = numGates * hiddenSize;
+            const size_t yDim = numDirections * hiddenSize;
+            let numParameters = attributes.GetNumParameters(xDim);
+            DMatrix w = DMatrix::RandomUniform(numParameters.first, numParameters.second, -0.5, 0.5, IncrementCounter());
+            const double* p = w.Data();
+
+            // reference: each sequence on its own, with the parameters indexed as cuDNN lays them out
+            DMatrix expected(yDim, numFrames);
+            for (size_t j = 0; j < lengths.size(); j++)
+            {
+                const size_t length = lengths[j];
+                std::vector<std::vector<double>> input(length);
+                for (size_t t = 0; t < length; t++)
+                    for (size_t i = 0; i < xDim; i++)
+                        input[t].push_back(x(i, frameOffsets[t] + j));
+
+                size_t weightOffset = 0;
+                size_t biasOffset = w.GetNumElements() - numLayers * numDirections * 2 * gateDim;
+                for (size_t layer = 0; layer < numLayers; layer++)
+                {
+                    const size_t inputDim = input[0].size();
+                    std::vector<std::vector<double>> output(length, std::vector<double>(yDim));
+                    for (size_t d = 0; d < numDirections; d++)
+                    {
+                        const double* W = p + weightOffset;
+                        const double* R = W + gateDim * inputDim;
+                        const double* bW = p + biasOffset;
+                        const double* bR = bW + gateDim;
+                        weightOffset += gateDim * (inputDim + hiddenSize);
+                        biasOffset += 2 * gateDim;
+
+                        std::vector<double> h(hiddenSize, 0), c(hiddenSize, 0);
+                        for (size_t s = 0; s < length; s++)
+                        {
+                            const size_t t = d == 0 ? s : length - 1 - s;
+                            std::vector<double> a(gateDim), r(gateDim);
+                            for (size_t g = 0; g < gateDim; g++)
+                            {
+                                a[g] = bW[g];
+                                r[g] = bR[g];
+                                for (size_t i = 0; i < inputDim; i++)
+                                    a[g] += W[g * inputDim + i] * input[t][i];
+                                for (size_t k = 0; k < hiddenSize; k++)
+                                    r[g] += R[g * hiddenSize + k] * h[k];
+                            }
+                            for (size_t k = 0; k < hiddenSize; k++)
+                            {
+                                const size_t H = hiddenSize;
+                                if (recurrentOp == L"lstm")
+                                {
+                                    c[k] = sigmoid(a[H + k] + r[H + k]) * c[k] + sigmoid(a[k] + r[k]) * tanh(a[2 * H + k] + r[2 * H + k]);
+                                    h[k] = sigmoid(a[3 * H + k] + r[3 * H + k]) * tanh(c[k]);
+                                }
+                                else if (recurrentOp == L"gru")
+                                {
+                                    double n = tanh(a[2 * H + k] + sigmoid(a[k] + r[k]) * r[2 * H + k]);
+                                    double u = sigmoid(a[H + k] + r[H + k]);
+                                    h[k] = (1 - u) * n + u * h[k];
+                                }
+                                else if (recurrentOp == L"rnnReLU")
+                                    h[k] = std::max(a[k] + r[k], 0.0);
+                                else
+                                    h[k] = tanh(a[k] + r[k]);
+                            }
+                            for (size_t k = 0; k < hiddenSize; k++)
+                                output[t][d * hiddenSize + k] = h[k];
+                        }
+                    }
+                    input = output;
+                }
+                for (size_t t = 0; t < length; t++)
+                    for (size_t i = 0; i < yDim; i++)
+                        expected(i, frameOffsets[t] + j) = input[t][i];
+            }
+
+            DMatrix y, workspace;
+            y.RNNForward(x, w, xDim, yDim, numSequencesForFrame, attributes, workspace);
+            BOOST_CHECK_EQUAL(y.GetNumRows(), yDim);
+            BOOST_CHECK_EQUAL(y.GetNumCols(), numFrames);
+            BOOST_CHECK(y.IsEqualTo(expected, c_epsilonDoubleE11));
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUMatrixPoolingAllocator, RandomSeedFixture)
+{
+    const size_t rows = 37, cols = 11;
+    auto before = CPUPoolingMemAllocator::GetStatistics();
+    const double* firstBuffer;
+    {
+        DMatrix m(rows, cols);
+        firstBuffer = m.Data();
+        BOOST_CHECK_EQUAL((size_t) firstBuffer % CPUPoolingMemAllocator::Alignment, 0);
+
+        // the constructor still hands out zeroed memory
+        foreach_coord (i, j, m)
+            BOOST_CHECK_EQUAL(m(i, j), 0.0);
+        m.SetValue(1.0);
+
+        auto live = CPUPoolingMemAllocator::GetStatistics();
+        BOOST_CHECK_GE(live.liveBytes, before.liveBytes + rows * cols * sizeof(double));
+        BOOST_CHECK_GE(live.peakBytes, live.liveBytes);
+    }
+    auto released = CPUPoolingMemAllocator::GetStatistics();
+    BOOST_CHECK_EQUAL(released.liveBytes, before.liveBytes);
+    BOOST_CHECK_GE(released.cachedBytes, rows * cols * sizeof(double));
+
+    // a same-sized request is served from the free list, and is zeroed again
+    DMatrix m(rows, cols);
+    BOOST_CHECK_EQUAL(m.Data(), firstBuffer);
+    BOOST_CHECK_EQUAL(CPUPoolingMemAllocator::GetStatistics().numCacheHits, released.numCacheHits + 1);
+    foreach_coord (i, j, m)
+        BOOST_CHECK_EQUAL(m(i, j), 0.0);
+
+    // first-touch placement must not change the observable content
+    CPUPoolingMemAllocator::SetFirstTouchPlacement(true);
+    CPUPoolingMemAllocator::ReleaseCachedMemory();
+    BOOST_CHECK_EQUAL(CPUPoolingMemAllocator::GetStatistics().cachedBytes, 0);
+    DMatrix big(1024, 33);
+    CPUPoolingMemAllocator::SetFirstTouchPlacement(false);
+    foreach_coord (i, j, big)
+        BOOST_CHECK_EQUAL(big(i, j), 0.0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }
 } } }
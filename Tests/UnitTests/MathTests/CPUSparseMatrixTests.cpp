@@ -116,6 +116,61 @@ BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixMultiplyAndAdd, RandomSeedFixture)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixMultiplyAndWeightedAdd, RandomSeedFixture)
+{
+    const size_t m = 40;
+    const size_t k = 30;
+
+    // Few columns use the partitioning of the dense matrix for all variants, many columns the partitioning of the sparse columns.
+    for (size_t n : {1, 3, 200})
+    {
+        for (bool transposeDense : {false, true})
+        {
+            for (bool transposeSparse : {false, true})
+            {
+                // dense * sparse
+                DenseMatrix dm0 = transposeDense ? DenseMatrix(k, m) : DenseMatrix(m, k);
+                dm0.SetUniformRandomValue(-1, 1, IncrementCounter());
+                DenseMatrix dm1 = transposeSparse ? DenseMatrix(n, k) : DenseMatrix(k, n);
+                dm1.SetUniformRandomValue(-9, 1, IncrementCounter());
+                dm1.InplaceTruncateBottom(0);
+                SparseMatrix sm1(MatrixFormat::matrixFormatSparseCSC, dm1.GetNumRows(), dm1.GetNumCols(), 0);
+                foreach_coord (row, col, dm1)
+                {
+                    if (dm1(row, col) != 0)
+                        sm1.SetValue(row, col, dm1(row, col));
+                }
+
+                DenseMatrix dmExpected(m, n);
+                dmExpected.SetUniformRandomValue(-1, 1, IncrementCounter());
+                DenseMatrix dmActual(dmExpected);
+                DenseMatrix::MultiplyAndWeightedAdd(0.5, dm0, transposeDense, dm1, transposeSparse, 0.3, dmExpected);
+                SparseMatrix::MultiplyAndWeightedAdd(0.5, dm0, transposeDense, sm1, transposeSparse, 0.3, dmActual);
+                BOOST_CHECK(dmActual.IsEqualTo(dmExpected, c_epsilonFloatE4));
+
+                // sparse * dense
+                DenseMatrix dm2 = transposeSparse ? DenseMatrix(k, m) : DenseMatrix(m, k);
+                dm2.SetUniformRandomValue(-9, 1, IncrementCounter());
+                dm2.InplaceTruncateBottom(0);
+                SparseMatrix sm2(MatrixFormat::matrixFormatSparseCSC, dm2.GetNumRows(), dm2.GetNumCols(), 0);
+                foreach_coord (row, col, dm2)
+                {
+                    if (dm2(row, col) != 0)
+                        sm2.SetValue(row, col, dm2(row, col));
+                }
+                DenseMatrix dm3 = transposeDense ? DenseMatrix(n, k) : DenseMatrix(k, n);
+                dm3.SetUniformRandomValue(-1, 1, IncrementCounter());
+
+                dmExpected.SetUniformRandomValue(-1, 1, IncrementCounter());
+                dmActual.SetValue(dmExpected);
+                DenseMatrix::MultiplyAndWeightedAdd(0.5, dm2, transposeSparse, dm3, transposeDense, 1, dmExpected);
+                SparseMatrix::MultiplyAndWeightedAdd(0.5, sm2, transposeSparse, dm3, transposeDense, 1, dmActual);
+                BOOST_CHECK(dmActual.IsEqualTo(dmExpected, c_epsilonFloatE4));
+            }
+        }
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixDoGatherColumnsOf, RandomSeedFixture)
 {
     const size_t m = 100;
@@ -14,6 +14,7 @@
 #include "../../../Source/Math/CPUMatrix.h"
 #include "../../../Source/Math/GPUMatrix.h"
 #include "../../../Source/Math/ConvolutionEngine.h"
+#include "../../../Source/Math/CPUConvolution.h"
 #include "../../../Source/Math/CuDnnFactories.h"
 #include "common.h"
 
@@ -62,6 +63,11 @@ std::vector<std::tuple<ConvolutionEngineKind, DEVICEID_TYPE, size_t>> GetTestEng
     res.push_back(std::make_tuple(ConvolutionEngineKind::Gemm, -1, 0));
     res.push_back(std::make_tuple(ConvolutionEngineKind::Gemm, -1, 1));
     res.push_back(std::make_tuple(ConvolutionEngineKind::Gemm, -1, 3));
+
+    // Direct engine, CPU only. Falls back to Gemm for geometries it does not support.
+    auto direct = (ConvolutionEngineKind)((int)ConvolutionEngineKind::Direct | (int)ConvolutionEngineKind::Gemm);
+    res.push_back(std::make_tuple(direct, -1, 0));
+    res.push_back(std::make_tuple(direct, -1, 3));
     return res;
 }
 
@@ -371,6 +377,137 @@ BOOST_AUTO_TEST_CASE(ConvolutionBackwardKernel)
     }
 }
 
+// The direct engine picks the fastest algorithm on the first call, so the tests above do not necessarily
+// run all of them. This test runs each algorithm of CPUBlockedConvolution against the CPU reference engine.
+BOOST_AUTO_TEST_CASE(BlockedConvolutionAlgorithms)
+{
+    std::mt19937 rng(0);
+    boost::random::uniform_int_distribution<> batchSizeG(1, 8);
+    boost::random::normal_distribution<float> nd;
+
+    auto geometries = GenerateConvTestConfigs();
+    // Multiple channel and map blocks, partial blocks and rows that are not a multiple of RowBlock.
+    geometries.push_back(std::make_shared<ConvolveGeometry>(TensorShape(13, 9, 19),
+        TensorShape(3, 3, 19), TensorShape(21), TensorShape(1, 1, 19),
+        ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{true, true, false},
+        TensorShape(0), TensorShape(0)));
+    geometries.push_back(std::make_shared<ConvolveGeometry>(TensorShape(23, 17, 3),
+        TensorShape(7, 7, 3), TensorShape(16), TensorShape(2, 2, 3),
+        ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{true, true, false},
+        TensorShape(0), TensorShape(0)));
+
+    int deviceId = -1;
+    for (const auto& g : geometries)
+    {
+        if (!CPUBlockedConvolution<float>::IsSupported(*g))
+            continue;
+
+        auto refEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, ConvolutionEngineKind::Reference);
+        CPUBlockedConvolution<float> conv(*g);
+
+        size_t n = batchSizeG(rng);
+        size_t mapCount = g->GetMapCount(g->InputShape().GetRank() - 1);
+        size_t crowIn = g->InputShape().GetNumElements();
+        size_t crowOut = g->OutputShape().GetNumElements();
+        size_t ckernel = g->KernelShape().GetNumElements();
+
+        vec buf(crowIn * n);
+        std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+        SingleMatrix in(crowIn, n, buf.data(), deviceId, matrixFlagNormal);
+        buf.resize(mapCount * ckernel);
+        std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+        SingleMatrix kernel(mapCount, ckernel, buf.data(), deviceId, matrixFlagNormal);
+        buf.resize(crowOut * n);
+        std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+        SingleMatrix srcGrad(crowOut, n, buf.data(), deviceId, matrixFlagNormal);
+
+        SingleMatrix workspace(deviceId);
+        SingleMatrix outB(crowOut, n, deviceId);
+        refEng->Forward(in, kernel, outB, workspace);
+        SingleMatrix gradB = SingleMatrix::Zeros(crowIn, n, deviceId);
+        refEng->BackwardData(srcGrad, kernel, gradB, true, workspace);
+        SingleMatrix kernelGradB = SingleMatrix::Zeros(mapCount, ckernel, deviceId);
+        refEng->BackwardKernel(srcGrad, in, kernelGradB, true, false, workspace);
+
+        std::stringstream tmsg;
+        tmsg << "Geometry: " << (std::string)(*g) << ", Batch: " << n;
+        std::string msg = " are not equal, " + tmsg.str();
+
+        float relErr = Err<float>::Rel;
+        float absErr = Err<float>::Abs;
+        std::string emsg;
+
+        SingleMatrix out(crowOut, n, deviceId);
+        conv.ForwardDirect(in.Data(), kernel.Data(), out.Data(), n);
+        BOOST_REQUIRE_MESSAGE(CheckEqual(out, outB, emsg, relErr * 4, absErr * 14), "Direct out" << msg << ". " << emsg);
+        SingleMatrix grad = SingleMatrix::Zeros(crowIn, n, deviceId);
+        conv.BackwardDataDirect(srcGrad.Data(), kernel.Data(), grad.Data(), n);
+        BOOST_REQUIRE_MESSAGE(CheckEqual(grad, gradB, emsg, relErr * 16, absErr * 8), "Direct grad" << msg << ". " << emsg);
+        SingleMatrix kernelGrad = SingleMatrix::Zeros(mapCount, ckernel, deviceId);
+        conv.BackwardKernelDirect(srcGrad.Data(), in.Data(), kernelGrad.Data(), n);
+        BOOST_REQUIRE_MESSAGE(CheckEqual(kernelGrad, kernelGradB, emsg, relErr * 32, absErr * 32), "Direct kernelGrad" << msg << ". " << emsg);
+
+        if (conv.SupportsWinograd())
+        {
+            conv.ForwardWinograd(in.Data(), kernel.Data(), out.Data(), n);
+            BOOST_REQUIRE_MESSAGE(CheckEqual(out, outB, emsg, relErr * 8, absErr * 16), "Winograd out" << msg << ". " << emsg);
+            grad.SetValue(0);
+            conv.BackwardDataWinograd(srcGrad.Data(), kernel.Data(), grad.Data(), n);
+            BOOST_REQUIRE_MESSAGE(CheckEqual(grad, gradB, emsg, relErr * 16, absErr * 16), "Winograd grad" << msg << ". " << emsg);
+        }
+    }
+}
+
+// With deterministic algorithms forced, the direct engine uses fixed algorithms instead of timing them,
+// so separately created engines compute bit-identical results.
+BOOST_AUTO_TEST_CASE(DirectConvolutionDeterministic)
+{
+    std::mt19937 rng(0);
+    boost::random::normal_distribution<float> nd;
+    auto direct = (ConvolutionEngineKind)((int)ConvolutionEngineKind::Direct | (int)ConvolutionEngineKind::Gemm);
+
+    int deviceId = -1;
+    size_t n = 4;
+    for (const auto& g : GenerateConvTestConfigs())
+    {
+        if (!CPUBlockedConvolution<float>::IsSupported(*g))
+            continue;
+
+        size_t mapCount = g->GetMapCount(g->InputShape().GetRank() - 1);
+        size_t crowIn = g->InputShape().GetNumElements();
+        size_t crowOut = g->OutputShape().GetNumElements();
+        size_t ckernel = g->KernelShape().GetNumElements();
+
+        vec buf(crowIn * n);
+        std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+        SingleMatrix in(crowIn, n, buf.data(), deviceId, matrixFlagNormal);
+        buf.resize(mapCount * ckernel);
+        std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+        SingleMatrix kernel(mapCount, ckernel, buf.data(), deviceId, matrixFlagNormal);
+        buf.resize(crowOut * n);
+        std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+        SingleMatrix srcGrad(crowOut, n, buf.data(), deviceId, matrixFlagNormal);
+
+        std::vector<SingleMatrix> outs, grads, kernelGrads;
+        for (int i = 0; i < 2; i++)
+        {
+            auto eng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, direct, L"", /*forceDeterministicAlgorithms=*/true);
+            SingleMatrix workspace(deviceId);
+            outs.push_back(SingleMatrix(crowOut, n, deviceId));
+            eng->Forward(in, kernel, outs.back(), workspace);
+            grads.push_back(SingleMatrix::Zeros(crowIn, n, deviceId));
+            eng->BackwardData(srcGrad, kernel, grads.back(), true, workspace);
+            kernelGrads.push_back(SingleMatrix::Zeros(mapCount, ckernel, deviceId));
+            eng->BackwardKernel(srcGrad, in, kernelGrads.back(), true, false, workspace);
+        }
+
+        std::string msg = " differ between runs, Geometry: " + (std::string)(*g);
+        BOOST_REQUIRE_MESSAGE(outs[0].IsEqualTo(outs[1], 0), "Forward" << msg);
+        BOOST_REQUIRE_MESSAGE(grads[0].IsEqualTo(grads[1], 0), "Backward data" << msg);
+        BOOST_REQUIRE_MESSAGE(kernelGrads[0].IsEqualTo(kernelGrads[1], 0), "Backward kernel" << msg);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(PoolingForward)
 {
     std::mt19937 rng(0);
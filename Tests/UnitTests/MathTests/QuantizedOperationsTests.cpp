@@ -5,6 +5,7 @@
 #include "stdafx.h"
 #include "../../../Source/Math/QuantizedOperations.h"
 #include "../../../Source/Math/Helpers.h"
+#include <random>
 
 using namespace Microsoft::MSR::CNTK;
 namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
@@ -50,6 +51,35 @@ BOOST_FIXTURE_TEST_CASE(MultiplyIntToShort, RandomSeedFixture)
         BOOST_CHECK_EQUAL(round(C_upd[i]), C_expected_upd[i]);
 }
 
+BOOST_FIXTURE_TEST_CASE(Int16GemmOddSizes, RandomSeedFixture)
+{
+    // sizes that are not multiples of the panel sizes, and an odd k
+    for (int m : { 1, 7, (int) Int16Gemm::MR + 3 })
+        for (int n : { 1, 5, 33 })
+            for (int k : { 1, 4, 51 })
+            {
+                std::mt19937 rng(IncrementCounter());
+                std::uniform_int_distribution<int> dist(-1000, 1000);
+                std::vector<short> A(m * k), B(k * n);
+                for (auto& v : A) v = (short)dist(rng);
+                for (auto& v : B) v = (short)dist(rng);
+
+                std::vector<short> packedA, packedB;
+                Int16Gemm::PackA(A.data(), m, k, packedA);
+                Int16Gemm::PackB(B.data(), k, n, packedB);
+                std::vector<float> C(m * n);
+                Int16Gemm::Multiply(packedA, packedB, m, n, k, C.data(), m);
+
+                for (int i = 0; i < m; i++)
+                    for (int j = 0; j < n; j++)
+                    {
+                        int expected = 0;
+                        for (int l = 0; l < k; l++)
+                            expected += A[i + l * m] * B[l + j * k];
+                        BOOST_CHECK_EQUAL(C[i + j * m], (float)expected);
+                    }
+            }
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 
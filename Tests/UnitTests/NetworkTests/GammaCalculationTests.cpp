@@ -0,0 +1,178 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "Sequences.h"
+#include "gammacalculation.h"
+#include <cstdio>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace msra::lattices;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+BOOST_AUTO_TEST_SUITE(GammaCalculationTests)
+
+// same layout as lattice::header_v1_v2, which is private
+struct LatticeHeader
+{
+    size_t numnodes : 32;
+    size_t numedges : 32;
+    float lmf;
+    float wp;
+    double frameduration;
+    size_t numframes : 32;
+    size_t impliedspunitid : 31;
+    size_t hasacscores : 1;
+};
+
+static const size_t numFrames = 4;
+static const size_t numSenones = 3;
+
+static void WriteTextFile(const std::wstring& path, const char* text)
+{
+    FILE* f = fopenOrDie(path, L"wb");
+    fputs(text, f);
+    fcloseOrDie(f);
+}
+
+// three single-state units sil, a, b with senones s0, s1, s2
+static void LoadHmmSet(msra::asr::simplesenonehmm& hset)
+{
+    WriteTextFile(L"GammaCalculationTests.statelist", "s0\ns1\ns2\n");
+    WriteTextFile(L"GammaCalculationTests.transp", "T 1 1 0 0.5 0.5\n");
+    WriteTextFile(L"GammaCalculationTests.tying", "sil T s0\na T s1\nb T s2\n");
+    hset.loadfromfile(L"GammaCalculationTests.tying", L"GammaCalculationTests.statelist", L"GammaCalculationTests.transp");
+    _wunlink(L"GammaCalculationTests.statelist");
+    _wunlink(L"GammaCalculationTests.transp");
+    _wunlink(L"GammaCalculationTests.tying");
+}
+
+// a V1 lattice over 4 frames: {a, b} for frames 0..1, then {sil, a} for frames 2..3
+static void LoadLattice(const msra::asr::simplesenonehmm& hset, lattice& L)
+{
+    const size_t sil = hset.gethmmid("sil"), a = hset.gethmmid("a"), b = hset.gethmmid("b");
+
+    std::vector<nodeinfo> nodes = { nodeinfo(0), nodeinfo(2), nodeinfo(numFrames) };
+    std::vector<edgeinfowithscores> edges = {
+        edgeinfowithscores(0, 1, 0.0f, -1.0f, 0),
+        edgeinfowithscores(0, 1, 0.0f, -2.0f, 1),
+        edgeinfowithscores(1, 2, 0.0f, -0.5f, 2),
+        edgeinfowithscores(1, 2, 0.0f, -1.5f, 3),
+    };
+    std::vector<aligninfo> align = { aligninfo(a, 2), aligninfo(b, 2), aligninfo(sil, 2), aligninfo(a, 2) };
+
+    LatticeHeader header = {};
+    header.numnodes = nodes.size();
+    header.numedges = edges.size();
+    header.lmf = 1.0f;
+    header.frameduration = 0.01;
+    header.numframes = numFrames;
+    header.impliedspunitid = INT_MAX;
+
+    const std::wstring path = L"GammaCalculationTests.lat";
+    FILE* f = fopenOrDie(path, L"wb");
+    fputTag(f, "LAT ");
+    fputint(f, 1);
+    fwriteOrDie(&header, sizeof(header), 1, f);
+    fputTag(f, "NODE");
+    fputint(f, (int) nodes.size());
+    fwriteOrDie(nodes, f);
+    fputTag(f, "EDGE");
+    fputint(f, (int) edges.size());
+    fwriteOrDie(edges, f);
+    fputTag(f, "ALIG");
+    fputint(f, (int) align.size());
+    fwriteOrDie(align, f);
+    fputTag(f, "END ");
+    fcloseOrDie(f);
+
+    std::vector<size_t> idmap = { 0, 1, 2 };
+    f = fopenOrDie(path, L"rb");
+    L.fread(f, idmap, SIZE_MAX);
+    fcloseOrDie(f);
+    _wunlink(path.c_str());
+}
+
+// run calgammaformb() on frame-concatenated utterances, one lattice per utterance
+static float CalculateGammas(const msra::asr::simplesenonehmm& hset, bool sMBRmode,
+                             std::vector<std::shared_ptr<const msra::dbn::latticepair>> lattices,
+                             const Matrix<float>& loglikelihood, std::vector<size_t> uids, Matrix<float>& gammas)
+{
+    GammaCalculation<float> gammaCalculation;
+    gammaCalculation.init(hset, CPUDEVICE);
+    SeqGammarCalParam params;
+    params.sMBRmode = sMBRmode;
+    gammaCalculation.SetGammarCalculationParams(params);
+
+    Matrix<float> objective(1, 1, CPUDEVICE);
+    Matrix<float> labels(loglikelihood.GetNumRows(), loglikelihood.GetNumCols(), CPUDEVICE);
+    gammas.Resize(loglikelihood.GetNumRows(), loglikelihood.GetNumCols());
+    gammas.SetValue(0.0f);
+    std::vector<size_t> boundaries(uids.size(), 0);
+    std::vector<size_t> extrauttmap;
+    gammaCalculation.calgammaformb(objective, lattices, loglikelihood, labels, gammas, uids, boundaries, 1, nullptr, extrauttmap, false);
+    return objective.Get00Element();
+}
+
+BOOST_AUTO_TEST_CASE(GammasOfMinibatchMatchPerUtteranceGammas)
+{
+    msra::asr::simplesenonehmm hset;
+    LoadHmmSet(hset);
+
+    const size_t numUtterances = 3;
+    std::vector<std::shared_ptr<const msra::dbn::latticepair>> lattices;
+    for (size_t i = 0; i < numUtterances; i++)
+    {
+        auto pair = std::make_shared<msra::dbn::latticepair>();
+        LoadLattice(hset, pair->second);
+        lattices.push_back(pair);
+    }
+
+    // different log-likelihoods per utterance, so that their gammas differ
+    Matrix<float> loglikelihood(numSenones, numUtterances * numFrames, CPUDEVICE);
+    for (size_t c = 0; c < loglikelihood.GetNumCols(); c++)
+        for (size_t s = 0; s < numSenones; s++)
+            loglikelihood(s, c) = -0.5f * (float) ((s * 7 + c * 3) % 5) - 0.1f * (float) c;
+    // reference path a a sil sil
+    std::vector<size_t> uids;
+    for (size_t i = 0; i < numUtterances; i++)
+        uids.insert(uids.end(), { 1, 1, 0, 0 });
+
+    for (bool sMBRmode : { false, true })
+    {
+        Matrix<float> gammas(CPUDEVICE);
+        const float objective = CalculateGammas(hset, sMBRmode, lattices, loglikelihood, uids, gammas);
+
+        // the same utterances, one minibatch each
+        float sumOfObjectives = 0;
+        for (size_t i = 0; i < numUtterances; i++)
+        {
+            Matrix<float> utteranceLoglikelihood = loglikelihood.ColumnSlice(i * numFrames, numFrames).DeepClone();
+            std::vector<size_t> utteranceUids(uids.begin() + i * numFrames, uids.begin() + (i + 1) * numFrames);
+            Matrix<float> utteranceGammas(CPUDEVICE);
+            sumOfObjectives += CalculateGammas(hset, sMBRmode, { lattices[i] }, utteranceLoglikelihood, utteranceUids, utteranceGammas);
+
+            for (size_t t = 0; t < numFrames; t++)
+            {
+                float columnSum = 0;
+                for (size_t s = 0; s < numSenones; s++)
+                {
+                    BOOST_CHECK_EQUAL(gammas(s, i * numFrames + t), utteranceGammas(s, t));
+                    columnSum += utteranceGammas(s, t);
+                }
+                if (!sMBRmode) // MMI gammas are state posteriors
+                    BOOST_CHECK_CLOSE(columnSum, 1.0f, 1e-3f);
+            }
+            // utterances differ, so a copy from the wrong columns would not go unnoticed
+            if (i > 0)
+                BOOST_CHECK(!gammas.ColumnSlice(i * numFrames, numFrames).IsEqualTo(gammas.ColumnSlice(0, numFrames), 1e-6f));
+        }
+        BOOST_CHECK_CLOSE(objective, sumOfObjectives, 1e-3f);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
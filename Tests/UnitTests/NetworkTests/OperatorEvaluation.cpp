@@ -4,6 +4,9 @@
 //
 #include "stdafx.h"
 #include "Common/NetworkTestHelper.h"
+#include "ComputationNetwork.h"
+#include "ComputationNetworkBuilder.h"
+#include "Globals.h"
 
 using namespace Microsoft::MSR::CNTK;
 
@@ -18,6 +21,79 @@ struct OperatorFixture : DataFixture
     }
 };
 
+// Enables (or disables) elementwise fusion while in scope and restores the previous setting, also if the test fails.
+struct ElementwiseFusionScope
+{
+    explicit ElementwiseFusionScope(bool enable = true)
+        : m_wasEnabled(Globals::ShouldFuseElementwiseOperations())
+    {
+        Globals::SetElementwiseFusion(enable);
+    }
+
+    ~ElementwiseFusionScope()
+    {
+        Globals::SetElementwiseFusion(m_wasEnabled);
+    }
+
+    bool m_wasEnabled;
+};
+
+typedef shared_ptr<ComputationNode<float>> (ComputationNetworkBuilder<float>::*ActivationBuilder)(const shared_ptr<ComputationNode<float>>, const std::wstring);
+
+// Computes the gradients of SumElements(ElementTimes(activation(Plus(a, b)), weights)) with respect to a and b.
+// b is a column that is broadcast along the second axis of a, so its gradient is reduced over that axis.
+static void ComputeActivationOfPlusGradients(ActivationBuilder activation, bool fuse, const wstring& expectedOperationName,
+                                             Matrix<float>& gradientA, Matrix<float>& gradientB)
+{
+    ElementwiseFusionScope fusion(fuse);
+    auto net = make_shared<ComputationNetwork>(CPUDEVICE);
+    ComputationNetworkBuilder<float> builder(*net);
+    auto a = builder.CreateLearnableParameter(L"a", 3, 4);
+    auto b = builder.CreateLearnableParameter(L"b", 3, 1);
+    auto weights = builder.CreateLearnableParameter(L"weights", 3, 4);
+    a->Value().SetValue(3, 4, { -2.0f, -0.5f, 0.25f,  1.5f,
+                                 0.75f, -1.25f, 2.0f, -0.25f,
+                                 1.0f,  0.5f, -1.5f, -2.5f });
+    b->Value().SetValue(3, 1, { 0.5f, -0.75f, 1.25f });
+    weights->Value().SetValue(3, 4, { 1.0f, -2.0f,  0.5f, 3.0f,
+                                      -1.5f, 0.25f, 2.0f, -1.0f,
+                                       0.75f, 1.5f, -0.5f, 2.5f });
+    weights->SetLearningRateMultiplier(0);
+    auto output = (builder.*activation)(builder.Plus(a, b, L"plus"), L"activation");
+    ComputationNodeBasePtr criterion = builder.Sum(builder.ElementTimes(output, weights, L"weighted"), L"criterion");
+    net->AddToNodeGroup(L"criterion", criterion);
+    net->CompileNetwork();
+
+    BOOST_REQUIRE(net->GetNodeFromName(L"activation")->OperationName() == expectedOperationName);
+    BOOST_REQUIRE(net->NodeNameExists(L"plus") != fuse);
+
+    ScopedNetworkOperationMode modeGuard(net, NetworkOperationMode::training);
+    net->StartEvaluateMinibatchLoop(criterion);
+    net->AllocateAllMatrices({}, {}, criterion);
+    net->ForwardProp(criterion);
+    net->Backprop(criterion);
+
+    gradientA = a->Gradient().DeepClone();
+    gradientB = b->Gradient().DeepClone();
+}
+
+static void CheckFusedActivationOfPlusGradients(ActivationBuilder activation, const wstring& activationName, const wstring& fusedName)
+{
+    Matrix<float> unfusedA(CPUDEVICE), unfusedB(CPUDEVICE), fusedA(CPUDEVICE), fusedB(CPUDEVICE);
+    ComputeActivationOfPlusGradients(activation, false, activationName, unfusedA, unfusedB);
+    ComputeActivationOfPlusGradients(activation, true, fusedName, fusedA, fusedB);
+
+    BOOST_REQUIRE(fusedA.GetNumRows() == 3 && fusedA.GetNumCols() == 4);
+    BOOST_REQUIRE(fusedB.GetNumRows() == 3 && fusedB.GetNumCols() == 1);
+    BOOST_CHECK(fusedA.FrobeniusNorm() > 0);
+    BOOST_CHECK(fusedA.IsEqualTo(unfusedA, 1e-6f));
+    BOOST_CHECK(fusedB.IsEqualTo(unfusedB, 1e-6f));
+    // the gradient of the broadcast operand is the row sum of the gradient of the other one
+    Matrix<float> rowSums(CPUDEVICE);
+    Matrix<float>::VectorSum(fusedA, rowSums, /*isColWise=*/false);
+    BOOST_CHECK(fusedB.IsEqualTo(rowSums, 1e-5f));
+}
+
 // Use SpeechReaderFixture for most tests
 BOOST_FIXTURE_TEST_SUITE(NetworkTestSuite, OperatorFixture)
 
@@ -29,6 +105,63 @@ BOOST_AUTO_TEST_CASE(NetworkOperatorPlus)
         "../Output/out.txt.v2" /*output*/);
 };
 
+BOOST_AUTO_TEST_CASE(NetworkOperatorSigmoidOfPlus)
+{
+    // Plus followed by Sigmoid is fused into a single SigmoidOfPlus node, which keeps the name of the Sigmoid
+    ElementwiseFusionScope fusion;
+    HelperRunNetworkTest<float>(
+        L"../Config/Network_Operator_SigmoidOfPlus.cntk" /*config*/,
+        "../Control/Network_Operator_SigmoidOfPlus_Control.txt" /*control*/,
+        "../Output/out.txt.v3" /*output*/);
+};
+
+BOOST_AUTO_TEST_CASE(NetworkOperatorSigmoidOfPlusIsNotSaved)
+{
+    const wstring modelPath = L"../Output/SigmoidOfPlus.model";
+    {
+        ElementwiseFusionScope fusion;
+        auto net = make_shared<ComputationNetwork>(CPUDEVICE);
+        ComputationNetworkBuilder<float> builder(*net);
+        auto features = builder.CreateInputNode(L"features", 1);
+        auto bias = builder.CreateLearnableParameter(L"v1", 1, 1);
+        bias->Value().SetValue(1);
+        auto output = builder.Sigmoid(builder.Plus(features, bias, L"v2"), L"v3");
+        net->AddToNodeGroup(L"feature", features);
+        net->AddToNodeGroup(L"output", output);
+        net->CompileNetwork();
+
+        BOOST_REQUIRE(net->NodeNameExists(L"v3"));
+        BOOST_CHECK(net->GetNodeFromName(L"v3")->OperationName() == L"SigmoidOfPlus");
+        BOOST_CHECK(!net->NodeNameExists(L"v2"));
+        net->Save(modelPath);
+    }
+
+    // The model has the original nodes, so that it can be read without fusion.
+    ComputationNetwork net(CPUDEVICE);
+    net.Read<float>(modelPath);
+    BOOST_REQUIRE(net.NodeNameExists(L"v2") && net.NodeNameExists(L"v3"));
+    BOOST_CHECK(net.GetNodeFromName(L"v2")->OperationName() == L"Plus");
+    BOOST_CHECK(net.GetNodeFromName(L"v3")->OperationName() == L"Sigmoid");
+    BOOST_CHECK(net.GetNodeFromName(L"v3")->Input(0) == net.GetNodeFromName(L"v2"));
+    BOOST_CHECK(net.GetNodeFromName(L"v2")->Input(1) == net.GetNodeFromName(L"v1"));
+    boost::filesystem::remove(modelPath);
+};
+
+BOOST_AUTO_TEST_CASE(NetworkOperatorSigmoidOfPlusGradient)
+{
+    CheckFusedActivationOfPlusGradients(&ComputationNetworkBuilder<float>::Sigmoid, L"Sigmoid", L"SigmoidOfPlus");
+};
+
+BOOST_AUTO_TEST_CASE(NetworkOperatorTanhOfPlusGradient)
+{
+    CheckFusedActivationOfPlusGradients(&ComputationNetworkBuilder<float>::Tanh, L"Tanh", L"TanhOfPlus");
+};
+
+BOOST_AUTO_TEST_CASE(NetworkOperatorRectifiedLinearOfPlusGradient)
+{
+    CheckFusedActivationOfPlusGradients(&ComputationNetworkBuilder<float>::RectifiedLinear, L"RectifiedLinear", L"RectifiedLinearOfPlus");
+};
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -4,6 +4,7 @@
 //
 #include "stdafx.h"
 #include <algorithm>
+#include <chrono>
 #include <boost/scope_exit.hpp>
 #include "Common/ReaderTestHelper.h"
 
@@ -56,6 +57,56 @@ BOOST_AUTO_TEST_CASE(CNTKBinaryReader_MNIST_dense)
         1);
 };
 
+BOOST_AUTO_TEST_CASE(CNTKBinaryReader_Simple_dense_memory_mapped)
+{
+    HelperRunReaderTest<float>(
+        testDataPath() + "/Config/CNTKBinaryReader/test.cntk",
+        testDataPath() + "/Control/CNTKTextFormatReader/Simple_dense.txt",
+        testDataPath() + "/Control/CNTKBinaryReader/Simple_dense_memory_mapped_Output.txt",
+        "Simple",
+        "reader",
+        1000, // epoch size
+        250,  // mb size
+        10,   // num epochs 
+        1,
+        1,
+        0,
+        1,
+        false,
+        false,
+        true,
+        { L"Simple=[reader=[useMemoryMapping=true]]" });
+};
+
+// Reads chunks into buffers and maps them from the file, which must deliver the same number of samples.
+// The reported throughput is only indicative with a few epochs; increase them to benchmark.
+BOOST_AUTO_TEST_CASE(CNTKBinaryReader_memory_mapped_throughput)
+{
+    const size_t epochSize = 1000, mbSize = 250, epochs = 3;
+    size_t numSamples[2] = { 0, 0 };
+    for (bool memoryMapping : { false, true })
+    {
+        auto inputs = CreateStreamMinibatchInputs<float>(1, 1);
+        auto reader = GetDataReader(testDataPath() + "/Config/CNTKBinaryReader/test.cntk", "Simple", "reader",
+            { memoryMapping ? L"Simple=[reader=[useMemoryMapping=true]]" : L"Simple=[reader=[useMemoryMapping=false]]" });
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t epoch = 0; epoch < epochs; epoch++)
+        {
+            reader->StartMinibatchLoop(mbSize, epoch, inputs->GetStreamDescriptions(), epochSize);
+            while (reader->GetMinibatch(*inputs))
+                numSamples[memoryMapping] += inputs->GetInputMatrix<float>(L"features").GetNumCols();
+        }
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+        BOOST_TEST_MESSAGE("Simple_dense.bin: " << (memoryMapping ? "memory mapped" : "buffered") << " reading of "
+            << numSamples[memoryMapping] << " samples at " << numSamples[memoryMapping] / seconds.count() << " samples/s");
+    }
+
+    BOOST_REQUIRE_EQUAL(numSamples[0], epochSize * epochs);
+    BOOST_REQUIRE_EQUAL(numSamples[1], numSamples[0]);
+};
+
 // 10 sequences with 10 samples each (no randomization)
 BOOST_AUTO_TEST_CASE(CNTKBinaryReader_10x10_dense)
 {
@@ -131,6 +182,28 @@ BOOST_AUTO_TEST_CASE(CNTKBinaryReader_50x20_jagged_sequences_sparse)
         true);
 };
 
+// Same as above, with sparse sequences pointing into the mapped file.
+BOOST_AUTO_TEST_CASE(CNTKBinaryReader_50x20_jagged_sequences_sparse_memory_mapped)
+{
+    HelperRunReaderTest<float>(
+        testDataPath() + "/Config/CNTKBinaryReader/test.cntk",
+        testDataPath() + "/Control/CNTKTextFormatReader/50x20_jagged_sequences_sparse.txt",
+        testDataPath() + "/Control/CNTKBinaryReader/50x20_jagged_sequences_sparse_memory_mapped_Output.txt",
+        "50x20_jagged_sequences_sparse",
+        "reader",
+        564,  // epoch size
+        564,  // mb size 
+        1,  // num epochs
+        1,
+        0,
+        0,
+        1,
+        true,
+        false,
+        true,
+        { L"50x20_jagged_sequences_sparse=[reader=[useMemoryMapping=true]]" });
+};
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } } } }
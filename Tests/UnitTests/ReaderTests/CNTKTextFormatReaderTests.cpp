@@ -13,6 +13,8 @@
 #define _fileno fileno
 #endif
 #include <cstdio>
+#include <chrono>
+#include <random>
 #include <boost/scope_exit.hpp>
 #include "Common/ReaderTestHelper.h"
 #include "TextParser.h"
@@ -47,6 +49,16 @@ namespace CNTK {
         {
             m_chunk = m_parser.GetChunk(0);
         }
+
+        void SetBulkParsing(bool value)
+        {
+            m_parser.SetBulkParsing(value);
+        }
+
+        void SetTraceLevel(unsigned int traceLevel)
+        {
+            m_parser.SetTraceLevel(traceLevel);
+        }
     };
 }
 
@@ -903,6 +915,118 @@ BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_extra_input_should_be_ignored)
     }
 };
 
+// Parses the file with the bulk and the character-wise parser, checks that the results are identical
+// and reports the parsing throughput of both.
+template <class ElemType>
+void CheckBulkParsing(const string& filename, const vector<StreamDescriptor>& streams, size_t numberOfSequences)
+{
+    auto sizeInMB = boost::filesystem::file_size(filename) / (1024.0 * 1024.0);
+    vector<ChunkPtr> chunks;
+    for (bool bulkParsing : { true, false })
+    {
+        CNTKTextFormatReaderTestRunner<ElemType> testRunner(filename, streams, 0);
+        testRunner.SetTraceLevel(0);
+        testRunner.SetBulkParsing(bulkParsing);
+
+        auto start = std::chrono::steady_clock::now();
+        testRunner.LoadChunk();
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+        BOOST_TEST_MESSAGE(filename << ": " << (bulkParsing ? "bulk" : "character-wise") << " parsing of "
+            << sizeInMB << " MB at " << sizeInMB / seconds.count() << " MB/s");
+        chunks.push_back(testRunner.m_chunk);
+    }
+
+    for (size_t i = 0; i < numberOfSequences; ++i)
+    {
+        vector<SequenceDataPtr> bulk, characterWise;
+        chunks[0]->GetSequence(i, bulk);
+        chunks[1]->GetSequence(i, characterWise);
+        BOOST_REQUIRE_EQUAL(bulk.size(), streams.size());
+        BOOST_REQUIRE_EQUAL(characterWise.size(), streams.size());
+        for (size_t j = 0; j < streams.size(); ++j)
+        {
+            BOOST_REQUIRE_EQUAL(bulk[j]->m_numberOfSamples, characterWise[j]->m_numberOfSamples);
+            size_t count = bulk[j]->m_numberOfSamples * streams[j].m_sampleDimension;
+            if (streams[j].m_storageFormat == StorageFormat::SparseCSC)
+            {
+                auto& b = static_cast<SparseSequenceData&>(*bulk[j]);
+                auto& c = static_cast<SparseSequenceData&>(*characterWise[j]);
+                BOOST_REQUIRE_EQUAL(b.m_totalNnzCount, c.m_totalNnzCount);
+                BOOST_REQUIRE(b.m_nnzCounts == c.m_nnzCounts);
+                BOOST_REQUIRE(equal(b.m_indices, b.m_indices + b.m_totalNnzCount, c.m_indices));
+                count = b.m_totalNnzCount;
+            }
+
+            auto b = reinterpret_cast<const ElemType*>(bulk[j]->GetDataBuffer());
+            auto c = reinterpret_cast<const ElemType*>(characterWise[j]->GetDataBuffer());
+            // bitwise comparison, both parsers have to produce exactly the same values.
+            BOOST_REQUIRE(memcmp(b, c, count * sizeof(ElemType)) == 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_bulk_parsing)
+{
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<double> values(-100, 100);
+    // Most values are written with the default precision, every 10th one in one of various other formats
+    // (including more digits than fit into a double).
+    const char* formats[] = { "%.6g", "%.0f", "%.3f", "%.9g", "%e", "%.17f", "%.22E", "%+.1f", "%.0f." };
+
+    const size_t numberOfSequences = 2000;
+    const size_t denseDimension = 100, sparseDimension = 100000, nnz = 100;
+    string denseFile = "bulk_parsing_dense.txt", sparseFile = "bulk_parsing_sparse.txt";
+    {
+        std::ofstream dense(denseFile, std::ofstream::out | std::ofstream::binary);
+        std::ofstream sparse(sparseFile, std::ofstream::out | std::ofstream::binary);
+        char buffer[64];
+        for (size_t i = 0; i < numberOfSequences; ++i)
+        {
+            for (size_t k = 0; k < 1 + i % 4; ++k)
+            {
+                dense << i << "\t|features";
+                for (size_t j = 0; j < denseDimension; ++j)
+                {
+                    sprintf(buffer, formats[j % 10 ? 0 : rng() % _countof(formats)], values(rng));
+                    dense << (j % 10 ? " " : "  ") << buffer;
+                }
+                dense << " |# a comment |labels " << (i % 10) << ":1" << (i % 2 ? "\r\n" : "\n");
+
+                sparse << i << " |x";
+                for (size_t j = 0; j < nnz; ++j)
+                {
+                    sprintf(buffer, formats[j % 10 ? 0 : rng() % _countof(formats)], values(rng));
+                    sparse << " " << (j * sparseDimension / nnz + rng() % (sparseDimension / nnz)) << ":" << buffer;
+                }
+                sparse << "\n";
+            }
+        }
+    }
+
+    vector<StreamDescriptor> streams(2);
+    streams[0].m_alias = "features";
+    streams[0].m_name = L"features";
+    streams[0].m_storageFormat = StorageFormat::Dense;
+    streams[0].m_sampleDimension = denseDimension;
+    streams[1].m_alias = "labels";
+    streams[1].m_name = L"labels";
+    streams[1].m_storageFormat = StorageFormat::SparseCSC;
+    streams[1].m_sampleDimension = 10;
+    CheckBulkParsing<float>(denseFile, streams, numberOfSequences);
+    CheckBulkParsing<double>(denseFile, streams, numberOfSequences);
+
+    streams.resize(1);
+    streams[0].m_alias = "x";
+    streams[0].m_name = L"x";
+    streams[0].m_storageFormat = StorageFormat::SparseCSC;
+    streams[0].m_sampleDimension = sparseDimension;
+    CheckBulkParsing<float>(sparseFile, streams, numberOfSequences);
+
+    boost::filesystem::remove(denseFile);
+    boost::filesystem::remove(sparseFile);
+};
+
 // 100 sequences with N samples for each of 3 inputs, where N is chosen at random
 // from [1, 100] for each sequence
 BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_100x100x3)
@@ -5,9 +5,16 @@
 #include "stdafx.h"
 #include "Common/ReaderTestHelper.h"
 #include "CPUMatrix.h"
+#include "../../../Source/Readers/HTKDeserializers/HTKChunkDescription.h"
 
 using namespace Microsoft::MSR::CNTK;
 
+// The HTK deserializer is a plugin that is not linked into the tests, so the statics of its path parser are defined here.
+namespace CNTK {
+std::unordered_map<std::string, unsigned int> htkfeatreader::parsedpath::archivePathStringMap;
+std::vector<std::wstring> htkfeatreader::parsedpath::archivePathStringVector;
+}
+
 namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
 
 // Fixture specific to the AN4 data
@@ -846,6 +853,147 @@ BOOST_AUTO_TEST_CASE(HTKIVectorBptt)
 
 BOOST_AUTO_TEST_SUITE_END()
 
+// Writes an HTK file with USER features, in the byte order of this machine or swapped. Compressed files store
+// each value v as a short s with v = (s + b[k]) / a[k]; the returned values are the ones the reader has to produce.
+static vector<float> WriteHtkFile(const string& path, size_t numFrames, size_t dim, bool swapBytes, bool compressed)
+{
+    auto put = [swapBytes](FILE* f, const void* value, size_t size)
+    {
+        char bytes[4];
+        memcpy(bytes, value, size);
+        if (swapBytes)
+            reverse(bytes, bytes + size);
+        fwriteOrDie(bytes, size, 1, f);
+    };
+
+    const int userKind = 9, hasCompression = 02000;
+    int numSamples = (int)numFrames + (compressed ? 4 : 0); // a and b count as 4 frames
+    int period = 100000;
+    short sampleSize = (short)(dim * (compressed ? sizeof(short) : sizeof(float)));
+    short kind = (short)(compressed ? userKind | hasCompression : userKind);
+
+    vector<float> values;
+    auto f = fopenOrDie(path, "wb");
+    put(f, &numSamples, sizeof(numSamples));
+    put(f, &period, sizeof(period));
+    put(f, &sampleSize, sizeof(sampleSize));
+    put(f, &kind, sizeof(kind));
+    if (compressed)
+    {
+        vector<float> a(dim), b(dim);
+        for (size_t k = 0; k < dim; k++)
+        {
+            a[k] = 2.0f + k;
+            b[k] = 0.5f * k;
+        }
+        for (auto& v : a)
+            put(f, &v, sizeof(v));
+        for (auto& v : b)
+            put(f, &v, sizeof(v));
+        for (size_t t = 0; t < numFrames; t++)
+        {
+            for (size_t k = 0; k < dim; k++)
+            {
+                short s = (short)(t * 100 - (short)k * 7);
+                put(f, &s, sizeof(s));
+                values.push_back((s + b[k]) / a[k]);
+            }
+        }
+    }
+    else
+    {
+        for (size_t t = 0; t < numFrames; t++)
+        {
+            for (size_t k = 0; k < dim; k++)
+            {
+                float v = t * 10.0f + k * 0.25f;
+                put(f, &v, sizeof(v));
+                values.push_back(v);
+            }
+        }
+    }
+    fcloseOrDie(f);
+    return values;
+}
+
+BOOST_AUTO_TEST_SUITE(HTKBulkReadTestSuite)
+
+BOOST_AUTO_TEST_CASE(HTKFeatureReaderReadsRangeInBulk)
+{
+    const size_t numFrames = 10, dim = 3, first = 2, last = 7;
+    for (bool swapBytes : { false, true })
+    {
+        for (bool compressed : { false, true })
+        {
+            const string fileName = "HTKBulkRead.htk";
+            auto expected = WriteHtkFile(fileName, numFrames, dim, swapBytes, compressed);
+
+            string logicalPath;
+            auto path = ::CNTK::htkfeatreader::parsedpath::Parse("utt=" + fileName + "[" + to_string(first) + "," + to_string(last) + "]", logicalPath);
+
+            msra::dbn::matrix frames;
+            string kind;
+            unsigned int period;
+            {
+                ::CNTK::htkfeatreader reader;
+                reader.read(path, kind, period, frames);
+            }
+            remove(fileName.c_str());
+
+            BOOST_CHECK_EQUAL(kind, "USER");
+            BOOST_CHECK_EQUAL(period, 100000);
+            BOOST_REQUIRE_EQUAL(frames.cols(), last - first + 1);
+            BOOST_REQUIRE_EQUAL(frames.rows(), dim);
+            for (size_t t = 0; t < frames.cols(); t++)
+                for (size_t k = 0; k < dim; k++)
+                    BOOST_CHECK_EQUAL(frames(k, t), expected[(first + t) * dim + k]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(HTKChunkReadsUtterancesStoredBackToBack)
+{
+    const size_t dim = 2;
+    auto archive = WriteHtkFile("HTKChunkArchive.htk", 12, dim, false, false);
+    auto other = WriteHtkFile("HTKChunkOther.htk", 3, dim, true, true);
+
+    auto parse = [](const string& s)
+    {
+        string logicalPath;
+        return ::CNTK::htkfeatreader::parsedpath::Parse(s, logicalPath);
+    };
+
+    // The first two utterances are one run, the third one follows a gap, the last one is in another file.
+    vector<string> lines = { "a=HTKChunkArchive.htk[0,3]", "b=HTKChunkArchive.htk[4,6]", "c=HTKChunkArchive.htk[9,11]", "d=HTKChunkOther.htk[0,2]" };
+    vector<pair<const vector<float>*, size_t>> firstFrames = { { &archive, 0 }, { &archive, 4 }, { &archive, 9 }, { &other, 0 } };
+
+    BOOST_CHECK(::CNTK::HTKChunkInfo::IsContinuation(parse(lines[0]), parse(lines[1])));
+    BOOST_CHECK(!::CNTK::HTKChunkInfo::IsContinuation(parse(lines[1]), parse(lines[2])));
+    BOOST_CHECK(!::CNTK::HTKChunkInfo::IsContinuation(parse(lines[2]), parse(lines[3])));
+    BOOST_CHECK(!::CNTK::HTKChunkInfo::IsContinuation(parse(lines[1]), parse(lines[0])));
+    BOOST_CHECK(!::CNTK::HTKChunkInfo::IsContinuation(parse("e=HTKChunkArchive.htk"), parse(lines[0])));
+
+    ::CNTK::HTKChunkInfo chunk(0);
+    for (const auto& line : lines)
+        chunk.Add(::CNTK::UtteranceDescription(parse(line)));
+    chunk.RequireData("USER", dim, 100000);
+
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        auto frames = chunk.GetUtteranceFrames(i);
+        const auto& expected = *firstFrames[i].first;
+        for (size_t t = 0; t < frames.cols(); t++)
+            for (size_t k = 0; k < dim; k++)
+                BOOST_CHECK_EQUAL(frames(k, t), expected[(firstFrames[i].second + t) * dim + k]);
+    }
+    chunk.ReleaseData();
+    remove("HTKChunkArchive.htk");
+    remove("HTKChunkOther.htk");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+
 }
 
 }}}
@@ -87,6 +87,41 @@ BOOST_AUTO_TEST_CASE(ImageSimpleCompositeAndBase64)
     });
 };
 
+BOOST_AUTO_TEST_CASE(ImageSimpleCompositeFusedTransform)
+{
+    // The fused transform has to produce the same data as the Crop, Scale, Mean, Transpose chain.
+    auto test = [this](std::vector<std::wstring> additionalParameters)
+    {
+        HelperRunReaderTest<float>(
+            testDataPath() + "/Config/ImageReaderSimple_Config.cntk",
+            testDataPath() + "/Control/ImageSimpleCompositeAndBase64_Control.txt",
+            testDataPath() + "/Control/ImageSimpleCompositeFused_Output.txt",
+            "CompositeFused_Test",
+            "reader",
+            4,
+            4,
+            1,
+            1,
+            1,
+            0,
+            1,
+            false,
+            true,
+            true,
+            additionalParameters);
+    };
+
+    // Image deserializer.
+    test({});
+    // Base64 deserializer.
+    test(
+    {
+        L"MapFile=\"$RootDir$/Base64ImageReaderSimple_map.txt\"",
+        L"DeserializerType=\"Base64ImageDeserializer\"",
+        L"useNumericSequenceKeys=true"
+    });
+};
+
 BOOST_AUTO_TEST_CASE(InvalidImageSimpleCompositeAndBase64)
 {
     auto test = [this](std::vector<std::wstring> additionalParameters)
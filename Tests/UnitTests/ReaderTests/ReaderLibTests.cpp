@@ -10,6 +10,7 @@
 #include "NoRandomizer.h"
 #include "DataDeserializer.h"
 #include "BlockRandomizer.h"
+#include "ChunkCache.h"
 #include "CorpusDescriptor.h"
 #include "FramePacker.h"
 #include "SequencePacker.h"
@@ -17,6 +18,8 @@
 #include "CudaMemoryProvider.h"
 #include "HeapMemoryProvider.h"
 #include "BufferedFileReader.h"
+#include "ReaderBase.h"
+#include "ReaderShim.h"
 
 #pragma warning(push)
 // disable warning about possible mod 0 operation in uniform_int_distribution
@@ -380,6 +383,263 @@ BOOST_AUTO_TEST_CASE(RandRollbackToSameEpochInBigRandomizationWindow)
 }
 
 
+BOOST_AUTO_TEST_CASE(BlockRandomizerPrefetchDepth)
+{
+    size_t chunkSizeInSamples = 10000;
+    size_t sweepNumberOfSamples = 500000;
+    uint32_t maxSequenceLength = 300;
+    size_t randomizationWindow = chunkSizeInSamples * 3;
+    auto deserializer = make_shared<SequentialDeserializer>(0, chunkSizeInSamples, sweepNumberOfSamples, maxSequenceLength);
+
+    // The baseline prefetches a single chunk.
+    auto expected = make_shared<BlockRandomizer>(0, randomizationWindow, deserializer, true, false);
+    auto firstSweep = ReadFullSweep(expected, 0, sweepNumberOfSamples);
+    auto secondSweep = ReadFullSweep(expected, 1, sweepNumberOfSamples);
+
+    // The order of sequences must not depend on how many chunks are prefetched, on how many threads,
+    // or on the memory budget (each chunk here is ~40KB).
+    auto test = [&](size_t prefetchDepth, size_t prefetchThreads, size_t prefetchBudgetInBytes)
+    {
+        auto underTest = make_shared<BlockRandomizer>(0, randomizationWindow, deserializer, true, false, 0, true, 0,
+                                                      prefetchDepth, prefetchThreads, prefetchBudgetInBytes);
+        auto first = ReadFullSweep(underTest, 0, sweepNumberOfSamples);
+        BOOST_CHECK_EQUAL_COLLECTIONS(firstSweep.begin(), firstSweep.end(), first.begin(), first.end());
+
+        auto second = ReadFullSweep(underTest, 1, sweepNumberOfSamples);
+        BOOST_CHECK_EQUAL_COLLECTIONS(secondSweep.begin(), secondSweep.end(), second.begin(), second.end());
+
+        // All chunks but the ones of the first window are taken from the prefetch.
+        const auto& stats = underTest->GetPrefetchStatistics();
+        BOOST_CHECK(stats.m_numLoadedChunks > 0);
+        BOOST_CHECK(stats.m_minLoadSeconds <= stats.m_maxLoadSeconds);
+    };
+
+    test(1, 1, 0);
+    test(4, 1, 0);
+    test(4, 4, 0);
+    test(8, 2, 100000);
+    test(8, 2, 1);
+}
+
+BOOST_AUTO_TEST_CASE(ChunkCacheWithBudgetAndSpillFile)
+{
+    size_t chunkSizeInSamples = 10000;
+    size_t sweepNumberOfSamples = 200000;
+    uint32_t maxSequenceLength = 300;
+    size_t randomizationWindow = chunkSizeInSamples * 3;
+    auto deserializer = make_shared<SequentialDeserializer>(0, chunkSizeInSamples, sweepNumberOfSamples, maxSequenceLength);
+    size_t numberOfChunks = deserializer->ChunkInfos().size();
+
+    auto expected = make_shared<BlockRandomizer>(0, randomizationWindow, deserializer, true, false);
+    vector<vector<float>> expectedSweeps;
+    for (size_t sweep = 0; sweep < 3; ++sweep)
+        expectedSweeps.push_back(ReadFullSweep(expected, sweep, sweepNumberOfSamples));
+
+    // Each chunk takes ~40KB in memory, so only a few of them fit into the budget.
+    auto test = [&](const wstring& spillFile)
+    {
+        auto cache = make_shared<ChunkCache>(deserializer, 4 * chunkSizeInSamples * sizeof(float), spillFile);
+        auto underTest = make_shared<BlockRandomizer>(0, randomizationWindow, cache, true, false);
+        for (size_t sweep = 0; sweep < expectedSweeps.size(); ++sweep)
+        {
+            auto actual = ReadFullSweep(underTest, sweep, sweepNumberOfSamples);
+            BOOST_CHECK_EQUAL_COLLECTIONS(expectedSweeps[sweep].begin(), expectedSweeps[sweep].end(), actual.begin(), actual.end());
+        }
+
+        auto stats = cache->GetStatistics();
+        BOOST_CHECK(stats.m_evictions > 0);
+        BOOST_CHECK(stats.m_cachedBytes <= 4 * chunkSizeInSamples * sizeof(float) + maxSequenceLength * sizeof(float));
+        if (spillFile.empty())
+        {
+            // Evicted chunks have to be deserialized again.
+            BOOST_CHECK_EQUAL(stats.m_spillHits, 0);
+            BOOST_CHECK(stats.m_misses > numberOfChunks);
+        }
+        else
+        {
+            // All chunks are deserialized once, later sweeps read evicted chunks from the spill file.
+            // Only evicted chunks are spilled, each of them once.
+            BOOST_CHECK_EQUAL(stats.m_misses, numberOfChunks);
+            BOOST_CHECK(stats.m_spilledChunks > 0);
+            BOOST_CHECK(stats.m_spilledChunks <= numberOfChunks);
+            BOOST_CHECK(stats.m_spillHits > 0);
+        }
+    };
+
+    test(L"");
+    test(L"ChunkCacheSpill.bin");
+}
+
+// A deserializer with a single sparse stream, sequence i of chunk c has i + 1 samples,
+// sample j of it has j + 1 non-zero values. Without nnz counts the sequences only have the total count.
+class MockSparseDeserializer : public DataDeserializer
+{
+    struct MockSparseSequenceData : SparseSequenceData
+    {
+        const void* GetDataBuffer() override { return m_values.data(); }
+        const NDShape& GetSampleShape() override { return m_shape; }
+
+        vector<float> m_values;
+        vector<SparseIndexType> m_indexBuffer;
+        NDShape m_shape;
+    };
+
+    struct MockSparseChunk : Chunk
+    {
+        MockSparseChunk(ChunkIdType chunkId, bool withNnzCounts) : m_chunkId(chunkId), m_withNnzCounts(withNnzCounts) {}
+
+        void GetSequence(size_t sequenceIndex, vector<SequenceDataPtr>& result) override
+        {
+            auto s = make_shared<MockSparseSequenceData>();
+            s->m_shape = NDShape({ 100 });
+            s->m_numberOfSamples = (uint32_t)sequenceIndex + 1;
+            for (uint32_t j = 0; j < s->m_numberOfSamples; ++j)
+            {
+                if (m_withNnzCounts)
+                    s->m_nnzCounts.push_back(j + 1);
+                for (uint32_t k = 0; k <= j; ++k)
+                {
+                    s->m_indexBuffer.push_back(k * 7 % 100);
+                    s->m_values.push_back(m_chunkId * 1000.0f + sequenceIndex * 100.0f + j * 10.0f + k);
+                }
+            }
+            s->m_indices = s->m_indexBuffer.data();
+            s->m_totalNnzCount = (SparseIndexType)s->m_values.size();
+            s->m_key = SequenceKey(m_chunkId * 10 + sequenceIndex, 0);
+            result.push_back(s);
+        }
+
+        ChunkIdType m_chunkId;
+        bool m_withNnzCounts;
+    };
+
+    bool m_withNnzCounts;
+
+public:
+    MockSparseDeserializer(bool withNnzCounts = true) : m_withNnzCounts(withNnzCounts) {}
+
+    static const size_t NumberOfChunks = 3;
+    static const size_t NumberOfSequencesPerChunk = 4;
+
+    vector<StreamInformation> StreamInfos() override
+    {
+        StreamInformation si;
+        si.m_name = L"input";
+        si.m_id = 0;
+        si.m_storageFormat = StorageFormat::SparseCSC;
+        si.m_elementType = DataType::Float;
+        si.m_sampleLayout = NDShape({ 100 });
+        return vector<StreamInformation>{ si };
+    }
+
+    vector<ChunkInfo> ChunkInfos() override
+    {
+        vector<ChunkInfo> result;
+        for (ChunkIdType i = 0; i < NumberOfChunks; ++i)
+            result.push_back(ChunkInfo{ i, 10, NumberOfSequencesPerChunk });
+        return result;
+    }
+
+    void SequenceInfosForChunk(ChunkIdType chunkId, vector<SequenceInfo>& descriptions) override
+    {
+        for (size_t i = 0; i < NumberOfSequencesPerChunk; ++i)
+            descriptions.push_back(SequenceInfo{ i, (unsigned int)i + 1, chunkId, SequenceKey(chunkId * 10 + i, 0) });
+    }
+
+    bool GetSequenceInfo(const SequenceInfo&, SequenceInfo&) override
+    {
+        throw logic_error("Not implemented");
+    }
+
+    ChunkPtr GetChunk(ChunkIdType chunkId) override
+    {
+        return make_shared<MockSparseChunk>(chunkId, m_withNnzCounts);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(ChunkCacheSpillsSparseSequences)
+{
+    auto deserializer = make_shared<MockSparseDeserializer>();
+    const size_t numberOfChunks = MockSparseDeserializer::NumberOfChunks;
+
+    // With a budget of one byte every chunk except the last one loaded is evicted immediately.
+    ChunkCache cache(deserializer, 1, L"ChunkCacheSparseSpill.bin");
+    for (ChunkIdType c = 0; c < numberOfChunks; ++c)
+        cache.GetChunk(c);
+
+    for (ChunkIdType c = 0; c < numberOfChunks; ++c)
+    {
+        auto expected = deserializer->GetChunk(c);
+        auto actual = cache.GetChunk(c);
+        for (size_t i = 0; i < MockSparseDeserializer::NumberOfSequencesPerChunk; ++i)
+        {
+            vector<SequenceDataPtr> e, a;
+            expected->GetSequence(i, e);
+            actual->GetSequence(i, a);
+            BOOST_REQUIRE_EQUAL(a.size(), 1);
+
+            auto& es = static_cast<SparseSequenceData&>(*e[0]);
+            auto& as = static_cast<SparseSequenceData&>(*a[0]);
+            BOOST_CHECK_EQUAL(as.m_numberOfSamples, es.m_numberOfSamples);
+            BOOST_CHECK_EQUAL(as.m_totalNnzCount, es.m_totalNnzCount);
+            BOOST_CHECK_EQUAL(as.m_key.m_sequence, es.m_key.m_sequence);
+            BOOST_CHECK(as.GetSampleShape() == es.GetSampleShape());
+            // The mock does not set the element type of its sequences, the spilled ones have the one of the stream.
+            if (c != numberOfChunks - 1)
+                BOOST_CHECK(as.m_elementType == DataType::Float);
+            BOOST_CHECK_EQUAL_COLLECTIONS(as.m_nnzCounts.begin(), as.m_nnzCounts.end(), es.m_nnzCounts.begin(), es.m_nnzCounts.end());
+            BOOST_CHECK_EQUAL_COLLECTIONS(as.m_indices, as.m_indices + as.m_totalNnzCount, es.m_indices, es.m_indices + es.m_totalNnzCount);
+
+            const float* av = (const float*)as.GetDataBuffer();
+            const float* ev = (const float*)es.GetDataBuffer();
+            BOOST_CHECK_EQUAL_COLLECTIONS(av, av + as.m_totalNnzCount, ev, ev + es.m_totalNnzCount);
+        }
+    }
+
+    auto stats = cache.GetStatistics();
+    BOOST_CHECK_EQUAL(stats.m_misses, numberOfChunks);
+    BOOST_CHECK_EQUAL(stats.m_spillHits, numberOfChunks - 1);
+    BOOST_CHECK_EQUAL(stats.m_hits, 1);
+    BOOST_CHECK_EQUAL(stats.m_spilledChunks, numberOfChunks - 1);
+
+    // Chunks that fit into the budget are never written to the spill file.
+    ChunkCache large(deserializer, 1 << 20, L"ChunkCacheSparseSpill.bin");
+    for (size_t sweep = 0; sweep < 2; ++sweep)
+        for (ChunkIdType c = 0; c < numberOfChunks; ++c)
+            large.GetChunk(c);
+
+    stats = large.GetStatistics();
+    BOOST_CHECK_EQUAL(stats.m_misses, numberOfChunks);
+    BOOST_CHECK_EQUAL(stats.m_hits, numberOfChunks);
+    BOOST_CHECK_EQUAL(stats.m_spilledChunks, 0);
+    BOOST_CHECK_EQUAL(stats.m_spilledBytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(ChunkCacheDoesNotSpillSparseSequencesWithoutNnzCounts)
+{
+    auto deserializer = make_shared<MockSparseDeserializer>(false);
+    const size_t numberOfChunks = MockSparseDeserializer::NumberOfChunks;
+
+    // Evicted chunks cannot be spilled, so they are deserialized again.
+    ChunkCache cache(deserializer, 1, L"ChunkCacheSparseSpill.bin");
+    for (size_t sweep = 0; sweep < 2; ++sweep)
+    {
+        for (ChunkIdType c = 0; c < numberOfChunks; ++c)
+        {
+            vector<SequenceDataPtr> sequence;
+            cache.GetChunk(c)->GetSequence(1, sequence);
+            BOOST_REQUIRE_EQUAL(sequence.size(), 1);
+            BOOST_CHECK_EQUAL(sequence[0]->m_key.m_sequence, c * 10 + 1);
+            BOOST_CHECK_EQUAL(static_cast<SparseSequenceData&>(*sequence[0]).m_totalNnzCount, 3);
+        }
+    }
+
+    auto stats = cache.GetStatistics();
+    BOOST_CHECK_EQUAL(stats.m_spilledChunks, 0);
+    BOOST_CHECK_EQUAL(stats.m_spillHits, 0);
+    BOOST_CHECK_EQUAL(stats.m_misses, 2 * numberOfChunks);
+}
+
 BOOST_AUTO_TEST_CASE(BlockRandomizerInstantiate)
 {
     BlockRandomizerInstantiateTest(false);
@@ -1203,6 +1463,144 @@ BOOST_AUTO_TEST_CASE(CheckNoDegenerateMinibatches)
 
 BOOST_AUTO_TEST_SUITE_END()
 
+BOOST_AUTO_TEST_SUITE(ReaderShimTests)
+
+// Reads the sequential deserializer in order, one sample per sequence.
+class SequentialReader : public ReaderBase
+{
+public:
+    SequentialReader(size_t sweepNumberOfSamples)
+    {
+        m_deserializer = make_shared<SequentialDeserializer>(0, 10, sweepNumberOfSamples, 1);
+        m_sequenceEnumerator = make_shared<NoRandomizer>(m_deserializer);
+        m_packer = make_shared<FramePacker>(m_sequenceEnumerator, m_deserializer->StreamInfos());
+    }
+};
+
+struct ReaderShimFixture
+{
+    static const size_t sweepSize = 100;
+    static const size_t mbSize = 7;
+
+    ReaderShimFixture(size_t prefetchMinibatches)
+        : m_shim(make_shared<SequentialReader>(sweepSize))
+    {
+        ConfigParameters config;
+        config.Insert("prefetchMinibatches", std::to_string(prefetchMinibatches));
+        m_shim.Init(config);
+
+        m_inputs.AddInput(L"input", make_shared<Matrix<float>>(CPUDEVICE), make_shared<MBLayout>(), TensorShape(1));
+    }
+
+    void StartEpoch(size_t epoch, size_t epochSize)
+    {
+        m_shim.StartMinibatchLoop(mbSize, epoch, m_inputs.GetStreamDescriptions(), epochSize);
+    }
+
+    // Returns the samples of the next maxMinibatches minibatches, or of the rest of the epoch.
+    vector<float> Read(size_t maxMinibatches = SIZE_MAX)
+    {
+        vector<float> samples;
+        auto& matrix = m_inputs.GetInputMatrix<float>(L"input");
+        for (size_t i = 0; i < maxMinibatches && m_shim.GetMinibatch(m_inputs); i++)
+        {
+            BOOST_TEST(matrix.GetNumElements() <= mbSize);
+            samples.insert(samples.end(), matrix.Data(), matrix.Data() + matrix.GetNumElements());
+        }
+        return samples;
+    }
+
+    static vector<float> Range(size_t begin, size_t end)
+    {
+        vector<float> samples(end - begin);
+        iota(samples.begin(), samples.end(), (float)begin);
+        return samples;
+    }
+
+    ::CNTK::ReaderShim<float> m_shim;
+    StreamMinibatchInputs m_inputs;
+};
+
+const size_t ReaderShimFixture::sweepSize;
+const size_t ReaderShimFixture::mbSize;
+
+BOOST_AUTO_TEST_CASE(ReaderShimPrefetchReadsEpochsInOrder)
+{
+    for (size_t prefetchMinibatches : { 1, 3, 8 })
+    {
+        ReaderShimFixture fixture(prefetchMinibatches);
+
+        // The second epoch continues where the first ended, and the prefetch thread must not read past its end.
+        const size_t epochSize = 45;
+        for (size_t epoch = 0; epoch < 2; epoch++)
+        {
+            fixture.StartEpoch(epoch, epochSize);
+            auto expected = ReaderShimFixture::Range(epoch * epochSize, (epoch + 1) * epochSize);
+            auto actual = fixture.Read();
+            BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+
+            BOOST_TEST(fixture.m_shim.IsEndOfEpoch());
+            BOOST_TEST(!fixture.m_shim.GetMinibatch(fixture.m_inputs));
+            BOOST_TEST(fixture.m_shim.GetCurrentSamplePosition() == (epoch + 1) * epochSize);
+
+            const auto& statistics = fixture.m_shim.GetPipelineStatistics();
+            BOOST_TEST(statistics.m_numMinibatches >= (epochSize + ReaderShimFixture::mbSize - 1) / ReaderShimFixture::mbSize);
+            BOOST_TEST(statistics.m_totalOccupancy <= statistics.m_numMinibatches * prefetchMinibatches);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReaderShimPrefetchSetPositionMidEpoch)
+{
+    for (size_t prefetchMinibatches : { 1, 3 })
+    {
+        ReaderShimFixture fixture(prefetchMinibatches);
+        fixture.StartEpoch(0, ReaderShimFixture::sweepSize);
+
+        // The reported position is that of the returned minibatches, not of the prepared ones.
+        auto actual = fixture.Read(3);
+        auto expected = ReaderShimFixture::Range(0, 21);
+        BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+        BOOST_TEST(fixture.m_shim.GetCurrentSamplePosition() == 21);
+
+        // Forward: the prepared minibatches are dropped.
+        fixture.m_shim.SetCurrentSamplePosition(50);
+        actual = fixture.Read(2);
+        expected = ReaderShimFixture::Range(50, 64);
+        BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+
+        // Backward, then to the end of the epoch.
+        fixture.m_shim.SetCurrentSamplePosition(10);
+        actual = fixture.Read();
+        expected = ReaderShimFixture::Range(10, ReaderShimFixture::sweepSize);
+        BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+        BOOST_TEST(fixture.m_shim.IsEndOfEpoch());
+        BOOST_TEST(fixture.m_shim.GetCurrentSamplePosition() == ReaderShimFixture::sweepSize);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReaderShimPrefetchStartEpochMidEpoch)
+{
+    for (size_t prefetchMinibatches : { 1, 3 })
+    {
+        ReaderShimFixture fixture(prefetchMinibatches);
+        const size_t epochSize = 35;
+        fixture.StartEpoch(0, epochSize);
+        auto actual = fixture.Read(2);
+        auto expected = ReaderShimFixture::Range(0, 14);
+        BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+
+        // Minibatches prepared for the abandoned epoch must not leak into the next one.
+        fixture.StartEpoch(1, epochSize);
+        actual = fixture.Read();
+        expected = ReaderShimFixture::Range(epochSize, 2 * epochSize);
+        BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+        BOOST_TEST(fixture.m_shim.IsEndOfEpoch());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 BOOST_AUTO_TEST_SUITE(PackerTests)
 
 typedef std::multimap<size_t, SequentialDeserializer::MockSequenceInfo> CorpusSubset;
@@ -4,6 +4,7 @@
 //
 
 #include <chrono>
+#include <random>
 #include "stdafx.h"
 #include "BufferedFileReader.h"
 #include "FileWrapper.h"
@@ -354,8 +355,8 @@ static void CheckIdentical(const shared_ptr<Index>& index1, const shared_ptr<Ind
         Check(chunk1, chunk2.NumberOfSequences(), chunk2.NumberOfSamples(), chunk2.StartOffset(), chunk2.SizeInBytes());
         for (int j = 0; j < chunk1.NumberOfSequences(); j++)
         {
-            auto& seq1 = chunk1[i];
-            auto& seq2 = chunk2[i];
+            auto& seq1 = chunk1[j];
+            auto& seq2 = chunk2[j];
             Check(seq1, seq2.m_key, seq2.NumberOfSamples(), seq2.OffsetInChunk(), seq2.SizeInBytes());
         }
     }
@@ -741,6 +742,59 @@ BOOST_AUTO_TEST_CASE(Index_non_primary)
 }
 
 
+BOOST_AUTO_TEST_CASE(Index_built_in_parallel)
+{
+    // Multi-line sequences with sequence ids, where continuation lines do not always
+    // repeat the id and some sequences do not contain the main stream.
+    auto generate = [](const string& keyPrefix, bool withIds)
+    {
+        std::mt19937 rng(17);
+        string content = "\xEF\xBB\xBF \n\n";
+        for (size_t i = 0; content.size() < 2 * g_1MB; ++i)
+        {
+            string id = keyPrefix + std::to_string(i);
+            auto numberOfLines = rng() % 5 + 1;
+            bool hasMainStream = (rng() % 10 != 0);
+            for (size_t j = 0; j < numberOfLines; ++j)
+            {
+                if (withIds && (j == 0 || rng() % 2))
+                    content += id + "\t";
+                content += (hasMainStream ? "|a 1 2 3" : "") + string("|b ") + std::to_string(rng()) + (j % 3 ? "\n" : "\r\n");
+            }
+        }
+        return content;
+    };
+
+    auto checkParallel = [](const string& content, CorpusDescriptorPtr (*corpus)(), bool skipSequenceIds)
+    {
+        shared_ptr<Index> index[2];
+        for (size_t numberOfThreads : { 1, 8 })
+        {
+            auto builder = GetIndexBuilder(content);
+            builder->SetSkipSequenceIds(skipSequenceIds).SetMainStream("a");
+            // A small buffer splits the input into as many ranges as there are threads.
+            index[numberOfThreads > 1] = builder->SetNumberOfThreads(numberOfThreads)
+                .SetBufferSize(g_1MB / 64)
+                .SetChunkSize(g_1MB / 16)
+                .SetCorpus(corpus ? corpus() : nullptr)
+                .Build();
+        }
+
+        Check(index[0]);
+        BOOST_REQUIRE(index[0]->NumberOfChunks() > 16);
+        CheckIdentical(index[1], index[0]);
+    };
+
+    string withNumericIds = generate("", true);
+    checkParallel(withNumericIds, nullptr, false);
+    checkParallel(withNumericIds, nullptr, true);
+    checkParallel(generate("", false), nullptr, false);
+
+    string withSymbolicIds = generate("key", true);
+    checkParallel(withSymbolicIds, []() { return std::make_shared<CorpusDescriptor>(false, false); }, false);
+    checkParallel(withSymbolicIds, []() { return std::make_shared<CorpusDescriptor>(false, true); }, false);
+}
+
 BOOST_AUTO_TEST_CASE(Index_with_caching)
 {
     auto filename = L"test.tmp";
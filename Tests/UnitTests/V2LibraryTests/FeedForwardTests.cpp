@@ -450,6 +450,83 @@ void TestTimesReduceSequenceAxis(
     }
 }
 
+// Evaluates a network with several independent branches, which share a parameter and the input, and a criterion
+// with reductions over the samples, one node at a time and with inter-op parallelism. With inter-op parallelism
+// each node uses fewer intra-op threads, which changes the rounding of reductions, so the outputs and gradients
+// must match the sequential ones up to the floating-point tolerance. For a given number of workers they must not
+// depend on the schedule, though, so repeated runs, also with another schedule seed, give exactly the same results.
+void TestInterOpParallelism(const DeviceDescriptor& device)
+{
+    const size_t inputDim = 32;
+    const size_t hiddenDim = 64;
+    const size_t numSamples = 16;
+    const size_t numBranches = 6;
+
+    auto inputVar = InputVariable({ inputDim }, DataType::Float, L"input");
+    auto bias = Parameter(NDArrayView::RandomNormal<float>({ hiddenDim }, 0, 1, 1, device), L"bias");
+    std::vector<Parameter> weights;
+    FunctionPtr sum;
+    for (size_t i = 0; i < numBranches; i++)
+    {
+        weights.push_back(Parameter(NDArrayView::RandomNormal<float>({ hiddenDim, inputDim }, 0, 1, (unsigned long)i + 2, device)));
+        auto branch = Tanh(Plus(Times(weights.back(), inputVar), bias));
+        sum = sum ? Plus(sum, branch) : branch;
+    }
+    auto output = ElementTimes(sum, Sigmoid(Times(weights.front(), inputVar))); // shares a parameter across branches
+
+    auto labelsVar = InputVariable({ hiddenDim }, DataType::Float, L"labels");
+    auto criterion = Plus(CrossEntropyWithSoftmax(output, labelsVar), ReduceSum(output, Axis::AllStaticAxes()));
+    auto root = Combine({ output, criterion });
+
+    auto inputValue = MakeSharedObject<Value>(NDArrayView::RandomUniform<float>(inputVar.Shape().AppendShape({ 1, numSamples }), -1, 1, 7, device));
+    std::vector<float> labelsData(hiddenDim * numSamples, 0.0f);
+    for (size_t i = 0; i < numSamples; i++)
+        labelsData[i * hiddenDim + (i * 7) % hiddenDim] = 1.0f;
+    auto labelsValue = MakeSharedObject<Value>(MakeSharedObject<NDArrayView>(labelsVar.Shape().AppendShape({ 1, numSamples }), labelsData.data(), labelsData.size(), DeviceDescriptor::CPUDevice(), true)->DeepClone(device));
+    auto evaluate = [&]()
+    {
+        std::unordered_map<Variable, ValuePtr> outputs = { { output->Output(), nullptr }, { criterion->Output(), nullptr } };
+        auto backpropState = root->Forward({ { inputVar, inputValue }, { labelsVar, labelsValue } }, outputs, device, { criterion->Output() });
+        auto rootGradient = MakeSharedObject<Value>(MakeSharedObject<NDArrayView>(1.0f, outputs[criterion->Output()]->Shape(), device));
+
+        std::unordered_map<Variable, ValuePtr> gradients = { { bias, nullptr } };
+        for (auto& weight : weights)
+            gradients.insert({ weight, nullptr });
+        root->Backward(backpropState, { { criterion->Output(), rootGradient } }, gradients);
+
+        std::vector<float> results;
+        auto append = [&results](const NDArrayViewPtr& data)
+        {
+            auto cpuData = data->DeepClone(DeviceDescriptor::CPUDevice());
+            results.insert(results.end(), cpuData->DataBuffer<float>(), cpuData->DataBuffer<float>() + cpuData->Shape().TotalSize());
+        };
+        append(outputs[output->Output()]->Data());
+        append(outputs[criterion->Output()]->Data());
+        append(gradients[bias]->Data());
+        for (auto& weight : weights)
+            append(gradients[weight]->Data());
+        return results;
+    };
+
+    Internal::SetInterOpParallelism(1);
+    auto expected = evaluate();
+    std::vector<float> firstParallel;
+    for (unsigned long scheduleSeed : { 0, 13 })
+    {
+        Internal::SetInterOpParallelism(4, scheduleSeed);
+        auto actual = evaluate();
+        FloatingPointVectorCompare(actual, expected, "Inter-op parallel evaluation differs from sequential evaluation");
+
+        for (size_t run = 0; run < 3; run++)
+            BOOST_TEST((evaluate() == actual), "Repeated inter-op parallel evaluation with the same schedule seed is not bitwise identical");
+        if (firstParallel.empty())
+            firstParallel = actual;
+        else
+            BOOST_TEST((actual == firstParallel), "Inter-op parallel evaluation depends on the schedule seed");
+    }
+    Internal::SetInterOpParallelism(1);
+}
+
 BOOST_AUTO_TEST_SUITE(FeedForwardSuite)
 
 BOOST_AUTO_TEST_CASE(FFTimesAndPlusInCPU)
@@ -457,6 +534,11 @@ BOOST_AUTO_TEST_CASE(FFTimesAndPlusInCPU)
     TestTimesAndPlus<double>(4, 2, 5, DeviceDescriptor::CPUDevice(), 3, true, true, true);
 }
 
+BOOST_AUTO_TEST_CASE(InterOpParallelismInCPU)
+{
+    TestInterOpParallelism(DeviceDescriptor::CPUDevice());
+}
+
 BOOST_AUTO_TEST_CASE(ReduceableTransposeTimesInCPU)
 {
     TestReduceableTransposeTimes<double>(4, 5, DeviceDescriptor::CPUDevice(), 3);
@@ -6,6 +6,11 @@
 #include "CNTKLibrary.h"
 #include "Common.h"
 #include <numeric>
+#include <future>
+#include <fstream>
+#include <iterator>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
 using namespace CNTK;
 
@@ -1096,6 +1101,422 @@ void SetRandomSeed(const DeviceDescriptor& device)
     FloatingPointVectorCompare(result2, result4, "SetRandomSeed: output does match the expected after resetting the dropout seed.");
 }
 
+void TestBatchingEvaluator(const DeviceDescriptor& device)
+{
+    const size_t inputDim = 3;
+    const size_t outputDim = 4;
+    const size_t maxBatchSize = 8;
+    const size_t numThreads = 4;
+    const size_t numRequestsPerThread = 25;
+
+    auto input = InputVariable({ inputDim }, DataType::Float, L"input");
+    auto timesParam = Parameter(NDArrayView::RandomUniform<float>({ outputDim, inputDim }, -0.5, 0.5, 1, device));
+    auto plusParam = Parameter(NDArrayView::RandomUniform<float>({ outputDim }, -0.5, 0.5, 2, device));
+    auto model = Sigmoid(Plus(plusParam, Times(timesParam, input)));
+
+    // The expected result of a request is that of evaluating it on its own.
+    auto evaluateAlone = [&](const NDArrayViewPtr& data) -> std::vector<float>
+    {
+        std::unordered_map<Variable, ValuePtr> outputs = { { model->Output(), nullptr } };
+        model->Evaluate({ { input, Value::Create(input.Shape(), { data }, device, /*readOnly =*/ true) } }, outputs, device);
+        std::vector<std::vector<float>> sequences;
+        outputs[model->Output()]->CopyVariableValueTo(model->Output(), sequences);
+        return sequences[0];
+    };
+
+    auto evaluator = CreateBatchingEvaluator(model, maxBatchSize, std::chrono::microseconds(2000), device);
+
+    // Requests are sequences of different lengths; every fifth is a single sample without sequence axis.
+    // Boost.Test is not thread-safe, so the clients only collect their requests and results.
+    typedef std::vector<std::pair<NDArrayViewPtr, NDArrayViewPtr>> RequestsAndResults;
+    std::vector<std::future<RequestsAndResults>> clients;
+    for (size_t t = 0; t < numThreads; t++)
+    {
+        clients.push_back(std::async(std::launch::async, [&, t]()
+        {
+            RequestsAndResults requestsAndResults;
+            for (size_t r = 0; r < numRequestsPerThread; r++)
+            {
+                size_t sequenceLength = 1 + (t + r) % 5;
+                NDShape shape = (r % 5 == 0) ? input.Shape() : input.Shape().AppendShape({ sequenceLength });
+                auto data = NDArrayView::RandomUniform<float>(shape, -1, 1, (unsigned long)(t * numRequestsPerThread + r), DeviceDescriptor::CPUDevice());
+
+                auto result = evaluator->Evaluate({ { input, data } }).get();
+                requestsAndResults.push_back({ data, result.at(model->Output()) });
+            }
+            return requestsAndResults;
+        }));
+    }
+
+    for (auto& client : clients)
+    {
+        for (const auto& requestAndResult : client.get())
+        {
+            auto data = requestAndResult.first;
+            auto result = requestAndResult.second;
+            BOOST_TEST(result->Shape().TotalSize() == outputDim * data->Shape().SubShape(1).TotalSize());
+
+            std::vector<float> actual(result->DataBuffer<float>(), result->DataBuffer<float>() + result->Shape().TotalSize());
+            FloatingPointVectorCompare(actual, evaluateAlone(data), "BatchingEvaluator: The result of a batched request does not match its result when evaluated alone.");
+        }
+    }
+
+    auto statistics = evaluator->Statistics();
+    BOOST_TEST(statistics.m_numRequests == numThreads * numRequestsPerThread);
+    BOOST_TEST(statistics.m_batchSizeHistogram.size() == maxBatchSize + 1);
+    BOOST_TEST(statistics.m_batchSizeHistogram[0] == 0);
+    size_t numBatches = 0, numBatchedRequests = 0;
+    for (size_t i = 0; i < statistics.m_batchSizeHistogram.size(); i++)
+    {
+        numBatches += statistics.m_batchSizeHistogram[i];
+        numBatchedRequests += i * statistics.m_batchSizeHistogram[i];
+    }
+    BOOST_TEST(numBatches == statistics.m_numBatches);
+    BOOST_TEST(numBatchedRequests == statistics.m_numRequests);
+    BOOST_TEST(std::accumulate(statistics.m_queueDepthHistogram.begin(), statistics.m_queueDepthHistogram.end(), (size_t)0) == statistics.m_numRequests);
+
+    // Missing arguments are rejected when submitting.
+    VerifyException([&evaluator]() { evaluator->Evaluate({}); }, "Was able to submit a request without arguments.");
+
+    // So is data of the wrong type or shape, without failing the requests around it.
+    auto goodData = NDArrayView::RandomUniform<float>(input.Shape(), -1, 1, 3, DeviceDescriptor::CPUDevice());
+    auto before = evaluator->Evaluate({ { input, goodData } });
+    VerifyException([&]() { evaluator->Evaluate({ { input, NDArrayView::RandomUniform<double>(input.Shape(), -1, 1, 4, DeviceDescriptor::CPUDevice()) } }); },
+                    "Was able to submit a request with data of the wrong type.");
+    VerifyException([&]() { evaluator->Evaluate({ { input, NDArrayView::RandomUniform<float>({ inputDim + 1 }, -1, 1, 5, DeviceDescriptor::CPUDevice()) } }); },
+                    "Was able to submit a request with data of the wrong shape.");
+    auto after = evaluator->Evaluate({ { input, goodData } });
+    for (auto result : { before.get(), after.get() })
+    {
+        auto output = result.at(model->Output());
+        std::vector<float> actual(output->DataBuffer<float>(), output->DataBuffer<float>() + output->Shape().TotalSize());
+        FloatingPointVectorCompare(actual, evaluateAlone(goodData), "BatchingEvaluator: A request next to a rejected one did not get its result.");
+    }
+
+    evaluator->ResetStatistics();
+    BOOST_TEST(evaluator->Statistics().m_numRequests == 0);
+}
+
+// A recurrent step model for beam search: the next state depends on the previous token, the state and a per-sequence context.
+struct BeamSearchStepModel
+{
+    FunctionPtr m_function;
+    Variable m_token;
+    Variable m_state;
+    Variable m_context;
+    Variable m_scores;
+    Variable m_nextState;
+};
+
+BeamSearchStepModel CreateBeamSearchStepModel(size_t vocabularySize, size_t stateDim, const DeviceDescriptor& device)
+{
+    std::vector<Axis> batchAxis = { Axis::DefaultBatchAxis() };
+    auto token = InputVariable({ vocabularySize }, DataType::Float, L"token", batchAxis);
+    auto state = InputVariable({ stateDim }, DataType::Float, L"state", batchAxis);
+    auto context = InputVariable({ stateDim }, DataType::Float, L"context", batchAxis);
+
+    auto embedding = Parameter(NDArrayView::RandomUniform<float>({ stateDim, vocabularySize }, -1, 1, 1, device));
+    auto recurrence = Parameter(NDArrayView::RandomUniform<float>({ stateDim, stateDim }, -1, 1, 2, device));
+    auto projection = Parameter(NDArrayView::RandomUniform<float>({ vocabularySize, stateDim }, -2, 2, 3, device));
+    auto nextState = Tanh(Plus(Plus(Times(embedding, token), Times(recurrence, state)), context), L"nextState");
+    auto logits = Times(projection, nextState);
+    auto scores = Minus(logits, ReduceLogSum(logits, Axis(0)), L"scores");
+
+    auto function = Combine({ scores, nextState });
+    return { function, token, state, context, function->Outputs()[0], function->Outputs()[1] };
+}
+
+// Scores a token sequence by evaluating the step model one token at a time.
+double ScoreTokenSequence(const BeamSearchStepModel& model, const std::vector<float>& initialState, const std::vector<float>& context, size_t startToken, const std::vector<size_t>& tokens, const DeviceDescriptor& device)
+{
+    size_t vocabularySize = model.m_token.Shape().TotalSize();
+    auto state = initialState;
+    size_t previousToken = startToken;
+    double logProbability = 0;
+    for (auto token : tokens)
+    {
+        std::vector<float> oneHot(vocabularySize, 0);
+        oneHot[previousToken] = 1;
+
+        std::unordered_map<Variable, ValuePtr> arguments = {
+            { model.m_token, Value::CreateBatch(model.m_token.Shape(), oneHot, device) },
+            { model.m_state, Value::CreateBatch(model.m_state.Shape(), state, device) },
+            { model.m_context, Value::CreateBatch(model.m_context.Shape(), context, device) } };
+        std::unordered_map<Variable, ValuePtr> outputs = { { model.m_scores, nullptr }, { model.m_nextState, nullptr } };
+        model.m_function->Evaluate(arguments, outputs, device);
+
+        auto scores = outputs[model.m_scores]->Data()->DeepClone(DeviceDescriptor::CPUDevice());
+        logProbability += scores->DataBuffer<float>()[token];
+
+        auto nextState = outputs[model.m_nextState]->Data()->DeepClone(DeviceDescriptor::CPUDevice());
+        state.assign(nextState->DataBuffer<float>(), nextState->DataBuffer<float>() + state.size());
+        previousToken = token;
+    }
+    return logProbability;
+}
+
+void TestBeamSearchDecoder(const DeviceDescriptor& device)
+{
+    const size_t vocabularySize = 4;
+    const size_t stateDim = 5;
+    const size_t numSequences = 3;
+    const size_t startToken = 0;
+    const size_t endToken = 3;
+    const size_t maxLength = 3;
+    const size_t nBest = 3;
+
+    auto model = CreateBeamSearchStepModel(vocabularySize, stateDim, device);
+
+    auto initialStates = NDArrayView::RandomUniform<float>({ stateDim, numSequences }, -1, 1, 4, DeviceDescriptor::CPUDevice());
+    auto contexts = NDArrayView::RandomUniform<float>({ stateDim, numSequences }, -1, 1, 5, DeviceDescriptor::CPUDevice());
+    std::unordered_map<Variable, ValuePtr> arguments = {
+        { model.m_state, MakeSharedObject<Value>(initialStates) },
+        { model.m_context, MakeSharedObject<Value>(contexts) } };
+
+    auto sequenceData = [stateDim](const NDArrayViewPtr& data, size_t sequence)
+    {
+        return std::vector<float>(data->DataBuffer<float>() + sequence * stateDim, data->DataBuffer<float>() + (sequence + 1) * stateDim);
+    };
+
+    // The decoder stops selecting candidates of a step once it has beamWidth live ones, so a finished candidate that scores
+    // below them would be lost. At the last step there are (vocabularySize - 1)^maxLength live candidates; with a beam at least
+    // that wide nothing is pruned, the search is exhaustive, and finds the best of all token sequences.
+    size_t exhaustiveBeamWidth = 1;
+    for (size_t length = 0; length < maxLength; length++)
+        exhaustiveBeamWidth *= vocabularySize - 1;
+    auto decoder = CreateBeamSearchDecoder(model.m_function, model.m_token, model.m_scores, { { model.m_state, model.m_nextState } }, startToken, endToken, exhaustiveBeamWidth, maxLength, device);
+    auto results = decoder->Decode(arguments, nBest);
+    BOOST_TEST(results.size() == numSequences);
+    for (size_t s = 0; s < numSequences; s++)
+    {
+        auto initialState = sequenceData(initialStates, s);
+        auto context = sequenceData(contexts, s);
+
+        std::vector<std::pair<double, std::vector<size_t>>> expected;
+        std::vector<std::vector<size_t>> prefixes = { {} };
+        for (size_t length = 0; length < maxLength; length++)
+        {
+            std::vector<std::vector<size_t>> longerPrefixes;
+            for (const auto& prefix : prefixes)
+            {
+                for (size_t token = 0; token < vocabularySize; token++)
+                {
+                    auto tokens = prefix;
+                    tokens.push_back(token);
+                    if (token == endToken)
+                        expected.push_back({ ScoreTokenSequence(model, initialState, context, startToken, tokens, device), tokens });
+                    else
+                        longerPrefixes.push_back(tokens);
+                }
+            }
+            prefixes.swap(longerPrefixes);
+        }
+        std::sort(expected.begin(), expected.end(), [](const std::pair<double, std::vector<size_t>>& a, const std::pair<double, std::vector<size_t>>& b) { return a.first > b.first; });
+
+        BOOST_TEST(results[s].size() == nBest);
+        for (size_t i = 0; i < results[s].size(); i++)
+        {
+            BOOST_TEST(results[s][i].m_finished);
+            BOOST_TEST((results[s][i].m_tokens == expected[i].second));
+            FloatingPointCompare(results[s][i].m_logProbability, expected[i].first, "BeamSearchDecoder: The score of an n-best hypothesis does not match its score when evaluated step by step.");
+        }
+    }
+
+    auto statistics = decoder->Statistics();
+    BOOST_TEST(statistics.m_numSequences == numSequences);
+    BOOST_TEST(statistics.m_numSteps <= maxLength);
+    BOOST_TEST(statistics.m_numHypothesisSteps >= statistics.m_numSteps);
+
+    // A narrow beam only approximates the search, but every hypothesis must still carry its own score.
+    const size_t longMaxLength = 6;
+    auto narrowDecoder = CreateBeamSearchDecoder(model.m_function, model.m_token, model.m_scores, { { model.m_state, model.m_nextState } }, startToken, endToken, /*beamWidth =*/ 2, longMaxLength, device);
+    results = narrowDecoder->Decode(arguments, 2);
+    BOOST_TEST(results.size() == numSequences);
+    for (size_t s = 0; s < numSequences; s++)
+    {
+        BOOST_TEST(!results[s].empty());
+        for (const auto& hypothesis : results[s])
+        {
+            BOOST_TEST((hypothesis.m_finished ? (hypothesis.m_tokens.back() == endToken) : (hypothesis.m_tokens.size() == longMaxLength)));
+            FloatingPointCompare(hypothesis.m_logProbability, ScoreTokenSequence(model, sequenceData(initialStates, s), sequenceData(contexts, s), startToken, hypothesis.m_tokens, device),
+                                 "BeamSearchDecoder: The score of a hypothesis does not match its score when evaluated step by step.");
+        }
+    }
+
+    // Missing arguments are rejected.
+    VerifyException([&decoder]() { decoder->Decode({}); }, "Was able to decode without arguments.");
+
+    decoder->ResetStatistics();
+    BOOST_TEST(decoder->Statistics().m_numSteps == 0);
+}
+
+void TestCTCBeamSearchDecode(const DeviceDescriptor& device)
+{
+    // Every frame strongly prefers one label; 0 is the blank.
+    const size_t dimension = 3;
+    auto frames = [dimension](const std::vector<size_t>& labels)
+    {
+        std::vector<float> logProbabilities;
+        for (auto label : labels)
+        {
+            for (size_t i = 0; i < dimension; i++)
+                logProbabilities.push_back(std::log(i == label ? 0.9f : 0.05f));
+        }
+        return logProbabilities;
+    };
+
+    // Sequences of different lengths; repeated labels only count twice when a blank separates them.
+    auto value = Value::Create(NDShape({ dimension }), std::vector<std::vector<float>>({ frames({ 1, 1, 0, 2 }), frames({ 2, 0, 2 }) }), device, /*readOnly =*/ true);
+    auto results = CTCBeamSearchDecode(value, /*blankToken =*/ 0, /*beamWidth =*/ 4, /*nBest =*/ 2);
+    BOOST_TEST(results.size() == 2);
+    BOOST_TEST(results[0].size() == 2);
+    BOOST_TEST((results[0][0].m_tokens == std::vector<size_t>({ 1, 2 })));
+    BOOST_TEST(results[0][0].m_logProbability > results[0][1].m_logProbability);
+    BOOST_TEST((results[1][0].m_tokens == std::vector<size_t>({ 2, 2 })));
+
+    // With a beam width of 1 only the most probable prefix survives each frame. This is not best path decoding in general,
+    // since a prefix sums over all of its alignments, but here every frame is dominated by one label, so both agree.
+    results = CTCBeamSearchDecode(value, 0, 1);
+    BOOST_TEST((results[0][0].m_tokens == std::vector<size_t>({ 1, 2 })));
+    BOOST_TEST((results[1][0].m_tokens == std::vector<size_t>({ 2, 2 })));
+}
+
+void TestOptimizeForInference(const DeviceDescriptor& device)
+{
+    const size_t inputDim = 5;
+    const size_t hiddenDim = 4;
+    const size_t outputDim = 3;
+    const size_t numSamples = 7;
+
+    // A dense layer with batch normalization and dropout, and an output layer scaled by a subgraph of Constants.
+    auto input = InputVariable({ inputDim }, DataType::Float, L"input");
+    auto hiddenParam = Parameter(NDArrayView::RandomUniform<float>({ hiddenDim, inputDim }, -0.5, 0.5, 1, device));
+    auto scale = Parameter(NDArrayView::RandomUniform<float>({ hiddenDim }, 0.5, 1.5, 2, device));
+    auto bias = Parameter(NDArrayView::RandomUniform<float>({ hiddenDim }, -0.5, 0.5, 3, device));
+    auto runningMean = Constant(NDArrayView::RandomUniform<float>({ hiddenDim }, -0.5, 0.5, 4, device));
+    auto runningVariance = Constant(NDArrayView::RandomUniform<float>({ hiddenDim }, 0.5, 2, 5, device));
+    auto normalized = BatchNormalization(Times(hiddenParam, input), scale, bias, runningMean, runningVariance, Constant::Scalar(0.0f, device), /*spatial =*/ false);
+    auto hidden = ReLU(Dropout(normalized, 0.5));
+
+    auto outputParam = Parameter(NDArrayView::RandomUniform<float>({ outputDim, hiddenDim }, -0.5, 0.5, 6, device));
+    auto outputScale = Sqrt(Plus(Constant(NDArrayView::RandomUniform<float>({ outputDim }, 1, 2, 7, device)), Constant::Scalar(1.0f, device)));
+    auto model = ElementTimes(Times(outputParam, hidden), outputScale, L"output");
+
+    // The criterion is only needed for training, and is dropped with the outputs that are not kept.
+    // It is a block of three primitive Functions, which are counted before the optimization.
+    auto labels = InputVariable({ outputDim }, DataType::Float, L"labels");
+    auto trainingFunction = Combine({ model->Output(), SquaredError(model, labels)->Output() });
+
+    InferenceOptimizationStatistics statistics;
+    auto optimized = OptimizeForInference(trainingFunction, { model->Output() }, statistics);
+    BOOST_TEST(optimized->Parameters().empty());
+    BOOST_TEST((optimized->Arguments() == std::vector<Variable>({ input })));
+    BOOST_TEST(statistics.m_numBatchNormalizationsFoldedIntoWeights == 1);
+    BOOST_TEST(statistics.m_numIdentityFunctionsRemoved == 1);
+    BOOST_TEST(statistics.m_numConstantFunctionsFolded == 2);
+    BOOST_TEST(statistics.m_numFunctionsBefore == 11);
+    BOOST_TEST(statistics.m_numFunctionsAfter == 5);
+    BOOST_TEST(statistics.m_flopsAfter < statistics.m_flopsBefore);
+
+    auto data = NDArrayView::RandomUniform<float>({ inputDim * numSamples }, -1, 1, 8, DeviceDescriptor::CPUDevice());
+    auto batch = Value::CreateBatch(input.Shape(), std::vector<float>(data->DataBuffer<float>(), data->DataBuffer<float>() + inputDim * numSamples), device, /*readOnly =*/ true);
+    auto evaluate = [&](const FunctionPtr& function)
+    {
+        std::unordered_map<Variable, ValuePtr> outputs = { { function->Output(), nullptr } };
+        function->Evaluate({ { input, batch } }, outputs, device);
+        auto result = outputs[function->Output()]->Data()->DeepClone(DeviceDescriptor::CPUDevice(), /*readOnly =*/ true);
+        return std::vector<float>(result->DataBuffer<float>(), result->DataBuffer<float>() + result->Shape().TotalSize());
+    };
+    FloatingPointVectorCompare(evaluate(optimized), evaluate(model), "OptimizeForInference: The optimized Function computes different values than the original one.");
+}
+
+void TestNodeProfiling(const DeviceDescriptor& device)
+{
+    const size_t inputDim = 3;
+    const size_t outputDim = 4;
+    const size_t numSamples = 5;
+    const size_t numIterations = 3;
+    const std::wstring profilerDir = L"NodeProfilingTest";
+    boost::filesystem::remove_all(profilerDir);
+
+    auto input = InputVariable({ inputDim }, DataType::Float, L"input");
+    auto timesParam = Parameter(NDArrayView::RandomUniform<float>({ outputDim, inputDim }, -0.5, 0.5, 1, device), L"timesParam");
+    auto output = Sigmoid(Times(timesParam, input), L"output");
+
+    std::vector<float> inputData(numSamples * inputDim);
+    for (size_t i = 0; i < inputData.size(); ++i)
+        inputData[i] = (float)i / inputData.size();
+    auto inputValue = Value::CreateBatch(input.Shape(), inputData, device);
+
+    Internal::StartProfiler(profilerDir, /*profilerSyncGpu =*/ false, Internal::DefaultProfilerBufferSize, /*profileNodes =*/ true);
+    Internal::EnableProfiler();
+    for (size_t i = 0; i < numIterations; ++i)
+    {
+        std::unordered_map<Variable, ValuePtr> outputs = { { output->Output(), nullptr } };
+        auto backpropState = output->Forward({ { input, inputValue } }, outputs, device, { output->Output() });
+
+        auto rootGradient = MakeSharedObject<Value>(MakeSharedObject<NDArrayView>(1.0f, outputs[output->Output()]->Shape(), device));
+        std::unordered_map<Variable, ValuePtr> gradients = { { timesParam, nullptr } };
+        output->Backward(backpropState, { { output->Output(), rootGradient } }, gradients);
+    }
+    Internal::StopProfiler();
+
+    std::string traceFile, nodeReportFile;
+    for (boost::filesystem::directory_iterator it(profilerDir), end; it != end; ++it)
+    {
+        auto fileName = it->path().filename().string();
+        if (fileName.find("_trace_") != std::string::npos)
+            traceFile = it->path().string();
+        else if (fileName.find("_nodes_") != std::string::npos)
+            nodeReportFile = it->path().string();
+    }
+    BOOST_REQUIRE(!traceFile.empty());
+    BOOST_REQUIRE(!nodeReportFile.empty());
+
+    // The trace must be valid JSON, with a complete event per forward and backward pass of each node
+    boost::property_tree::ptree trace;
+    boost::property_tree::read_json(traceFile, trace);
+    std::map<std::string, size_t> nodeEventCounts;
+    for (const auto& event : trace.get_child("traceEvents"))
+    {
+        BOOST_TEST(event.second.get<std::string>("ph") == "X");
+        BOOST_TEST(event.second.get<double>("ts") >= 0);
+        BOOST_TEST(event.second.get<double>("dur") >= 0);
+
+        auto name = event.second.get<std::string>("name");
+        auto pass = name.substr(0, name.find(' '));
+        auto operationBegin = name.rfind(" (");
+        if ((pass == "Forward" || pass == "Backward") && operationBegin != std::string::npos)
+            nodeEventCounts[pass + name.substr(operationBegin)]++;
+    }
+    // The V2 Sigmoid is computed by a StableSigmoid node.
+    BOOST_TEST(nodeEventCounts["Forward (Times)"] == numIterations);
+    BOOST_TEST(nodeEventCounts["Backward (Times)"] == numIterations);
+    BOOST_TEST(nodeEventCounts["Forward (StableSigmoid)"] == numIterations);
+    BOOST_TEST(nodeEventCounts["Backward (StableSigmoid)"] == numIterations);
+
+    // The node report has a row per node, with the operation and the number of forward and backward passes
+    std::ifstream nodeReport(nodeReportFile);
+    std::map<std::string, std::string> nodeCounts;
+    bool inTable = false;
+    for (std::string line; std::getline(nodeReport, line);)
+    {
+        if (line.compare(0, 4, "Node") == 0)
+            inTable = true;
+        else if (inTable && !line.empty())
+        {
+            std::istringstream row(line);
+            std::vector<std::string> tokens{ std::istream_iterator<std::string>(row), std::istream_iterator<std::string>() };
+            BOOST_REQUIRE(tokens.size() > 9);
+            nodeCounts[tokens[1]] = tokens[9];
+        }
+    }
+    BOOST_TEST(nodeCounts["Times"] == std::to_string(2 * numIterations));
+    BOOST_TEST(nodeCounts["StableSigmoid"] == std::to_string(2 * numIterations));
+
+    boost::filesystem::remove_all(profilerDir);
+}
+
 BOOST_AUTO_TEST_SUITE(FunctionSuite)
 
 BOOST_AUTO_TEST_CASE(FindNameInCPU)
@@ -1204,6 +1625,48 @@ BOOST_AUTO_TEST_CASE(TimesIndirectSparseGradType)
 }
 
 
+BOOST_AUTO_TEST_CASE(BatchingEvaluatorInCPU)
+{
+    if (ShouldRunOnCpu())
+        TestBatchingEvaluator(DeviceDescriptor::CPUDevice());
+}
+
+BOOST_AUTO_TEST_CASE(BatchingEvaluatorInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestBatchingEvaluator(DeviceDescriptor::GPUDevice(0));
+}
+
+BOOST_AUTO_TEST_CASE(BeamSearchDecoderInCPU)
+{
+    if (ShouldRunOnCpu())
+        TestBeamSearchDecoder(DeviceDescriptor::CPUDevice());
+}
+
+BOOST_AUTO_TEST_CASE(BeamSearchDecoderInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestBeamSearchDecoder(DeviceDescriptor::GPUDevice(0));
+}
+
+BOOST_AUTO_TEST_CASE(CTCBeamSearchDecodeInCPU)
+{
+    if (ShouldRunOnCpu())
+        TestCTCBeamSearchDecode(DeviceDescriptor::CPUDevice());
+}
+
+BOOST_AUTO_TEST_CASE(OptimizeForInferenceInCPU)
+{
+    if (ShouldRunOnCpu())
+        TestOptimizeForInference(DeviceDescriptor::CPUDevice());
+}
+
+BOOST_AUTO_TEST_CASE(OptimizeForInferenceInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestOptimizeForInference(DeviceDescriptor::GPUDevice(0));
+}
+
 BOOST_AUTO_TEST_CASE(TestSettingDropoutRate)
 {
     if (ShouldRunOnCpu())
@@ -1222,6 +1685,12 @@ BOOST_AUTO_TEST_CASE(TestSettingRandomSeed)
         SetRandomSeed(DeviceDescriptor::GPUDevice(0));
 }
 
+BOOST_AUTO_TEST_CASE(NodeProfiling)
+{
+    if (ShouldRunOnCpu())
+        TestNodeProfiling(DeviceDescriptor::CPUDevice());
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
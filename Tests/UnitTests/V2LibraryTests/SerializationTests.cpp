@@ -449,6 +449,62 @@ void TestFunctionSerialization(const DeviceDescriptor& device)
     TestFunctionSaveAndLoad(BuildLSTMClassifierNet(inputVar, 5, device), device);
 }
 
+void TestMappedModelSaveAndLoad(const FunctionPtr& function, const DeviceDescriptor& device)
+{
+    auto file = L"TestMappedModelSaveAndLoad.out";
+    function->Save(file, ModelFormat::CNTKv2Mapped);
+
+    auto reloadedFunction = Function::Load(file, device);
+    if (!AreEqual(function, reloadedFunction))
+    {
+        BOOST_ERROR("TestMappedModelSaveAndLoad: original and reloaded functions are not identical.");
+    }
+
+    // The values of the reloaded function live in the mapping of the file, save them in the protobuf format.
+    auto protobufFile = L"TestMappedModelSaveAndLoad.protobuf.out";
+    reloadedFunction->Save(protobufFile);
+    auto functionReloadedFromProtobuf = Function::Load(protobufFile, device);
+    if (!AreEqual(function, functionReloadedFromProtobuf))
+    {
+        BOOST_ERROR("TestMappedModelSaveAndLoad: original function and function saved from the mapped model are not identical.");
+    }
+
+    // Save the reloaded function over the file its values are mapped from.
+    reloadedFunction->Save(file, ModelFormat::CNTKv2Mapped);
+    if (!AreEqual(function, reloadedFunction))
+    {
+        BOOST_ERROR("TestMappedModelSaveAndLoad: mapped function changed when it was saved over its own file.");
+    }
+
+    auto functionSavedOverItself = Function::Load(file, device);
+    if (!AreEqual(function, functionSavedOverItself))
+    {
+        BOOST_ERROR("TestMappedModelSaveAndLoad: original function and mapped function saved over its own file are not identical.");
+    }
+
+    vector<char> buffer;
+    {
+        auto stream = GetFstream(file, true);
+        buffer.assign(istreambuf_iterator<char>(*stream), istreambuf_iterator<char>());
+    }
+
+    VerifyException([&buffer]() {
+        Function::Load(buffer.data(), buffer.size());
+    }, "Was able to load a mapped model from memory buffer.");
+}
+
+void TestMappedModelSerialization(const DeviceDescriptor& device)
+{
+    const size_t inputDim = 20;
+    auto inputVar = InputVariable({ inputDim }, true /*isSparse*/, DataType::Float, L"input_variable");
+
+    TestMappedModelSaveAndLoad(FullyConnectedLinearLayer(inputVar, 30, device), device);
+
+    TestMappedModelSaveAndLoad(BuildFFClassifierNet(inputVar, 5, device), device);
+
+    TestMappedModelSaveAndLoad(BuildLSTMClassifierNet(inputVar, 5, device), device);
+}
+
 TrainerPtr BuildTrainer(const FunctionPtr& function, const Variable& labels,
                      LearningRateSchedule lr = LearningRateSchedule(0.005, 1),
                      MomentumSchedule m = MomentumAsTimeConstantSchedule(0.0))
@@ -1011,6 +1067,11 @@ BOOST_AUTO_TEST_CASE(FunctionSerializationInCPU)
     TestFunctionSerialization(DeviceDescriptor::CPUDevice());
 }
 
+BOOST_AUTO_TEST_CASE(MappedModelSerializationInCPU)
+{
+    TestMappedModelSerialization(DeviceDescriptor::CPUDevice());
+}
+
 BOOST_AUTO_TEST_CASE(ModelSerializationDuringTrainingInCPU)
 {
     TestModelSerializationDuringTraining(DeviceDescriptor::CPUDevice());
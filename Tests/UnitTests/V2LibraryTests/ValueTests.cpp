@@ -1168,6 +1168,48 @@ void CreateBatchOfSequencesTestDense(const DeviceDescriptor device, bool readOnl
     }
 }
 
+template <typename ElementType>
+void CreatePackedBatchOfSequencesTestDense(const DeviceDescriptor device, bool readOnly)
+{
+    size_t numAxes = 3;
+    size_t maxDimSize = 10;
+    NDShape sampleShape = CreateShape(numAxes, maxDimSize);
+    size_t maxNumOfSequences = 20;
+    size_t maxAllowedSequenceLen = 10;
+    auto sampleVariable = CreateVariable<ElementType>(sampleShape, 2);
+
+    auto automaticUnpackingOfPackedValuesDisabled = Internal::IsAutomaticUnpackingOfPackedValuesDisabled();
+    int testRun = 4;
+    std::default_random_engine generator;
+    std::uniform_int_distribution<size_t> distribution(1, maxNumOfSequences);
+    for (int i = 0; i < testRun; i++)
+    {
+        // Copying the output reads the packed data, so it must work even if automatic unpacking is disabled.
+        auto batchCount = distribution(generator);
+        auto seqLenList = GenerateSequenceLengths(batchCount, maxAllowedSequenceLen);
+        auto data = GenerateSequences<ElementType>(seqLenList, sampleShape);
+        auto testValue = Value::CreatePackedBatchOfSequences(sampleShape, data, device, readOnly);
+        std::vector<std::vector<ElementType>> output;
+        testValue->CopyVariableValueTo(sampleVariable, output);
+        CheckCopyToOutput(data, output);
+
+        // Checking the value unpacks it, so temporarily enable the unpacking of packed value objects.
+        Internal::SetAutomaticUnpackingOfPackedValues(/*disable =*/ false);
+        CheckValue(testValue, sampleShape, data, seqLenList);
+
+        seqLenList = GenerateSequenceLengths(batchCount, maxAllowedSequenceLen);
+        data = GenerateSequences<ElementType>(seqLenList, sampleShape);
+        auto seqStartFlags = GenerateSequenceStartFlags(batchCount);
+        testValue = Value::CreatePackedBatchOfSequences(sampleShape, data, seqStartFlags, device, readOnly);
+        CheckValue(testValue, sampleShape, data, seqLenList, seqStartFlags);
+        Internal::SetAutomaticUnpackingOfPackedValues(/*disable =*/ automaticUnpackingOfPackedValuesDisabled);
+    }
+
+    VerifyException([&sampleShape, &device]() {
+        Value::CreatePackedBatchOfSequences(sampleShape, std::vector<std::vector<ElementType>>({ {} }), device);
+    }, "Was able to create a packed Value containing an empty sequence.");
+}
+
 
 template <typename ElementType>
 void CreateBatchTestOneHot(const DeviceDescriptor device, bool readOnly)
@@ -1520,6 +1562,24 @@ BOOST_AUTO_TEST_CASE(CreateBatchOfSequencesDenseInGPU)
     }
 }
 
+BOOST_AUTO_TEST_CASE(CreatePackedBatchOfSequencesDenseInCPU)
+{
+    if (!ShouldRunOnCpu())
+        return;
+
+    CreatePackedBatchOfSequencesTestDense<float>(DeviceDescriptor::CPUDevice(), true);
+    CreatePackedBatchOfSequencesTestDense<double>(DeviceDescriptor::CPUDevice(), false);
+}
+
+BOOST_AUTO_TEST_CASE(CreatePackedBatchOfSequencesDenseInGPU)
+{
+    if (ShouldRunOnGpu())
+    {
+        CreatePackedBatchOfSequencesTestDense<float>(DeviceDescriptor::GPUDevice(0), false);
+        CreatePackedBatchOfSequencesTestDense<double>(DeviceDescriptor::GPUDevice(0), true);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(CreateBatchOneHotInCPU)
 {
     if (!ShouldRunOnCpu())
@@ -235,6 +235,16 @@ IGNORE_FUNCTION CNTK::CreateQuantizedDataParallelDistributedLearner;
 IGNORE_FUNCTION CNTK::CreateBlockMomentumDistributedLearner;
 IGNORE_CLASS CNTK::Evaluator;
 IGNORE_FUNCTION CNTK::CreateEvaluator;
+IGNORE_CLASS CNTK::BatchingEvaluator;
+IGNORE_STRUCT CNTK::BatchingEvaluatorStatistics;
+IGNORE_FUNCTION CNTK::CreateBatchingEvaluator;
+IGNORE_STRUCT CNTK::DecodingHypothesis;
+IGNORE_CLASS CNTK::BeamSearchDecoder;
+IGNORE_STRUCT CNTK::BeamSearchDecoderStatistics;
+IGNORE_FUNCTION CNTK::CreateBeamSearchDecoder;
+IGNORE_FUNCTION CNTK::CTCBeamSearchDecode;
+IGNORE_STRUCT CNTK::InferenceOptimizationStatistics;
+IGNORE_FUNCTION CNTK::OptimizeForInference;
 IGNORE_STRUCT std::hash<::CNTK::StreamInformation>;
 %ignore operator==(const StreamInformation& left, const StreamInformation& right);
 IGNORE_STRUCT CNTK::DistributedWorkerDescriptor;
@@ -296,6 +306,8 @@ IGNORE_FUNCTION CNTK::Internal::EnableForwardValuesSharing;
 IGNORE_FUNCTION CNTK::Internal::DisableForwardValuesSharing;
 IGNORE_FUNCTION CNTK::Internal::EnableGradientAccumulationOptimization;
 IGNORE_FUNCTION CNTK::Internal::DisableGradientAccumulationOptimization;
+IGNORE_FUNCTION CNTK::Internal::EnableDirectConvolution;
+IGNORE_FUNCTION CNTK::Internal::DisableDirectConvolution;
 %ignore CNTK::Internal::DefaultProfilerBufferSize;
 IGNORE_FUNCTION CNTK::Internal::StartProfiler;
 IGNORE_FUNCTION CNTK::Internal::StopProfiler;
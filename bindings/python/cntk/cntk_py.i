@@ -105,6 +105,20 @@
 
 %ignore CNTK::NDArrayView::AdjustSparseBlockColumn;
 
+// std::future and std::chrono are not exposed to Python
+%ignore CNTK::BatchingEvaluator;
+%ignore CNTK::BatchingEvaluatorStatistics;
+%ignore CNTK::CreateBatchingEvaluator;
+
+// The n-best lists of the decoders have no Python mapping yet
+%ignore CNTK::DecodingHypothesis;
+%ignore CNTK::BeamSearchDecoder;
+%ignore CNTK::BeamSearchDecoderStatistics;
+%ignore CNTK::CreateBeamSearchDecoder;
+%ignore CNTK::CTCBeamSearchDecode;
+%ignore CNTK::InferenceOptimizationStatistics;
+%ignore CNTK::OptimizeForInference;
+
 // renaming overloads for TrainMinibatch and TestMinibatch that take a map
 // of Variables and MinibatchData as their first parameter. If this is not done,
 // the overloads that are legal in C++ will be shadowed and ignored by SWIG.
@@ -1841,8 +1841,9 @@ def optimized_rnnstack(operand, weights, hidden_size, num_layers,
                        bidirectional=False, recurrent_op='lstm', name=''):
     '''
     An RNN implementation that uses the primitives in cuDNN.
-    If cuDNN is not available it fails. You can use :class:`~cntk.misc.optimized_rnnstack_converter.convert_optimized_rnnstack`
-    to convert a model to GEMM-based implementation when no cuDNN.
+    On the CPU, a native implementation with the same parameter layout is used, which only supports
+    evaluation. To train without cuDNN, you can use :class:`~cntk.misc.optimized_rnnstack_converter.convert_optimized_rnnstack`
+    to convert a model to GEMM-based implementation.
 
     Args:
         operand: input of the optimized RNN stack.
@@ -11,11 +11,11 @@ from cntk.metrics import classification_error
 from cntk import parameter, plus, reduce_sum
 import cntk as C
 
-def create_data_parallel_distributed_learner(learner, quantized, distributed_after):
+def create_data_parallel_distributed_learner(learner, quantized, distributed_after, use_async=False):
     return distributed.data_parallel_distributed_learner(
         learner=learner,
         distributed_after=distributed_after,
-        use_async_buffered_parameter_update=False,
+        use_async_buffered_parameter_update=use_async,
         num_quantization_bits=(1 if quantized else 32))
 
 def create_block_momentum_distributed_learner(learner, distributed_after):
@@ -232,6 +232,9 @@ def test_distributed(tmpdir, is_1bit_sgd):
     simple_aggregation=lambda learner: create_data_parallel_distributed_learner(learner, False, 0)
     run_distributed_training(tmpdir, create_func=simple_aggregation)
 
+    async_aggregation=lambda learner: create_data_parallel_distributed_learner(learner, False, 0, True)
+    run_distributed_training(tmpdir, create_func=async_aggregation)
+
     if is_1bit_sgd == 1:
         quantized_aggregation=lambda learner: create_data_parallel_distributed_learner(learner, True, 100)
         run_distributed_training(tmpdir, create_func=quantized_aggregation)